@@ -0,0 +1,113 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Cycles per sample and stage of AudioFilterBiquadBank by mode and
+// length, against the old 4 stage AudioFilterBiquad. Each figure is the
+// median host cycles of one update(), receive and transmit included,
+// divided by 128 samples and the stages.
+
+#include "host.h"
+#include "filter_biquad.h"
+#include "ref_biquad.h"
+
+#define MAX_STAGES	16
+
+static void lowpass(double f, double q, double *c)
+{
+	double w0 = 2 * M_PI * f / 88235.29412, cs = cos(w0), alpha = sin(w0) / (2 * q);
+	double a0 = 1 + alpha;
+
+	c[0] = (1 - cs) / 2 / a0;
+	c[1] = (1 - cs) / a0;
+	c[2] = c[0];
+	c[3] = -2 * cs / a0;
+	c[4] = (1 - alpha) / a0;
+}
+
+static int16_t in[64 * AUDIO_BLOCK_SAMPLES];
+
+// "stages" of the bank, 32 bit state or not, ramping on every block or not
+static double bank(uint32_t stages, bool precise, bool ramping)
+{
+	static int32_t mem[AUDIO_BIQUAD_WORDS(MAX_STAGES)];
+	static HostSource src;
+	static AudioFilterBiquadBank *filter;
+	std::vector<uint32_t> t;
+	double c[2][5];
+	int b = 0;
+
+	lowpass(5000, 0.7, c[0]);
+	lowpass(5100, 0.7, c[1]);
+	// one object per run, AudioStream keeps them all, the old ones hold
+	// on to one input block each
+	filter = new AudioFilterBiquadBank(mem, stages);
+	new AudioConnection(src, *filter);
+	filter->setInterpolation(ramping ? AUDIO_BLOCK_SAMPLES : 0);
+	for (uint32_t s=0; s < stages; s++) {
+		filter->setCoefficients(s, c[0]);
+		filter->setPrecision(s, precise);
+	}
+	for (int r=0; r < 2001 + 16; r++, b++) {
+		if (b == 64) b = 0;
+		if (ramping) {
+			for (uint32_t s=0; s < stages; s++) filter->setCoefficients(s, c[r & 1]);
+		}
+		src.play(in + b * AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+		src.update();
+		uint32_t t0 = host_cycles();
+		filter->update();
+		if (r >= 16) t.push_back(host_cycles() - t0);
+	}
+	std::sort(t.begin(), t.end());
+	return (double)t[t.size() / 2] / (AUDIO_BLOCK_SAMPLES * stages);
+}
+
+int main(void)
+{
+	static ReferenceBiquad ref;
+	static int16_t work[AUDIO_BLOCK_SAMPLES];
+	static const uint32_t lengths[] = {1, 4, 8, 16};
+	double c[5];
+
+	AudioMemory(32);
+	host_sines_noise(in, 64 * AUDIO_BLOCK_SAMPLES, 88235.29412);
+	lowpass(5000, 0.7, c);
+	for (int s=0; s < 4; s++) ref.setCoefficients(s, c);
+	double old = host_cycles_median([&]() {
+		memcpy(work, in, sizeof(work));
+		ref.filter(work);
+	}) / (AUDIO_BLOCK_SAMPLES * 4);
+
+	printf("biquad, host cycles per sample and stage (median of 2001 blocks)\n");
+	printf("  old AudioFilterBiquad, 4 stages      %6.2f\n", old);
+	printf("  stages                  ");
+	for (uint32_t l : lengths) printf("%8u", l);
+	printf("\n");
+	for (int mode=0; mode < 4; mode++) {
+		bool precise = mode & 1, ramping = mode & 2;
+		printf("  %-6s state%-12s", precise ? "32 bit" : "16 bit", ramping ? ", ramping" : "");
+		for (uint32_t l : lengths) printf("%8.2f", bank(l, precise, ramping));
+		printf("\n");
+	}
+	return 0;
+}
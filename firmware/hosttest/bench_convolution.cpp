@@ -0,0 +1,76 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Host cycles per block of AudioFilterConvolution against a direct FIR
+// of the same taps (32 bit multiply-accumulate per tap), by IR length.
+// The convolver costs two FFTs plus one complex multiply per bin and
+// partition, the FIR one multiply per tap and sample.
+
+#include "host.h"
+#include "filter_convolution.h"
+
+#define MAX_TAPS	4096
+#define BLOCKS		64
+
+// not static, so the FIR is not optimized away
+int16_t out[AUDIO_BLOCK_SAMPLES];
+
+int main(void)
+{
+	static int32_t memory[AUDIO_CONVOLUTION_WORDS(MAX_TAPS)];
+	static int16_t in[(BLOCKS + MAX_TAPS / AUDIO_BLOCK_SAMPLES + 1) * AUDIO_BLOCK_SAMPLES];
+	static int16_t ir[MAX_TAPS];
+	static HostSource src;
+	static AudioFilterConvolution conv;
+	static AudioConnection c1(src, conv);
+	static const int lengths[] = {64, 128, 256, 512, 1024, 2048, 4096};
+	uint32_t seed = 1;
+
+	AudioMemory(8);
+	host_sines_noise(in, sizeof(in) / sizeof(in[0]), 44117.64706);
+	for (int i=0; i < MAX_TAPS; i++) {
+		ir[i] = (int16_t)((int32_t)host_rand(&seed) >> 20) * exp(-4.0 * i / MAX_TAPS);
+	}
+	printf("convolution, host cycles per block (median)\n");
+	printf("   taps  partitioned     direct  direct/partitioned\n");
+	for (int taps : lengths) {
+		int b = 0;
+		conv.begin(ir, taps, memory);
+		double fast = host_cycles_median([&]() {
+			src.play(in + (b++ % BLOCKS) * AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+			src.update();
+			conv.update();
+		}, 501);
+		// the FIR reads the history in front of the block
+		const int16_t *x = in + (taps / AUDIO_BLOCK_SAMPLES + 1) * AUDIO_BLOCK_SAMPLES;
+		double direct = host_cycles_median([&]() {
+			for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+				int64_t s = 0;
+				for (int j=0; j < taps; j++) s += (int32_t)ir[j] * x[i - j];
+				out[i] = s >> 15;
+			}
+		}, 301);
+		printf("  %5d  %11.0f  %9.0f  %18.1f\n", taps, fast, direct, direct / fast);
+	}
+	return 0;
+}
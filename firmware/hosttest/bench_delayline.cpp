@@ -0,0 +1,82 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// Host cycles per block of AudioEffectDelayLine against AudioEffectDelay
+// by the number of taps, delays spread up to 4237 samples. The block
+// queue copies whole or split blocks per tap, the delay line writes the
+// input once and reads every tap from its sample buffer: whole samples
+// (no interpolation), linear and allpass at a half sample.
+
+#include "host.h"
+#include "effect_delay.h"
+
+#define LONGEST		5000
+#define RUNS		2001
+
+static int16_t ring[AUDIO_DELAYLINE_SAMPLES(LONGEST)];
+
+int main(void)
+{
+	static int16_t in[64 * AUDIO_BLOCK_SAMPLES];
+	static HostSource src;
+	static AudioEffectDelay old;
+	static AudioEffectDelayLine line(ring, sizeof(ring) / sizeof(ring[0]));
+	static AudioConnection c1(src, old), c2(src, line);
+	static const int counts[] = {1, 2, 4, 8};
+	static const uint8_t modes[3] = {DELAYLINE_INTERP_NONE, DELAYLINE_INTERP_LINEAR,
+		DELAYLINE_INTERP_ALLPASS};
+	int b = 0;
+
+	AudioMemory(60);
+	host_sines_noise(in, sizeof(in) / sizeof(in[0]), 44117.64706);
+	auto play = [&]() {
+		src.play(in + (b++ % 64) * AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+		src.update();
+	};
+	printf("delay line, host cycles per block (median)\n");
+	printf("  taps  block queue     whole    linear   allpass\n");
+	for (int k : counts) {
+		double t[4];
+		for (int c=0; c < 8; c++) {
+			old.disable(c);
+			line.disable(c);
+		}
+		for (int c=0; c < k; c++) old.delay(c, (c * 600 + 37) * 1000.0f / AudioSampleRate());
+		// fill the queue up to the longest delay
+		for (int i=0; i < 40; i++) {
+			play();
+			old.update();
+		}
+		t[0] = host_cycles_median([&]() { play(); old.update(); }, RUNS);
+		for (int m=0; m < 3; m++) {
+			line.interpolation(modes[m]);
+			line.glide(0);
+			float frac = modes[m] == DELAYLINE_INTERP_NONE ? 0.0f : 0.5f;
+			for (int c=0; c < k; c++) line.delaySamples(c, c * 600 + 37 + frac);
+			t[m + 1] = host_cycles_median([&]() { play(); line.update(); }, RUNS);
+		}
+		printf("  %4d  %11.0f  %8.0f  %8.0f  %8.0f\n", k, t[0], t[1], t[2], t[3]);
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Cycles of each AudioAnalyzeFFT1024 update(), by state of the 4 block
+// hop, against the whole spectrum done in one update as before. The
+// worst update is what has to fit into the audio interrupt.
+
+#include "host.h"
+#include "ref_fft1024.h"
+
+#define HOPS	2001
+
+int main(void)
+{
+	static int16_t in[(HOPS * 4 + 8) * AUDIO_BLOCK_SAMPLES];
+	static HostSource src;
+	static AudioAnalyzeFFT1024 fft;
+	static AudioConnection c1(src, fft);
+	static ReferenceFFT1024 ref(AudioWindowHanning1024);
+	std::vector<uint32_t> t[4];
+	double median[4], total = 0, worst = 0;
+	uint32_t b = 0;
+
+	AudioMemory(20);
+	host_sines_noise(in, (HOPS * 4 + 8) * AUDIO_BLOCK_SAMPLES, 44117.64706);
+	src.play(in, (HOPS * 4 + 8) * AUDIO_BLOCK_SAMPLES);
+	// the first 8 blocks fill the object, then states 4, 5, 6, 7
+	for ( ; b < 8; b++) {
+		src.update();
+		fft.update();
+	}
+	for (int h=0; h < HOPS; h++) {
+		for (int s=0; s < 4; s++, b++) {
+			src.update();
+			uint32_t t0 = host_cycles();
+			fft.update();
+			t[s].push_back(host_cycles() - t0);
+		}
+	}
+	printf("AudioAnalyzeFFT1024, host cycles per update (median of %d hops)\n", HOPS);
+	for (int s=0; s < 4; s++) {
+		std::sort(t[s].begin(), t[s].end());
+		median[s] = t[s][HOPS / 2];
+		total += median[s];
+		worst = std::max(worst, median[s]);
+	}
+	printf("  state 4 (CFFT)              %8.0f\n", median[0]);
+	printf("  state 5 (bins 0-255)        %8.0f\n", median[1]);
+	printf("  state 6 (bins 256-511, 0-3) %8.0f\n", median[2]);
+	printf("  state 7 (blocks 4-7)        %8.0f\n", median[3]);
+	printf("  spread: max %.0f, average %.0f, max/average %.2f\n", worst, total / 4,
+		worst * 4 / total);
+	double one = host_cycles_median([&]() { ref.frame(in); });
+	printf("  in one update: max %.0f, average %.0f, max/average 4.00\n", one, one / 4);
+	return 0;
+}
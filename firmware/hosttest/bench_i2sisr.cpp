@@ -0,0 +1,68 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// Host cycles per block of the I2S output interrupt work that the zero
+// copy output takes out: AudioOutputI2S copies a block pair into the
+// DMA buffer, half a block in each of its two interrupts, while
+// AudioOutputI2Sdirect only moves the pair through its slots, once per
+// block (utility/output_direct.h). Update and release cost the same in
+// both and are left out. On the device a firmware built with
+// -DI2S_DIRECT and RECONFIG_REPORT prints the whole interrupt through
+// AudioOutputI2S::isrCycles().
+
+#include "host.h"
+#include "memcpy_audio.h"
+#include "utility/output_direct.h"
+
+#define RUNS	20001
+
+int main(void)
+{
+	static audio_block_t left, right;
+	static int16_t buffer[AUDIO_BLOCK_SAMPLES * 2];
+	static output_direct_t direct = OUTPUT_DIRECT_INIT;
+	audio_block_t *doneL, *doneR;
+	volatile int32_t sink = 0;
+
+	host_sines_noise(left.data, AUDIO_BLOCK_SAMPLES, AUDIO_SAMPLE_RATE_EXACT, 1);
+	host_sines_noise(right.data, AUDIO_BLOCK_SAMPLES, AUDIO_SAMPLE_RATE_EXACT, 2);
+	double t_copy = host_cycles_median([&]() {
+		memcpy_tointerleaveLR(buffer, left.data, right.data);
+		memcpy_tointerleaveLR(buffer + AUDIO_BLOCK_SAMPLES, left.data + AUDIO_BLOCK_SAMPLES / 2,
+			right.data + AUDIO_BLOCK_SAMPLES / 2);
+		sink = buffer[AUDIO_BLOCK_SAMPLES - 1];
+	}, RUNS);
+	double t_direct = host_cycles_median([&]() {
+		int32_t diff = (const char *)right.data - (const char *)left.data;
+		output_direct_take(&direct, &left, &right, diff);
+		output_direct_done(&direct, false, &doneL, &doneR);
+		sink = doneL != NULL;
+	}, RUNS);
+	printf("I2S output interrupt work, host cycles per block (median)\n");
+	printf("  copy (2 halves)  %6.0f\n", t_copy);
+	printf("  direct (slots)   %6.0f\n", t_direct);
+	printf("  saved            %6.0f\n", t_copy - t_direct);
+	(void)sink;
+	return 0;
+}
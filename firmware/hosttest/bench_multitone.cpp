@@ -0,0 +1,69 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// Host cycles per block of AudioSynthMultitone by the number of tones,
+// against as many AudioSynthWaveformSine objects summed by a tree of
+// AudioMixer4, the way a multitone was made before.
+
+#include "host.h"
+#include "synth_multitone.h"
+#include "synth_sine.h"
+#include "mixer.h"
+
+#define RUNS	2001
+
+static const int counts[] = {1, 2, 4, 8, 16, 32};
+
+int main(void)
+{
+	static AudioSynthMultitone multi;
+	static AudioSynthWaveformSine sine[AUDIO_MULTITONE_MAX];
+	// 32 sines into 8 + 2 + 1 mixers
+	static AudioMixer4 mix1[8], mix2[2], mix3;
+	for (int i=0; i < 32; i++) new AudioConnection(sine[i], 0, mix1[i / 4], i % 4);
+	for (int i=0; i < 8; i++) new AudioConnection(mix1[i], 0, mix2[i / 4], i % 4);
+	for (int i=0; i < 2; i++) new AudioConnection(mix2[i], 0, mix3, i);
+
+	AudioMemory(48);
+	printf("multitone, host cycles per block (median)\n");
+	printf("  tones  multitone  per tone  sines+mixers  per tone\n");
+	for (int k : counts) {
+		multi.logSpaced(20.0f, 20000.0f, k);
+		multi.amplitude(0.9f);
+		for (int i=0; i < k; i++) {
+			sine[i].frequency(20.0f * powf(1000.0f, (float)i / k));
+			sine[i].amplitude(0.9f / k);
+		}
+		double t_multi = host_cycles_median([&]() { multi.update(); }, RUNS);
+		double t_sines = host_cycles_median([&]() {
+			for (int i=0; i < k; i++) sine[i].update();
+			for (int i=0; i < (k + 3) / 4; i++) mix1[i].update();
+			for (int i=0; i < (k + 15) / 16; i++) mix2[i].update();
+			mix3.update();
+		}, RUNS);
+		printf("  %5d  %9.0f  %8.0f  %12.0f  %8.0f\n", k, t_multi, t_multi / k,
+			t_sines, t_sines / k);
+	}
+	return 0;
+}
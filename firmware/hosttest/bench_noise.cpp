@@ -0,0 +1,79 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Noise throughput, Msamples/s of 4 streams: AudioSynthNoiseMulti
+// against 4 AudioSynthNoiseWhite/AudioSynthNoisePink objects. Built
+// scalar, SSE4.1 and native like the tests. The outputs are not
+// connected, every update() allocates, fills and frees its blocks.
+
+#include "host.h"
+#include "synth_noisemulti.h"
+#include "synth_whitenoise.h"
+#include "synth_pinknoise.h"
+
+#define UPDATES	20000
+
+static AudioSynthNoiseMulti multi;
+static AudioSynthNoiseWhite white[4];
+static AudioSynthNoisePink pink[4];
+
+template <typename F>
+static double msamples(F f)
+{
+	double best = 1e30;
+
+	for (int run=0; run < 5; run++) {
+		uint64_t t0 = host_nanoseconds();
+		for (int i=0; i < UPDATES; i++) f();
+		best = std::min(best, (double)(host_nanoseconds() - t0));
+	}
+	return 4.0 * UPDATES * AUDIO_BLOCK_SAMPLES / best * 1e3;
+}
+
+int main(void)
+{
+	AudioMemory(20);
+	multi.amplitude(1.0);
+	for (int i=0; i < 4; i++) {
+		white[i].amplitude(1.0);
+		pink[i].amplitude(1.0);
+	}
+	printf("noise, 4 streams, Msamples/s (%s)\n",
+#if defined(__AVX2__)
+		"avx2"
+#elif defined(__SSE4_1__)
+		"sse4.1"
+#else
+		"scalar"
+#endif
+		);
+	multi.type(NOISE_WHITE);
+	double w1 = msamples([]() { multi.update(); });
+	double w4 = msamples([]() { for (int i=0; i < 4; i++) white[i].update(); });
+	multi.type(NOISE_PINK);
+	double p1 = msamples([]() { multi.update(); });
+	double p4 = msamples([]() { for (int i=0; i < 4; i++) pink[i].update(); });
+	printf("  white: multi %6.0f, 4 objects %6.0f\n", w1, w4);
+	printf("  pink:  multi %6.0f, 4 objects %6.0f\n", p1, p4);
+	return 0;
+}
@@ -0,0 +1,71 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Host cycles per block and memory of AudioEffectReverbFDN by quality
+// tier, next to AudioEffectReverb whose comb and allpass buffers are
+// part of the object.
+
+#include "host.h"
+#include "effect_reverb_fdn.h"
+#include "effect_reverb.h"
+
+int main(void)
+{
+	static const struct {
+		uint32_t lines;
+		bool modulation;
+	} tiers[] = {{4, false}, {8, false}, {8, true}, {16, false}, {16, true}};
+	static int16_t memory[AUDIO_REVERB_FDN_SAMPLES(16)];
+	static int16_t in[64 * AUDIO_BLOCK_SAMPLES];
+	static HostSource src;
+	static AudioEffectReverbFDN fdn;
+	static AudioEffectReverb old;
+	static AudioConnection c1(src, fdn), c2(src, old);
+	int b = 0;
+
+	AudioMemory(8);
+	host_sines_noise(in, sizeof(in) / sizeof(in[0]), AudioSampleRate());
+	printf("reverb, host cycles per block (median), memory in bytes\n");
+	printf("  lines  modulation  cycles  memory\n");
+	for (auto &t : tiers) {
+		uint32_t samples = AUDIO_REVERB_FDN_SAMPLES(t.lines);
+		fdn.begin(memory, samples, t.lines, t.modulation);
+		fdn.reverbTime(2.0f);
+		double cycles = host_cycles_median([&]() {
+			src.play(in + (b++ % 64) * AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+			src.update();
+			fdn.update();
+		}, 501);
+		printf("  %5u  %-10s  %6.0f  %6u\n", t.lines, t.modulation ? "on" : "off",
+			cycles, samples * (uint32_t)sizeof(int16_t));
+	}
+	fdn.end();
+	old.reverbTime(2.0f);
+	double cycles = host_cycles_median([&]() {
+		src.play(in + (b++ % 64) * AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+		src.update();
+		old.update();
+	}, 501);
+	printf("  AudioEffectReverb  %6.0f  %6u (in the object)\n", cycles, (uint32_t)sizeof(old));
+	return 0;
+}
@@ -0,0 +1,97 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Cost of measuring K tones: one AudioAnalyzeToneBank with K bins,
+// K AudioAnalyzeToneDetect objects and one AudioAnalyzeFFT1024 (whose
+// cost doesn't depend on K), for K = 1..32. The bins are harmonics of
+// 500 Hz over 10 periods, every detector gets the same window. Host
+// cycles per update, averaged over 2000 blocks so the end of window
+// work of the detectors and the FFT states are included.
+
+#include "host.h"
+#include "analyze_tonedetect.h"
+#include "analyze_fft1024.h"
+
+#define BLOCKS	2000
+#define MAXK	AUDIO_TONEBANK_BINS
+
+static int16_t in[(BLOCKS + 100) * AUDIO_BLOCK_SAMPLES];
+static HostSource src;
+static AudioAnalyzeToneBank bank;
+static AudioAnalyzeToneDetect tone[MAXK];
+static AudioAnalyzeFFT1024 fft;
+
+template <typename F>
+static double per_block_run(F f)
+{
+	uint64_t total = 0;
+
+	src.play(in, (BLOCKS + 100) * AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < BLOCKS + 100; b++) {
+		src.update();
+		uint32_t t0 = host_cycles();
+		f();
+		uint32_t t = host_cycles() - t0;
+		if (b >= 100) total += t;
+		// the objects not measured drop their block
+		bank.update();
+		for (int k=0; k < MAXK; k++) tone[k].update();
+		fft.update();
+	}
+	return (double)total / BLOCKS;
+}
+
+// average cycles of "f" per block, the source runs outside the timing,
+// best of 5 runs
+template <typename F>
+static double per_block(F f)
+{
+	double best = 1e30;
+
+	for (int run=0; run < 5; run++) {
+		best = std::min(best, per_block_run(f));
+	}
+	return best;
+}
+
+int main(void)
+{
+	static AudioConnection c1(src, bank), c2(src, fft);
+
+	AudioMemory(40);
+	for (int k=0; k < MAXK; k++) {
+		new AudioConnection(src, tone[k]);
+		tone[k].frequency(500.0f * (k + 1), 10 * (k + 1));
+	}
+	host_sines_noise(in, (BLOCKS + 100) * AUDIO_BLOCK_SAMPLES, 44117.64706);
+	double t_fft = per_block([]() { fft.update(); });
+	printf("K tones, host cycles per block: tone bank, K x tone detect, fft1024\n");
+	printf("   K     bank   detect      fft  detect/bank\n");
+	for (int k=1; k <= MAXK; k++) {
+		bank.harmonics(500.0f, k, 10);
+		double t_bank = per_block([]() { bank.update(); });
+		double t_tone = per_block([k]() { for (int i=0; i < k; i++) tone[i].update(); });
+		printf("  %2d %8.0f %8.0f %8.0f %8.2f\n", k, t_bank, t_tone, t_fft, t_tone / t_bank);
+	}
+	return 0;
+}
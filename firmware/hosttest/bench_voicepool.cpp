@@ -0,0 +1,89 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Host cycles per block of the drum and pluck voice pools by the number
+// of sounding voices, against as many single voice objects as the pool
+// has voices. The pool costs about a voice's render per sounding voice,
+// the single objects run whether they sound or not.
+
+#include "host.h"
+#include "synth_voicepool.h"
+#include "synth_simple_drum.h"
+#include "synth_karplusstrong.h"
+
+#define VOICES	16
+#define RUNS	101
+
+static const int counts[] = {0, 1, 2, 4, 8, 16};
+
+static void print(const char *name, int k, double pool, double singles)
+{
+	if (k) {
+		printf("  %-6s %6d  %8.0f  %9.0f  %12.0f\n", name, k, pool, pool / k, singles);
+	} else {
+		printf("  %-6s %6d  %8.0f  %9s  %12.0f\n", name, k, pool, "-", singles);
+	}
+}
+
+int main(void)
+{
+	static int32_t drum_memory[AUDIO_DRUM_POOL_WORDS(VOICES)];
+	static int32_t pluck_memory[AUDIO_KARPLUS_POOL_WORDS(VOICES)];
+	static AudioSynthSimpleDrumPool drums(drum_memory, VOICES);
+	static AudioSynthKarplusStrongPool plucks(pluck_memory, VOICES);
+	static AudioSynthSimpleDrum drum[VOICES];
+	static AudioSynthKarplusStrong pluck[VOICES];
+
+	AudioMemory(8);
+	printf("voice pools, host cycles per block (median), %d voices\n", VOICES);
+	printf("  synth  active      pool  per voice  %d objects\n", VOICES);
+	drums.length(5000);
+	for (int i=0; i < VOICES; i++) drum[i].length(5000);
+	for (int k : counts) {
+		drums.allOff();
+		for (int i=0; i < k; i++) {
+			drums.noteOn(100.0f + 20.0f * i);
+			drum[i].frequency(100.0f + 20.0f * i);
+			drum[i].noteOn();
+		}
+		double pool = host_cycles_median([&]() { drums.update(); }, RUNS);
+		double singles = host_cycles_median([&]() {
+			for (int i=0; i < VOICES; i++) drum[i].update();
+		}, RUNS);
+		print("drum", k, pool, singles);
+	}
+	for (int k : counts) {
+		plucks.allOff();
+		for (int i=0; i < VOICES; i++) pluck[i].noteOff(0.0f);
+		for (int i=0; i < k; i++) {
+			plucks.noteOn(110.0f + 10.0f * i, 0.8f);
+			pluck[i].noteOn(110.0f + 10.0f * i, 0.8f);
+		}
+		double pool = host_cycles_median([&]() { plucks.update(); }, RUNS);
+		double singles = host_cycles_median([&]() {
+			for (int i=0; i < VOICES; i++) pluck[i].update();
+		}, RUNS);
+		print("pluck", k, pool, singles);
+	}
+	return 0;
+}
@@ -0,0 +1,173 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Shared bits of the host tests: a source that plays a buffer into the
+// audio graph, a sink that records what reaches it, update() of the
+// whole graph and a few measurement helpers.
+
+#ifndef host_h_
+#define host_h_
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "Arduino.h"
+#include "AudioStream.h"
+
+void software_isr(void);
+
+// one software interrupt: every object's update() in construction order
+static inline void host_update(void) { software_isr(); }
+
+// plays "length" samples, then silence (no blocks)
+class HostSource : public AudioStream
+{
+public:
+	HostSource(void) : AudioStream(0, NULL), data(NULL), length(0), pos(0) { }
+	void play(const int16_t *samples, uint32_t n) {
+		data = samples;
+		length = n;
+		pos = 0;
+	}
+	virtual void update(void) {
+		audio_block_t *block;
+		uint32_t i;
+
+		if (pos >= length) return;
+		block = allocate();
+		if (!block) return;
+		for (i=0; i < AUDIO_BLOCK_SAMPLES; i++, pos++) {
+			block->data[i] = pos < length ? data[pos] : 0;
+		}
+		transmit(block);
+		release(block);
+	}
+private:
+	const int16_t *data;
+	uint32_t length;
+	uint32_t pos;
+};
+
+// records up to "length" samples from each of its inputs, a missing
+// block is recorded as silence
+template <unsigned char N = 1>
+class HostSink : public AudioStream
+{
+public:
+	HostSink(void) : AudioStream(N, inputQueueArray), length(0), pos(0) { }
+	void record(int16_t **buffers, uint32_t n) {
+		for (int i=0; i < N; i++) out[i] = buffers[i];
+		length = n;
+		pos = 0;
+	}
+	void record(int16_t *buffer, uint32_t n) { record(&buffer, n); }
+	uint32_t recorded(void) { return pos; }
+	virtual void update(void) {
+		audio_block_t *block;
+		uint32_t n = AUDIO_BLOCK_SAMPLES;
+
+		if (pos + n > length) n = length - pos;
+		for (int i=0; i < N; i++) {
+			block = receiveReadOnly(i);
+			if (n) {
+				if (block) memcpy(out[i] + pos, block->data, n * sizeof(int16_t));
+				else memset(out[i] + pos, 0, n * sizeof(int16_t));
+			}
+			if (block) release(block);
+		}
+		pos += n;
+	}
+private:
+	int16_t *out[N];
+	uint32_t length;
+	uint32_t pos;
+	audio_block_t *inputQueueArray[N];
+};
+
+static inline uint32_t host_memory_used(void) { return AudioStream::memory_used; }
+
+static int host_failures = 0;
+
+#define HOST_CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		if (host_failures++ < 20) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+// exit status of a test program
+static inline int host_result(const char *name)
+{
+	printf("%s: %s (%d failures)\n", name, host_failures ? "FAILED" : "ok", host_failures);
+	return host_failures ? 1 : 0;
+}
+
+// median cycles of "runs" calls, after a few to warm the caches
+template <typename F>
+static double host_cycles_median(F f, int runs = 2001)
+{
+	std::vector<uint32_t> t(runs);
+
+	for (int i=0; i < 16; i++) f();
+	for (int i=0; i < runs; i++) {
+		uint32_t t0 = host_cycles();
+		f();
+		t[i] = host_cycles() - t0;
+	}
+	std::sort(t.begin(), t.end());
+	return t[runs / 2];
+}
+
+// wall clock, for throughput figures
+static inline uint64_t host_nanoseconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// deterministic test signals
+static inline uint32_t host_rand(uint32_t *state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return *state;
+}
+
+static inline void host_sines_noise(int16_t *out, uint32_t n, double fs, uint32_t seed = 1)
+{
+	for (uint32_t i=0; i < n; i++) {
+		double t = i / fs;
+		double v = 9000.0 * sin(2.0 * M_PI * 300.0 * t)
+		  + 6000.0 * sin(2.0 * M_PI * 1100.0 * t + 1.0)
+		  + 3000.0 * sin(2.0 * M_PI * 3700.0 * t + 2.0);
+		v += (int32_t)(host_rand(&seed) >> 20) - 2048;
+		out[i] = (int16_t)lrint(v);
+	}
+}
+
+#endif
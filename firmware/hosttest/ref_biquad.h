@@ -0,0 +1,105 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioFilterBiquad as it was before the bank, for test_biquadbank and
+// bench_biquad: four stages with the coefficients and state interleaved,
+// coefficient changes take effect at once.
+
+#ifndef ref_biquad_h_
+#define ref_biquad_h_
+
+#include "dspinst.h"
+
+class ReferenceBiquad
+{
+public:
+	ReferenceBiquad(void) {
+		for (int i=0; i < 32; i++) definition[i] = 0;
+	}
+	void setCoefficients(uint32_t stage, const int *coefficients) {
+		if (stage >= 4) return;
+		int32_t *dest = definition + (stage << 3);
+		if (stage > 0) *(dest - 1) |= 0x80000000;
+		*dest++ = *coefficients++;
+		*dest++ = *coefficients++;
+		*dest++ = *coefficients++;
+		*dest++ = *coefficients++ * -1;
+		*dest++ = *coefficients++ * -1;
+		dest += 2;
+		*dest   &= 0x80000000;
+	}
+	void setCoefficients(uint32_t stage, const double *coefficients) {
+		int coef[5];
+		for (int i=0; i < 5; i++) coef[i] = coefficients[i] * 1073741824.0;
+		setCoefficients(stage, coef);
+	}
+	// one block in place
+	void filter(int16_t *block) {
+		int32_t b0, b1, b2, a1, a2, sum;
+		uint32_t in2, out2, bprev, aprev, flag;
+		uint32_t *data, *end;
+		int32_t *state;
+
+		end = (uint32_t *)block + AUDIO_BLOCK_SAMPLES/2;
+		state = (int32_t *)definition;
+		do {
+			b0 = *state++;
+			b1 = *state++;
+			b2 = *state++;
+			a1 = *state++;
+			a2 = *state++;
+			bprev = *state++;
+			aprev = *state++;
+			sum = *state & 0x3FFF;
+			data = end - AUDIO_BLOCK_SAMPLES/2;
+			do {
+				in2 = *data;
+				sum = signed_multiply_accumulate_32x16b(sum, b0, in2);
+				sum = signed_multiply_accumulate_32x16t(sum, b1, bprev);
+				sum = signed_multiply_accumulate_32x16b(sum, b2, bprev);
+				sum = signed_multiply_accumulate_32x16t(sum, a1, aprev);
+				sum = signed_multiply_accumulate_32x16b(sum, a2, aprev);
+				out2 = signed_saturate_rshift(sum, 16, 14);
+				sum &= 0x3FFF;
+				sum = signed_multiply_accumulate_32x16t(sum, b0, in2);
+				sum = signed_multiply_accumulate_32x16b(sum, b1, in2);
+				sum = signed_multiply_accumulate_32x16t(sum, b2, bprev);
+				sum = signed_multiply_accumulate_32x16b(sum, a1, out2);
+				sum = signed_multiply_accumulate_32x16t(sum, a2, aprev);
+				bprev = in2;
+				aprev = pack_16b_16b(
+					signed_saturate_rshift(sum, 16, 14), out2);
+				sum &= 0x3FFF;
+				*data++ = aprev;
+			} while (data < end);
+			flag = *state & 0x80000000;
+			*state++ = sum | flag;
+			*(state-2) = aprev;
+			*(state-3) = bprev;
+		} while (flag);
+	}
+private:
+	int32_t definition[32];
+};
+
+#endif
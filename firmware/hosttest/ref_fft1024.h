@@ -0,0 +1,84 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioAnalyzeFFT1024 as it was before its work was spread over the
+// hop, for test_fft1024 and bench_fft1024: window, 512 point CFFT,
+// split step and averaging in one call.
+
+#ifndef ref_fft1024_h_
+#define ref_fft1024_h_
+
+#include "analyze_fft1024.h"
+#include "sqrt_integer.h"
+#include "dspblock.h"
+#include "rfft_split.h"
+
+// one spectrum per call on the last 1024 samples
+class ReferenceFFT1024
+{
+public:
+	ReferenceFFT1024(const int16_t *w) : window(w), count(0), naverage(1), avgshift(0) {
+		arm_cfft_radix2_init_q15(&fft_inst, 512, 0, 1);
+	}
+	void averageTogether(uint8_t n) { naverage = n; avgshift = 0; }
+	void averageExponential(uint8_t shift) { avgshift = shift; }
+	// true when a new output is ready
+	bool frame(const int16_t *samples) {
+		if (window) block_window(buffer, samples, window, 1024);
+		else memcpy(buffer, samples, sizeof(buffer));
+		arm_cfft_radix2_q15(&fft_inst, buffer);
+		for (int i=0; i < 512; i++) {
+			uint32_t magsq = rfft_split_magsq(buffer, i, 512, 1);
+			if (avgshift) {
+				uint32_t avg = sum[i];
+				// steps rounded up, so a bin that goes quiet decays to 0
+				uint32_t round = (1 << avgshift) - 1;
+				if (magsq >= avg) avg += (magsq - avg + round) >> avgshift;
+				else avg -= (avg - magsq + round) >> avgshift;
+				sum[i] = avg;
+				output[i] = sqrt_uint32_approx(avg);
+			} else {
+				magsq /= naverage;
+				if (count == 0) sum[i] = magsq;
+				else sum[i] += magsq;
+				if (count + 1 >= naverage) output[i] = sqrt_uint32_approx(sum[i]);
+			}
+		}
+		if (avgshift || ++count >= naverage) {
+			count = 0;
+			return true;
+		}
+		return false;
+	}
+	uint16_t output[512];
+private:
+	const int16_t *window;
+	int16_t buffer[1024] __attribute__ ((aligned (4)));
+	uint32_t sum[512];
+	uint8_t count;
+	uint8_t naverage;
+	uint8_t avgshift;
+	arm_cfft_radix2_instance_q15 fft_inst;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Pete (El Supremo)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioEffectChorus and AudioEffectFlange as they were before they ran on
+// AudioModDelay, for test_moddelay: the loops of their update(), on one
+// block in place.
+
+#ifndef ref_moddelay_h_
+#define ref_moddelay_h_
+
+#include "arm_math.h"
+
+class ReferenceChorus
+{
+public:
+	ReferenceChorus(void) : l_delayline(NULL) { }
+	bool begin(short *delayline, int d_length, int n_chorus) {
+		l_delayline = NULL;
+		delay_length = 0;
+		l_circ_idx = 0;
+		if (delayline == NULL || d_length < 10 || n_chorus < 1) return false;
+		l_delayline = delayline;
+		delay_length = d_length/2;
+		num_chorus = n_chorus;
+		return true;
+	}
+	void process(int16_t *bp) {
+		int sum, c_idx;
+
+		if (l_delayline == NULL) return;
+		if (num_chorus <= 1) {
+			for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+				if (++l_circ_idx >= delay_length) l_circ_idx = 0;
+				l_delayline[l_circ_idx] = *bp++;
+			}
+			return;
+		}
+		uint32_t tmp = delay_length/(num_chorus - 1) - 1;
+		for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			if (++l_circ_idx >= delay_length) l_circ_idx = 0;
+			l_delayline[l_circ_idx] = *bp;
+			sum = 0;
+			c_idx = l_circ_idx;
+			for (int k = 0; k < num_chorus; k++) {
+				sum += l_delayline[c_idx];
+				c_idx -= tmp;
+				if (c_idx < 0) c_idx += delay_length;
+			}
+			*bp++ = sum/num_chorus;
+		}
+	}
+private:
+	short *l_delayline;
+	int l_circ_idx;
+	int num_chorus;
+	int delay_length;
+};
+
+class ReferenceFlange
+{
+public:
+	ReferenceFlange(void) : l_delayline(NULL) { }
+	bool begin(short *delayline, int d_length, int delay_offset, int d_depth, float delay_rate) {
+		bool all_ok = true;
+
+		delay_length = d_length/2;
+		l_delayline = delayline;
+		delay_depth = d_depth;
+		l_delay_rate_index = 0;
+		l_circ_idx = 0;
+		delay_rate_incr = (delay_rate * 2147483648.0)/ AudioSampleRate();
+		delay_offset_idx = delay_offset;
+		if (delay_offset_idx < -1) {
+			delay_offset_idx = 0;
+			all_ok = false;
+		}
+		if (delay_offset_idx >= delay_length) {
+			delay_offset_idx = delay_length - 1;
+			all_ok = false;
+		}
+		return all_ok;
+	}
+	void process(int16_t *bp) {
+		int idx, idx1;
+		short frac;
+
+		if (l_delayline == NULL) return;
+		for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			if (++l_circ_idx >= delay_length) l_circ_idx = 0;
+			l_delayline[l_circ_idx] = *bp;
+			frac = arm_sin_q15((q15_t)((l_delay_rate_index >> 16) & 0x7fff));
+			idx = (frac * delay_depth) >> 15;
+			idx = l_circ_idx - (delay_offset_idx + idx);
+			if (idx < 0) idx += delay_length;
+			if (idx >= delay_length) idx -= delay_length;
+			if (frac < 0) idx1 = idx - 1;
+			else idx1 = idx + 1;
+			if (idx1 < 0) idx1 += delay_length;
+			if (idx1 >= delay_length) idx1 -= delay_length;
+			frac = (l_delay_rate_index >> 1) & 0x7fff;
+			frac = (((int)(l_delayline[idx1] - l_delayline[idx])*frac) >> 15);
+			*bp++ = (l_delayline[l_circ_idx] + l_delayline[idx] + frac)/2;
+			l_delay_rate_index += delay_rate_incr;
+			if (l_delay_rate_index & 0x80000000) l_delay_rate_index &= 0x7fffffff;
+		}
+	}
+private:
+	short *l_delayline;
+	int delay_length;
+	short l_circ_idx;
+	int delay_depth;
+	int delay_offset_idx;
+	int delay_rate_incr;
+	unsigned int l_delay_rate_index;
+};
+
+#endif
@@ -0,0 +1,278 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <math.h>
+#include "arm_math.h"
+
+#define TWIDDLE_LEN	4096
+
+static q15_t twiddle_q15[TWIDDLE_LEN * 3 / 2];
+static q31_t twiddle_q31[TWIDDLE_LEN * 3 / 2];
+
+static q31_t sat_q31(double v)
+{
+	if (v >= 2147483647.0) return 2147483647;
+	if (v <= -2147483648.0) return -2147483647 - 1;
+	return (q31_t)lrint(v);
+}
+
+static q15_t sat_q15(double v)
+{
+	q31_t out = sat_q31(v * 32768.0);
+	return out > 32767 ? 32767 : out < -32768 ? -32768 : out;
+}
+
+// cos, sin pairs for 4096 points, like twiddleCoef_4096_q15/q31
+static void twiddle_init(void)
+{
+	static int done = 0;
+	int i;
+
+	if (done) return;
+	for (i=0; i < TWIDDLE_LEN * 3 / 4; i++) {
+		double c = cos(2.0 * M_PI * i / TWIDDLE_LEN);
+		double s = sin(2.0 * M_PI * i / TWIDDLE_LEN);
+		twiddle_q15[2 * i] = sat_q15(c);
+		twiddle_q15[2 * i + 1] = sat_q15(s);
+		twiddle_q31[2 * i] = sat_q31(c * 2147483648.0);
+		twiddle_q31[2 * i + 1] = sat_q31(s * 2147483648.0);
+	}
+	done = 1;
+}
+
+static int fft_len_ok(uint16_t fftLen)
+{
+	return fftLen >= 4 && fftLen <= TWIDDLE_LEN && (fftLen & (fftLen - 1)) == 0;
+}
+
+arm_status arm_cfft_radix2_init_q15(arm_cfft_radix2_instance_q15 *S,
+	uint16_t fftLen, uint8_t ifftFlag, uint8_t bitReverseFlag)
+{
+	if (!fft_len_ok(fftLen)) return ARM_MATH_ARGUMENT_ERROR;
+	twiddle_init();
+	S->fftLen = fftLen;
+	S->ifftFlag = ifftFlag;
+	S->bitReverseFlag = bitReverseFlag;
+	return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_cfft_radix2_init_q31(arm_cfft_radix2_instance_q31 *S,
+	uint16_t fftLen, uint8_t ifftFlag, uint8_t bitReverseFlag)
+{
+	if (!fft_len_ok(fftLen)) return ARM_MATH_ARGUMENT_ERROR;
+	twiddle_init();
+	S->fftLen = fftLen;
+	S->ifftFlag = ifftFlag;
+	S->bitReverseFlag = bitReverseFlag;
+	return ARM_MATH_SUCCESS;
+}
+
+#define BITREVERSE(type) \
+static void bitreverse_##type(type *p, uint32_t n) \
+{ \
+	uint32_t i, j, bit; \
+	type t; \
+	for (i=1, j=0; i < n; i++) { \
+		for (bit = n >> 1; j & bit; bit >>= 1) j ^= bit; \
+		j |= bit; \
+		if (i < j) { \
+			t = p[2 * i]; p[2 * i] = p[2 * j]; p[2 * j] = t; \
+			t = p[2 * i + 1]; p[2 * i + 1] = p[2 * j + 1]; p[2 * j + 1] = t; \
+		} \
+	} \
+}
+BITREVERSE(q15_t)
+BITREVERSE(q31_t)
+
+static q15_t mul_q15(q15_t x, q15_t c)
+{
+	return (q15_t)(((q31_t)x * c) >> 16);
+}
+
+// arm_radix2_butterfly_q15 / arm_radix2_butterfly_inverse_q15: the first
+// stage halves the inputs before the butterfly, every stage but the last
+// halves its outputs, 1/N overall
+void arm_cfft_radix2_q15(const arm_cfft_radix2_instance_q15 *S, q15_t *p)
+{
+	uint32_t n = S->fftLen, n1, n2 = n, i, j, l, ia, step = TWIDDLE_LEN / n;
+	int sgn = S->ifftFlag ? -1 : 1;
+	q15_t xt, yt, c, s;
+
+	n2 >>= 1;
+	for (i=0, ia=0; i < n2; i++, ia += step) {
+		c = twiddle_q15[2 * ia];
+		s = twiddle_q15[2 * ia + 1] * sgn;
+		l = i + n2;
+		xt = (p[2 * i] >> 1) - (p[2 * l] >> 1);
+		p[2 * i] = ((p[2 * i] >> 1) + (p[2 * l] >> 1)) >> 1;
+		yt = (p[2 * i + 1] >> 1) - (p[2 * l + 1] >> 1);
+		p[2 * i + 1] = ((p[2 * l + 1] >> 1) + (p[2 * i + 1] >> 1)) >> 1;
+		p[2 * l] = mul_q15(xt, c) + mul_q15(yt, s);
+		p[2 * l + 1] = mul_q15(yt, c) - mul_q15(xt, s);
+	}
+	step <<= 1;
+	while (n2 > 2) {
+		n1 = n2;
+		n2 >>= 1;
+		for (j=0, ia=0; j < n2; j++, ia += step) {
+			c = twiddle_q15[2 * ia];
+			s = twiddle_q15[2 * ia + 1] * sgn;
+			for (i=j; i < n; i += n1) {
+				l = i + n2;
+				xt = p[2 * i] - p[2 * l];
+				p[2 * i] = (p[2 * i] + p[2 * l]) >> 1;
+				yt = p[2 * i + 1] - p[2 * l + 1];
+				p[2 * i + 1] = (p[2 * l + 1] + p[2 * i + 1]) >> 1;
+				p[2 * l] = mul_q15(xt, c) + mul_q15(yt, s);
+				p[2 * l + 1] = mul_q15(yt, c) - mul_q15(xt, s);
+			}
+		}
+		step <<= 1;
+	}
+	n1 = n2;
+	n2 >>= 1;
+	for (i=0; i < n; i += n1) {
+		l = i + n2;
+		xt = p[2 * i] - p[2 * l];
+		p[2 * i] = p[2 * i] + p[2 * l];
+		yt = p[2 * i + 1] - p[2 * l + 1];
+		p[2 * i + 1] = p[2 * l + 1] + p[2 * i + 1];
+		p[2 * l] = xt;
+		p[2 * l + 1] = yt;
+	}
+	if (S->bitReverseFlag) bitreverse_q15_t(p, n);
+}
+
+static q31_t mul_q31(q31_t x, q31_t c)
+{
+	return (q31_t)(((q63_t)x * c + 0x80000000LL) >> 32);
+}
+
+// arm_radix2_butterfly_q31, same scaling as the q15 one
+void arm_cfft_radix2_q31(const arm_cfft_radix2_instance_q31 *S, q31_t *p)
+{
+	uint32_t n = S->fftLen, n1, n2 = n, i, j, l, ia, step = TWIDDLE_LEN / n;
+	int sgn = S->ifftFlag ? -1 : 1;
+	q31_t xt, yt, c, s;
+
+	n2 >>= 1;
+	for (i=0, ia=0; i < n2; i++, ia += step) {
+		c = twiddle_q31[2 * ia];
+		s = sgn < 0 ? -twiddle_q31[2 * ia + 1] : twiddle_q31[2 * ia + 1];
+		l = i + n2;
+		xt = (p[2 * i] >> 1) - (p[2 * l] >> 1);
+		p[2 * i] = ((p[2 * i] >> 1) + (p[2 * l] >> 1)) >> 1;
+		yt = (p[2 * i + 1] >> 1) - (p[2 * l + 1] >> 1);
+		p[2 * i + 1] = ((p[2 * l + 1] >> 1) + (p[2 * i + 1] >> 1)) >> 1;
+		p[2 * l] = mul_q31(xt, c) + mul_q31(yt, s);
+		p[2 * l + 1] = mul_q31(yt, c) - mul_q31(xt, s);
+	}
+	step <<= 1;
+	while (n2 > 2) {
+		n1 = n2;
+		n2 >>= 1;
+		for (j=0, ia=0; j < n2; j++, ia += step) {
+			c = twiddle_q31[2 * ia];
+			s = sgn < 0 ? -twiddle_q31[2 * ia + 1] : twiddle_q31[2 * ia + 1];
+			for (i=j; i < n; i += n1) {
+				l = i + n2;
+				xt = p[2 * i] - p[2 * l];
+				p[2 * i] = (p[2 * i] + p[2 * l]) >> 1;
+				yt = p[2 * i + 1] - p[2 * l + 1];
+				p[2 * i + 1] = (p[2 * l + 1] + p[2 * i + 1]) >> 1;
+				p[2 * l] = mul_q31(xt, c) + mul_q31(yt, s);
+				p[2 * l + 1] = mul_q31(yt, c) - mul_q31(xt, s);
+			}
+		}
+		step <<= 1;
+	}
+	n1 = n2;
+	n2 >>= 1;
+	for (i=0; i < n; i += n1) {
+		l = i + n2;
+		xt = p[2 * i] - p[2 * l];
+		p[2 * i] = p[2 * i] + p[2 * l];
+		yt = p[2 * i + 1] - p[2 * l + 1];
+		p[2 * i + 1] = p[2 * l + 1] + p[2 * i + 1];
+		p[2 * l] = xt;
+		p[2 * l + 1] = yt;
+	}
+	if (S->bitReverseFlag) bitreverse_q31_t(p, n);
+}
+
+// input 0 to 1.0 is one turn
+q31_t arm_sin_q31(q31_t x)
+{
+	return sat_q31(sin(2.0 * M_PI * (double)(uint32_t)x / 2147483648.0) * 2147483648.0);
+}
+
+q15_t arm_sin_q15(q15_t x)
+{
+	return sat_q15(sin(2.0 * M_PI * (double)(uint16_t)x / 32768.0));
+}
+
+void arm_shift_q31(q31_t *pSrc, int8_t shiftBits, q31_t *pDst, uint32_t blockSize)
+{
+	uint32_t i;
+
+	for (i=0; i < blockSize; i++) {
+		if (shiftBits >= 0) pDst[i] = sat_q31((double)pSrc[i] * (double)(1u << shiftBits));
+		else pDst[i] = pSrc[i] >> -shiftBits;
+	}
+}
+
+void arm_add_q31(q31_t *pSrcA, q31_t *pSrcB, q31_t *pDst, uint32_t blockSize)
+{
+	uint32_t i;
+
+	for (i=0; i < blockSize; i++) {
+		pDst[i] = sat_q31((double)pSrcA[i] + pSrcB[i]);
+	}
+}
+
+void arm_float_to_q31(float32_t *pSrc, q31_t *pDst, uint32_t blockSize)
+{
+	uint32_t i;
+
+	for (i=0; i < blockSize; i++) {
+		pDst[i] = sat_q31(pSrc[i] * 2147483648.0);
+	}
+}
+
+void arm_q15_to_q31(q15_t *pSrc, q31_t *pDst, uint32_t blockSize)
+{
+	uint32_t i;
+
+	for (i=0; i < blockSize; i++) {
+		pDst[i] = (q31_t)pSrc[i] << 16;
+	}
+}
+
+void arm_q31_to_q15(q31_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+	uint32_t i;
+
+	for (i=0; i < blockSize; i++) {
+		pDst[i] = (q15_t)(pSrc[i] >> 16);
+	}
+}
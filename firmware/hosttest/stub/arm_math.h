@@ -0,0 +1,82 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Host stand-in for the few CMSIS-DSP functions the audio library calls.
+// The FFTs are the CMSIS radix 2 butterflies written out in C, with the
+// same 1/N scaling, so the library code around them sees the same ranges
+// as on a Teensy. They are not guaranteed bit exact with the Cortex-M4
+// library builds.
+
+#ifndef arm_math_h_
+#define arm_math_h_
+
+#include <stdint.h>
+#include <math.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+
+typedef enum {
+	ARM_MATH_SUCCESS = 0,
+	ARM_MATH_ARGUMENT_ERROR = -1
+} arm_status;
+
+typedef struct {
+	uint16_t fftLen;
+	uint8_t ifftFlag;
+	uint8_t bitReverseFlag;
+} arm_cfft_radix2_instance_q15;
+
+typedef struct {
+	uint16_t fftLen;
+	uint8_t ifftFlag;
+	uint8_t bitReverseFlag;
+} arm_cfft_radix2_instance_q31;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+arm_status arm_cfft_radix2_init_q15(arm_cfft_radix2_instance_q15 *S,
+	uint16_t fftLen, uint8_t ifftFlag, uint8_t bitReverseFlag);
+void arm_cfft_radix2_q15(const arm_cfft_radix2_instance_q15 *S, q15_t *pSrc);
+arm_status arm_cfft_radix2_init_q31(arm_cfft_radix2_instance_q31 *S,
+	uint16_t fftLen, uint8_t ifftFlag, uint8_t bitReverseFlag);
+void arm_cfft_radix2_q31(const arm_cfft_radix2_instance_q31 *S, q31_t *pSrc);
+
+q31_t arm_sin_q31(q31_t x);
+q15_t arm_sin_q15(q15_t x);
+
+void arm_shift_q31(q31_t *pSrc, int8_t shiftBits, q31_t *pDst, uint32_t blockSize);
+void arm_add_q31(q31_t *pSrcA, q31_t *pSrcB, q31_t *pDst, uint32_t blockSize);
+void arm_float_to_q31(float32_t *pSrc, q31_t *pDst, uint32_t blockSize);
+void arm_q15_to_q31(q15_t *pSrc, q31_t *pDst, uint32_t blockSize);
+void arm_q31_to_q15(q31_t *pSrc, q15_t *pDst, uint32_t blockSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
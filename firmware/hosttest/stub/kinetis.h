@@ -0,0 +1,70 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Host stand-in for the parts of the Teensy core kinetis.h the audio
+// library uses: interrupt masking does nothing and the DWT cycle counter
+// reads the host time stamp counter.
+
+#ifndef kinetis_h_
+#define kinetis_h_
+
+#include <stdint.h>
+#include <time.h>
+
+#ifndef F_CPU
+#define F_CPU 96000000
+#endif
+#define F_BUS 48000000
+
+#define DMAMEM
+#define FASTRUN
+
+#define IRQ_SOFTWARE		0
+#define NVIC_SET_PENDING(n)	((void)(n))
+#define NVIC_SET_PRIORITY(n, p)	((void)(n), (void)(p))
+#define NVIC_ENABLE_IRQ(n)	((void)(n))
+#define NVIC_DISABLE_IRQ(n)	((void)(n))
+
+static inline void __disable_irq(void) { }
+static inline void __enable_irq(void) { }
+
+static inline uint32_t host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (uint32_t)__builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+#endif
+}
+
+static volatile uint32_t host_demcr __attribute__((unused));
+static volatile uint32_t host_dwt_ctrl __attribute__((unused));
+#define ARM_DEMCR		host_demcr
+#define ARM_DEMCR_TRCENA	(1 << 24)
+#define ARM_DWT_CTRL		host_dwt_ctrl
+#define ARM_DWT_CTRL_CYCCNTENA	(1 << 0)
+#define ARM_DWT_CYCCNT		(host_cycles())
+
+#endif
@@ -0,0 +1,232 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioFilterBiquadBank against the biquad it replaced and against
+// double precision: the 16 bit mode with instant coefficient changes is
+// bit exact with the old AudioFilterBiquad, the 32 bit mode is within
+// output rounding of double math where the 16 bit state is not, and a
+// coefficient ramp follows a double model of the same integer steps.
+
+#include "host.h"
+#include "filter_biquad.h"
+#include "ref_biquad.h"
+
+#define FS		88235.29412
+#define BLOCKS		2000
+#define SWITCH		1000	// block where the coefficients change
+#define LENGTH		(BLOCKS * AUDIO_BLOCK_SAMPLES)
+#define RAMP		256	// samples
+
+static void lowpass(double f, double q, double *c)
+{
+	double w0 = 2 * M_PI * f / FS, cs = cos(w0), alpha = sin(w0) / (2 * q);
+	double a0 = 1 + alpha;
+
+	c[0] = (1 - cs) / 2 / a0;
+	c[1] = (1 - cs) / a0;
+	c[2] = c[0];
+	c[3] = -2 * cs / a0;
+	c[4] = (1 - alpha) / a0;
+}
+
+static void peak(double f, double q, double db, double *c)
+{
+	double a = pow(10.0, db / 40), w0 = 2 * M_PI * f / FS;
+	double alpha = sin(w0) / (2 * q), a0 = 1 + alpha / a;
+
+	c[0] = (1 + alpha * a) / a0;
+	c[1] = -2 * cos(w0) / a0;
+	c[2] = (1 - alpha * a) / a0;
+	c[3] = c[1];
+	c[4] = (1 - alpha / a) / a0;
+}
+
+// Q30 as setCoefficients(double *) rounds them
+static void quantize(const double *c, int *q)
+{
+	for (int k=0; k < 5; k++) q[k] = c[k] * 1073741824.0;
+}
+
+// direct form 1 in double on Q30 coefficients
+struct DoubleBiquad {
+	double x1, x2, y1, y2;
+	double run(const int *q, double x) {
+		double y = (q[0] * x + q[1] * x1 + q[2] * x2 - q[3] * y1 - q[4] * y2)
+		  / 1073741824.0;
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = y;
+		return y;
+	}
+};
+
+static double rms(double sum2, long n) { return sqrt(sum2 / n); }
+
+int main(void)
+{
+	static int16_t in[LENGTH], work[LENGTH];
+	static int16_t quad4[LENGTH], bank4[LENGTH], slow16[LENGTH], slow32[LENGTH], ramped[LENGTH];
+	static int32_t mem4[AUDIO_BIQUAD_WORDS(4)], mem16[AUDIO_BIQUAD_WORDS(1)];
+	static int32_t mem32[AUDIO_BIQUAD_WORDS(1)], memr[AUDIO_BIQUAD_WORDS(1)];
+	static HostSource src;
+	static AudioFilterBiquad quad;
+	static AudioFilterBiquadBank bank(mem4, 4), lp16(mem16, 1), lp32(mem32, 1), ramp(memr, 1);
+	static HostSink<5> sink;
+	static AudioConnection c1(src, quad), c2(src, bank), c3(src, lp16), c4(src, lp32), c5(src, ramp);
+	static AudioConnection c6(quad, 0, sink, 0), c7(bank, 0, sink, 1), c8(lp16, 0, sink, 2);
+	static AudioConnection c9(lp32, 0, sink, 3), c10(ramp, 0, sink, 4);
+	static ReferenceBiquad ref;
+	int16_t *out[5] = {quad4, bank4, slow16, slow32, ramped};
+	double set[2][4][5], slow[5], from[5], to[5];
+	int q[5], qfrom[5], qto[5], step[5];
+	uint32_t seed = 1;
+
+	AudioMemory(16);
+	for (int i=0; i < LENGTH; i++) in[i] = (int16_t)((int32_t)host_rand(&seed) >> 19);
+	lowpass(6000, 0.7, set[0][0]);
+	peak(300, 2.0, -6, set[0][1]);
+	peak(2500, 1.0, 4, set[0][2]);
+	lowpass(15000, 1.2, set[0][3]);
+	lowpass(2000, 0.9, set[1][0]);
+	peak(800, 4.0, 6, set[1][1]);
+	peak(5000, 0.7, -3, set[1][2]);
+	lowpass(12000, 0.7, set[1][3]);
+	lowpass(20, 2.0, slow);
+	lowpass(200, 0.7, from);
+	lowpass(8000, 0.7, to);
+
+	quad.setInterpolation(0);
+	bank.setInterpolation(0);
+	lp16.setInterpolation(0);
+	lp32.setInterpolation(0);
+	ramp.setInterpolation(0);
+	for (int s=0; s < 4; s++) {
+		quad.setCoefficients(s, set[0][s]);
+		bank.setCoefficients(s, set[0][s]);
+		ref.setCoefficients(s, set[0][s]);
+	}
+	lp16.setCoefficients(0, slow);
+	lp32.setCoefficients(0, slow);
+	lp32.setPrecision(0, true);
+	ramp.setCoefficients(0, from);
+	ramp.setPrecision(0, true);
+	ramp.setInterpolation(RAMP);
+
+	memcpy(work, in, sizeof(work));
+	src.play(in, LENGTH);
+	sink.record(out, LENGTH);
+	for (int b=0; b < BLOCKS; b++) {
+		if (b == SWITCH) {
+			for (int s=0; s < 4; s++) {
+				quad.setCoefficients(s, set[1][s]);
+				bank.setCoefficients(s, set[1][s]);
+				ref.setCoefficients(s, set[1][s]);
+			}
+			ramp.setCoefficients(0, to);
+		}
+		ref.filter(work + b * AUDIO_BLOCK_SAMPLES);
+		host_update();
+	}
+
+	// 16 bit mode, 4 stages: the old code. The old setCoefficients()
+	// also cleared the rounding carry, the bank keeps it, so after the
+	// change both are compared with double math instead.
+	DoubleBiquad cascade[4] = {};
+	int before[2] = {0, 0};
+	double eold = 0, enew[2] = {0, 0};
+	long n = 0;
+	for (int i=0; i < LENGTH; i++) {
+		int16_t *o[2] = {bank4, quad4};
+		double y = in[i];
+		for (int s=0; s < 4; s++) {
+			quantize(set[i < SWITCH * AUDIO_BLOCK_SAMPLES ? 0 : 1][s], q);
+			y = cascade[s].run(q, y);
+		}
+		for (int k=0; k < 2; k++) {
+			if (i < SWITCH * AUDIO_BLOCK_SAMPLES) before[k] += o[k][i] != work[i];
+			else enew[k] += (o[k][i] - y) * (o[k][i] - y);
+		}
+		if (i < SWITCH * AUDIO_BLOCK_SAMPLES) continue;
+		eold += (work[i] - y) * (work[i] - y);
+		n++;
+	}
+	printf("  4 stages, 16 bit: %d/%d samples differ before the change, after it %.2f/%.2f "
+		"LSB rms from double, old %.2f\n", before[0], before[1], rms(enew[0], n),
+		rms(enew[1], n), rms(eold, n));
+	HOST_CHECK(before[0] == 0 && before[1] == 0, "%d bank, %d AudioFilterBiquad samples "
+		"differ from the old biquad", before[0], before[1]);
+	HOST_CHECK(rms(enew[0], n) < 1.1 * rms(eold, n) && rms(enew[1], n) < 1.1 * rms(eold, n),
+		"after the change %.2f bank, %.2f AudioFilterBiquad LSB rms, old %.2f",
+		rms(enew[0], n), rms(enew[1], n), rms(eold, n));
+
+	// 20 Hz Q2 lowpass, both states against double math
+	DoubleBiquad d16 = {0, 0, 0, 0}, dr = {0, 0, 0, 0};
+	double e16 = 0, e32 = 0, er = 0, ermax = 0;
+	n = 0;
+	quantize(slow, q);
+	for (int i=0; i < LENGTH; i++) {
+		double y = d16.run(q, in[i]);
+		if (i < 100 * AUDIO_BLOCK_SAMPLES) continue;
+		e16 += (slow16[i] - y) * (slow16[i] - y);
+		e32 += (slow32[i] - y) * (slow32[i] - y);
+		n++;
+	}
+	printf("  20 Hz Q2 lowpass at %.0f Hz: 16 bit state %.2f LSB rms, 32 bit state %.2f LSB rms\n",
+		FS, rms(e16, n), rms(e32, n));
+	HOST_CHECK(rms(e32, n) < 0.5, "32 bit state: %.2f LSB rms from double", rms(e32, n));
+	HOST_CHECK(rms(e16, n) > 20 * rms(e32, n), "16 bit state only %.2f LSB rms from double",
+		rms(e16, n));
+
+	// the ramp: integer steps every 2 samples from the old set, then the
+	// target exactly
+	quantize(from, qfrom);
+	quantize(to, qto);
+	for (int k=0; k < 5; k++) {
+		if (k >= 3) {
+			qfrom[k] = -qfrom[k];
+			qto[k] = -qto[k];
+		}
+		step[k] = ((int64_t)qto[k] - qfrom[k]) / (RAMP / 2);
+	}
+	n = 0;
+	for (int i=0; i < LENGTH; i++) {
+		int pair = (i - SWITCH * AUDIO_BLOCK_SAMPLES) / 2;
+		for (int k=0; k < 5; k++) {
+			int32_t c = (i < SWITCH * AUDIO_BLOCK_SAMPLES) ? qfrom[k] :
+			  (pair < RAMP / 2) ? qfrom[k] + pair * step[k] : qto[k];
+			q[k] = (k >= 3) ? -c : c;
+		}
+		double y = dr.run(q, in[i]);
+		if (i < (SWITCH - 2) * AUDIO_BLOCK_SAMPLES || i > (SWITCH + 10) * AUDIO_BLOCK_SAMPLES) continue;
+		double e = ramped[i] - y;
+		er += e * e;
+		if (fabs(e) > ermax) ermax = fabs(e);
+		n++;
+	}
+	printf("  200 Hz -> 8 kHz lowpass over %d samples: %.2f LSB rms, %.2f max from the model\n",
+		RAMP, rms(er, n), ermax);
+	HOST_CHECK(rms(er, n) < 0.5 && ermax < 2.0, "ramp: %.2f LSB rms, %.2f max from the model",
+		rms(er, n), ermax);
+	return host_result("biquad bank");
+}
@@ -0,0 +1,113 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioFilterConvolution against a double precision direct convolution
+// with the same q15 impulse response: rooms at -6 and -30 dB and a
+// single impulse, 64 to 4096 taps, noise and then a 20000 peak sine in,
+// then silence for the tail. Samples where the exact result clips are
+// left out.
+
+#include "host.h"
+#include "filter_convolution.h"
+
+#define MAX_TAPS	4096
+
+static int32_t memory[AUDIO_CONVOLUTION_WORDS(MAX_TAPS)];
+static HostSource src;
+static AudioFilterConvolution conv;
+static HostSink<> sink;
+static AudioConnection c1(src, conv), c2(conv, sink);
+
+static double gauss(uint32_t *seed)
+{
+	double u = ((host_rand(seed) >> 8) + 1.0) / 16777217.0;
+	double v = (host_rand(seed) >> 8) / 16777216.0;
+	return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+// kind 0: room at -6 dB, 1: one impulse, 2: room at -30 dB
+static void make_ir(int16_t *ir, int taps, int kind, uint32_t *seed)
+{
+	std::vector<double> h(taps);
+	double sum2 = 0;
+
+	for (int i=0; i < taps; i++) {
+		h[i] = gauss(seed) * exp(-4.0 * i / taps);
+		sum2 += h[i] * h[i];
+	}
+	for (int i=0; i < taps; i++) {
+		double v = (kind == 1) ? (i == taps / 3 ? 0.9 : 0.0) :
+		  h[i] / sqrt(sum2) * (kind == 2 ? 0.03 : 0.5);
+		ir[i] = lrint(v * 32768);
+	}
+}
+
+static void run(int taps, int kind, uint32_t *seed)
+{
+	static int16_t ir[MAX_TAPS];
+	static const char *names[] = {"room -6 dB", "impulse", "room -30 dB"};
+	int blocks = 200 + taps / AUDIO_BLOCK_SAMPLES;
+	int n = blocks * AUDIO_BLOCK_SAMPLES;
+	std::vector<int16_t> x(n), y(n);
+	double maxe = 0, sum2 = 0;
+	long count = 0;
+
+	make_ir(ir, taps, kind, seed);
+	for (int i=0; i < n; i++) {
+		double v = (i < 100 * AUDIO_BLOCK_SAMPLES) ? gauss(seed) * 4000 : 20000 * sin(i * 0.0712);
+		if (i >= (blocks - 20) * AUDIO_BLOCK_SAMPLES) v = 0;
+		x[i] = lrint(std::max(-32768.0, std::min(32767.0, v)));
+	}
+	HOST_CHECK(conv.begin(ir, taps, memory), "begin %d taps", taps);
+	src.play(x.data(), (blocks - 20) * AUDIO_BLOCK_SAMPLES);
+	sink.record(y.data(), n);
+	for (int b=0; b < blocks; b++) host_update();
+	for (int i=0; i < n; i++) {
+		double exact = 0;
+		for (int j=0; j < taps && j <= i; j++) exact += ir[j] * (double)x[i - j];
+		exact /= 32768;
+		if (fabs(exact) > 32767) continue;
+		double e = fabs(y[i] - exact);
+		if (e > maxe) maxe = e;
+		sum2 += e * e;
+		count++;
+	}
+	printf("  %4d taps, %-12s max error %.2f LSB, rms %.2f LSB\n", taps, names[kind],
+		maxe, sqrt(sum2 / count));
+	// the q15 rounding of the IR spectra adds up over the partitions, a
+	// loud 4096 tap room gets to about 4 LSB
+	HOST_CHECK(maxe < 5.0 && sqrt(sum2 / count) < 1.0, "%d taps, %s: %.2f LSB max, %.2f rms",
+		taps, names[kind], maxe, sqrt(sum2 / count));
+}
+
+int main(void)
+{
+	static const int taps[] = {64, 256, 1000, 1024, 4096};
+	uint32_t seed = 1;
+
+	AudioMemory(8);
+	for (int t : taps) {
+		for (int kind=0; kind < 3; kind++) run(t, kind, &seed);
+	}
+	return host_result("partitioned convolution");
+}
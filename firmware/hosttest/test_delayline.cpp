@@ -0,0 +1,133 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioEffectDelayLine against AudioEffectDelay: the same whole sample
+// taps must give the same output while the delay line keeps no audio
+// blocks, fractional taps against a double precision linear
+// interpolation, and memory too short for a block.
+
+#include "host.h"
+#include "effect_delay.h"
+
+#define LONGEST		5000
+#define BLOCKS		120
+
+static int16_t ring[AUDIO_DELAYLINE_SAMPLES(LONGEST)];
+static int16_t ring_min[AUDIO_DELAYLINE_SAMPLES(0)];
+static int16_t ring_short[AUDIO_BLOCK_SAMPLES];
+
+static HostSource src;
+static AudioEffectDelay old;
+static AudioEffectDelayLine line(ring, sizeof(ring) / sizeof(ring[0]));
+static AudioEffectDelayLine line_min(ring_min, sizeof(ring_min) / sizeof(ring_min[0]));
+static AudioEffectDelayLine line_short(ring_short, sizeof(ring_short) / sizeof(ring_short[0]));
+static HostSink<4> sink_old, sink_line;
+static HostSink<2> sink_small;
+static AudioConnection c1(src, old), c2(src, line), c3(src, line_min), c4(src, line_short);
+static AudioConnection c5(old, 0, sink_old, 0), c6(old, 1, sink_old, 1);
+static AudioConnection c7(old, 2, sink_old, 2), c8(old, 3, sink_old, 3);
+static AudioConnection c9(line, 0, sink_line, 0), c10(line, 1, sink_line, 1);
+static AudioConnection c11(line, 2, sink_line, 2), c12(line, 3, sink_line, 3);
+static AudioConnection c13(line_min, 0, sink_small, 0), c14(line_short, 0, sink_small, 1);
+
+int main(void)
+{
+	static const uint32_t whole[4] = {0, 1, AUDIO_BLOCK_SAMPLES, LONGEST};
+	static const float frac[4] = {0.25f, 10.5f, 300.75f, LONGEST - 0.7f};
+	const int n = BLOCKS * AUDIO_BLOCK_SAMPLES;
+	std::vector<int16_t> x(2 * n), y_old[4], y_line[4], y_small[2];
+	int16_t *p_old[4], *p_line[4], *p_small[2];
+	uint32_t seed = 7;
+
+	AudioMemory(60);
+	for (int i=0; i < 2 * n; i++) x[i] = (int32_t)host_rand(&seed) >> 17;
+	for (int c=0; c < 4; c++) {
+		y_old[c].resize(n);
+		y_line[c].resize(n);
+		p_old[c] = y_old[c].data();
+		p_line[c] = y_line[c].data();
+		if (c < 2) {
+			y_small[c].resize(n);
+			p_small[c] = y_small[c].data();
+		}
+	}
+
+	// whole samples, old and new
+	for (int c=0; c < 4; c++) {
+		old.delay(c, whole[c] * 1000.0f / AudioSampleRate());
+		line.delaySamples(c, whole[c]);
+	}
+	line_min.delaySamples(0, 0);
+	line_short.delaySamples(0, 50);
+	src.play(x.data(), n);
+	sink_old.record(p_old, n);
+	sink_line.record(p_line, n);
+	sink_small.record(p_small, n);
+	for (int b=0; b < BLOCKS; b++) host_update();
+	int diff = 0;
+	for (int c=0; c < 4; c++) {
+		for (int i=0; i < n; i++) if (y_old[c][i] != y_line[c][i]) diff++;
+	}
+	// only the old queue holds blocks between updates, the newest one
+	// and the ones the longest tap reaches back to
+	uint32_t held = host_memory_used();
+	printf("  taps 0, 1, %d, %d samples: %d samples differ\n", AUDIO_BLOCK_SAMPLES, LONGEST, diff);
+	printf("  blocks held: AudioEffectDelay %u (%u bytes), delay line 0 (ring %u bytes)\n",
+		held, held * (uint32_t)sizeof(audio_block_t), (uint32_t)sizeof(ring));
+	HOST_CHECK(diff == 0, "%d samples differ from AudioEffectDelay", diff);
+	HOST_CHECK(held == (LONGEST + AUDIO_BLOCK_SAMPLES - 1) / AUDIO_BLOCK_SAMPLES + 2,
+		"%u blocks held", held);
+
+	// the smallest ring passes the input through, a shorter one nothing
+	int bad_min = 0, bad_short = 0;
+	for (int i=0; i < n; i++) {
+		if (y_small[0][i] != x[i]) bad_min++;
+		if (y_small[1][i] != 0) bad_short++;
+	}
+	printf("  %u sample ring: maxDelay %u, %d samples differ from the input\n",
+		(uint32_t)AUDIO_DELAYLINE_SAMPLES(0), line_min.maxDelay(), bad_min);
+	printf("  %u sample ring: maxDelay %u, %d samples not silent\n",
+		(uint32_t)AUDIO_BLOCK_SAMPLES, line_short.maxDelay(), bad_short);
+	HOST_CHECK(line_min.maxDelay() == 0 && bad_min == 0, "smallest ring");
+	HOST_CHECK(line_short.maxDelay() == 0 && bad_short == 0, "short ring");
+
+	// fractional delays, linear interpolation, jumping to the new delay
+	line.glide(0);
+	for (int c=0; c < 4; c++) line.delaySamples(c, frac[c]);
+	src.play(x.data() + n, n);
+	sink_line.record(p_line, n);
+	for (int b=0; b < BLOCKS; b++) host_update();
+	for (int c=0; c < 4; c++) {
+		uint32_t d = frac[c] * 65536.0f + 0.5f;
+		uint32_t m = d >> 16;
+		double f = ((d & 0xFFFF) >> 1) / 32768.0, maxe = 0;
+		for (int i=0; i < n; i++) {
+			double a = x[n + i - m], b = x[n + i - m - 1];
+			double e = fabs(y_line[c][i] - (a + (b - a) * f));
+			if (e > maxe) maxe = e;
+		}
+		printf("  linear tap at %.2f samples: max error %.3f LSB\n", frac[c], maxe);
+		HOST_CHECK(maxe < 1.0, "tap at %.2f: %.3f LSB", frac[c], maxe);
+	}
+	return host_result("delay line");
+}
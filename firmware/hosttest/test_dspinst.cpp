@@ -0,0 +1,174 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Golden tests of the host dspinst.h emulation and the dspblock.h kernels.
+// The instructions are checked against a straight reading of the ARMv7-M
+// reference manual in 64/128 bit arithmetic, the kernels against their
+// scalar definition, on random and edge operands. Built twice: plain
+// (scalar kernels) and -march=native (SSE4.1/AVX2 kernels when present).
+
+#include <random>
+#include "host.h"
+#include "utility/dspinst.h"
+#include "utility/dspblock.h"
+
+static std::mt19937 rng(7);
+
+// one in four is an edge value
+static int16_t r16(void)
+{
+	switch (rng() % 8) {
+	case 0: return 32767;
+	case 1: return -32768;
+	case 2: return 0;
+	default: return (int16_t)rng();
+	}
+}
+
+static int32_t sat16(int64_t v)
+{
+	return v > 32767 ? 32767 : v < -32768 ? -32768 : (int32_t)v;
+}
+
+static uint32_t pack(int32_t hi, int32_t lo)
+{
+	return ((uint32_t)(uint16_t)hi << 16) | (uint16_t)lo;
+}
+
+static void instructions(void)
+{
+	for (int it=0; it < 2000000; it++) {
+		int32_t a = rng(), b = rng(), s = rng();
+		if (it & 1) {
+			a = pack(r16(), r16());
+			b = pack(r16(), r16());
+		}
+		__int128 p = (__int128)a * b;
+		int16_t al = a, ah = a >> 16, bl = b, bh = b >> 16;
+		HOST_CHECK(multiply_32x32_rshift32(a, b) == (int32_t)(p >> 32), "smmul %d %d", a, b);
+		HOST_CHECK(multiply_32x32_rshift32_rounded(a, b) == (int32_t)((p + 0x80000000LL) >> 32),
+			"smmulr %d %d", a, b);
+		HOST_CHECK(multiply_accumulate_32x32_rshift32_rounded(s, a, b) ==
+			(int32_t)((((__int128)s << 32) + p + 0x80000000LL) >> 32), "smmlar %d %d %d", s, a, b);
+		HOST_CHECK(multiply_subtract_32x32_rshift32_rounded(s, a, b) ==
+			(int32_t)((((__int128)s << 32) - p + 0x80000000LL) >> 32), "smmlsr %d %d %d", s, a, b);
+		HOST_CHECK(signed_add_16_and_16(a, b) == pack(sat16(ah + bh), sat16(al + bl)), "qadd16");
+		HOST_CHECK((uint32_t)signed_subtract_16_and_16(a, b) == pack(sat16(ah - bh), sat16(al - bl)),
+			"qsub16");
+		HOST_CHECK((uint32_t)signed_halving_add_16_and_16(a, b) == pack((ah + bh) >> 1, (al + bl) >> 1),
+			"shadd16");
+		HOST_CHECK((uint32_t)signed_halving_subtract_16_and_16(a, b) == pack((ah - bh) >> 1, (al - bl) >> 1),
+			"shsub16");
+		HOST_CHECK(signed_multiply_32x16b(a, b) == (int32_t)(((int64_t)a * bl) >> 16), "smulwb");
+		HOST_CHECK(signed_multiply_32x16t(a, b) == (int32_t)(((int64_t)a * bh) >> 16), "smulwt");
+		HOST_CHECK(signed_multiply_accumulate_32x16b(s, a, b) ==
+			(int32_t)((uint32_t)s + (uint32_t)(((int64_t)a * bl) >> 16)), "smlawb");
+		HOST_CHECK(signed_multiply_accumulate_32x16t(s, a, b) ==
+			(int32_t)((uint32_t)s + (uint32_t)(((int64_t)a * bh) >> 16)), "smlawt");
+		HOST_CHECK(multiply_16tx16t_add_16bx16b(a, b) == (int32_t)(uint32_t)((int64_t)al * bl + (int64_t)ah * bh),
+			"smuad");
+		HOST_CHECK(multiply_16tx16b_add_16bx16t(a, b) == (int32_t)(uint32_t)((int64_t)al * bh + (int64_t)ah * bl),
+			"smuadx");
+		HOST_CHECK(multiply_accumulate_16tx16t_add_16bx16b((int64_t)s << 20, a, b) ==
+			((int64_t)s << 20) + (int64_t)al * bl + (int64_t)ah * bh, "smlald");
+		HOST_CHECK(multiply_accumulate_16tx16b_add_16bx16t((int64_t)s << 20, a, b) ==
+			((int64_t)s << 20) + (int64_t)al * bh + (int64_t)ah * bl, "smlaldx");
+		HOST_CHECK(multiply_16bx16b(a, b) == al * bl, "smulbb");
+		HOST_CHECK(multiply_16bx16t(a, b) == al * bh, "smulbt");
+		HOST_CHECK(multiply_16tx16b(a, b) == ah * bl, "smultb");
+		HOST_CHECK(multiply_16tx16t(a, b) == ah * bh, "smultt");
+		int64_t d = (int64_t)a - b;
+		d = d > INT32_MAX ? INT32_MAX : d < INT32_MIN ? INT32_MIN : d;
+		HOST_CHECK(substract_32_saturate(a, b) == d, "qsub %d %d", a, b);
+		HOST_CHECK(pack_16b_16b(a, b) == pack(al, bl), "pkhbt");
+		HOST_CHECK(pack_16t_16b(a, b) == pack(ah, bl), "pkhbt top");
+		HOST_CHECK(pack_16t_16t(a, b) == pack(ah, bh), "pkhtb asr");
+		HOST_CHECK(saturate16(a >> (it % 20)) == sat16(a >> (it % 20)), "ssat 16");
+		int bits = 2 + it % 30, shift = it % 16;
+		int64_t lim = 1LL << (bits - 1), v = a >> shift;
+		v = v >= lim ? lim - 1 : v < -lim ? -lim : v;
+		HOST_CHECK(signed_saturate_rshift(a, bits, shift) == v, "ssat %d asr %d", bits, shift);
+	}
+}
+
+// odd lengths, so the SIMD tails are covered
+static void kernels(void)
+{
+	static int16_t x[1037], y[1037], w[1037], ref[1037], t[1037];
+	static int16_t il[2074], ilref[2074];
+	static int32_t q[1037];
+
+	for (int it=0; it < 20000; it++) {
+		uint32_t n = 1 + rng() % 1037, i;
+		int32_t mult;
+		if (it % 5 == 0) mult = 65536;
+		else if (rng() % 8 == 0) mult = 32767 * 65536;
+		else mult = (int32_t)(rng() % (1 << 22)) - (1 << 21);
+		int rs = rng() % 24;
+		for (i=0; i < n; i++) {
+			x[i] = r16();
+			y[i] = r16();
+			w[i] = r16();
+			q[i] = (int32_t)rng();
+		}
+		for (i=0; i < n; i++) ref[i] = sat16(((int64_t)mult * x[i]) >> 16);
+		memcpy(t, x, n * 2);
+		block_gain(t, mult, n);
+		HOST_CHECK(!memcmp(t, ref, n * 2), "block_gain n %u mult %d", n, mult);
+		block_gain_copy(t, x, mult, n);
+		HOST_CHECK(!memcmp(t, ref, n * 2), "block_gain_copy n %u mult %d", n, mult);
+		for (i=0; i < n; i++) ref[i] = sat16(y[i] + ref[i]);
+		memcpy(t, y, n * 2);
+		block_gain_add(t, x, mult, n);
+		HOST_CHECK(!memcmp(t, ref, n * 2), "block_gain_add n %u mult %d", n, mult);
+		for (i=0; i < n; i++) ref[i] = sat16(q[i] >> rs);
+		block_saturate(t, q, rs, n);
+		HOST_CHECK(!memcmp(t, ref, n * 2), "block_saturate n %u shift %d", n, rs);
+		for (i=0; i < n; i++) ref[i] = (int16_t)((x[i] * w[i]) >> 15);
+		block_window(t, x, w, n);
+		HOST_CHECK(!memcmp(t, ref, n * 2), "block_window n %u", n);
+		memcpy(t, x, n * 2);
+		block_window(t, t, w, n);
+		HOST_CHECK(!memcmp(t, ref, n * 2), "block_window in place n %u", n);
+		const int16_t *l = (it % 3 == 1) ? NULL : x, *r = (it % 3 == 2) ? NULL : y;
+		for (i=0; i < n; i++) {
+			ilref[2 * i] = l ? l[i] : 0;
+			ilref[2 * i + 1] = r ? r[i] : 0;
+		}
+		block_interleave(il, l, r, n);
+		HOST_CHECK(!memcmp(il, ilref, n * 4), "block_interleave n %u", n);
+	}
+}
+
+int main(void)
+{
+	instructions();
+	kernels();
+#if defined(DSPBLOCK_AVX2)
+	return host_result("dspinst/dspblock, avx2 kernels");
+#elif defined(DSPBLOCK_SSE4)
+	return host_result("dspinst/dspblock, sse4.1 kernels");
+#else
+	return host_result("dspinst/dspblock, scalar kernels");
+#endif
+}
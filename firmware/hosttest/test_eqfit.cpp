@@ -0,0 +1,130 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioEqualizerFit: fit() on a modelled codec response, and apply()
+// loading a bank whose stages have to be scaled down to fit Q30. The
+// level and the scaled down gain are spread from the first stage on, a
+// sine through the bank has to come out at response() plus the level,
+// less what apply() reports it could not load.
+
+#include "host.h"
+#include "filter_eqfit.h"
+
+#define FS	88235.29412f
+#define STAGES	4
+
+static int32_t mem[AUDIO_BIQUAD_WORDS(STAGES)], mem1[AUDIO_BIQUAD_WORDS(1)];
+static HostSource src;
+static AudioFilterBiquadBank bank(mem, STAGES), one(mem1, 1);
+static HostSink<2> sink;
+static AudioConnection c1(src, bank), c2(src, one), c3(bank, 0, sink, 0), c4(one, 0, sink, 1);
+
+// gain in dB of a sine through the bank, after it has settled
+static float measure(AudioFilterBiquadBank &filter, float freq)
+{
+	static int16_t in[64 * AUDIO_BLOCK_SAMPLES], out[2][64 * AUDIO_BLOCK_SAMPLES];
+	int16_t *o[2] = {out[0], out[1]}, *y = out[&filter == &bank ? 0 : 1];
+	double a = 0, b = 0;
+
+	for (int i=0; i < 64 * AUDIO_BLOCK_SAMPLES; i++) {
+		in[i] = lrint(4000.0 * sin(2 * M_PI * freq * i / FS));
+	}
+	src.play(in, 64 * AUDIO_BLOCK_SAMPLES);
+	sink.record(o, 64 * AUDIO_BLOCK_SAMPLES);
+	while (sink.recorded() < 64 * AUDIO_BLOCK_SAMPLES) host_update();
+	for (int i=32 * AUDIO_BLOCK_SAMPLES; i < 64 * AUDIO_BLOCK_SAMPLES; i++) {
+		a += (double)in[i] * in[i];
+		b += (double)y[i] * y[i];
+	}
+	return 10 * log10(b / a);
+}
+
+// load the stages, then check the bank at a few frequencies
+static void check(const char *name, AudioFilterBiquadBank &filter,
+  const eqfit_stage_t *st, uint32_t n, float level, float lost)
+{
+	// whole periods in the 4096 samples measured
+	static const int periods[] = {3, 19, 46, 232, 696};
+	float missing = AudioEqualizerFit::apply(&filter, st, n, FS, level);
+	float worst = 0;
+
+	for (int k : periods) {
+		float f = k * FS / 4096;
+		float want = AudioEqualizerFit::response(st, n, f, FS) + level - missing;
+		float got = measure(filter, f);
+		if (fabsf(got - want) > worst) worst = fabsf(got - want);
+	}
+	printf("  %s: %.2f dB not loaded, bank within %.3f dB of the response\n", name,
+		missing, worst);
+	HOST_CHECK(fabsf(missing - lost) < 0.01f, "%s: %.2f dB not loaded, expected %.2f",
+		name, missing, lost);
+	HOST_CHECK(worst < 0.01f, "%s: bank %.3f dB off the response", name, worst);
+}
+
+static float codec(float f)
+{
+	return -10 * log10f(1 + powf(f / 22000, 8)) + 0.3f * sinf(f / 2000)
+	  - 10 * log10f(1 + powf(15 / f, 4)) - 1.0f;
+}
+
+int main(void)
+{
+	static const float fr[31] = {20, 25, 31.5, 40, 50, 63, 80, 100, 125, 160, 200, 250,
+		315, 400, 500, 630, 800, 1000, 1250, 1600, 2000, 2500, 3150, 4000, 5000, 6300,
+		8000, 10000, 12500, 16000, 20000};
+	// a boosting high shelf with its corner low has |b| near 2
+	static const eqfit_stage_t shelf[2] = {
+		{EQFIT_HIGHSHELF, 50, 6, 0.9f},
+		{EQFIT_PEAK, 5000, 3, 1.0f},
+	};
+	float g[31], worst = 0;
+	eqfit_stage_t st[8];
+
+	AudioMemory(8);
+	bank.setInterpolation(0);
+	one.setInterpolation(0);
+
+	// fit: flat within the band afterwards
+	for (int i=0; i < 31; i++) g[i] = codec(fr[i]);
+	uint32_t n = AudioEqualizerFit::fit(fr, g, 31, 1000, 100, 20000, 6, FS, st, 8);
+	for (int i=0; i < 31; i++) {
+		if (fr[i] < 100) continue;
+		float r = g[i] - g[17] + AudioEqualizerFit::response(st, n, fr[i], FS);
+		if (fabsf(r) > worst) worst = fabsf(r);
+	}
+	printf("  fit: %u stages, within %.2f dB from 100 Hz to 20 kHz\n", n, worst);
+	HOST_CHECK(n > 0 && n <= 8 && worst < 0.5f, "fit: %u stages, %.2f dB off", n, worst);
+
+	// the shelf in stage 0 is halved, stage 0 cannot take it all back
+	// at full level, the peak stage behind it takes the rest
+	check("shelf first, 0 dB", bank, shelf, 2, 0.0f, 0.0f);
+	check("shelf first, -6 dB", bank, shelf, 2, -6.0f, 0.0f);
+	check("shelf first, +3 dB", bank, shelf, 2, 3.0f, 0.0f);
+	// with one stage there is nowhere to put it, the level is short by
+	// the factor its largest b is over the Q30 limit
+	double c[5];
+	AudioEqualizerFit::coefficients(shelf, FS, c);
+	double b = std::max(fabs(c[0]), std::max(fabs(c[1]), fabs(c[2])));
+	check("one stage, 0 dB", one, shelf, 1, 0.0f, 20 * log10(b / 1.999));
+	return host_result("equalizer fit and apply");
+}
@@ -0,0 +1,94 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioAnalyzeFFT1024 spreads one spectrum over the 4 updates of the
+// hop. Check it against the same arithmetic done in one go (window,
+// 512 point CFFT, split step, averaging) on the 4th block, the way the
+// object worked before the work was spread: every spectrum must be bit
+// identical, with and without averaging and window.
+
+#include "host.h"
+#include "ref_fft1024.h"
+
+#define BLOCKS	400
+
+static int16_t in[BLOCKS * AUDIO_BLOCK_SAMPLES];
+
+#define RUNS	6
+
+int main(void)
+{
+	static HostSource src;
+	static AudioAnalyzeFFT1024 fft[RUNS];
+	static AudioConnection c0(src, fft[0]), c1(src, fft[1]), c2(src, fft[2]);
+	static AudioConnection c3(src, fft[3]), c4(src, fft[4]), c5(src, fft[5]);
+	// every object listens to the same source, each one with its own
+	// window and averaging mode: r/2 = 0 no averaging,
+	// 1 averageTogether(3), 2 averageExponential(3)
+	ReferenceFFT1024 *ref[RUNS];
+	int spectra[RUNS] = {0}, mismatches[RUNS] = {0}, pending[RUNS] = {0};
+
+	AudioMemory(20);
+	host_sines_noise(in, BLOCKS * AUDIO_BLOCK_SAMPLES, 44117.64706);
+	for (int r=0; r < RUNS; r++) {
+		const int16_t *window = r & 1 ? NULL : AudioWindowHanning1024;
+		int mode = r / 2;
+		ref[r] = new ReferenceFFT1024(window);
+		fft[r].windowFunction(window);
+		if (mode == 1) {
+			fft[r].averageTogether(3);
+			ref[r]->averageTogether(3);
+		} else if (mode == 2) {
+			fft[r].averageExponential(3);
+			ref[r]->averageExponential(3);
+		}
+	}
+	src.play(in, BLOCKS * AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < BLOCKS; b++) {
+		host_update();
+		for (int r=0; r < RUNS; r++) {
+			// 8 blocks every 4 from the 8th, the spread spectrum
+			// comes out 3 updates later
+			if (b >= 7 && (b - 7) % 4 == 0) {
+				if (ref[r]->frame(in + (b - 7) * AUDIO_BLOCK_SAMPLES)) pending[r]++;
+			}
+			if (!fft[r].available()) continue;
+			HOST_CHECK(pending[r] == 1 && (b - 7) % 4 == 3,
+				"run %d: spectrum in block %d, %d reference frames", r, b, pending[r]);
+			pending[r] = 0;
+			spectra[r]++;
+			for (int i=0; i < 512; i++) {
+				if (fft[r].output[i] != ref[r]->output[i]) mismatches[r]++;
+			}
+		}
+	}
+	for (int r=0; r < RUNS; r++) {
+		printf("  %s window, %s: %d spectra, %d bins differ\n", r & 1 ? "no" : "hann",
+			r < 2 ? "no averaging" : r < 4 ? "averageTogether(3)" : "averageExponential(3)",
+			spectra[r], mismatches[r]);
+		HOST_CHECK(spectra[r] >= (BLOCKS / 4 - 2) / (r / 2 == 1 ? 3 : 1), "run %d: %d spectra", r, spectra[r]);
+		HOST_CHECK(mismatches[r] == 0, "run %d: %d bins differ", r, mismatches[r]);
+		delete ref[r];
+	}
+	return host_result("fft1024 spread schedule");
+}
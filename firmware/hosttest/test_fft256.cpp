@@ -0,0 +1,103 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// AudioAnalyzeFFT256 computes its spectrum with a 128 point complex FFT
+// and a split step. Check every bin against a double precision DFT of
+// the same windowed 256 samples, and check that the exponential average
+// of a bin that goes quiet decays all the way to 0.
+
+#include "host.h"
+#include "analyze_fft256.h"
+
+#define BLOCKS	1600
+#define LOUD	40
+
+static int16_t in[BLOCKS * AUDIO_BLOCK_SAMPLES];
+
+// |X[k]| of the windowed frame, in the units of output[]: the q15 FFT
+// scales the 256 point transform by 1/256
+static void reference(const int16_t *x, const int16_t *window, double *mag)
+{
+	double w[256];
+
+	for (int n=0; n < 256; n++) w[n] = x[n] * (window ? window[n] / 32768.0 : 1.0);
+	for (int k=0; k < 128; k++) {
+		double re = 0.0, im = 0.0;
+		for (int n=0; n < 256; n++) {
+			re += w[n] * cos(2.0 * M_PI * k * n / 256.0);
+			im -= w[n] * sin(2.0 * M_PI * k * n / 256.0);
+		}
+		mag[k] = sqrt(re * re + im * im) / 256.0;
+	}
+}
+
+int main(void)
+{
+	static HostSource src;
+	static AudioAnalyzeFFT256 hann, rect, expo;
+	static AudioConnection c0(src, hann), c1(src, rect), c2(src, expo);
+	double mag[128], worst = 0.0, worst_rect = 0.0;
+	int spectra = 0;
+
+	AudioMemory(10);
+	// the loud part is followed by silence as samples, not missing blocks
+	host_sines_noise(in, LOUD * AUDIO_BLOCK_SAMPLES, 44117.64706);
+	hann.averageTogether(1);
+	rect.averageTogether(1);
+	rect.windowFunction(NULL);
+	expo.averageExponential(6);
+	src.play(in, BLOCKS * AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < BLOCKS; b++) {
+		host_update();
+		bool h = hann.available(), r = rect.available();
+		HOST_CHECK(h == (b >= 1) && r == h, "block %d: spectrum %d %d", b, h, r);
+		if (!h || b >= LOUD + 2) continue;
+		spectra++;
+		const int16_t *frame = in + (b - 1) * AUDIO_BLOCK_SAMPLES;
+		reference(frame, AudioWindowHanning256, mag);
+		for (int k=0; k < 128; k++) {
+			double err = fabs(hann.output[k] - mag[k]);
+			if (err > worst) worst = err;
+		}
+		reference(frame, NULL, mag);
+		for (int k=0; k < 128; k++) {
+			double err = fabs(rect.output[k] - mag[k]);
+			if (err > worst_rect) worst_rect = err;
+		}
+	}
+	printf("  %d spectra, worst bin error %.2f (hann) %.2f (no window)\n",
+		spectra, worst, worst_rect);
+	HOST_CHECK(spectra == LOUD + 1, "%d spectra", spectra);
+	HOST_CHECK(worst < 8.0, "hann: bin %.2f from the DFT", worst);
+	HOST_CHECK(worst_rect < 8.0, "no window: bin %.2f from the DFT", worst_rect);
+
+	// 1/64 of the difference per spectrum: with the steps truncated a bin
+	// stuck anywhere below 64, up to 7 in output[]
+	int nonzero = 0;
+	for (int k=0; k < 128; k++) if (expo.output[k] != 0) nonzero++;
+	printf("  exponential average, %d bins not back to 0 after %d silent blocks\n",
+		nonzero, BLOCKS - LOUD);
+	HOST_CHECK(nonzero == 0, "%d bins not back to 0", nonzero);
+	return host_result("fft256 against a DFT");
+}
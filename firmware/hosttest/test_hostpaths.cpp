@@ -0,0 +1,204 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// The objects whose update() was Teensy 3.x only until the host build:
+// run each one on a signal with a known answer, so a host build that
+// compiles them to silence or garbage fails here. The audio objects are
+// static, AudioStream keeps them in its update list for good.
+
+#include "host.h"
+#include "analyze_tonedetect.h"
+#include "analyze_fft1024.h"
+#include "filter_convolution.h"
+#include "effect_reverb_fdn.h"
+#include "synth_multitone.h"
+
+#define FS	44117.64706
+
+static void tonebank(void)
+{
+	static int16_t in[44100];
+	static HostSource src;
+	static AudioAnalyzeToneBank bank;
+	static AudioAnalyzeToneDetect single;
+	static AudioConnection c1(src, bank);
+	static AudioConnection c2(src, single);
+	float bins[4] = {0};
+
+	for (int i=0; i < 44100; i++) {
+		in[i] = lrint(16384.0 * sin(2.0 * M_PI * 1000.0 * i / FS)
+		  + 8192.0 * sin(2.0 * M_PI * 3000.0 * i / FS));
+	}
+	src.play(in, 44100);
+	bank.harmonics(1000.0f, 4, 10);
+	single.frequency(3000.0f, 30);
+	for (int b=0; b < 40; b++) {
+		host_update();
+		if (bank.available()) bank.read(bins, 4);
+	}
+	HOST_CHECK(fabsf(bins[0] - 0.5f) < 0.03f, "tone bank 1 kHz %f, expected 0.5", bins[0]);
+	HOST_CHECK(fabsf(bins[2] - 0.25f) < 0.03f, "tone bank 3 kHz %f, expected 0.25", bins[2]);
+	HOST_CHECK(bins[1] < 0.02f && bins[3] < 0.02f, "tone bank empty bins %f %f", bins[1], bins[3]);
+	HOST_CHECK(bins[2] == single.read(), "tone bank %f, tone detect %f", bins[2], single.read());
+}
+
+static void fft1024(void)
+{
+	static int16_t in[128 * 40];
+	static HostSource src;
+	static AudioAnalyzeFFT1024 fft;
+	static AudioConnection c1(src, fft);
+	int outputs = 0;
+
+	for (int i=0; i < 128 * 40; i++) {
+		in[i] = lrint(16000.0 * sin(2.0 * M_PI * 100.0 * i / 1024.0));
+	}
+	src.play(in, 128 * 40);
+	for (int b=0; b < 40; b++) {
+		host_update();
+		if (fft.available()) outputs++;
+	}
+	unsigned int peak = 0;
+	for (unsigned int i=1; i < 512; i++) {
+		if (fft.output[i] > fft.output[peak]) peak = i;
+	}
+	HOST_CHECK(outputs >= 8, "fft1024 %d spectra from 40 blocks", outputs);
+	HOST_CHECK(peak == 100, "fft1024 peak in bin %u, expected 100", peak);
+	// Hann window: half the sine's amplitude lands in the center bin
+	HOST_CHECK(fabsf(fft.read(100) - 0.244f) < 0.02f, "fft1024 bin 100 %f", fft.read(100));
+	HOST_CHECK(fft.read(90, 95) < 0.001f, "fft1024 bins 90-95 %f", fft.read(90, 95));
+}
+
+static void convolution(void)
+{
+	static int16_t in[128 * 20], out[128 * 20], ir[300];
+	static int32_t memory[AUDIO_CONVOLUTION_WORDS(300)];
+	static HostSource src;
+	static AudioFilterConvolution conv;
+	static HostSink<> sink;
+	static AudioConnection c1(src, conv);
+	static AudioConnection c2(conv, sink);
+	int err = 0;
+
+	// half level, 200 samples late
+	ir[200] = 16384;
+	host_sines_noise(in, 128 * 20, FS);
+	HOST_CHECK(conv.begin(ir, 300, memory), "convolution begin");
+	src.play(in, 128 * 20);
+	sink.record(out, 128 * 20);
+	for (int b=0; b < 20; b++) host_update();
+	for (int i=200; i < 128 * 20; i++) {
+		err = std::max(err, abs(out[i] - in[i - 200] / 2));
+	}
+	HOST_CHECK(err <= 2, "convolution max error %d LSB", err);
+}
+
+static void reverb(void)
+{
+	static int16_t in[128], left[44100], right[44100];
+	static int16_t memory[AUDIO_REVERB_FDN_SAMPLES(8)];
+	static HostSource src;
+	static AudioEffectReverbFDN fdn;
+	static HostSink<2> sink;
+	static AudioConnection c1(src, fdn);
+	static AudioConnection c2(fdn, 0, sink, 0);
+	static AudioConnection c3(fdn, 1, sink, 1);
+	int16_t *out[2] = {left, right};
+	double early = 0, late = 0, diff = 0;
+
+	in[0] = 30000;
+	// less than the modulation room, and less than a quarter room
+	HOST_CHECK(!fdn.begin(memory, 50, 8, true), "reverb took 50 samples");
+	HOST_CHECK(!fdn.begin(memory, 2000, 8, true), "reverb took 2000 samples");
+	HOST_CHECK(fdn.begin(memory, AUDIO_REVERB_FDN_SAMPLES(8), 8, true), "reverb refused its memory");
+	fdn.reverbTime(1.0f);
+	src.play(in, 128);
+	sink.record(out, 44100);
+	for (int b=0; b < 345; b++) host_update();
+	for (int i=4410; i < 13230; i++) early += (double)left[i] * left[i];
+	for (int i=35280; i < 44100; i++) late += (double)left[i] * left[i];
+	for (int i=0; i < 44100; i++) diff += abs(left[i] - right[i]);
+	// 1 s to fall 60 dB: 0.1-0.3 s against 0.8-1.0 s is about 42 dB
+	HOST_CHECK(early > 0 && late > 0, "reverb tail silent");
+	HOST_CHECK(late < early / 3000 && late > early / 300000, "reverb decay %.1f dB",
+		10.0 * log10(early / late));
+	HOST_CHECK(diff > 0, "reverb left and right identical");
+}
+
+// 16 log spaced tones on a 2^14 period: the sum repeats exactly and
+// all of its power is in the 16 bins, at equal levels
+static void multitone(void)
+{
+	static int16_t out[3 << 14];
+	static AudioSynthMultitone tones;
+	static HostSink<> sink;
+	static AudioConnection c1(tones, sink);
+	double bin[16], total = 0, found = 0;
+	int peak = 0, diff = 0;
+	unsigned int last = 0;
+
+	tones.logSpaced(100.0, 10000.0, 16, 14);
+	tones.amplitude(0.5);
+	sink.record(out, 3 << 14);
+	for (int b=0; b < (3 << 14) / AUDIO_BLOCK_SAMPLES; b++) host_update();
+	for (int i=0; i < 1 << 14; i++) {
+		peak = std::max(peak, abs(out[i]));
+		if (out[i] != out[i + (1 << 14)] || out[i] != out[i + (2 << 14)]) diff++;
+		total += (double)out[i] * out[i];
+	}
+	// the bins logSpaced() picks, DFT of one period at each
+	for (int k=0; k < 16; k++) {
+		double freq = 100.0 * pow(100.0, k / 15.0);
+		unsigned int b = (float)freq * 16384.0f / (float)FS + 0.5f;
+		if (b <= last) b = last + 1;
+		last = b;
+		double re = 0, im = 0;
+		for (int i=0; i < 1 << 14; i++) {
+			double w = 2.0 * M_PI * (double)b * i / 16384.0;
+			re += out[i] * cos(w);
+			im += out[i] * sin(w);
+		}
+		bin[k] = sqrt(re * re + im * im) * (2.0 / 16384.0);
+		found += bin[k] * bin[k] * 0.5 * 16384.0;
+	}
+	HOST_CHECK(diff == 0, "multitone: %d samples differ between periods", diff);
+	// each tone's product is truncated, the sum can come out a few LSB low
+	HOST_CHECK(peak <= 16384 && peak > 16384 * 0.998, "multitone peak %d, expected 16384", peak);
+	HOST_CHECK(found > 0.9999 * total, "multitone: %f of the power in the tones", found / total);
+	for (int k=1; k < 16; k++) {
+		HOST_CHECK(fabs(bin[k] / bin[0] - 1.0) < 0.01, "multitone tone %d level %f, tone 0 %f",
+			k, bin[k], bin[0]);
+	}
+	tones.stop();
+}
+
+int main(void)
+{
+	AudioMemory(20);
+	tonebank();
+	fft1024();
+	convolution();
+	reverb();
+	multitone();
+	return host_result("host update() paths");
+}
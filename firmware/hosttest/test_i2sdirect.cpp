@@ -0,0 +1,280 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Host model of the block ownership in AudioOutputI2Sdirect. The DMA
+// hardware is not available here, so ModelI2Sdirect runs the slot
+// bookkeeping of utility/output_direct.h, as update() and isr() of
+// output_i2s.cpp call it, on a modelled DMA channel: three TCDs, scatter/gather through DLASTSGA, the
+// minor loop read as SOFF and the minor loop offset, and interrupts that
+// wait while update() holds them off. The DMA finishes its block at
+// random points, also inside update(), the update is sometimes late by
+// one or two blocks and the pairs are stereo, mono (the same block on
+// both inputs) or have one channel missing. Checked: the pairs play in
+// the order update() took them, each once, from blocks still held, and
+// are released in playing order; no block is left over at the end.
+
+#include "host.h"
+#include "utility/output_direct.h"
+#include <stddef.h>
+
+#define BLOCKS	200000
+
+// the DMA channel, TCD registers and the three TCDs in memory
+struct ModelTCD {
+	const int16_t *saddr;
+	int32_t soff;
+	int32_t mloff;
+	int link;		// DLASTSGA, an index into direct_tcd[]
+};
+#define DIRECT_SILENCE	2
+static ModelTCD direct_tcd[3], dma_tcd;	// in memory, the channel's registers
+static int16_t direct_zero = 0;
+static bool irq_off, irq_pending, update_pending;
+static int complete_at = -1;	// point in update() where the DMA finishes
+
+static std::vector<int> played, released, taken;
+static int read_released, bad_block, dropped;
+
+static void model_isr(void);
+
+// one block: 128 minor loops of left, +soff, right, +soff, +mloff
+static void dma_complete(void)
+{
+	const char *addr = (const char *)dma_tcd.saddr;
+	int id = 0;
+
+	for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		const int16_t *l = (const int16_t *)addr;
+		const int16_t *r = (const int16_t *)(addr + dma_tcd.soff);
+		if (dma_tcd.saddr != &direct_zero) {
+			const audio_block_t *bl = (const audio_block_t *)((const char *)(l - i)
+			  - offsetof(audio_block_t, data));
+			const audio_block_t *br = (const audio_block_t *)((const char *)(r - i)
+			  - offsetof(audio_block_t, data));
+			if (bl->ref_count == 0 || br->ref_count == 0) read_released++;
+		}
+		int v = *l ? *l : -*r;
+		if (i == 0) id = v;
+		else if (v != id) bad_block++;
+		addr += 2 * dma_tcd.soff + dma_tcd.mloff;
+	}
+	played.push_back(id);
+	// scatter/gather loads the next TCD, then the major loop interrupt
+	dma_tcd = direct_tcd[dma_tcd.link];
+	if (irq_off) irq_pending = true;
+	else model_isr();
+}
+
+static void at(int point)
+{
+	if (point == complete_at) {
+		complete_at = -1;
+		dma_complete();
+	}
+}
+
+static void disable_irq(void) { irq_off = true; }
+static void enable_irq(void)
+{
+	irq_off = false;
+	if (irq_pending) {
+		irq_pending = false;
+		model_isr();
+	}
+}
+
+static void tcd_fill(ModelTCD *t, const int16_t *left, int32_t diff, int32_t mloff)
+{
+	t->saddr = left;
+	t->soff = diff;
+	t->mloff = mloff;
+	t->link = DIRECT_SILENCE;
+}
+
+// block id of a pair, left blocks hold +id, right blocks -id
+static int pair_id(const audio_block_t *l, const audio_block_t *r)
+{
+	return l->data[0] ? l->data[0] : -r->data[0];
+}
+
+class ModelI2Sdirect : public AudioStream
+{
+public:
+	ModelI2Sdirect(void) : AudioStream(2, inputQueueArray) { }
+	virtual void update(void);
+	static void isr(void);
+private:
+	static output_direct_t direct;
+	audio_block_t *inputQueueArray[2];
+};
+
+output_direct_t ModelI2Sdirect::direct = OUTPUT_DIRECT_INIT;
+
+static void model_isr(void) { ModelI2Sdirect::isr(); }
+
+// AudioOutputI2Sdirect::update()
+void ModelI2Sdirect::update(void)
+{
+	audio_block_t *blockL, *blockR, *zero;
+	const int16_t *left, *right;
+	int32_t diff;
+	int s;
+
+	at(0);
+	blockL = receiveReadOnly(0);
+	blockR = receiveReadOnly(1);
+	if (!blockL && !blockR) return;
+	if (!blockL || !blockR) {
+		zero = allocate();
+		if (!zero) {
+			if (blockL) release(blockL);
+			if (blockR) release(blockR);
+			return;
+		}
+		memset(zero->data, 0, sizeof(zero->data));
+		if (!blockL) blockL = zero;
+		else blockR = zero;
+	}
+	left = blockL->data;
+	right = blockR->data;
+	diff = (const char *)right - (const char *)left;
+	at(1);
+	disable_irq();
+	s = output_direct_take(&direct, blockL, blockR, diff);
+	if (s < 0) {
+		dropped++;
+		enable_irq();
+		release(blockL);
+		release(blockR);
+		return;
+	}
+	at(2);
+	tcd_fill(&direct_tcd[s], left, diff, 2 - 2 * diff);
+	at(3);
+	dma_tcd.link = s;
+	taken.push_back(pair_id(blockL, blockR));
+	at(4);
+	enable_irq();
+}
+
+// AudioOutputI2Sdirect::isr()
+void ModelI2Sdirect::isr(void)
+{
+	audio_block_t *blockL, *blockR;
+
+	output_direct_done(&direct, dma_tcd.saddr == &direct_zero, &blockL, &blockR);
+	update_pending = true;
+	if (blockL) released.push_back(pair_id(blockL, blockR));
+	if (blockL) AudioStream::release(blockL);
+	if (blockR) AudioStream::release(blockR);
+}
+
+// numbered pairs: stereo, mono, left or right only, or nothing
+class PairSource : public AudioStream
+{
+public:
+	PairSource(void) : AudioStream(0, NULL), running(true), id(0), seed(1) { }
+	virtual void update(void) {
+		audio_block_t *l, *r;
+		uint32_t mode = host_rand(&seed) >> 29;
+
+		if (!running || mode == 7) return;
+		id = id < 32767 ? id + 1 : 1;	// never 0, that is silence
+		if (mode == 0 || mode == 3) {
+			l = allocate();
+			if (!l) return;
+			for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) l->data[i] = id;
+			transmit(l, 0);
+			if (mode == 3) transmit(l, 1);	// mono, read twice
+			release(l);
+		}
+		if (mode == 1 || mode >= 4) {
+			r = allocate();
+			if (!r) return;
+			for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) r->data[i] = -id;
+			transmit(r, 1);
+			release(r);
+		}
+		if (mode == 2 || mode >= 4) {
+			l = allocate();
+			if (!l) return;
+			for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) l->data[i] = id;
+			transmit(l, 0);
+			release(l);
+		}
+	}
+	bool running;
+private:
+	int16_t id;
+	uint32_t seed;
+};
+
+int main(void)
+{
+	static PairSource src;
+	static ModelI2Sdirect out;
+	static AudioConnection c1(src, 0, out, 0), c2(src, 1, out, 1);
+	uint32_t seed = 7;
+	int late = 0, inside = 0;
+
+	AudioMemory(12);
+	tcd_fill(&direct_tcd[DIRECT_SILENCE], &direct_zero, 0, 0);
+	dma_tcd = direct_tcd[DIRECT_SILENCE];
+	for (int b=0; b < BLOCKS + 8; b++) {
+		if (b == BLOCKS) src.running = false;
+		dma_complete();
+		if (!update_pending) continue;
+		uint32_t r = host_rand(&seed) >> 24;
+		if (r < 12) {
+			late++;		// held off, runs after the next block
+			continue;
+		}
+		if (r < 80) {
+			complete_at = r % 5;
+			inside++;
+		}
+		update_pending = false;
+		host_update();
+		complete_at = -1;
+		// the DMA finished inside update(), its interrupt asks for the
+		// next update, which may run before the next block ends
+		if (update_pending && (r & 1)) {
+			update_pending = false;
+			host_update();
+		}
+	}
+
+	// the pairs that played, without the silence blocks in between
+	std::vector<int> pairs;
+	for (int id : played) if (id != 0) pairs.push_back(id);
+	int silence = played.size() - pairs.size();
+	printf("  %zu pairs taken, %zu played, %d dropped, %d silence blocks, %d updates late, "
+		"%d with the DMA inside\n", taken.size(), pairs.size(), dropped, silence, late, inside);
+	HOST_CHECK(pairs == taken, "played pairs differ from the ones update() took");
+	HOST_CHECK(released == taken, "pairs not released in playing order");
+	HOST_CHECK(read_released == 0, "%d samples read from released blocks", read_released);
+	HOST_CHECK(bad_block == 0, "%d samples from the wrong block", bad_block);
+	HOST_CHECK(AudioMemoryUsage() == 0, "%d blocks still held", (int)AudioMemoryUsage());
+	HOST_CHECK(AudioMemoryUsageMax() <= 6, "%d blocks used at most", (int)AudioMemoryUsageMax());
+	return host_result("I2S direct output block ownership model");
+}
@@ -0,0 +1,138 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioWaveformLoop::fit() and render(), the parts of the DMA loop mode
+// that do not need the output hardware. fit() is checked against a brute
+// force search over every loop length and period count, render() for a
+// seamless loop and for the period count it was asked for.
+
+#include "host.h"
+#include "synth_loop.h"
+
+#define MAXF	AUDIO_LOOP_MAX_FRAMES
+
+// the best ratio any loop of at most MAXF frames can give
+static double best_error(double ratio)
+{
+	double best = 1.0;
+
+	for (uint32_t n=2; n <= MAXF; n++) {
+		for (uint32_t k=1; 2 * k < n; k++) {
+			double err = fabs((double)k / n - ratio);
+			if (err < best) best = err;
+		}
+	}
+	return best;
+}
+
+static void fit(float rate)
+{
+	double worst = 0, worst_f = 0;
+	int checked = 0, brute = 0;
+	uint32_t n, k;
+
+	HOST_CHECK(AudioWaveformLoop::fit(rate / (MAXF + 1), rate, MAXF, &n, &k) == 0.0f,
+		"fit %.0f: no period fits, expected 0", rate);
+	HOST_CHECK(AudioWaveformLoop::fit(rate / 2, rate, MAXF, &n, &k) == 0.0f,
+		"fit %.0f: Nyquist, expected 0", rate);
+	for (float f = rate / MAXF; f < rate / 2; f *= 1.01f) {
+		float r = AudioWaveformLoop::fit(f, rate, MAXF, &n, &k);
+		if (r == 0.0f) {
+			HOST_CHECK(0, "fit %.0f: %.2f Hz did not fit", rate, f);
+			continue;
+		}
+		checked++;
+		HOST_CHECK(n >= 2 && n <= MAXF && k > 0 && 2 * k < n,
+			"fit %.0f: %.2f Hz gave %u periods in %u frames", rate, f, k, n);
+		HOST_CHECK(fabs(r - (double)rate * k / n) < 1e-3 * r,
+			"fit %.0f: returned %f, loop plays %f", rate, r, (double)rate * k / n);
+		double e = fabs(r - f) / f;
+		if (e > worst) {
+			worst = e;
+			worst_f = f;
+		}
+		// a few against every loop there is, the search is slow
+		if (checked % 16 == 0) {
+			double ratio = (double)f / rate;
+			double got = fabs((double)k / n - ratio);
+			HOST_CHECK(got <= best_error(ratio) * (1 + 1e-9),
+				"fit %.0f: %.2f Hz not the closest loop", rate, f);
+			brute++;
+		}
+	}
+	printf("  fit at %.0f Hz: %d frequencies, worst %.0f ppm at %.1f Hz, %d brute force\n",
+		rate, checked, worst * 1e6, worst_f, brute);
+	// relative to the frequency, loop frequencies are furthest apart in
+	// the lowest octaves, where only one or two periods fit
+	HOST_CHECK(worst < 500e-6, "fit %.0f: worst error %.0f ppm", rate, worst * 1e6);
+	// exact when the period divides a loop length
+	HOST_CHECK(AudioWaveformLoop::fit(1000, 96000, MAXF, &n, &k) == 1000.0f && k * 96 == n,
+		"fit 1 kHz at 96 kHz: %u periods in %u frames", k, n);
+}
+
+// the loop played twice has to be the loop of twice the length
+static void render(void)
+{
+	static int16_t one[2 * MAXF], two[2 * MAXF], stereo[4 * MAXF];
+	static const short types[] = {WAVEFORM_SINE, WAVEFORM_SAWTOOTH, WAVEFORM_SQUARE,
+		WAVEFORM_TRIANGLE, WAVEFORM_PULSE, WAVEFORM_SAWTOOTH_REVERSE};
+	uint32_t n, k;
+
+	AudioWaveformLoop::fit(1234.5f, 96000, MAXF, &n, &k);
+	for (unsigned t=0; t < sizeof(types) / sizeof(types[0]); t++) {
+		AudioWaveformLoop::render(one, n, k, types[t], 1.0f, 0.3f);
+		memcpy(one + n, one, n * sizeof(int16_t));
+		AudioWaveformLoop::render(two, 2 * n, 2 * k, types[t], 1.0f, 0.3f);
+		HOST_CHECK(memcmp(one, two, 2 * n * sizeof(int16_t)) == 0,
+			"render type %d: loop seam differs from a continuous wave", types[t]);
+		AudioWaveformLoop::render(stereo, n, k, types[t], 1.0f, 0.3f, 2);
+		AudioWaveformLoop::render(stereo + 1, n, k, types[t], 1.0f, 0.3f, 2);
+		int diff = 0;
+		for (uint32_t i=0; i < n; i++) {
+			if (stereo[2 * i] != one[i] || stereo[2 * i + 1] != one[i]) diff++;
+		}
+		HOST_CHECK(diff == 0, "render type %d: %d interleaved samples differ", types[t], diff);
+	}
+
+	// the sine has its power in bin k of the loop
+	AudioWaveformLoop::render(one, n, k, WAVEFORM_SINE, 0.5f, 0.5f);
+	double re = 0, im = 0, total = 0;
+	for (uint32_t i=0; i < n; i++) {
+		re += one[i] * cos(2 * M_PI * k * i / n);
+		im += one[i] * sin(2 * M_PI * k * i / n);
+		total += (double)one[i] * one[i];
+	}
+	double inbin = 2 * (re * re + im * im) / n;
+	printf("  sine %u periods in %u frames: %.6f of the power in bin %u\n", k, n,
+		inbin / total, k);
+	HOST_CHECK(inbin > 0.99999 * total, "render sine: %f of the power in bin %u",
+		inbin / total, k);
+}
+
+int main(void)
+{
+	fit(96000);
+	fit(192000);
+	render();
+	return host_result("waveform loop fit and render");
+}
@@ -0,0 +1,162 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// The loopback analyzer with a known path instead of the DAC, the codec
+// and the line input: a one pole lowpass, a delay and a cubic term in
+// double precision. Gain, phase, THD+N and latency must come out as
+// the analytic values of that path.
+
+#include "host.h"
+#include "synth_waveform.h"
+#include "analyze_loopback.h"
+
+#define FS	44117.64706
+
+// y = g*(1-a)/(1 - a*z^-1) * z^-D * x, then y + c*y^3 (full scale = 1)
+class KnownPath : public AudioStream
+{
+public:
+	KnownPath(void) : AudioStream(1, inputQueueArray) { set(1.0, 0.0, 0, 0.0); }
+	void set(double g, double a, unsigned int d, double c) {
+		gain = g;
+		pole = a;
+		delay = d;
+		cubic = c;
+		state = 0.0;
+		pos = 0;
+		memset(line, 0, sizeof(line));
+	}
+	// gain and phase (degrees, -180..180] of the linear part at freq
+	void response(double freq, double *g, double *deg) {
+		double w = 2.0 * M_PI * freq / FS;
+		double re = 1.0 - pole * cos(w), im = pole * sin(w);
+		*g = gain * (1.0 - pole) / sqrt(re * re + im * im);
+		double ph = -atan2(im, re) - w * delay;
+		*deg = remainder(ph * (180.0 / M_PI), 360.0);
+	}
+	virtual void update(void) {
+		audio_block_t *block = receiveWritable();
+		if (!block) return;
+		for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			line[pos] = block->data[i];
+			double x = line[(pos - delay) & 1023] / 32768.0;
+			pos = (pos + 1) & 1023;
+			state = gain * (1.0 - pole) * x + pole * state;
+			double y = (state + cubic * state * state * state) * 32768.0;
+			block->data[i] = (int16_t)std::max(-32768.0, std::min(32767.0, rint(y)));
+		}
+		transmit(block);
+		release(block);
+	}
+private:
+	double gain, pole, cubic, state;
+	unsigned int delay, pos;
+	int16_t line[1024];
+	audio_block_t *inputQueueArray[1];
+};
+
+static AudioSynthWaveform wave;
+static KnownPath path;
+static AudioAnalyzeLoopback loopback;
+static AudioConnection c1(wave, 0, loopback, 0);
+static AudioConnection c2(wave, path);
+static AudioConnection c3(path, 0, loopback, 1);
+
+static bool measure(float freq)
+{
+	wave.begin(0.5, freq, WAVEFORM_SINE);
+	loopback.frequency(freq, 20);
+	for (int b=0; b < 2000; b++) {
+		host_update();
+		if (loopback.available()) return true;
+	}
+	return false;
+}
+
+// response of a lowpass (fc about 1 kHz) with 25 samples of delay
+static void response(void)
+{
+	static const float freqs[] = {20.0, 100.0, 1000.0, 5000.0, 15000.0};
+	double g, deg;
+
+	path.set(0.8, 0.866, 25, 0.0);
+	for (unsigned int i=0; i < sizeof(freqs) / sizeof(freqs[0]); i++) {
+		HOST_CHECK(measure(freqs[i]), "%.0f Hz: no result", freqs[i]);
+		path.response(freqs[i], &g, &deg);
+		printf("  %5.0f Hz: gain %.5f (%.5f), phase %8.3f (%8.3f) deg\n", freqs[i],
+			loopback.gain(), g, loopback.phase(), deg);
+		HOST_CHECK(fabs(loopback.gain() / g - 1.0) < 0.002, "%.0f Hz: gain %f, expected %f",
+			freqs[i], loopback.gain(), g);
+		HOST_CHECK(fabs(remainder(loopback.phase() - deg, 360.0)) < 0.2,
+			"%.0f Hz: phase %f, expected %f", freqs[i], loopback.phase(), deg);
+	}
+}
+
+// y = x + c*x^3 with x = A*cos: fundamental A + 3cA^3/4, 3rd harmonic cA^3/4
+static void thdn(void)
+{
+	const double a = 0.5;
+	static const double cubics[] = {0.0, 0.004, 0.04, 0.4};
+
+	for (unsigned int i=0; i < sizeof(cubics) / sizeof(cubics[0]); i++) {
+		double c = cubics[i];
+		double h1 = a + 0.75 * c * a * a * a, h3 = 0.25 * c * a * a * a;
+		double expected = h3 / sqrt(h1 * h1 + h3 * h3);
+		path.set(1.0, 0.0, 0, c);
+		HOST_CHECK(measure(1000.0), "THD+N: no result");
+		printf("  THD+N c=%.3f: %.6f%% (%.6f%%)\n", c, loopback.thdn() * 100.0, expected * 100.0);
+		if (c == 0.0) {
+			// the generator and 16 bit rounding only, below -80 dB
+			HOST_CHECK(loopback.thdn() < 1e-4, "THD+N of a clean path %f", loopback.thdn());
+		} else {
+			HOST_CHECK(fabs(loopback.thdn() / expected - 1.0) < 0.05,
+				"THD+N c=%f: %f, expected %f", c, loopback.thdn(), expected);
+		}
+	}
+}
+
+static void latency(void)
+{
+	static const unsigned int delays[] = {0, 1, 127, 128, 300, 1000};
+
+	for (unsigned int i=0; i < sizeof(delays) / sizeof(delays[0]); i++) {
+		wave.amplitude(0.0);
+		for (int b=0; b < 10; b++) host_update();
+		path.set(1.0, 0.0, delays[i], 0.0);
+		loopback.latency(0.05);
+		wave.begin(0.5, 100.0, WAVEFORM_SQUARE);
+		for (int b=0; b < 300 && !loopback.available(); b++) host_update();
+		HOST_CHECK(loopback.latencySamples() == (int32_t)delays[i],
+			"latency %d samples, expected %u", loopback.latencySamples(), delays[i]);
+	}
+	printf("  latency: %u delays found\n", (unsigned)(sizeof(delays) / sizeof(delays[0])));
+}
+
+int main(void)
+{
+	AudioMemory(20);
+	response();
+	thdn();
+	latency();
+	return host_result("loopback analyzer, known path");
+}
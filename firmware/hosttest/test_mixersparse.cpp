@@ -0,0 +1,173 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// AudioMixer<4> against AudioMixer4, bit for bit. Two sets of random
+// sources play the same blocks, one into each mixer; inputs 1 and 3 of
+// the sparse mixer are also read by a watcher, so their blocks are
+// shared, inputs 0 and 2 are its own. The gains change every few blocks
+// through muted, single unity, shared unity and mixed settings. Checked:
+// equal outputs, a shared block never written (the watcher finds the
+// samples the source sent), every block released in the update it came
+// in, muted inputs included, and each way the sum is made actually
+// taken: in place into an input block nobody else holds, a shared
+// block passed on at unity, a new block.
+
+#include "host.h"
+#include "mixer.h"
+
+#define BLOCKS	20000
+#define SPAN	8
+
+// random blocks, some at full scale so the sums saturate, or nothing
+class RandomSource : public AudioStream
+{
+public:
+	RandomSource(uint32_t s) : AudioStream(0, NULL), last(NULL), seed(s) { }
+	virtual void update(void) {
+		uint32_t r = host_rand(&seed);
+		int shift = 16 + (r >> 30);
+
+		last = NULL;
+		if ((r & 0xFF) < 40) return;
+		audio_block_t *block = allocate();
+		if (!block) return;
+		for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			sent[i] = (int32_t)host_rand(&seed) >> shift;
+			block->data[i] = sent[i];
+		}
+		transmit(block);
+		release(block);
+		last = block;
+	}
+	const audio_block_t *last;	// this update's block, NULL for none
+	int16_t sent[AUDIO_BLOCK_SAMPLES];
+private:
+	uint32_t seed;
+};
+
+// a second reader of two sources, after the mixer in the update order
+class Watcher : public AudioStream
+{
+public:
+	Watcher(void) : AudioStream(2, inputQueueArray), written(0) { }
+	void watch(RandomSource *a, RandomSource *b) {
+		src[0] = a;
+		src[1] = b;
+	}
+	virtual void update(void) {
+		for (int i=0; i < 2; i++) {
+			audio_block_t *block = receiveReadOnly(i);
+			if (!block) continue;
+			if (memcmp(block->data, src[i]->sent, sizeof(block->data))) written++;
+			release(block);
+		}
+	}
+	int written;
+private:
+	RandomSource *src[2];
+	audio_block_t *inputQueueArray[2];
+};
+
+// the output of a mixer, NULL for none
+class BlockProbe : public AudioStream
+{
+public:
+	BlockProbe(void) : AudioStream(1, inputQueueArray), last(NULL) { }
+	virtual void update(void) {
+		audio_block_t *block = receiveReadOnly();
+		last = block;
+		if (block) {
+			memcpy(data, block->data, sizeof(data));
+			release(block);
+		} else {
+			memset(data, 0, sizeof(data));
+		}
+	}
+	const audio_block_t *last;
+	int16_t data[AUDIO_BLOCK_SAMPLES];
+private:
+	audio_block_t *inputQueueArray[1];
+};
+
+static RandomSource srcA[4] = {RandomSource(11), RandomSource(12), RandomSource(13), RandomSource(14)};
+static RandomSource srcB[4] = {RandomSource(11), RandomSource(12), RandomSource(13), RandomSource(14)};
+static AudioMixer<4> sparse;
+static AudioMixer4 mixer;
+static Watcher watcher;
+static BlockProbe probeSparse, probeMixer;
+static AudioConnection a0(srcA[0], 0, sparse, 0), a1(srcA[1], 0, sparse, 1);
+static AudioConnection a2(srcA[2], 0, sparse, 2), a3(srcA[3], 0, sparse, 3);
+static AudioConnection b0(srcB[0], 0, mixer, 0), b1(srcB[1], 0, mixer, 1);
+static AudioConnection b2(srcB[2], 0, mixer, 2), b3(srcB[3], 0, mixer, 3);
+static AudioConnection w1(srcA[1], 0, watcher, 0), w3(srcA[3], 0, watcher, 1);
+static AudioConnection p0(sparse, probeSparse), p1(mixer, probeMixer);
+
+static const float presets[][4] = {
+	{1, 0, 0, 0},		// own block at unity, in place
+	{0, 1, 0, 0},		// shared block at unity, passed on
+	{0, 0, 0, 0},		// all muted
+	{0, 1, 0, 1},		// shared blocks only, a new block
+	{0.5f, -1, 0, 2},
+	{0, 0, 1.5f, 1},
+	{1, 1, 1, 1},
+};
+static const float levels[8] = {0, 0, 1, -1, 0.5f, 1.7f, -3.2f, 0.25f};
+
+int main(void)
+{
+	const int npresets = sizeof(presets) / sizeof(presets[0]);
+	int wrong = 0, held = 0, inplace = 0, passed = 0, fresh = 0;
+	uint32_t seed = 5;
+
+	watcher.watch(&srcA[1], &srcA[3]);
+	AudioMemory(20);
+	for (int b=0; b < BLOCKS; b++) {
+		if (b % SPAN == 0) {
+			int p = (b / SPAN) % (npresets + 4);
+			for (int c=0; c < 4; c++) {
+				float g = p < npresets ? presets[p][c] : levels[host_rand(&seed) >> 29];
+				sparse.gain(c, g);
+				mixer.gain(c, g);
+			}
+		}
+		host_update();
+		if (memcmp(probeSparse.data, probeMixer.data, sizeof(probeSparse.data))) {
+			if (wrong++ < 4) printf("  block %d differs\n", b);
+		}
+		if (AudioMemoryUsage() != 0) held++;
+		const audio_block_t *out = probeSparse.last;
+		if (!out) continue;
+		if (out == srcA[0].last || out == srcA[2].last) inplace++;
+		else if (out == srcA[1].last || out == srcA[3].last) passed++;
+		else fresh++;
+	}
+	printf("  %d blocks: %d summed in place, %d passed on, %d new, %d differ\n",
+		BLOCKS, inplace, passed, fresh, wrong);
+	HOST_CHECK(wrong == 0, "%d blocks differ from AudioMixer4", wrong);
+	HOST_CHECK(watcher.written == 0, "%d shared blocks written", watcher.written);
+	HOST_CHECK(held == 0, "%d updates left blocks held", held);
+	HOST_CHECK(inplace > 0 && passed > 0 && fresh > 0, "a way of summing not taken");
+	HOST_CHECK(AudioMemoryUsageMax() <= 9, "%d blocks used at most", (int)AudioMemoryUsageMax());
+	return host_result("sparse mixer against AudioMixer4");
+}
@@ -0,0 +1,228 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// AudioMixerStereo<9> against two AudioMixer4 cascades, one per side,
+// the way the firmware mixed its sources before. Inputs 0 to 3 are two
+// stereo players, 4 to 8 mono sources, each played by two sets of
+// random sources with the same blocks, one set into each graph. Inputs
+// 1 and 6 are also read by a watcher, their blocks are shared. The
+// gains change every few blocks: the firmware's wav and single source
+// settings, panned, muted and random ones, linked (same gain on both
+// sides) or not. Levels stay out of saturation, where the summing order
+// of the two graphs would differ. Checked: both outputs equal to the
+// cascades, shared blocks never written, every block released in its
+// update, and linked sums sent as one block to both sides, input blocks
+// summed into or passed on, and new blocks all taken.
+
+#include "host.h"
+#include "mixer.h"
+
+#define BLOCKS	20000
+#define SPAN	8
+#define INPUTS	9
+
+// random blocks at a level nine of which sum without clipping, or nothing
+class RandomSource : public AudioStream
+{
+public:
+	RandomSource(uint32_t s) : AudioStream(0, NULL), last(NULL), seed(s) { }
+	virtual void update(void) {
+		uint32_t r = host_rand(&seed);
+
+		last = NULL;
+		if ((r & 0xFF) < 40) return;
+		audio_block_t *block = allocate();
+		if (!block) return;
+		for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			sent[i] = (int32_t)host_rand(&seed) >> 20;
+			block->data[i] = sent[i];
+		}
+		transmit(block);
+		release(block);
+		last = block;
+	}
+	const audio_block_t *last;	// this update's block, NULL for none
+	int16_t sent[AUDIO_BLOCK_SAMPLES];
+private:
+	uint32_t seed;
+};
+
+// a second reader of two sources, after the mixer in the update order
+class Watcher : public AudioStream
+{
+public:
+	Watcher(void) : AudioStream(2, inputQueueArray), written(0) { }
+	void watch(RandomSource *a, RandomSource *b) {
+		src[0] = a;
+		src[1] = b;
+	}
+	virtual void update(void) {
+		for (int i=0; i < 2; i++) {
+			audio_block_t *block = receiveReadOnly(i);
+			if (!block) continue;
+			if (memcmp(block->data, src[i]->sent, sizeof(block->data))) written++;
+			release(block);
+		}
+	}
+	int written;
+private:
+	RandomSource *src[2];
+	audio_block_t *inputQueueArray[2];
+};
+
+// both outputs of a graph, NULL and silence for none
+class StereoProbe : public AudioStream
+{
+public:
+	StereoProbe(void) : AudioStream(2, inputQueueArray) { }
+	virtual void update(void) {
+		for (int i=0; i < 2; i++) {
+			audio_block_t *block = receiveReadOnly(i);
+			last[i] = block;
+			if (block) {
+				memcpy(data[i], block->data, sizeof(data[i]));
+				release(block);
+			} else {
+				memset(data[i], 0, sizeof(data[i]));
+			}
+		}
+	}
+	const audio_block_t *last[2];
+	int16_t data[2][AUDIO_BLOCK_SAMPLES];
+private:
+	audio_block_t *inputQueueArray[2];
+};
+
+#define SOURCES(n) {RandomSource(n), RandomSource(n + 1), RandomSource(n + 2), \
+	RandomSource(n + 3), RandomSource(n + 4), RandomSource(n + 5), RandomSource(n + 6), \
+	RandomSource(n + 7), RandomSource(n + 8)}
+static RandomSource srcA[INPUTS] = SOURCES(21);
+static RandomSource srcB[INPUTS] = SOURCES(21);
+static AudioMixerStereo<INPUTS> stereo;
+// per side: inputs 0-3 and 4-7 into two mixers, those and input 8 into a third
+static AudioMixer4 mix1[2], mix2[2], mix3[2];
+static Watcher watcher;
+static StereoProbe probeStereo, probeCascade;
+
+// gains of the stereo inputs, left and right
+struct setting {
+	float g[INPUTS][2];
+};
+static const setting presets[] = {
+	// wav player: the left and right inputs to their sides, unlinked
+	{{{1, 0}, {0, 1}, {1, 0}, {0, 1}}},
+	// one mono source of its own, linked, summed in place or passed on
+	{{{0, 0}, {0, 0}, {0, 0}, {0, 0}, {1, 1}}},
+	// one shared mono source, passed on to both sides
+	{{{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {1, 1}}},
+	// all muted
+	{{{0, 0}}},
+	// a panned source: the left side may not sum into what the right reads
+	{{{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0.5f, 1}}},
+	// shared wav input 1 at unity on the left only
+	{{{0, 0}, {1, 0}}},
+	// everything, linked
+	{{{1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}}},
+};
+static const float levels[8] = {0, 0, 0, 1, -1, 0.5f, 0.25f, -0.75f};
+
+static void apply(const setting &s)
+{
+	for (int c=0; c < INPUTS; c++) {
+		stereo.gain(c, s.g[c][0], s.g[c][1]);
+		for (int side=0; side < 2; side++) {
+			float g = s.g[c][side];
+			if (c < 4) mix1[side].gain(c, g);
+			else if (c < 8) mix2[side].gain(c - 4, g);
+			else mix3[side].gain(2, g);
+		}
+	}
+}
+
+int main(void)
+{
+	const int npresets = sizeof(presets) / sizeof(presets[0]);
+	int wrong = 0, held = 0, shared_out = 0, borrowed = 0, fresh = 0, split = 0;
+	uint32_t seed = 9;
+
+	for (int c=0; c < INPUTS; c++) {
+		new AudioConnection(srcA[c], 0, stereo, c);
+		for (int side=0; side < 2; side++) {
+			AudioStream &m = c < 4 ? mix1[side] : c < 8 ? mix2[side] : mix3[side];
+			new AudioConnection(srcB[c], 0, m, c < 8 ? c % 4 : 2);
+		}
+	}
+	for (int side=0; side < 2; side++) {
+		new AudioConnection(mix1[side], 0, mix3[side], 0);
+		new AudioConnection(mix2[side], 0, mix3[side], 1);
+		mix3[side].gain(3, 0);
+		new AudioConnection(mix3[side], 0, probeCascade, side);
+		new AudioConnection(stereo, side, probeStereo, side);
+	}
+	new AudioConnection(srcA[1], 0, watcher, 0);
+	new AudioConnection(srcA[6], 0, watcher, 1);
+	watcher.watch(&srcA[1], &srcA[6]);
+	AudioMemory(40);
+
+	for (int b=0; b < BLOCKS; b++) {
+		if (b % SPAN == 0) {
+			int p = (b / SPAN) % (npresets + 4);
+			setting s;
+			if (p < npresets) {
+				s = presets[p];
+			} else {
+				bool linked = p & 1;
+				for (int c=0; c < INPUTS; c++) {
+					s.g[c][0] = levels[host_rand(&seed) >> 29];
+					s.g[c][1] = linked ? s.g[c][0] : levels[host_rand(&seed) >> 29];
+				}
+			}
+			apply(s);
+		}
+		host_update();
+		if (memcmp(probeStereo.data, probeCascade.data, sizeof(probeStereo.data))) {
+			if (wrong++ < 4) printf("  block %d differs\n", b);
+		}
+		if (AudioMemoryUsage() != 0) held++;
+		for (int side=0; side < 2; side++) {
+			const audio_block_t *out = probeStereo.last[side];
+			bool input = false;
+			if (!out) continue;
+			for (int c=0; c < INPUTS; c++) if (out == srcA[c].last) input = true;
+			if (input) borrowed++;
+			else fresh++;
+		}
+		if (probeStereo.last[0] && probeStereo.last[0] == probeStereo.last[1]) shared_out++;
+		if (probeStereo.last[0] && probeStereo.last[1]
+		  && probeStereo.last[0] != probeStereo.last[1]) split++;
+	}
+	printf("  %d blocks: %d sides from an input block, %d new, %d sent to both, "
+		"%d split, %d differ\n", BLOCKS, borrowed, fresh, shared_out, split, wrong);
+	HOST_CHECK(wrong == 0, "%d blocks differ from the AudioMixer4 cascades", wrong);
+	HOST_CHECK(watcher.written == 0, "%d shared blocks written", watcher.written);
+	HOST_CHECK(held == 0, "%d updates left blocks held", held);
+	HOST_CHECK(borrowed > 0 && fresh > 0 && shared_out > 0 && split > 0,
+		"a way of summing not taken");
+	return host_result("stereo mixer against two AudioMixer4 cascades");
+}
@@ -0,0 +1,179 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioSynthMLS and the periodic noise generators:
+// - every order's tap mask gives a maximum length sequence, every
+//   nonzero order bit window appears exactly once per period
+// - impulseResponse() recovers a known FIR from one captured period
+// - white and pink noise with period(bits) repeat bit exactly, up to
+//   2^22 samples (also built with 64 sample blocks, test_mls_64)
+
+#include "host.h"
+#include "synth_mls.h"
+#include "synth_whitenoise.h"
+#include "synth_pinknoise.h"
+
+// records n samples of "gen" into out, one update() at a time, one
+// generator per type
+template <class Gen>
+static void run(Gen &gen, std::vector<int16_t> &out, uint32_t n)
+{
+	static HostSink<> sink;
+	static AudioConnection c(gen, sink);
+
+	out.assign(n, 0);
+	sink.record(out.data(), n);
+	while (sink.recorded() < n) {
+		gen.update();
+		sink.update();
+	}
+}
+
+static void taps(void)
+{
+	static AudioSynthMLS mls;
+	std::vector<int16_t> out;
+	std::vector<uint8_t> seen;
+
+	mls.amplitude(1.0);
+	for (int order=AUDIO_MLS_MIN_ORDER; order <= AUDIO_MLS_MAX_ORDER; order++) {
+		uint32_t len = (1UL << order) - 1, window = 0, bad = 0, ones = 0;
+		mls.order(order);
+		run(mls, out, len + order);
+		HOST_CHECK(mls.length() == len, "order %d: length() %u", order, mls.length());
+		seen.assign(len + 1, 0);
+		for (uint32_t n=0; n < len + order; n++) {
+			uint32_t bit = out[n] < 0;
+			window = ((window << 1) | bit) & len;
+			if (n < len) ones += bit;
+			if (n + 1 < (uint32_t)order) continue;
+			if (n + 1 - order >= len) break;
+			if (window == 0 || seen[window]++) bad++;
+		}
+		// the sequence starts again after exactly one period
+		for (int n=0; n < order; n++) {
+			if (out[len + n] != out[n]) bad++;
+		}
+		HOST_CHECK(bad == 0 && ones == (len + 1) / 2,
+			"order %d: %u repeated windows, %u ones", order, bad, ones);
+	}
+}
+
+// y = sum h[k] * x[n-k], rounded to 16 bits
+class FirPath : public AudioStream
+{
+public:
+	FirPath(const double *taps, unsigned int n) : AudioStream(1, inputQueueArray),
+	  h(taps), ntaps(n), pos(0) { memset(line, 0, sizeof(line)); }
+	virtual void update(void) {
+		audio_block_t *block = receiveWritable();
+		if (!block) return;
+		for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			line[pos & 63] = block->data[i];
+			double y = 0.0;
+			for (unsigned int k=0; k < ntaps; k++) y += h[k] * line[(pos - k) & 63];
+			pos++;
+			block->data[i] = (int16_t)lrint(y);
+		}
+		transmit(block);
+		release(block);
+	}
+private:
+	const double *h;
+	unsigned int ntaps, pos;
+	int16_t line[64];
+	audio_block_t *inputQueueArray[1];
+};
+
+static void impulse(void)
+{
+	static const double h[24] = {0, 0, 0, 0, 0, 0.5, -0.25, 0.125, 0, 0, 0, 0,
+		0.3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -0.05};
+	static const int orders[] = {3, 8, 12, 16};
+	static AudioSynthMLS mls;
+	static FirPath fir(h, 24);
+	static HostSink<> sink;
+	static AudioConnection c1(mls, fir);
+	static AudioConnection c2(fir, sink);
+	std::vector<int16_t> out;
+
+	mls.amplitude(0.5);
+	for (unsigned int o=0; o < sizeof(orders) / sizeof(orders[0]); o++) {
+		int order = orders[o];
+		uint32_t len = (1UL << order) - 1;
+		std::vector<float> data(len), work(len + 1);
+		double err = 0.0;
+		mls.order(order);
+		// a period that starts after the FIR has settled
+		uint32_t start = (24 + len - 1) / len * len;
+		out.assign(start + len, 0);
+		sink.record(out.data(), start + len);
+		while (sink.recorded() < start + len) host_update();
+		for (uint32_t n=0; n < len; n++) data[n] = out[start + n];
+		HOST_CHECK(AudioSynthMLS::impulseResponse(data.data(), work.data(), order),
+			"order %d: impulseResponse() failed", order);
+		// the response wraps around the period at order 3
+		for (uint32_t n=0; n < len; n++) {
+			double expect = 0.0;
+			for (uint32_t k=n; k < 24; k += len) expect += h[k];
+			err = std::max(err, fabs(data[n] / 16383.0 - expect));
+		}
+		printf("  MLS order %2d: impulse response max error %.2e\n", order, err);
+		HOST_CHECK(err < 2e-4, "order %d: impulse response error %f", order, err);
+	}
+	mls.amplitude(0.0);
+}
+
+template <class Noise>
+static void periodic(const char *name)
+{
+	static Noise noise;
+	std::vector<int16_t> out;
+	static const int bits[] = {AUDIO_NOISE_MIN_PERIOD, 16, 17, 22};
+
+	noise.amplitude(1.0);
+	for (unsigned int b=0; b < sizeof(bits) / sizeof(bits[0]); b++) {
+		uint32_t len = 1UL << bits[b], bad = 0, same = 0;
+		noise.period(bits[b]);
+		run(noise, out, 2 * len);
+		for (uint32_t n=0; n < len; n++) {
+			if (out[n] != out[len + n]) bad++;
+			if (out[n] == out[n + len / 2]) same++;
+		}
+		HOST_CHECK(bad == 0, "%s period 2^%d: %u samples differ", name, bits[b], bad);
+		HOST_CHECK(same < len / 16, "%s period 2^%d: repeats every half period", name, bits[b]);
+	}
+	noise.period(0);
+	noise.amplitude(0.0);
+}
+
+int main(void)
+{
+	AudioMemory(20);
+	taps();
+	impulse();
+	periodic<AudioSynthNoiseWhite>("white noise");
+	periodic<AudioSynthNoisePink>("pink noise");
+	return host_result(AUDIO_BLOCK_SAMPLES == 64 ? "MLS and periodic noise, 64 sample blocks"
+		: "MLS and periodic noise");
+}
@@ -0,0 +1,138 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioEffectChorus and AudioEffectFlange on AudioModDelay against the
+// code they replaced (ref_moddelay.h). The chorus must be bit exact for
+// every voice count and delay line length, also those just below a
+// power of two where the taps reach the end of the ring. The flange is
+// compared with an exact fractional delay of the same sines.
+
+#include "host.h"
+#include "effect_chorus.h"
+#include "effect_flange.h"
+#include "ref_moddelay.h"
+
+#define BLOCKS		400
+#define MAX_LENGTH	2048
+
+static int16_t line[MAX_LENGTH], flange_line[MAX_LENGTH], ref_line[MAX_LENGTH];
+static HostSource src;
+static AudioEffectChorus chorus;
+static AudioEffectFlange flange;
+static HostSink<2> sink;
+static AudioConnection c1(src, chorus), c2(src, flange);
+static AudioConnection c3(chorus, 0, sink, 0), c4(flange, 0, sink, 1);
+
+static double sines(double n)
+{
+	double t = n / AudioSampleRate();
+	return 9000 * sin(2 * M_PI * 300 * t) + 6000 * sin(2 * M_PI * 1100 * t + 1) +
+		3000 * sin(2 * M_PI * 3700 * t + 2);
+}
+
+static int16_t x[BLOCKS * AUDIO_BLOCK_SAMPLES];
+static int16_t y_chorus[BLOCKS * AUDIO_BLOCK_SAMPLES], y_flange[BLOCKS * AUDIO_BLOCK_SAMPLES];
+
+static void run(void)
+{
+	int16_t *out[2] = {y_chorus, y_flange};
+
+	src.play(x, BLOCKS * AUDIO_BLOCK_SAMPLES);
+	sink.record(out, BLOCKS * AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < BLOCKS; b++) host_update();
+}
+
+int main(void)
+{
+	static const int lengths[] = {MAX_LENGTH, 1023, 1000, 130, 64, 32};
+	int differ = 0;
+
+	AudioMemory(8);
+	for (int i=0; i < BLOCKS * AUDIO_BLOCK_SAMPLES; i++) x[i] = lrint(sines(i));
+
+	for (int length : lengths) {
+		for (int n=1; n <= AUDIO_MODDELAY_TAPS + 1; n++) {
+			ReferenceChorus ref;
+			int16_t block[AUDIO_BLOCK_SAMPLES];
+			int count = 0;
+
+			memset(ref_line, 0, sizeof(ref_line));
+			ref.begin(ref_line, length, n);
+			HOST_CHECK(chorus.begin(line, length, n), "chorus begin, %d samples, %d voices", length, n);
+			run();
+			for (int b=0; b < BLOCKS; b++) {
+				memcpy(block, x + b * AUDIO_BLOCK_SAMPLES, sizeof(block));
+				ref.process(block);
+				for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+					if (block[i] != y_chorus[b * AUDIO_BLOCK_SAMPLES + i]) count++;
+				}
+			}
+			HOST_CHECK(count == 0, "chorus, %d samples, %d voices: %d samples differ",
+				length, n, count);
+			differ += count;
+		}
+	}
+	printf("  chorus, 1 to %d voices, delay lines of %d to %d samples: %d samples differ\n",
+		AUDIO_MODDELAY_TAPS + 1, lengths[5], lengths[0], differ);
+	HOST_CHECK(!chorus.begin(line, MAX_LENGTH, AUDIO_MODDELAY_TAPS + 2), "chorus took %d voices",
+		AUDIO_MODDELAY_TAPS + 2);
+	HOST_CHECK(!chorus.begin(line, 31, 2), "chorus took a 31 sample delay line");
+	chorus.begin(line, MAX_LENGTH, 1);
+
+	static const struct {
+		int length, offset, depth;
+		float rate;
+	} flanges[] = {{MAX_LENGTH, 100, 50, 0.5f}, {MAX_LENGTH, 40, 30, 2.0f},
+		{MAX_LENGTH, 400, 200, 0.2f}, {1000, 400, 90, 1.0f}};
+	for (auto &f : flanges) {
+		ReferenceFlange ref;
+		int16_t block[AUDIO_BLOCK_SAMPLES];
+		double e_old = 0, e_new = 0;
+		int count = 0;
+
+		memset(ref_line, 0, sizeof(ref_line));
+		ref.begin(ref_line, f.length, f.offset, f.depth, f.rate);
+		flange.begin(flange_line, f.length, f.offset, f.depth, f.rate);
+		run();
+		for (int b=0; b < BLOCKS; b++) {
+			memcpy(block, x + b * AUDIO_BLOCK_SAMPLES, sizeof(block));
+			ref.process(block);
+			for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+				int k = b * AUDIO_BLOCK_SAMPLES + i;
+				if (k < f.length) continue;
+				double d = f.offset + f.depth * sin(2 * M_PI * f.rate * k / AudioSampleRate());
+				double exact = (sines(k) + sines(k - d)) / 2;
+				e_old += (block[i] - exact) * (block[i] - exact);
+				e_new += (y_flange[k] - exact) * (y_flange[k] - exact);
+				count++;
+			}
+		}
+		e_old = sqrt(e_old / count);
+		e_new = sqrt(e_new / count);
+		printf("  flange %4d +/- %3d samples at %.1f Hz, %4d sample line: rms error %.1f LSB, "
+			"old %.1f\n", f.offset, f.depth, f.rate, f.length, e_new, e_old);
+		HOST_CHECK(e_new < 40 && e_new < e_old / 10, "flange %d +/- %d: %.1f LSB rms, old %.1f",
+			f.offset, f.depth, e_new, e_old);
+	}
+	return host_result("chorus and flange on the modulated delay line");
+}
@@ -0,0 +1,135 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// AudioSynthNoiseMulti against the generators it is built from:
+// - white streams are the Park-Miller sequence (16807^n mod 2^31-1)
+//   from the documented start points, computed here with 64 bit math
+// - pink streams give the same output as the scalar build, a golden
+//   hash, and are uncorrelated
+// Built scalar, SSE4.1 and native like test_dspinst.
+
+#include "host.h"
+#include "synth_noisemulti.h"
+
+#define BLOCKS	64
+#define LONG	4000	// pink noise needs long runs for a correlation
+
+static uint32_t powmod(uint64_t b, uint32_t e)
+{
+	uint64_t r = 1;
+	while (e) {
+		if (e & 1) r = r * b % 0x7FFFFFFF;
+		b = b * b % 0x7FFFFFFF;
+		e >>= 1;
+	}
+	return r;
+}
+
+static AudioSynthNoiseMulti noise;
+static HostSink<AUDIO_NOISE_STREAMS> sink;
+static AudioConnection c0(noise, 0, sink, 0), c1(noise, 1, sink, 1);
+static AudioConnection c2(noise, 2, sink, 2), c3(noise, 3, sink, 3);
+static int16_t out[AUDIO_NOISE_STREAMS][LONG * AUDIO_BLOCK_SAMPLES];
+
+static void run(int blocks = BLOCKS)
+{
+	int16_t *p[AUDIO_NOISE_STREAMS];
+	for (int i=0; i < AUDIO_NOISE_STREAMS; i++) p[i] = out[i];
+	sink.record(p, blocks * AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < blocks; b++) host_update();
+}
+
+// levels of each run, with streams and pairs switched off
+static const float levels[][AUDIO_NOISE_STREAMS] = {
+	{1.0, 1.0, 1.0, 1.0}, {0.5, 0.25, 0.125, 0.999}, {0.3, 0.0, 0.0, 0.0},
+	{0.0, 0.0, 0.7, 0.0}, {0.0, 0.0, 0.0, 0.0}, {1.0, 0.0, 0.0, 1.0}
+};
+#define RUNS (sizeof(levels) / sizeof(levels[0]))
+
+static void white(void)
+{
+	uint64_t state[AUDIO_NOISE_STREAMS];
+	int bad = 0;
+
+	// stream n starts 2^24 n + 1 steps into the sequence from 1
+	for (int i=0; i < AUDIO_NOISE_STREAMS; i++) state[i] = powmod(16807, (i << 24) + 1);
+	noise.type(NOISE_WHITE);
+	for (unsigned int r=0; r < RUNS; r++) {
+		for (int i=0; i < AUDIO_NOISE_STREAMS; i++) noise.amplitude(i, levels[r][i]);
+		run();
+		for (int i=0; i < AUDIO_NOISE_STREAMS; i++) {
+			int32_t gain = levels[r][i] * 65536.0;
+			// a stream moves on when it or its pair partner runs
+			if (!gain && !(int32_t)(levels[r][i ^ 1] * 65536.0)) continue;
+			for (int n=0; n < BLOCKS * AUDIO_BLOCK_SAMPLES; n++) {
+				state[i] = state[i] * 16807 % 0x7FFFFFFF;
+				int16_t expect = ((int64_t)gain * (int16_t)state[i]) >> 16;
+				if (gain && out[i][n] != expect) bad++;
+			}
+		}
+	}
+	HOST_CHECK(bad == 0, "white: %d samples differ from Park-Miller", bad);
+}
+
+static void pink(void)
+{
+	uint32_t hash = 2166136261u;
+	double corr = 0, e0 = 0, e1 = 0;
+
+	noise.type(NOISE_PINK);
+	for (unsigned int r=0; r < RUNS; r++) {
+		for (int i=0; i < AUDIO_NOISE_STREAMS; i++) noise.amplitude(i, levels[r][i]);
+		run();
+		for (int i=0; i < AUDIO_NOISE_STREAMS; i++) {
+			for (int n=0; n < BLOCKS * AUDIO_BLOCK_SAMPLES; n++) {
+				hash = (hash ^ (uint16_t)out[i][n]) * 16777619u;
+			}
+		}
+	}
+	noise.amplitude(1.0);
+	run(LONG);
+	for (int n=0; n < LONG * AUDIO_BLOCK_SAMPLES; n++) {
+		corr += (double)out[0][n] * out[1][n];
+		e0 += (double)out[0][n] * out[0][n];
+		e1 += (double)out[1][n] * out[1][n];
+	}
+	printf("  pink hash %08x, streams 0/1 correlation %.4f\n", hash, corr / sqrt(e0 * e1));
+	HOST_CHECK(hash == 0xededa3a7u, "pink: hash %08x, expected %08x", hash, 0xededa3a7u);
+	HOST_CHECK(fabs(corr / sqrt(e0 * e1)) < 0.05, "pink: streams correlated");
+}
+
+int main(void)
+{
+	AudioMemory(20);
+	white();
+	pink();
+	return host_result(
+#if defined(__AVX2__)
+		"noise multi, avx2"
+#elif defined(__SSE4_1__)
+		"noise multi, sse4.1"
+#else
+		"noise multi, scalar"
+#endif
+		);
+}
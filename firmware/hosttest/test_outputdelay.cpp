@@ -0,0 +1,236 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// delaySamples() of AudioOutputI2S and AudioOutputAnalog: their
+// interrupts play through output_delayed_half() and output_dac_block()
+// of utility/output_delay.h, run here on a modelled queue. The queue is
+// filled the way the update() of both outputs fills it, the interrupts
+// run at the block rate (two I2S halves, one DAC block per update).
+// Blocks come stereo, mono (one block on both channels), on one
+// channel only or not at all. For every delay each output must be the
+// input stream delayed by exactly that many samples, a missing block
+// being silence; no block may be read after it was released and none
+// may be held once the input has stopped and the delay has played out.
+
+#include "host.h"
+#include "utility/output_delay.h"
+
+#define PERIODS	96
+#define TAIL	3
+
+struct Channel {
+	audio_block_t *first, *second, *prev;
+	uint16_t offset;
+};
+
+static Channel left, right, dac;
+static int read_released;
+
+static bool held(const audio_block_t *b) { return !b || b->ref_count > 0; }
+
+static void check_held(const Channel &c)
+{
+	if (!held(c.first) || !held(c.second) || !held(c.prev)) read_released++;
+}
+
+// the queue of AudioOutputI2S::update() and AudioOutputAnalog::update()
+static void enqueue(Channel &c, audio_block_t *block, audio_block_t **drop)
+{
+	*drop = NULL;
+	if (!c.first) {
+		c.first = block;
+		c.offset = 0;
+	} else if (!c.second) {
+		c.second = block;
+	} else {
+		*drop = c.first;
+		c.first = c.second;
+		c.second = block;
+		c.offset = 0;
+	}
+}
+
+class ModelOutput : public AudioStream
+{
+public:
+	ModelOutput(void) : AudioStream(3, inputQueueArray) { }
+	virtual void update(void) {
+		audio_block_t *block, *drop;
+
+		block = receiveReadOnly(0);
+		if (block) {
+			enqueue(left, block, &drop);
+			if (drop) release(drop);
+		}
+		// the DAC, fed the left channel
+		block = receiveReadOnly(2);
+		if (block) {
+			enqueue(dac, block, &drop);
+			if (drop) release(drop);
+		}
+		block = receiveReadOnly(1);
+		if (block) {
+			enqueue(right, block, &drop);
+			if (drop) release(drop);
+		}
+	}
+	// the delayed branch of AudioOutputI2S::isr()
+	static void i2s_isr(int16_t *dest, uint32_t delay) {
+		audio_block_t *blockL, *blockR;
+
+		check_held(left);
+		check_held(right);
+		blockL = output_delayed_half(dest, &left.first, &left.second,
+		  &left.prev, &left.offset, delay);
+		blockR = output_delayed_half(dest + 1, &right.first, &right.second,
+		  &right.prev, &right.offset, delay);
+		if (blockL) release(blockL);
+		if (blockR) release(blockR);
+	}
+	// the undelayed branch is not modelled, its blocks are only dropped
+	static void i2s_drop(void) {
+		if (left.first) release(left.first);
+		if (right.first) release(right.first);
+		left.first = right.first = NULL;
+	}
+	// AudioOutputAnalog::isr()
+	static void dac_isr(uint16_t *dest, uint32_t delay) {
+		audio_block_t *done;
+
+		check_held(dac);
+		done = output_dac_block(dest, &dac.first, &dac.second, &dac.prev, delay);
+		if (done) release(done);
+	}
+private:
+	audio_block_t *inputQueueArray[3];
+};
+
+// numbered samples on both channels: stereo, mono, one side or nothing,
+// with runs of nothing so tails play into gaps
+class StreamSource : public AudioStream
+{
+public:
+	StreamSource(void) : AudioStream(0, NULL), running(false), seed(1) { }
+	void start(int16_t *l, int16_t *r) {
+		outL = l;
+		outR = r;
+		pos = 0;
+		gap = 0;
+		running = true;
+	}
+	virtual void update(void) {
+		audio_block_t *l = NULL, *r = NULL;
+		uint32_t mode = host_rand(&seed) >> 29;
+
+		if (gap) {
+			gap--;
+			mode = 7;
+		} else if (mode == 6) {
+			gap = host_rand(&seed) >> 30;
+		}
+		if (!running) mode = 7;
+		if (mode <= 3 || mode == 5) l = allocate();
+		if (mode <= 2 || mode == 4) r = allocate();
+		if (mode == 3) r = l;
+		for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++, pos++) {
+			int16_t vl = (int16_t)(pos * 2 + 1), vr = (int16_t)(-pos * 2 - 1);
+			if (mode == 3) vr = vl;
+			if (l) l->data[i] = vl;
+			if (r && r != l) r->data[i] = vr;
+			outL[pos] = l ? vl : 0;
+			outR[pos] = r ? vr : 0;
+		}
+		if (l) transmit(l, 0);
+		if (r) transmit(r, 1);
+		if (l) release(l);
+		if (r && r != l) release(r);
+	}
+	bool running;
+private:
+	int16_t *outL, *outR;
+	uint32_t pos, gap, seed;
+};
+
+#define LENGTH	((PERIODS + TAIL) * AUDIO_BLOCK_SAMPLES)
+
+static int16_t inL[LENGTH], inR[LENGTH], outLR[LENGTH * 2];
+static uint16_t outDAC[LENGTH];
+
+int main(void)
+{
+	static StreamSource src;
+	static ModelOutput out;
+	static AudioConnection c0(src, 0, out, 0), c1(src, 1, out, 1),
+		c2(src, 0, out, 2);
+	int wrong_i2s = 0, wrong_dac = 0, held_after = 0;
+
+	AudioMemory(12);
+	for (uint32_t delay=0; delay <= AUDIO_BLOCK_SAMPLES; delay++) {
+		src.start(inL, inR);
+		for (int p=0; p < PERIODS + TAIL; p++) {
+			if (p == PERIODS) src.running = false;
+			int16_t *dest = outLR + p * AUDIO_BLOCK_SAMPLES * 2;
+			// the update runs in the interrupt that fills the second half
+			host_update();
+			if (delay) {
+				ModelOutput::i2s_isr(dest, delay);
+				ModelOutput::i2s_isr(dest + AUDIO_BLOCK_SAMPLES, delay);
+			} else {
+				ModelOutput::i2s_drop();
+			}
+			ModelOutput::dac_isr(outDAC + p * AUDIO_BLOCK_SAMPLES, delay);
+		}
+		for (uint32_t t=0; t < LENGTH; t++) {
+			int16_t l = t >= delay ? inL[t - delay] : 0;
+			int16_t r = t >= delay ? inR[t - delay] : 0;
+			if (delay && (outLR[2 * t] != l || outLR[2 * t + 1] != r)) {
+				if (wrong_i2s++ < 4) {
+					printf("  delay %u, I2S sample %u: %d %d, expected %d %d\n", delay, t,
+						outLR[2 * t], outLR[2 * t + 1], l, r);
+				}
+			}
+			if (outDAC[t] != ((l + 32767) >> 4)) {
+				if (wrong_dac++ < 4) {
+					printf("  delay %u, DAC sample %u: %u, expected %u\n", delay, t,
+						outDAC[t], (l + 32767) >> 4);
+				}
+			}
+		}
+		// the input stopped TAIL blocks ago, every tail has played
+		if (AudioMemoryUsage() != 0 || left.first || left.prev || right.first
+		  || right.prev || dac.first || dac.prev) {
+			held_after++;
+			left = right = dac = Channel();
+		}
+	}
+	printf("  delays 0 to %d, %d updates each: %d I2S and %d DAC samples wrong, "
+		"%d blocks at most\n", AUDIO_BLOCK_SAMPLES, PERIODS + TAIL, wrong_i2s, wrong_dac,
+		(int)AudioMemoryUsageMax());
+	HOST_CHECK(wrong_i2s == 0, "%d I2S samples differ from the delayed input", wrong_i2s);
+	HOST_CHECK(wrong_dac == 0, "%d DAC samples differ from the delayed input", wrong_dac);
+	HOST_CHECK(read_released == 0, "%d interrupts with a released block queued", read_released);
+	HOST_CHECK(held_after == 0, "%d delays left blocks held", held_after);
+	HOST_CHECK(AudioMemoryUsageMax() <= 4, "%d blocks used at most", (int)AudioMemoryUsageMax());
+	return host_result("I2S and DAC output delay");
+}
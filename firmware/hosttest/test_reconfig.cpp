@@ -0,0 +1,103 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// The audio side of the reconfigCommit()/reconfigUpdate() steps in
+// main.cpp on the faders they use: fade out, wait for isFading() to
+// drop, let the drain time pass, fade in and wait again. Counts the blocks of each step and the samples
+// that left the fader below full level (the glitch) or silent, for the
+// stereo fader with a mono source and the DAC fader. Block clock at
+// 44117 Hz, the codec I2C write and the I2S ISR hold-off are not here.
+
+#include "host.h"
+#include "effect_fade.h"
+
+#define FS	44117.64706
+#define FADE_MS		4	// RECONFIG_FADE_MS
+#define DRAIN_MS	6	// RECONFIG_DRAIN_MS
+#define LENGTH		(64 * AUDIO_BLOCK_SAMPLES)
+
+static int16_t in[LENGTH], left[LENGTH], right[LENGTH], dac[LENGTH];
+static HostSource src;
+static AudioEffectFadeStereo fadeLR;
+static AudioEffectFade fadeDAC;
+static HostSink<3> sink;
+static AudioConnection c1(src, 0, fadeLR, 0), c2(src, 0, fadeLR, 1), c3(src, fadeDAC);
+static AudioConnection c4(fadeLR, 0, sink, 0), c5(fadeLR, 1, sink, 1), c6(fadeDAC, 0, sink, 2);
+
+// updates until both faders are done, at most "limit"
+static int wait_fades(int limit)
+{
+	int n = 0;
+	while ((fadeLR.isFading() || fadeDAC.isFading()) && n < limit) {
+		host_update();
+		n++;
+	}
+	return n;
+}
+
+int main(void)
+{
+	int16_t *out[3] = {left, right, dac};
+	int out_blocks, drain_blocks, in_blocks, glitch[3] = {0}, silent[3] = {0};
+
+	AudioMemory(20);
+	for (int i=0; i < LENGTH; i++) in[i] = 16384;
+	src.play(in, LENGTH);
+	sink.record(out, LENGTH);
+	for (int b=0; b < 4; b++) host_update();
+	HOST_CHECK(!fadeLR.isFading() && !fadeDAC.isFading(), "faders busy before the switch");
+
+	fadeLR.fadeOut(FADE_MS);
+	fadeDAC.fadeOut(FADE_MS);
+	HOST_CHECK(fadeLR.isFading() && fadeDAC.isFading(), "faders idle after fadeOut()");
+	out_blocks = wait_fades(20);
+	drain_blocks = (int)ceil(DRAIN_MS * 1e-3 * FS / AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < drain_blocks; b++) host_update();
+	fadeLR.fadeIn(FADE_MS);
+	fadeDAC.fadeIn(FADE_MS);
+	in_blocks = wait_fades(20);
+	while (sink.recorded() < LENGTH) host_update();
+
+	for (int c=0; c < 3; c++) {
+		for (int i=0; i < LENGTH; i++) {
+			if (out[c][i] != 16384) glitch[c]++;
+			if (out[c][i] == 0) silent[c]++;
+		}
+	}
+	printf("  fade out %d blocks, drain %d, fade in %d: switch %.1f ms\n", out_blocks,
+		drain_blocks, in_blocks, (out_blocks + drain_blocks + in_blocks)
+		* AUDIO_BLOCK_SAMPLES * 1e3 / FS);
+	printf("  below full level: %d samples (%.2f ms), silent %d samples (%.2f ms)\n",
+		glitch[0], glitch[0] * 1e3 / FS, silent[0], silent[0] * 1e3 / FS);
+	HOST_CHECK(out_blocks > 0 && out_blocks < 20 && in_blocks > 0 && in_blocks < 20,
+		"fades did not end: %d/%d blocks", out_blocks, in_blocks);
+	HOST_CHECK(glitch[0] == glitch[1] && glitch[0] == glitch[2] && silent[0] == silent[2],
+		"stereo and DAC faders differ: %d/%d/%d, %d/%d", glitch[0], glitch[1], glitch[2],
+		silent[0], silent[2]);
+	// every sample off full level is inside the switch
+	HOST_CHECK(glitch[0] <= (out_blocks + drain_blocks + in_blocks) * AUDIO_BLOCK_SAMPLES,
+		"%d samples off level, the switch is %d blocks", glitch[0],
+		out_blocks + drain_blocks + in_blocks);
+	HOST_CHECK(silent[0] >= drain_blocks * AUDIO_BLOCK_SAMPLES, "silent for %d samples", silent[0]);
+	return host_result("mode switch fades");
+}
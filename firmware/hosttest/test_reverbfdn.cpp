@@ -0,0 +1,122 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// Decay time of AudioEffectReverbFDN against reverbTime(), every tier
+// with and without modulation. A burst of noise goes in, the T60 is
+// three times the -5 to -25 dB fall of the backward integrated energy
+// of both outputs. reverbTime() sets the low frequency decay, measured
+// through a 300 Hz lowpass; damping() shortens the highs, and with
+// modulation so do the interpolated taps, which the broadband T60 of an
+// undamped reverb shows.
+
+#include "host.h"
+#include "effect_reverb_fdn.h"
+
+#define BURST		8820
+#define BLOCKS		(3 * 345)
+
+static int16_t memory[AUDIO_REVERB_FDN_SAMPLES(16)];
+static int16_t outL[BLOCKS * AUDIO_BLOCK_SAMPLES], outR[BLOCKS * AUDIO_BLOCK_SAMPLES];
+
+static HostSource src;
+static AudioEffectReverbFDN fdn;
+static HostSink<2> sink;
+static AudioConnection c1(src, fdn), c2(fdn, 0, sink, 0), c3(fdn, 1, sink, 1);
+
+// T60 of the recorded tail, lowpassed at fc (two poles) unless fc is 0
+static float t60(float fc)
+{
+	const int n = BLOCKS * AUDIO_BLOCK_SAMPLES;
+	std::vector<double> e(n + 1, 0.0);
+	std::vector<double> l(outL, outL + n), r(outR, outR + n);
+	double a = exp(-2.0 * M_PI * fc / AudioSampleRate());
+	double l1 = 0, l2 = 0, r1 = 0, r2 = 0;
+	int i5 = -1, i25 = -1;
+
+	if (fc > 0.0f) {
+		for (int i=0; i < n; i++) {
+			l1 = a * l1 + (1.0 - a) * l[i];
+			l2 = a * l2 + (1.0 - a) * l1;
+			r1 = a * r1 + (1.0 - a) * r[i];
+			r2 = a * r2 + (1.0 - a) * r1;
+			l[i] = l2;
+			r[i] = r2;
+		}
+	}
+	for (int i=n-1; i >= 0; i--) e[i] = e[i + 1] + l[i] * l[i] + r[i] * r[i];
+	for (int i=BURST; i < n && i25 < 0; i++) {
+		double db = 10.0 * log10(e[i] / e[BURST]);
+		if (i5 < 0 && db < -5.0) i5 = i;
+		if (db < -25.0) i25 = i;
+	}
+	if (i5 < 0 || i25 < 0) return 0.0f;
+	return 3.0f * (i25 - i5) / AudioSampleRate();
+}
+
+static void run(uint32_t lines, bool modulation, float damping, float seconds)
+{
+	static int16_t burst[BURST];
+	int16_t *out[2] = {outL, outR};
+	uint32_t seed = 3;
+
+	for (int i=0; i < BURST; i++) burst[i] = (int32_t)host_rand(&seed) >> 19;
+	fdn.begin(memory, AUDIO_REVERB_FDN_SAMPLES(lines), lines, modulation);
+	fdn.damping(damping);
+	fdn.reverbTime(seconds);
+	sink.record(out, BLOCKS * AUDIO_BLOCK_SAMPLES);
+	src.play(burst, BURST);
+	for (int b=0; b < BLOCKS; b++) host_update();
+}
+
+int main(void)
+{
+	static const uint32_t tiers[3] = {4, 8, 16};
+	static const float times[2] = {1.0f, 2.0f};
+
+	AudioMemory(8);
+	printf("  lines  mod    set  low band  broadband, undamped\n");
+	for (uint32_t lines : tiers) {
+		for (int mod=0; mod < 2; mod++) {
+			for (float set : times) {
+				run(lines, mod, 0.3f, set);
+				float low = t60(300.0f);
+				run(lines, mod, 0.0f, set);
+				float wide = t60(0.0f);
+				printf("  %5u  %-3s  %4.1f s  %6.3f s  %6.3f s\n", lines, mod ? "on" : "off",
+					set, low, wide);
+				HOST_CHECK(fabsf(low / set - 1.0f) < 0.04f, "%u lines, modulation %d: low "
+					"band T60 %.3f s for %.1f s", lines, mod, low, set);
+				if (!mod) {
+					HOST_CHECK(fabsf(wide / set - 1.0f) < 0.02f, "%u lines: broadband "
+						"T60 %.3f s for %.1f s", lines, wide, set);
+				} else {
+					HOST_CHECK(wide > 0.8f * set && wide < set, "%u lines, modulated: "
+						"broadband T60 %.3f s for %.1f s", lines, wide, set);
+				}
+			}
+		}
+	}
+	HOST_CHECK(AudioMemoryUsage() == 0, "%d blocks still held", (int)AudioMemoryUsage());
+	return host_result("FDN reverb decay time");
+}
@@ -0,0 +1,156 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Objects with settings in ms or Hz keep them across a sample rate
+// change: one object set up at 88.2 kHz and then switched to 44.1 kHz
+// must give the same output as one set up at 44.1 kHz. The faders must
+// take the time asked for at the rate they run at.
+
+#include "host.h"
+#include "effect_fade.h"
+#include "effect_envelope.h"
+#include "filter_variable.h"
+#include "synth_simple_drum.h"
+#include "synth_voicepool.h"
+
+#define FS	44117.64706f
+#define FS2	88235.29412f
+#define LENGTH	(32 * AUDIO_BLOCK_SAMPLES)
+
+// samples until a fade out from full level is silent, the table
+// interpolation reaches zero up to 1% early. The stereo fader runs on
+// its left side.
+template <class Fade>
+static int fade_length(float rate, uint32_t milliseconds)
+{
+	static int16_t in[LENGTH], out[LENGTH];
+	static HostSource src;
+	static Fade fade;
+	static HostSink<1> sink;
+	static AudioConnection c1(src, fade), c2(fade, sink);
+	int n;
+
+	AudioStream::setSampleRate(rate);
+	for (int i=0; i < LENGTH; i++) in[i] = 16384;
+	src.play(in, LENGTH);
+	fade.fadeIn(1);
+	while (fade.isFading()) host_update();
+	sink.record(out, LENGTH);
+	fade.fadeOut(milliseconds);
+	while (sink.recorded() < LENGTH) host_update();
+	for (n=0; n < LENGTH && out[n] != 0; n++) ;
+	return n;
+}
+
+// samples where the two channels differ
+static int differ(int16_t *a, int16_t *b)
+{
+	int n = 0;
+	for (int i=0; i < LENGTH; i++) if (a[i] != b[i]) n++;
+	return n;
+}
+
+int main(void)
+{
+	static int16_t noise[LENGTH], ones[LENGTH];
+	static int16_t svf1[LENGTH], svf2[LENGTH], env1[LENGTH], env2[LENGTH];
+	static int16_t drum1[LENGTH], drum2[LENGTH], pool1[LENGTH], pool2[LENGTH];
+	static int32_t memA[AUDIO_DRUM_POOL_WORDS(4)], memB[AUDIO_DRUM_POOL_WORDS(4)];
+	static HostSource src, dc;
+	static AudioFilterStateVariable svfA, svfB;
+	static AudioEffectEnvelope envA, envB;
+	static AudioSynthSimpleDrum drumA, drumB;
+	static AudioSynthSimpleDrumPool poolA(memA, 4), poolB(memB, 4);
+	static HostSink<8> sink;
+	static AudioConnection c1(src, svfA), c2(src, svfB), c3(dc, envA), c4(dc, envB);
+	static AudioConnection c5(svfA, 0, sink, 0), c6(svfB, 0, sink, 1);
+	static AudioConnection c7(envA, 0, sink, 2), c8(envB, 0, sink, 3);
+	static AudioConnection c9(drumA, 0, sink, 4), c10(drumB, 0, sink, 5);
+	static AudioConnection c11(poolA, 0, sink, 6), c12(poolB, 0, sink, 7);
+	int16_t *out[8] = {svf1, svf2, env1, env2, drum1, drum2, pool1, pool2};
+	int n;
+
+	AudioMemory(40);
+	n = fade_length<AudioEffectFade>(FS, 10);
+	HOST_CHECK(n > 441 * 0.99 && n <= 442, "10 ms fade at 44.1 kHz: %d samples", n);
+	n = fade_length<AudioEffectFade>(FS2, 10);
+	HOST_CHECK(n > 882 * 0.99 && n <= 883, "10 ms fade at 88.2 kHz: %d samples", n);
+	n = fade_length<AudioEffectFadeStereo>(FS, 10);
+	HOST_CHECK(n > 441 * 0.99 && n <= 442, "10 ms stereo fade at 44.1 kHz: %d samples", n);
+	n = fade_length<AudioEffectFadeStereo>(FS2, 10);
+	HOST_CHECK(n > 882 * 0.99 && n <= 883, "10 ms stereo fade at 88.2 kHz: %d samples", n);
+
+	// A set up at 88.2 kHz
+	svfA.frequency(2000);
+	svfA.resonance(2.0);
+	envA.attack(5);
+	envA.hold(2);
+	envA.decay(20);
+	envA.sustain(0.5);
+	envA.release(40);
+	drumA.frequency(200);
+	drumA.length(80);
+	poolA.length(80);
+	poolA.noteOn(200);
+	poolA.noteOn(310, 0.5f);
+	AudioStream::setSampleRate(FS);
+	// B set up at 44.1 kHz
+	svfB.frequency(2000);
+	svfB.resonance(2.0);
+	envB.attack(5);
+	envB.hold(2);
+	envB.decay(20);
+	envB.sustain(0.5);
+	envB.release(40);
+	drumB.frequency(200);
+	drumB.length(80);
+	poolB.length(80);
+	poolB.noteOn(200);
+	poolB.noteOn(310, 0.5f);
+
+	host_sines_noise(noise, LENGTH, FS);
+	for (int i=0; i < LENGTH; i++) ones[i] = 16384;
+	src.play(noise, LENGTH);
+	dc.play(ones, LENGTH);
+	sink.record(out, LENGTH);
+	envA.noteOn();
+	envB.noteOn();
+	drumA.noteOn();
+	drumB.noteOn();
+	for (int b=0; sink.recorded() < LENGTH; b++) {
+		if (b == 16) {
+			envA.noteOff();
+			envB.noteOff();
+		}
+		host_update();
+	}
+	n = differ(svf1, svf2);
+	HOST_CHECK(n == 0, "state variable filter: %d samples differ after the rate change", n);
+	n = differ(env1, env2);
+	HOST_CHECK(n == 0, "envelope: %d samples differ after the rate change", n);
+	n = differ(drum1, drum2);
+	HOST_CHECK(n == 0, "simple drum: %d samples differ after the rate change", n);
+	n = differ(pool1, pool2);
+	HOST_CHECK(n == 0, "drum pool: %d samples differ after the rate change", n);
+	return host_result("settings across a sample rate change");
+}
@@ -0,0 +1,163 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// AudioSynthSteppedSine over log spaced tables, rendered on the host:
+// gate edges, the reported windows and the end of the sequence must fall
+// on the sample indices worked out here from the table and the timing,
+// every window must hold a whole number of cycles, and the step changes
+// (zero step glides and ramps of the waveform) must complete inside the
+// block that schedules them. The tight timing puts a step change in
+// nearly every block.
+
+#include "host.h"
+#include "synth_steppedsine.h"
+
+#define FS	44117.64706
+#define MAXLEN	(4 * 1024 * 1024)
+
+// the waveform state the checks look at
+class Probe : public AudioSynthSteppedSine
+{
+public:
+	uint32_t incr(void) { return tone_incr; }
+	uint32_t glideCount(void) { return glide_count; }
+	int32_t glideStep(void) { return glide_step; }
+	uint32_t ampCount(void) { return amp_count; }
+};
+
+static Probe sine;
+static HostSink<2> sink;
+static AudioConnection c0(sine, 0, sink, 0), c1(sine, 1, sink, 1);
+static int16_t wave[MAXLEN], gate[MAXLEN];
+
+// fraction of the energy of n samples in DFT bin c
+static double bin_fraction(const int16_t *x, uint32_t n, uint32_t c)
+{
+	double re = 0.0, im = 0.0, total = 0.0;
+
+	for (uint32_t i=0; i < n; i++) {
+		re += x[i] * cos(2.0 * M_PI * c * i / n);
+		im += x[i] * sin(2.0 * M_PI * c * i / n);
+		total += (double)x[i] * x[i];
+	}
+	return 2.0 * (re * re + im * im) / n / total;
+}
+
+static void run(float fmin, float fmax, unsigned int nsteps, float settle_ms, unsigned int cycles)
+{
+	uint32_t start[AUDIO_STEPPED_MAX], len[AUDIO_STEPPED_MAX], ncyc[AUDIO_STEPPED_MAX];
+	uint32_t incr[AUDIO_STEPPED_MAX];
+	uint32_t settle, pos, end;
+	int windows = 0, late = 0;
+	double worst_fraction = 1.0;
+	int worst_wrap = 0;
+
+	// expected boundaries: settle, window, settle, window...
+	settle = std::max((uint32_t)lrint(settle_ms * FS / 1000.0), (uint32_t)AUDIO_BLOCK_SAMPLES);
+	pos = 0;
+	for (unsigned int s=0; s < nsteps; s++) {
+		double f = fmin * pow((double)fmax / fmin, (double)s / (nsteps - 1));
+		double c = cycles;
+		if (c * FS / f < AUDIO_BLOCK_SAMPLES) c = ceil(AUDIO_BLOCK_SAMPLES * f / FS);
+		ncyc[s] = c;
+		len[s] = lrint(c * FS / f);
+		incr[s] = lrint(c * 2147483648.0 / len[s]);
+		start[s] = pos + settle;
+		pos = start[s] + len[s];
+	}
+	end = pos;
+
+	sine.logSpaced(fmin, fmax, nsteps);
+	sine.timing(settle_ms, cycles);
+	int16_t *rec[2] = {wave, gate};
+	sink.record(rec, MAXLEN);
+	sine.start(0.9f);
+	uint32_t blocks = (end + AUDIO_BLOCK_SAMPLES - 1) / AUDIO_BLOCK_SAMPLES + 4;
+	for (uint32_t b=0; b < blocks; b++) {
+		host_update();
+		// a step change is scheduled and done within one block
+		if (sine.glideCount() || sine.ampCount()) late++;
+		HOST_CHECK(sine.glideStep() == 0, "block %u: glide step %d", b, sine.glideStep());
+		int s = sine.step();
+		if (sine.measuring()) {
+			HOST_CHECK(sine.incr() == incr[s], "step %d: increment %u, expected %u",
+				s, sine.incr(), incr[s]);
+		}
+		if (!sine.available()) continue;
+		s = sine.lastStep();
+		HOST_CHECK(s == windows, "window %d reported as step %d", windows, s);
+		HOST_CHECK(sine.windowStart() == start[windows] && sine.windowLength() == len[windows],
+			"step %d: window %u + %u, expected %u + %u", s,
+			sine.windowStart(), sine.windowLength(), start[windows], len[windows]);
+		windows++;
+	}
+	HOST_CHECK(windows == (int)nsteps, "%d windows of %u", windows, nsteps);
+	HOST_CHECK(late == 0, "%d blocks ended with a step change pending", late);
+	HOST_CHECK(!sine.running() && sine.position() == end, "position %u, expected %u",
+		sine.position(), end);
+
+	// gate edges, the whole cycles and the end of the sine
+	for (unsigned int s=0; s < nsteps; s++) {
+		uint32_t from = s ? start[s - 1] + len[s - 1] : 0;
+		for (uint32_t i=from; i < start[s] + len[s]; i++) {
+			int16_t g = i >= start[s] ? 32767 : 0;
+			if (gate[i] != g) {
+				HOST_CHECK(0, "step %u: gate %d at sample %u, window %u + %u",
+					s, gate[i], i, start[s], len[s]);
+				break;
+			}
+		}
+		double fraction = bin_fraction(wave + start[s], len[s], ncyc[s]);
+		worst_fraction = std::min(worst_fraction, fraction);
+		HOST_CHECK(fraction > 0.9999, "step %u: %.6f of the window in bin %u",
+			s, fraction, ncyc[s]);
+		// the sample after the window is the phase it started with,
+		// the last one is followed by silence
+		if (s == nsteps - 1) continue;
+		int wrap = abs(wave[start[s] + len[s]] - wave[start[s]]);
+		worst_wrap = std::max(worst_wrap, wrap);
+		HOST_CHECK(wrap <= 2, "step %u: %d and %d at both ends of the window",
+			s, wave[start[s]], wave[start[s] + len[s]]);
+	}
+	int tail = 0;
+	for (uint32_t i=end; i < blocks * AUDIO_BLOCK_SAMPLES; i++) {
+		if (wave[i] || gate[i]) tail++;
+	}
+	HOST_CHECK(tail == 0, "%d samples after the last window", tail);
+	HOST_CHECK(wave[end - 1] || wave[end - 2], "the sine stops before sample %u", end);
+	printf("  %2u steps %5.0f to %5.0f Hz, settle %4.1f ms, %2u cycles: %u samples, "
+		"worst window %.7f in its bin, %d LSB across\n", nsteps, fmin, fmax, settle_ms,
+		cycles, end, worst_fraction, worst_wrap);
+}
+
+int main(void)
+{
+	AudioMemory(10);
+	run(20.0f, 20000.0f, 31, 20.0f, 10);
+	run(100.0f, 15000.0f, 24, 5.0f, 3);
+	// settle and windows raised to one block, a change in nearly every block
+	run(2000.0f, 20000.0f, 64, 0.0f, 1);
+	HOST_CHECK(host_memory_used() == 0, "%u blocks not released", host_memory_used());
+	return host_result("stepped sine schedule");
+}
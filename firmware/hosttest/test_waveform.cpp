@@ -0,0 +1,188 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+// Glides and amplitude ramps of AudioSynthWaveform: the phase, the
+// increment and the amplitude follow the per sample recurrence and land
+// on their targets on the exact sample, the output never steps faster
+// than the sine allows, and the cost of a block is the same with and
+// without a glide or ramp running.
+
+#include "host.h"
+#include "synth_waveform.h"
+
+#define FS	44117.64706
+#define BLOCKS	24
+
+// the state the checks look at
+class Probe : public AudioSynthWaveform
+{
+public:
+	uint32_t phase(void) { return tone_phase; }
+	uint32_t incr(void) { return tone_incr; }
+	int32_t amp(void) { return tone_amp; }
+	uint32_t glideTarget(void) { return glide_target; }
+	int32_t glideStep(void) { return glide_step; }
+	uint32_t glideCount(void) { return glide_count; }
+	int32_t ampTarget(void) { return amp_target; }
+	int32_t ampStep(void) { return amp_step; }
+	uint32_t ampCount(void) { return amp_count; }
+};
+
+static Probe wave;
+static HostSink<> sink;
+static AudioConnection c0(wave, sink);
+static int16_t out[BLOCKS * AUDIO_BLOCK_SAMPLES];
+
+// the model of one glide and ramp from the state just after they were set
+struct Model {
+	uint32_t ph, inc, inc_target, glide;
+	int32_t amp, amp_target, inc_step, amp_step;
+	uint32_t ramp, wrap;
+	void start(uint32_t phase_wrap) {
+		wrap = phase_wrap;
+		ph = wave.phase();
+		inc = wave.incr();
+		amp = wave.amp();
+		inc_target = wave.glideTarget();
+		inc_step = wave.glideStep();
+		glide = wave.glideCount();
+		amp_target = wave.ampTarget();
+		amp_step = wave.ampStep();
+		ramp = wave.ampCount();
+	}
+	// the amplitude sample n is made with, then one step of everything
+	int32_t step(void) {
+		int32_t a = amp;
+		ph = (ph + inc) & wrap;
+		if (glide) {
+			inc += inc_step;
+			if (--glide == 0) inc = inc_target;
+		}
+		if (ramp) {
+			amp += amp_step;
+			if (--ramp == 0) amp = amp_target;
+		}
+		return a;
+	}
+};
+
+// runs BLOCKS blocks after a glide or ramp was set, checks the state at
+// the end of each block against the model and returns the largest step
+// between two output samples. "square" checks the magnitude of every
+// sample against the model amplitude.
+static int run(const char *name, bool square)
+{
+	Model m;
+	int worst = 0;
+
+	// the sine keeps its phase in 31 bits, the square in 32
+	m.start(square ? 0xffffffff : 0x7fffffff);
+	sink.record(out, BLOCKS * AUDIO_BLOCK_SAMPLES);
+	for (int b=0; b < BLOCKS; b++) {
+		int32_t a[AUDIO_BLOCK_SAMPLES] = {0};
+		// a block that starts silent is not rendered, the phase stays
+		if (m.amp || m.ramp) {
+			for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) a[i] = m.step();
+		}
+		host_update();
+		HOST_CHECK(wave.phase() == m.ph && wave.incr() == m.inc && wave.amp() == m.amp,
+			"%s, block %d: phase %08x incr %u amp %08x, model %08x %u %08x", name, b,
+			wave.phase(), wave.incr(), wave.amp(), m.ph, m.inc, m.amp);
+		const int16_t *p = out + b * AUDIO_BLOCK_SAMPLES;
+		for (int i=0; square && i < AUDIO_BLOCK_SAMPLES; i++) {
+			HOST_CHECK(abs(p[i]) == a[i] >> 16, "%s, sample %d: %d, amplitude %d",
+				name, b * AUDIO_BLOCK_SAMPLES + i, p[i], a[i] >> 16);
+		}
+	}
+	for (int n=1; n < BLOCKS * AUDIO_BLOCK_SAMPLES; n++) {
+		worst = std::max(worst, abs(out[n] - out[n - 1]));
+	}
+	HOST_CHECK(wave.glideCount() == 0 && wave.ampCount() == 0, "%s: not finished", name);
+	return worst;
+}
+
+// largest step between two samples of a sine of amplitude a at f, plus
+// the table interpolation error
+static int slope(float a, float f)
+{
+	return (int)ceil(a * 32767.0 * 2.0 * sin(M_PI * f / FS)) + 2;
+}
+
+int main(void)
+{
+	static Probe timed;
+	int worst;
+
+	AudioMemory(10);
+
+	// glides end inside a block, 1324 and 322 samples
+	wave.begin(0.8f, 1000.0f, WAVEFORM_SINE);
+	for (int b=0; b < 4; b++) host_update();
+	wave.frequency(4000.0f, 30.0f);
+	HOST_CHECK(wave.glideCount() == 1324, "glide of %u samples", wave.glideCount());
+	worst = run("glide up", false);
+	printf("  glide 1000 -> 4000 Hz: largest step %d, sine slope %d\n", worst, slope(0.8f, 4000.0f));
+	HOST_CHECK(worst <= slope(0.8f, 4000.0f), "glide up: step %d", worst);
+	HOST_CHECK(wave.incr() == wave.glideTarget(), "glide up: increment %u, target %u",
+		wave.incr(), wave.glideTarget());
+	wave.frequency(200.0f, 7.3f);
+	worst = run("glide down", false);
+	printf("  glide 4000 -> 200 Hz: largest step %d, sine slope %d\n", worst, slope(0.8f, 4000.0f));
+	HOST_CHECK(worst <= slope(0.8f, 4000.0f), "glide down: step %d", worst);
+
+	// ramps from silence and back on a sine, full scale at the end
+	wave.amplitude(0.0f);
+	wave.frequency(1000.0f);
+	wave.amplitude(1.0f, 5.0f);
+	worst = run("ramp up", false);
+	printf("  ramp 0 -> 1.0 at 1000 Hz: largest step %d, sine slope %d\n", worst, slope(1.0f, 1000.0f));
+	HOST_CHECK(worst <= slope(1.0f, 1000.0f) + 1, "ramp up: step %d", worst);
+	HOST_CHECK(wave.amp() == 32767 << 16, "ramp up: amplitude %08x", wave.amp());
+	wave.amplitude(0.0f, 11.0f);
+	worst = run("ramp down", false);
+	HOST_CHECK(worst <= slope(1.0f, 1000.0f) + 1, "ramp down: step %d", worst);
+	HOST_CHECK(wave.amp() == 0, "ramp down: amplitude %08x", wave.amp());
+
+	// a square wave outputs the amplitude itself: every sample of a ramp
+	// and of a glide at the same time, ending on different samples
+	wave.begin(0.1f, 60.0f, WAVEFORM_SQUARE);
+	for (int b=0; b < 2; b++) host_update();
+	wave.amplitude(0.9f, 10.0f);
+	wave.frequency(300.0f, 20.0f);
+	run("square ramp", true);
+	HOST_CHECK(wave.amp() == (int32_t)(0.9f * 32767.0) << 16, "square ramp: amplitude %08x", wave.amp());
+	wave.amplitude(0.3f, 3.0f);
+	run("square ramp down", true);
+
+	// cost of a block with nothing running, a glide and a ramp
+	timed.begin(0.5f, 1000.0f, WAVEFORM_SINE);
+	double t_still = host_cycles_median([&]() { timed.update(); });
+	timed.frequency(8000.0f, 100000.0f);
+	timed.amplitude(1.0f, 100000.0f);
+	double t_moving = host_cycles_median([&]() { timed.update(); });
+	printf("  sine block: %.0f host cycles still, %.0f gliding and ramping\n", t_still, t_moving);
+	HOST_CHECK(t_moving < 1.25 * t_still, "%.0f cycles gliding, %.0f still", t_moving, t_still);
+	HOST_CHECK(host_memory_used() == 0, "%u blocks not released", host_memory_used());
+	return host_result("waveform glide and ramp");
+}
@@ -65,6 +65,8 @@
 #include "analyze_notefreq.h"
 #include "analyze_peak.h"
 #include "analyze_rms.h"
+#include "analyze_scope.h"
+#include "analyze_loopback.h"
 #include "control_sgtl5000.h"
 #include "control_wm8731.h"
 #include "control_ak4558.h"
@@ -78,8 +80,12 @@
 #include "effect_delay.h"
 #include "effect_delay_ext.h"
 #include "effect_midside.h"
+#include "effect_moddelay.h"
 #include "effect_reverb.h"
+#include "effect_reverb_fdn.h"
 #include "filter_biquad.h"
+#include "filter_convolution.h"
+#include "filter_eqfit.h"
 #include "filter_fir.h"
 #include "filter_variable.h"
 #include "input_adc.h"
@@ -106,7 +112,13 @@
 #include "synth_dc.h"
 #include "synth_whitenoise.h"
 #include "synth_pinknoise.h"
+#include "synth_mls.h"
+#include "synth_noisemulti.h"
+#include "synth_multitone.h"
+#include "synth_steppedsine.h"
+#include "synth_loop.h"
 #include "synth_karplusstrong.h"
 #include "synth_simple_drum.h"
+#include "synth_voicepool.h"
 
 #endif
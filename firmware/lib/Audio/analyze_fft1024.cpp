@@ -27,33 +27,73 @@
 #include "analyze_fft1024.h"
 #include "sqrt_integer.h"
 #include "utility/dspinst.h"
+#include "utility/dspblock.h"
+#include "utility/rfft_split.h"
 
 
-// 140312 - PAH - slightly faster copy
+// the real FFT needs the samples only, no zeros for the imaginary part
 static void copy_to_fft_buffer(void *destination, const void *source)
 {
-	const uint16_t *src = (const uint16_t *)source;
-	uint32_t *dst = (uint32_t *)destination;
-
-	for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
-		*dst++ = *src++;  // real sample plus a zero for imaginary
-	}
+	memcpy(destination, source, AUDIO_BLOCK_SAMPLES * sizeof(int16_t));
 }
 
-static void apply_window_to_fft_buffer(void *buffer, const void *window)
+// copy one block and apply its part of the window in the same pass
+static void copy_window_to_fft_buffer(void *destination, const void *source, const int16_t *window)
 {
-	int16_t *buf = (int16_t *)buffer;
-	const int16_t *win = (int16_t *)window;;
+	block_window((int16_t *)destination, (const int16_t *)source, window, AUDIO_BLOCK_SAMPLES);
+}
 
-	for (int i=0; i < 1024; i++) {
-		int32_t val = *buf * *win++;
-		//*buf = signed_saturate_rshift(val, 16, 15);
-		*buf = val >> 15;
-		buf += 2;
+// split step, averaging and magnitude for bins first to last-1
+void AudioAnalyzeFFT1024::spectrum(unsigned int first, unsigned int last)
+{
+	for (unsigned int i=first; i < last; i++) {
+		uint32_t magsq = rfft_split_magsq(buffer, i, 512, 1);
+		if (avgshift) {
+			// exponential: sum += (magsq - sum) / 2^avgshift
+			uint32_t avg = sum[i];
+			// steps rounded up, so a bin that goes quiet decays to 0
+			uint32_t round = (1 << avgshift) - 1;
+			if (magsq >= avg) avg += (magsq - avg + round) >> avgshift;
+			else avg -= (avg - magsq + round) >> avgshift;
+			sum[i] = avg;
+			output[i] = sqrt_uint32_approx(avg);
+		} else {
+			// G. Heinzel's paper says we're supposed to average the
+			// magnitude squared, then do the square root at the end.
+			magsq /= naverage;
+			if (count == 0) sum[i] = magsq;
+			else sum[i] += magsq;
+			if (count + 1 >= naverage) output[i] = sqrt_uint32_approx(sum[i]);
+		}
 	}
+}
 
+// copy + window blocks first to last-1 of the frame into the FFT buffer
+void AudioAnalyzeFFT1024::fill(unsigned int first, unsigned int last)
+{
+	for (unsigned int i=first; i < last; i++) {
+		if (window) {
+			copy_window_to_fft_buffer(buffer + i * AUDIO_BLOCK_SAMPLES,
+				blocklist[i]->data, window + i * AUDIO_BLOCK_SAMPLES);
+		} else {
+			copy_to_fft_buffer(buffer + i * AUDIO_BLOCK_SAMPLES, blocklist[i]->data);
+		}
+	}
 }
 
+// The work for one 1024 point spectrum is spread over the 4 updates of
+// the 50% overlap hop, each update does one stage:
+//
+//   state 4: 512 point arm_cfft_radix2_q15 (can't be split without
+//            changing the rounding, so it gets an update of its own)
+//   state 5: real FFT split step + averaging for bins 0 to 255
+//   state 6: the same for bins 256 to 511, output available, then
+//            copy + window blocks 0-3 of the next frame, which
+//            are not needed after that
+//   state 7: 8th block received, copy + window blocks 4-7
+//
+// The buffer is busy until the spectrum is done, so the copy of the
+// next frame can't start earlier than state 6.
 void AudioAnalyzeFFT1024::update(void)
 {
 	audio_block_t *block;
@@ -61,7 +101,7 @@ void AudioAnalyzeFFT1024::update(void)
 	block = receiveReadOnly();
 	if (!block) return;
 
-#if defined(KINETISK)
+#if defined(KINETISK) || defined(DSPINST_HOST)
 	switch (state) {
 	case 0:
 		blocklist[0] = block;
@@ -81,41 +121,39 @@ void AudioAnalyzeFFT1024::update(void)
 		break;
 	case 4:
 		blocklist[4] = block;
+		if (pending) {
+			arm_cfft_radix2_q15(&fft_inst, buffer);
+		}
 		state = 5;
 		break;
 	case 5:
 		blocklist[5] = block;
+		if (pending) {
+			spectrum(0, 256);
+		}
 		state = 6;
 		break;
 	case 6:
 		blocklist[6] = block;
-		state = 7;
-		break;
-	case 7:
-		blocklist[7] = block;
-		// TODO: perhaps distribute the work over multiple update() ??
-		//       github pull requsts welcome......
-		copy_to_fft_buffer(buffer+0x000, blocklist[0]->data);
-		copy_to_fft_buffer(buffer+0x100, blocklist[1]->data);
-		copy_to_fft_buffer(buffer+0x200, blocklist[2]->data);
-		copy_to_fft_buffer(buffer+0x300, blocklist[3]->data);
-		copy_to_fft_buffer(buffer+0x400, blocklist[4]->data);
-		copy_to_fft_buffer(buffer+0x500, blocklist[5]->data);
-		copy_to_fft_buffer(buffer+0x600, blocklist[6]->data);
-		copy_to_fft_buffer(buffer+0x700, blocklist[7]->data);
-		if (window) apply_window_to_fft_buffer(buffer, window);
-		arm_cfft_radix4_q15(&fft_inst, buffer);
-		// TODO: support averaging multiple copies
-		for (int i=0; i < 512; i++) {
-			uint32_t tmp = *((uint32_t *)buffer + i); // real & imag
-			uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
-			output[i] = sqrt_uint32_approx(magsq);
+		if (pending) {
+			spectrum(256, 512);
+			pending = false;
+			if (avgshift || ++count >= naverage) {
+				count = 0;
+				outputflag = true;
+			}
 		}
-		outputflag = true;
+		fill(0, 4);
 		release(blocklist[0]);
 		release(blocklist[1]);
 		release(blocklist[2]);
 		release(blocklist[3]);
+		state = 7;
+		break;
+	case 7:
+		blocklist[7] = block;
+		fill(4, 8);
+		pending = true;
 		blocklist[0] = blocklist[4];
 		blocklist[1] = blocklist[5];
 		blocklist[2] = blocklist[6];
@@ -127,5 +165,3 @@ void AudioAnalyzeFFT1024::update(void)
 	release(block);
 #endif
 }
-
-
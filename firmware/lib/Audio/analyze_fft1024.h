@@ -50,8 +50,10 @@ class AudioAnalyzeFFT1024 : public AudioStream
 {
 public:
 	AudioAnalyzeFFT1024() : AudioStream(1, inputQueueArray),
-	  window(AudioWindowHanning1024), state(0), outputflag(false) {
-		arm_cfft_radix4_init_q15(&fft_inst, 1024, 0, 1);
+	  window(AudioWindowHanning1024), state(0), pending(false),
+	  count(0), naverage(1), avgshift(0), outputflag(false) {
+		// real input FFT: 1024 samples as 512 complex values
+		arm_cfft_radix2_init_q15(&fft_inst, 512, 0, 1);
 	}
 	bool available() {
 		if (outputflag == true) {
@@ -78,8 +80,17 @@ public:
 		} while (binFirst <= binLast);
 		return (float)sum * (1.0 / 16384.0);
 	}
+	// linear average of n spectra, the output rate is divided by n
 	void averageTogether(uint8_t n) {
-		// not implemented yet (may never be, 86 Hz output rate is ok)
+		if (n == 0) n = 1;
+		naverage = n;
+		avgshift = 0;
+	}
+	// running average, every new spectrum is weighted by 1/2^shift and
+	// the output is updated on each one, 0 = back to averageTogether()
+	void averageExponential(uint8_t shift) {
+		if (shift > 15) shift = 15;
+		avgshift = shift;
 	}
 	void windowFunction(const int16_t *w) {
 		window = w;
@@ -87,17 +98,20 @@ public:
 	virtual void update(void);
 	uint16_t output[512] __attribute__ ((aligned (4)));
 private:
-	void init(void);
+	void spectrum(unsigned int first, unsigned int last);
+	void fill(unsigned int first, unsigned int last);
 	const int16_t *window;
 	audio_block_t *blocklist[8];
-	int16_t buffer[2048] __attribute__ ((aligned (4)));
-	//uint32_t sum[512];
-	//uint8_t count;
+	int16_t buffer[1024] __attribute__ ((aligned (4)));
+	uint32_t sum[512];
 	uint8_t state;
-	//uint8_t naverage;
+	bool pending;		// buffer holds a frame still being processed
+	uint8_t count;
+	uint8_t naverage;
+	uint8_t avgshift;
 	volatile bool outputflag;
 	audio_block_t *inputQueueArray[1];
-	arm_cfft_radix4_instance_q15 fft_inst;
+	arm_cfft_radix2_instance_q15 fft_inst;
 };
 
 #endif
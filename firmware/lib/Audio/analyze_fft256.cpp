@@ -27,71 +27,92 @@
 #include "analyze_fft256.h"
 #include "sqrt_integer.h"
 #include "utility/dspinst.h"
+#include "utility/dspblock.h"
+#include "utility/rfft_split.h"
 
 
-// 140312 - PAH - slightly faster copy
+// the real FFT needs the samples only, no zeros for the imaginary part
 static void copy_to_fft_buffer(void *destination, const void *source)
 {
-	const uint16_t *src = (const uint16_t *)source;
-	uint32_t *dst = (uint32_t *)destination;
-
-	for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
-		*dst++ = *src++;  // real sample plus a zero for imaginary
-	}
+	memcpy(destination, source, AUDIO_BLOCK_SAMPLES * sizeof(int16_t));
 }
 
 static void apply_window_to_fft_buffer(void *buffer, const void *window)
 {
 	int16_t *buf = (int16_t *)buffer;
-	const int16_t *win = (int16_t *)window;;
 
-	for (int i=0; i < 256; i++) {
-		int32_t val = *buf * *win++;
-		//*buf = signed_saturate_rshift(val, 16, 15);
-		*buf = val >> 15;
-		buf += 2;
-	}
+	block_window(buf, buf, (const int16_t *)window, 256);
 }
 
-void AudioAnalyzeFFT256::update(void)
-{
-	audio_block_t *block;
-
-	block = receiveReadOnly();
-	if (!block) return;
 #if AUDIO_BLOCK_SAMPLES == 128
-	if (!prevblock) {
-		prevblock = block;
+void AudioAnalyzeFFT256::accumulate(void)
+{
+	if (avgshift) {
+		// exponential: sum += (magsq - sum) / 2^avgshift
+		for (int i=0; i < 128; i++) {
+			uint32_t magsq = rfft_split_magsq(buffer, i, 128, 4);
+			uint32_t avg = sum[i];
+			// steps rounded up, so a bin that goes quiet decays to 0
+			uint32_t round = (1 << avgshift) - 1;
+			if (magsq >= avg) avg += (magsq - avg + round) >> avgshift;
+			else avg -= (avg - magsq + round) >> avgshift;
+			sum[i] = avg;
+			output[i] = sqrt_uint32_approx(avg);
+		}
+		outputflag = true;
 		return;
 	}
-	copy_to_fft_buffer(buffer, prevblock->data);
-	copy_to_fft_buffer(buffer+256, block->data);
-	//window = AudioWindowBlackmanNuttall256;
-	//window = NULL;
-	if (window) apply_window_to_fft_buffer(buffer, window);
-	arm_cfft_radix4_q15(&fft_inst, buffer);
 	// G. Heinzel's paper says we're supposed to average the magnitude
 	// squared, then do the square root at the end.
 	if (count == 0) {
 		for (int i=0; i < 128; i++) {
-			uint32_t tmp = *((uint32_t *)buffer + i);
-			uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+			uint32_t magsq = rfft_split_magsq(buffer, i, 128, 4);
 			sum[i] = magsq / naverage;
 		}
 	} else {
 		for (int i=0; i < 128; i++) {
-			uint32_t tmp = *((uint32_t *)buffer + i);
-			uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+			uint32_t magsq = rfft_split_magsq(buffer, i, 128, 4);
 			sum[i] += magsq / naverage;
 		}
 	}
-	if (++count == naverage) {
+	if (++count >= naverage) {
 		count = 0;
 		for (int i=0; i < 128; i++) {
 			output[i] = sqrt_uint32_approx(sum[i]);
 		}
 		outputflag = true;
 	}
+}
+#endif
+
+void AudioAnalyzeFFT256::update(void)
+{
+	audio_block_t *block;
+
+	block = receiveReadOnly();
+	if (!block) return;
+#if AUDIO_BLOCK_SAMPLES == 128
+	if (!prevblock) {
+		prevblock = block;
+		return;
+	}
+	if (pending) {
+		// FFT was done in the previous update, finish the magnitudes
+		pending = false;
+		accumulate();
+		skip = nholdoff;
+	} else if (skip) {
+		skip--;
+	} else {
+		copy_to_fft_buffer(buffer, prevblock->data);
+		copy_to_fft_buffer(buffer+128, block->data);
+		//window = AudioWindowBlackmanNuttall256;
+		//window = NULL;
+		if (window) apply_window_to_fft_buffer(buffer, window);
+		arm_cfft_radix2_q15(&fft_inst, buffer);
+		if (nholdoff) pending = true;
+		else accumulate();
+	}
 	release(prevblock);
 	prevblock = block;
 #elif AUDIO_BLOCK_SAMPLES == 64
@@ -104,19 +125,15 @@ void AudioAnalyzeFFT256::update(void)
 	if (count == 0) {
 		count = 1;
 		copy_to_fft_buffer(buffer, prevblocks[2]->data);
+		copy_to_fft_buffer(buffer+64, prevblocks[1]->data);
 		copy_to_fft_buffer(buffer+128, prevblocks[1]->data);
-		copy_to_fft_buffer(buffer+256, prevblocks[1]->data);
-		copy_to_fft_buffer(buffer+384, block->data);
+		copy_to_fft_buffer(buffer+192, block->data);
 		if (window) apply_window_to_fft_buffer(buffer, window);
-		arm_cfft_radix4_q15(&fft_inst, buffer);
+		arm_cfft_radix2_q15(&fft_inst, buffer);
 	} else {
 		count = 2;
-		const uint32_t *p = (uint32_t *)buffer;
 		for (int i=0; i < 128; i++) {
-			uint32_t tmp = *p++;
-			int16_t v1 = tmp & 0xFFFF;
-			int16_t v2 = tmp >> 16;
-			output[i] = sqrt_uint32_approx(v1 * v1 + v2 * v2);
+			output[i] = sqrt_uint32_approx(rfft_split_magsq(buffer, i, 128, 4));
 		}
 	}
 	release(prevblocks[2]);
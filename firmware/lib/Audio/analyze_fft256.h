@@ -51,10 +51,15 @@ class AudioAnalyzeFFT256 : public AudioStream
 public:
 	AudioAnalyzeFFT256() : AudioStream(1, inputQueueArray),
 	  window(AudioWindowHanning256), count(0), outputflag(false) {
-		arm_cfft_radix4_init_q15(&fft_inst, 256, 0, 1);
+		// real input FFT: 256 samples as 128 complex values
+		arm_cfft_radix2_init_q15(&fft_inst, 128, 0, 1);
 #if AUDIO_BLOCK_SAMPLES == 128
 		prevblock = NULL;
 		naverage = 8;
+		avgshift = 0;
+		nholdoff = 0;
+		skip = 0;
+		pending = false;
 #elif AUDIO_BLOCK_SAMPLES == 64
 		prevblocks[0] = NULL;
 		prevblocks[1] = NULL;
@@ -86,33 +91,55 @@ public:
 		} while (binFirst <= binLast);
 		return (float)sum * (1.0 / 16384.0);
 	}
+	// linear average of n spectra, the output rate is divided by n
 	void averageTogether(uint8_t n) {
 #if AUDIO_BLOCK_SAMPLES == 128
 		if (n == 0) n = 1;
 		naverage = n;
+		avgshift = 0;
+#endif
+	}
+	// running average, every new spectrum is weighted by 1/2^shift and
+	// the output is updated on each one, 0 = back to averageTogether()
+	void averageExponential(uint8_t shift) {
+#if AUDIO_BLOCK_SAMPLES == 128
+		if (shift > 15) shift = 15;
+		avgshift = shift;
 #endif
 	}
 	void windowFunction(const int16_t *w) {
 		window = w;
 	}
+	// skip n blocks between transforms to save CPU, with n > 0 the FFT
+	// and the magnitude calculation run in two separate update() calls
+	void holdoff(uint8_t n) {
+#if AUDIO_BLOCK_SAMPLES == 128
+		nholdoff = n;
+#endif
+	}
 	virtual void update(void);
 	uint16_t output[128] __attribute__ ((aligned (4)));
 private:
 	const int16_t *window;
 #if AUDIO_BLOCK_SAMPLES == 128
+	void accumulate(void);
 	audio_block_t *prevblock;
 #elif AUDIO_BLOCK_SAMPLES == 64
 	audio_block_t *prevblocks[3];
 #endif
-	int16_t buffer[512] __attribute__ ((aligned (4)));
+	int16_t buffer[256] __attribute__ ((aligned (4)));
 #if AUDIO_BLOCK_SAMPLES == 128
 	uint32_t sum[128];
 	uint8_t naverage;
+	uint8_t avgshift;
+	uint8_t nholdoff;
+	uint8_t skip;
+	bool pending;
 #endif
 	uint8_t count;
 	bool outputflag;
 	audio_block_t *inputQueueArray[1];
-	arm_cfft_radix4_instance_q15 fft_inst;
+	arm_cfft_radix2_instance_q15 fft_inst;
 };
 
 #endif
@@ -0,0 +1,242 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "analyze_loopback.h"
+#include <math.h>
+
+// data_waveforms.c
+extern "C" {
+extern const int16_t AudioWaveformSine[257];
+}
+
+#define STATE_IDLE     0  // doing nothing, blocks are released unread
+#define STATE_SETTLE   1  // skipping blocks while the output settles
+#define STATE_MEASURE  2  // correlating against the local oscillator
+#define STATE_LATENCY  3  // looking for the signal onset on both inputs
+
+// longest window, keeps the squared sums well inside 64 bits
+#define LOOPBACK_MAX_LENGTH  (1UL << 20)
+
+static inline int32_t sine_interp(uint32_t ph)
+{
+	uint32_t index = ph >> 24;
+	uint32_t scale = (ph >> 8) & 0xFFFF;
+	int32_t val1 = AudioWaveformSine[index];
+	int32_t val2 = AudioWaveformSine[index+1];
+	return (val1 * (int32_t)(0x10000 - scale) + val2 * (int32_t)scale) >> 16;
+}
+
+void AudioAnalyzeLoopback::update(void)
+{
+	audio_block_t *block[2];
+	const int16_t *p;
+	uint32_t i, n, ch;
+
+	block[0] = receiveReadOnly(0);
+	block[1] = receiveReadOnly(1);
+
+	if (state == STATE_SETTLE) {
+		if (--settle == 0) {
+			memset(acc, 0, sizeof(acc));
+			memset(&basis, 0, sizeof(basis));
+			count = 0;
+			state = STATE_MEASURE;
+		}
+	} else if (state == STATE_MEASURE) {
+		int16_t loc[AUDIO_BLOCK_SAMPLES], los[AUDIO_BLOCK_SAMPLES];
+		uint32_t ph = phase_accumulator;
+		uint32_t inc = phase_increment;
+		n = length - count;
+		if (n > AUDIO_BLOCK_SAMPLES) n = AUDIO_BLOCK_SAMPLES;
+		// the local oscillator and its sums are shared by both inputs
+		int64_t cc = 0, ss = 0, cs = 0, c = 0, s = 0;
+		for (i=0; i < n; i++) {
+			int32_t vc = sine_interp(ph + 0x40000000);
+			int32_t vs = sine_interp(ph);
+			loc[i] = vc;
+			los[i] = vs;
+			cc += vc * vc;
+			ss += vs * vs;
+			cs += vc * vs;
+			c += vc;
+			s += vs;
+			ph += inc;
+		}
+		basis.cc += cc;
+		basis.ss += ss;
+		basis.cs += cs;
+		basis.c += c;
+		basis.s += s;
+		// a missing block is a silent one, nothing to add
+		for (ch=0; ch < 2; ch++) {
+			if (!block[ch]) continue;
+			p = block[ch]->data;
+			int64_t si = 0, sq = 0, sum = 0, sumsq = 0;
+			for (i=0; i < n; i++) {
+				int32_t x = p[i];
+				si += x * loc[i];
+				sq += x * los[i];
+				sum += x;
+				sumsq += x * x;
+			}
+			acc[ch].i += si;
+			acc[ch].q += sq;
+			acc[ch].sum += sum;
+			acc[ch].sumsq += sumsq;
+		}
+		phase_accumulator += inc * n;
+		count += n;
+		if (count >= length) {
+			memcpy(result, acc, sizeof(result));
+			result_basis = basis;
+			state = STATE_IDLE;
+			new_output = true;
+		}
+	} else if (state == STATE_LATENCY) {
+		for (ch=0; ch < 2; ch++) {
+			if (!block[ch] || onset[ch] != 0xFFFFFFFF) continue;
+			p = block[ch]->data;
+			for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+				if (p[i] > threshold || p[i] < -threshold) {
+					onset[ch] = count + i;
+					break;
+				}
+			}
+		}
+		count += AUDIO_BLOCK_SAMPLES;
+		if (onset[0] != 0xFFFFFFFF && onset[1] != 0xFFFFFFFF) {
+			onset_delay = onset[1] - onset[0];
+			state = STATE_IDLE;
+			new_output = true;
+		} else if (--wait == 0) {
+			onset_delay = -1;
+			state = STATE_IDLE;
+			new_output = true;
+		}
+	}
+	if (block[0]) release(block[0]);
+	if (block[1]) release(block[1]);
+}
+
+float AudioAnalyzeLoopback::frequency(float freq, uint16_t cycles)
+{
+	uint32_t inc, len, blocks;
+
+	if (freq < 1.0) freq = 1.0;
+	else if (freq > AudioSampleRate() / 2) freq = AudioSampleRate() / 2;
+	if (cycles == 0) cycles = 1;
+	// same conversion as AudioSynthWaveform::frequency(), the local
+	// oscillator has to run at exactly the generator frequency
+	inc = (freq * (0x80000000LL/AudioSampleRate())) + 0.5;
+	len = (float)cycles * 2147483648.0f / (float)inc;
+	if (len > LOOPBACK_MAX_LENGTH) len = LOOPBACK_MAX_LENGTH;
+	if (len < AUDIO_BLOCK_SAMPLES) len = AUDIO_BLOCK_SAMPLES;
+	// settle for 4 blocks or 4 periods, whichever is longer
+	blocks = (uint32_t)(4.0f * AudioSampleRate() / freq) / AUDIO_BLOCK_SAMPLES + 1;
+	if (blocks < 4) blocks = 4;
+	if (blocks > 0xFFFF) blocks = 0xFFFF;
+	__disable_irq();
+	phase_increment = inc << 1;
+	phase_accumulator = 0;
+	length = len;
+	settle = blocks;
+	state = STATE_SETTLE;
+	new_output = false;
+	__enable_irq();
+	return inc * (AudioSampleRate() / 2147483648.0);
+}
+
+void AudioAnalyzeLoopback::latency(float amplitude, uint16_t timeout)
+{
+	if (amplitude < 0.0) amplitude = 0.0;
+	else if (amplitude > 1.0) amplitude = 1.0;
+	__disable_irq();
+	threshold = amplitude * 32767.0;
+	onset[0] = onset[1] = 0xFFFFFFFF;
+	count = 0;
+	wait = timeout ? timeout : 1;
+	state = STATE_LATENCY;
+	new_output = false;
+	__enable_irq();
+}
+
+// Least squares fit of mean + a*cos + b*sin to the captured window. The
+// sums are exact, so the fit does not need an integer number of periods
+// in the window and the residual is the noise and distortion power.
+bool AudioAnalyzeLoopback::fit(unsigned int channel, double *a, double *b,
+	double *residual, double *total)
+{
+	const sums_t *r = &result[channel & 1];
+	const basis_t *g = &result_basis;
+	double n = length;
+	double c = g->c, s = g->s;
+	// remove the mean from the basis and the signal
+	double cc = g->cc - c * c / n;
+	double ss = g->ss - s * s / n;
+	double cs = g->cs - c * s / n;
+	double xc = r->i - r->sum * c / n;
+	double xs = r->q - r->sum * s / n;
+	double xx = r->sumsq - (double)r->sum * r->sum / n;
+	double det = cc * ss - cs * cs;
+
+	if (det <= 0.0) return false;
+	*a = (xc * ss - xs * cs) / det;
+	*b = (xs * cc - xc * cs) / det;
+	*residual = xx - (*a * xc + *b * xs);
+	if (*residual < 0.0) *residual = 0.0;
+	*total = xx;
+	return true;
+}
+
+float AudioAnalyzeLoopback::level(unsigned int channel)
+{
+	double a, b, res, tot;
+	if (!fit(channel, &a, &b, &res, &tot)) return 0.0;
+	// the basis amplitude is 32767, full scale is 32768
+	return sqrt(a * a + b * b) * (32767.0 / 32768.0);
+}
+
+float AudioAnalyzeLoopback::gain(void)
+{
+	float ref = level(0);
+	if (ref <= 0.0) return 0.0;
+	return level(1) / ref;
+}
+
+float AudioAnalyzeLoopback::phase(void)
+{
+	double a0, b0, a1, b1, res, tot;
+	if (!fit(0, &a0, &b0, &res, &tot) || !fit(1, &a1, &b1, &res, &tot)) return 0.0;
+	// a*cos + b*sin = A*cos(x + phi), phi = atan2(-b, a)
+	double deg = (atan2(-b1, a1) - atan2(-b0, a0)) * (180.0 / M_PI);
+	if (deg > 180.0) deg -= 360.0;
+	else if (deg <= -180.0) deg += 360.0;
+	return deg;
+}
+
+float AudioAnalyzeLoopback::thdn(void)
+{
+	double a, b, res, tot;
+	if (!fit(1, &a, &b, &res, &tot) || tot <= 0.0) return 0.0;
+	return sqrt(res / tot);
+}
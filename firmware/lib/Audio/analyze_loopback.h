@@ -0,0 +1,96 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef analyze_loopback_h_
+#define analyze_loopback_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+// Loopback measurement of the output path. Input 0 is the reference
+// (the signal sent to the DAC), input 1 is the same signal captured back
+// through the line input. Both are correlated against a local sine/cosine
+// at the test frequency (lock-in) and fitted with mean + a*cos + b*sin,
+// giving the level and phase of the fundamental. The fit residual is what
+// an ideal notch at the test frequency would leave, its RMS is the THD+N.
+// All sums are integer, the float math is done in the read functions.
+class AudioAnalyzeLoopback : public AudioStream
+{
+public:
+	AudioAnalyzeLoopback(void) : AudioStream(2, inputQueueArray),
+	  onset_delay(-1), state(0), new_output(false) { }
+	// measure at freq over "cycles" periods, the first few blocks are
+	// skipped to let the output and the codec filters settle, returns
+	// the frequency the local oscillator actually runs at
+	float frequency(float freq, uint16_t cycles=20);
+	// measure the delay between the reference and the captured signal,
+	// the output must be silent when this is called, the first sample
+	// above "threshold" on each input marks the signal onset
+	void latency(float threshold=0.05, uint16_t timeout=200);
+	void stop(void) { state = 0; }
+	bool available(void) {
+		__disable_irq();
+		bool flag = new_output;
+		if (flag) new_output = false;
+		__enable_irq();
+		return flag;
+	}
+	float level(unsigned int channel);	// fundamental amplitude, 1.0 = full scale
+	float gain(void);			// captured/reference fundamental ratio
+	float phase(void);			// captured - reference, degrees
+	float thdn(void);			// captured signal THD+N ratio
+	int32_t latencySamples(void) { return onset_delay; }	// -1 on timeout
+	virtual void update(void);
+protected:
+	// the local oscillator was set for the old rate, drop the measurement
+	virtual void sampleRateChanged(void) { state = 0; }
+private:
+	struct sums_t {
+		int64_t i, q;		// fundamental correlation
+		int64_t sum, sumsq;	// total power
+	};
+	struct basis_t {
+		int64_t cc, ss, cs;	// local oscillator Gram matrix
+		int64_t c, s;
+	};
+	bool fit(unsigned int channel, double *a, double *b,
+		double *residual, double *total);
+	sums_t acc[2];
+	sums_t result[2];
+	basis_t basis;
+	basis_t result_basis;
+	uint32_t length;		// window length, samples
+	uint32_t count;
+	uint32_t phase_accumulator;
+	uint32_t phase_increment;
+	uint32_t onset[2];		// sample index of the signal onset
+	int32_t onset_delay;
+	uint16_t settle;		// blocks left before the window starts
+	uint16_t wait;			// latency timeout, blocks
+	int16_t threshold;
+	uint8_t state;
+	volatile bool new_output;
+	audio_block_t *inputQueueArray[2];
+};
+
+#endif
@@ -239,7 +239,7 @@ float AudioAnalyzeNoteFrequency::read( void ) {
     __disable_irq( );
     float d = data;
     __enable_irq( );
-    return AUDIO_SAMPLE_RATE_EXACT / d;
+    return AudioSampleRate() / d;
 }
 
 /**
@@ -0,0 +1,79 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "analyze_scope.h"
+
+#define STATE_IDLE          0  // doing nothing, blocks are released unread
+#define STATE_WAIT_TRIGGER  1  // looking for a rising zero crossing
+#define STATE_CAPTURE       2  // copying samples into the trace buffer
+
+void AudioAnalyzeScope::update(void)
+{
+	audio_block_t *block;
+	const int16_t *p;
+	uint32_t offset = 0;
+	uint32_t n;
+	int16_t prev;
+
+	block = receiveReadOnly();
+	if (!block) return;
+	p = block->data;
+
+	if (state == STATE_WAIT_TRIGGER) {
+		prev = last;
+		while (offset < AUDIO_BLOCK_SAMPLES) {
+			if (prev < 0 && p[offset] >= 0) break;
+			prev = p[offset++];
+		}
+		last = prev;
+		if (offset < AUDIO_BLOCK_SAMPLES) {
+			state = STATE_CAPTURE;
+		} else if (--wait == 0) {
+			// no trigger found, capture from the next block
+			count = 0;
+			state = STATE_CAPTURE;
+			release(block);
+			return;
+		}
+	}
+	if (state == STATE_CAPTURE) {
+		n = AUDIO_BLOCK_SAMPLES - offset;
+		if (n > AUDIO_SCOPE_SAMPLES - count) n = AUDIO_SCOPE_SAMPLES - count;
+		memcpy(buffer + count, p + offset, n * sizeof(int16_t));
+		count += n;
+		if (count >= AUDIO_SCOPE_SAMPLES) {
+			state = STATE_IDLE;
+			new_output = true;
+		}
+	}
+	release(block);
+}
+
+void AudioAnalyzeScope::trigger(void)
+{
+	__disable_irq();
+	count = 0;
+	last = 0;
+	wait = timeout ? timeout : 1;
+	state = STATE_WAIT_TRIGGER;
+	__enable_irq();
+}
@@ -0,0 +1,64 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef analyze_scope_h_
+#define analyze_scope_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+// number of samples captured per trace, one per OLED column
+#define AUDIO_SCOPE_SAMPLES	128
+
+class AudioAnalyzeScope : public AudioStream
+{
+public:
+	AudioAnalyzeScope(void) : AudioStream(1, inputQueueArray),
+	  state(0), timeout(8), new_output(false) { }
+	// arm a single capture, the trace starts at the next rising
+	// zero crossing or after "timeout" blocks without one (free run)
+	void trigger(void);
+	void triggerTimeout(uint8_t blocks) { timeout = blocks; }
+	bool available(void) {
+		__disable_irq();
+		bool flag = new_output;
+		if (flag) new_output = false;
+		__enable_irq();
+		return flag;
+	}
+	int16_t read(unsigned int n) {
+		if (n >= AUDIO_SCOPE_SAMPLES) return 0;
+		return buffer[n];
+	}
+	virtual void update(void);
+private:
+	int16_t buffer[AUDIO_SCOPE_SAMPLES];
+	uint32_t count;		// samples captured so far
+	uint8_t state;
+	uint8_t timeout;	// blocks to wait for a trigger
+	uint8_t wait;		// blocks left before free run
+	int16_t last;		// last sample of the previous block
+	volatile bool new_output;
+	audio_block_t *inputQueueArray[1];
+};
+
+#endif
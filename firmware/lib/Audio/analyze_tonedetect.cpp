@@ -27,7 +27,7 @@
 #include "analyze_tonedetect.h"
 #include "utility/dspinst.h"
 
-#if defined(KINETISK)
+#if defined(KINETISK) || defined(DSPINST_HOST)
 
 static inline int32_t multiply_32x32_rshift30(int32_t a, int32_t b) __attribute__((always_inline));
 static inline int32_t multiply_32x32_rshift30(int32_t a, int32_t b)
@@ -157,6 +157,159 @@ AudioAnalyzeToneDetect::operator bool()
 }
 
 
+// Goertzel filter bank
+
+void AudioAnalyzeToneBank::update(void)
+{
+	audio_block_t *block;
+	const int16_t *p;
+	unsigned int n, left;
+
+	block = receiveReadOnly();
+	if (!block) return;
+	if (!enabled) {
+		release(block);
+		return;
+	}
+	p = block->data;
+	left = AUDIO_BLOCK_SAMPLES;
+	do {
+		n = count;
+		if (n > left) n = left;
+		process(p, n);
+		p += n;
+		left -= n;
+		count -= n;
+		if (count == 0) {
+			memcpy(out1, s1, nbins * sizeof(int32_t));
+			memcpy(out2, s2, nbins * sizeof(int32_t));
+			memset(s1, 0, sizeof(s1));
+			memset(s2, 0, sizeof(s2));
+			new_output = true;
+			count = window;
+		}
+	} while (left > 0);
+	release(block);
+}
+
+// two bins per pass keep both states and coefficients in registers,
+// the samples are read once for every pair
+void AudioAnalyzeToneBank::process(const int16_t *data, unsigned int n)
+{
+	const int16_t *p, *end = data + n;
+	int32_t a0, a1, a2, b0, b1, b2, ca, cb, x;
+	unsigned int k;
+
+	for (k=0; k + 1 < nbins; k += 2) {
+		ca = coefficient[k];
+		cb = coefficient[k+1];
+		a1 = s1[k];
+		a2 = s2[k];
+		b1 = s1[k+1];
+		b2 = s2[k+1];
+		p = data;
+		while (p < end) {
+			x = *p++;
+			a0 = x + multiply_32x32_rshift30(ca, a1) - a2;
+			b0 = x + multiply_32x32_rshift30(cb, b1) - b2;
+			a2 = a1;
+			a1 = a0;
+			b2 = b1;
+			b1 = b0;
+		}
+		s1[k] = a1;
+		s2[k] = a2;
+		s1[k+1] = b1;
+		s2[k+1] = b2;
+	}
+	if (k < nbins) {
+		ca = coefficient[k];
+		a1 = s1[k];
+		a2 = s2[k];
+		p = data;
+		while (p < end) {
+			a0 = *p++ + multiply_32x32_rshift30(ca, a1) - a2;
+			a2 = a1;
+			a1 = a0;
+		}
+		s1[k] = a1;
+		s2[k] = a2;
+	}
+}
+
+void AudioAnalyzeToneBank::set_coef(unsigned int bin, int32_t coef)
+{
+	__disable_irq();
+	coefficient[bin] = coef;
+	s1[bin] = 0;
+	s2[bin] = 0;
+	out1[bin] = 0;
+	out2[bin] = 0;
+	if (bin >= nbins) nbins = bin + 1;
+	__enable_irq();
+}
+
+void AudioAnalyzeToneBank::harmonics(float fundamental, unsigned int n, uint16_t cycles)
+{
+	unsigned int i;
+	float len;
+
+	if (n > AUDIO_TONEBANK_BINS) n = AUDIO_TONEBANK_BINS;
+	__disable_irq();
+	enabled = false;
+	nbins = 0;
+	__enable_irq();
+	for (i=0; i < n; i++) {
+		frequency(i, fundamental * (i + 1));
+	}
+	len = (float)AudioSampleRate() / fundamental * (float)cycles + 0.5f;
+	length(len > 65535.0f ? 65535 : (uint16_t)len);
+}
+
+void AudioAnalyzeToneBank::length(uint16_t len)
+{
+	if (len == 0) len = 1;
+	__disable_irq();
+	window = len;
+	count = len;
+	memset(s1, 0, sizeof(s1));
+	memset(s2, 0, sizeof(s2));
+	enabled = nbins > 0;
+	__enable_irq();
+}
+
+float AudioAnalyzeToneBank::read(unsigned int bin)
+{
+	int32_t coef, q1, q2, power;
+	uint16_t len;
+	int64_t power64;
+
+	if (bin >= nbins) return 0.0f;
+	__disable_irq();
+	coef = coefficient[bin];
+	q1 = out1[bin];
+	q2 = out2[bin];
+	len = window;
+	__enable_irq();
+	power64 = (int64_t)q2 * (int64_t)q2;
+	power64 += (int64_t)q1 * (int64_t)q1;
+	power64 -= (((int64_t)q1 * (int64_t)q2) >> 30) * (int64_t)coef;
+	power = power64 >> 28;
+	return sqrtf((float)power) / (float)len;
+}
+
+unsigned int AudioAnalyzeToneBank::read(float *data, unsigned int n)
+{
+	unsigned int i;
+
+	if (n > nbins) n = nbins;
+	for (i=0; i < n; i++) {
+		data[i] = read(i);
+	}
+	return n;
+}
+
+
 #elif defined(KINETISL)
 
 void AudioAnalyzeToneDetect::update(void)
@@ -166,5 +319,12 @@ void AudioAnalyzeToneDetect::update(void)
 	if (block) release(block);
 }
 
+void AudioAnalyzeToneBank::update(void)
+{
+	audio_block_t *block;
+	block = receiveReadOnly();
+	if (block) release(block);
+}
+
 #endif
 
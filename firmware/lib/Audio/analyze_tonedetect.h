@@ -37,9 +37,9 @@ public:
 	  : AudioStream(1, inputQueueArray), thresh(6554), enabled(false) { }
 	void frequency(float freq, uint16_t cycles=10) {
 		set_params((int32_t)(cos((double)freq
-		  * (2.0 * 3.14159265358979323846 / AUDIO_SAMPLE_RATE_EXACT))
+		  * (2.0 * 3.14159265358979323846 / AudioSampleRate()))
 		  * (double)2147483647.999), cycles,
-		  (float)AUDIO_SAMPLE_RATE_EXACT / freq * (float)cycles + 0.5f);
+		  (float)AudioSampleRate() / freq * (float)cycles + 0.5f);
 	}
 	void set_params(int32_t coef, uint16_t cycles, uint16_t len);
 	bool available(void) {
@@ -70,4 +70,55 @@ private:
 	audio_block_t *inputQueueArray[1];
 };
 
+#define AUDIO_TONEBANK_BINS	32
+
+// Goertzel filter bank, all bins share one window length and are updated
+// in a single pass over each block, two bins at a time. Coefficients and
+// states are kept in contiguous arrays. read() scaling is the same as
+// AudioAnalyzeToneDetect::read().
+class AudioAnalyzeToneBank : public AudioStream
+{
+public:
+	AudioAnalyzeToneBank(void)
+	  : AudioStream(1, inputQueueArray), nbins(0), window(0), count(0),
+	  enabled(false), new_output(false) { }
+	// set one bin, the window length is set by harmonics() or length()
+	void frequency(unsigned int bin, float freq) {
+		if (bin >= AUDIO_TONEBANK_BINS) return;
+		set_coef(bin, (int32_t)(cos((double)freq
+		  * (2.0 * 3.14159265358979323846 / AudioSampleRate()))
+		  * (double)2147483647.999));
+	}
+	// bins 0 to n-1 at 1x to n x fundamental, the window is
+	// "cycles" periods of the fundamental so every bin sees whole periods
+	void harmonics(float fundamental, unsigned int n, uint16_t cycles=10);
+	void length(uint16_t len);
+	void stop(void) { enabled = false; }
+	bool available(void) {
+		__disable_irq();
+		bool flag = new_output;
+		if (flag) new_output = false;
+		__enable_irq();
+		return flag;
+	}
+	float read(unsigned int bin);
+	unsigned int read(float *data, unsigned int n);
+	virtual void update(void);
+protected:
+	// the bins were set for the old rate, stop until they are set again
+	virtual void sampleRateChanged(void) { enabled = false; }
+private:
+	void set_coef(unsigned int bin, int32_t coef);
+	void process(const int16_t *p, unsigned int n);
+	int32_t coefficient[AUDIO_TONEBANK_BINS];
+	int32_t s1[AUDIO_TONEBANK_BINS], s2[AUDIO_TONEBANK_BINS];
+	int32_t out1[AUDIO_TONEBANK_BINS], out2[AUDIO_TONEBANK_BINS];
+	uint16_t nbins;		// bins in use
+	uint16_t window;	// number of samples to analyze
+	uint16_t count;		// how many left to analyze
+	bool enabled;
+	volatile bool new_output;
+	audio_block_t *inputQueueArray[1];
+};
+
 #endif
@@ -31,17 +31,7 @@
 
 boolean AudioEffectChorus::begin(short *delayline,int d_length,int n_chorus)
 {
-#if 0
-Serial.print("AudioEffectChorus.begin(Chorus delay line length = ");
-Serial.print(d_length);
-Serial.print(", n_chorus = ");
-Serial.print(n_chorus);
-Serial.println(")");
-#endif
-
-  l_delayline = NULL;
   delay_length = 0;
-  l_circ_idx = 0;
 
   if(delayline == NULL) {
     return(false);
@@ -49,13 +39,15 @@ Serial.println(")");
   if(d_length < 10) {
     return(false);
   }
-  if(n_chorus < 1) {
+  if(n_chorus < 1 || n_chorus > AUDIO_MODDELAY_TAPS + 1) {
+    return(false);
+  }
+  if(!line.begin(delayline, d_length)) {
     return(false);
   }
-  
-  l_delayline = delayline;
   delay_length = d_length/2;
   num_chorus = n_chorus;
+  setTaps();
  
   return(true);
 }
@@ -63,68 +55,57 @@ Serial.println(")");
 void AudioEffectChorus::voices(int n_chorus)
 {
   num_chorus = n_chorus;
+  if(delay_length) setTaps();
+}
+
+void AudioEffectChorus::modulation(float rate, float depth)
+{
+  mod_rate = rate;
+  mod_depth = depth;
+  if(delay_length) setTaps();
+}
+
+// voice k is k * spacing samples late, voice 0 is the dry signal
+void AudioEffectChorus::setTaps(void)
+{
+  int n = num_chorus;
+
+  if(n > AUDIO_MODDELAY_TAPS + 1) n = AUDIO_MODDELAY_TAPS + 1;
+  if(n <= 1) {
+    line.taps(0);
+    return;
+  }
+  int spacing = delay_length/(n - 1) - 1;
+  for(int k = 1; k < n; k++) {
+    line.tap(k - 1, k * spacing, mod_depth, (float)(k - 1)/(n - 1));
+  }
+  line.rate(mod_rate);
+  line.taps(n - 1);
 }
 
-//int last_idx = 0;
 void AudioEffectChorus::update(void)
 {
   audio_block_t *block;
-  short *bp;
-  int sum;
-  int c_idx;
 
-  if(l_delayline == NULL)return;
+  if(delay_length == 0)return;
   
   // do passthru
   // It stores the unmodified data in the delay line so that
   // it isn't as likely to click
   if(num_chorus <= 1) {
-    // Just passthrough
-    block = receiveWritable(0);
+    block = receiveReadOnly(0);
     if(block) {
-      bp = block->data;
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        l_circ_idx++;
-        if(l_circ_idx >= delay_length) {
-          l_circ_idx = 0;
-        }
-        l_delayline[l_circ_idx] = *bp++;
-      }
+      line.write(block->data, AUDIO_BLOCK_SAMPLES);
       transmit(block,0);
       release(block);
     }
     return;
   }
 
-  //          L E F T  C H A N N E L
-
   block = receiveWritable(0);
   if(block) {
-    bp = block->data;
-    uint32_t tmp = delay_length/(num_chorus - 1) - 1;
-    for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-      l_circ_idx++;
-      if(l_circ_idx >= delay_length) {
-        l_circ_idx = 0;
-      }
-      l_delayline[l_circ_idx] = *bp;
-      sum = 0;
-      c_idx = l_circ_idx;
-      for(int k = 0; k < num_chorus; k++) {
-        sum += l_delayline[c_idx];
-        if(num_chorus > 1)c_idx -= tmp;
-        if(c_idx < 0) {
-          c_idx += delay_length;
-        }
-      }
-      *bp++ = sum/num_chorus;
-    }
-
-    // transmit the block
+    line.process(block->data, block->data, AUDIO_BLOCK_SAMPLES);
     transmit(block,0);
     release(block);
   }
 }
-
-
-
@@ -25,6 +25,7 @@
 
 #include "Arduino.h"
 #include "AudioStream.h"
+#include "effect_moddelay.h"
 
 /******************************************************************/
 
@@ -34,24 +35,34 @@
 
 #define CHORUS_DELAY_PASSTHRU -1
 
+// The voices are taps of an AudioModDelay, evenly spaced over half of the
+// delay line, up to AUDIO_MODDELAY_TAPS + 1 voices (begin() fails for
+// more) and a delay line of at least 2 * AUDIO_MODDELAY_SUBBLOCK.
 class AudioEffectChorus : 
 public AudioStream
 {
 public:
   AudioEffectChorus(void):
-  AudioStream(1,inputQueueArray), num_chorus(2)
+  AudioStream(1,inputQueueArray), num_chorus(2), delay_length(0),
+  mod_rate(0), mod_depth(0)
   { }
 
   boolean begin(short *delayline,int delay_length,int n_chorus);
   virtual void update(void);
   void voices(int n_chorus);
+  // slow modulation of the voices, depth in samples, 0 = none (default)
+  void modulation(float rate, float depth);
   
+protected:
+  virtual void sampleRateChanged(void) { line.sampleRateChanged(); }
 private:
+  void setTaps(void);
   audio_block_t *inputQueueArray[1];
-  short *l_delayline;
-  short l_circ_idx;
+  AudioModDelay line;
   int num_chorus;
   int delay_length;
+  float mod_rate;
+  float mod_depth;
 };
 
 #endif
@@ -38,7 +38,7 @@ void AudioEffectDelay::update(void)
 	tail = tailindex;
 	if (++head >= DELAY_QUEUE_SIZE) head = 0;
 	if (head == tail) {
-		release(queue[tail]);
+		if (queue[tail]) release(queue[tail]);
 		if (++tail >= DELAY_QUEUE_SIZE) tail = 0;
 	}
 	queue[head] = receiveReadOnly();
@@ -70,8 +70,10 @@ void AudioEffectDelay::update(void)
 	if (count > maxblocks) {
 		count -= maxblocks;
 		do {
-			release(queue[tail]);
-			queue[tail] = NULL;
+			if (queue[tail]) {
+				release(queue[tail]);
+				queue[tail] = NULL;
+			}
 			if (++tail >= DELAY_QUEUE_SIZE) tail = 0;
 		} while (--count > 0);
 	}
@@ -133,3 +135,141 @@ void AudioEffectDelay::update(void)
 }
 
 
+
+void AudioEffectDelayLine::delaySamples(uint8_t channel, float samples)
+{
+	if (channel >= 8) return;
+	if (samples < 0.0f) samples = 0.0f;
+	float max = maxDelay();
+	if (samples > max) samples = max;
+	uint32_t d = samples * 65536.0f + 0.5f;
+	__disable_irq();
+	if (!(activemask & (1<<channel)) || glide_length < 2) {
+		position[channel] = d;
+		ramp[channel] = 0;
+		ystate[channel] = 0;
+	} else {
+		int64_t diff = (int64_t)d - (int64_t)position[channel];
+		step[channel] = diff / (int32_t)glide_length;
+		ramp[channel] = glide_length;
+	}
+	target[channel] = d;
+	activemask |= (1<<channel);
+	__enable_irq();
+}
+
+// one output block of a tap, reading back from the block just written
+void AudioEffectDelayLine::tap(uint32_t channel, int16_t *dst)
+{
+	const int16_t *buf = buffer;
+	int32_t len = length;
+	uint32_t d = position[channel];
+	uint32_t n = ramp[channel];
+	int32_t s = step[channel];
+	int32_t y = ystate[channel];
+	int32_t i, j, k, eta = 0;
+
+	if (n == 0 && (mode == DELAYLINE_INTERP_NONE || (d & 0xFFFF) == 0)) {
+		// whole samples, a copy in at most two pieces
+		i = head - ((d + 0x8000) >> 16);
+		if (i < 0) i += len;
+		k = len - i;
+		if (k > AUDIO_BLOCK_SAMPLES) k = AUDIO_BLOCK_SAMPLES;
+		memcpy(dst, buf + i, k * sizeof(int16_t));
+		if (k < AUDIO_BLOCK_SAMPLES) {
+			memcpy(dst + k, buf, (AUDIO_BLOCK_SAMPLES - k) * sizeof(int16_t));
+		}
+		ystate[channel] = dst[AUDIO_BLOCK_SAMPLES-1];
+		return;
+	}
+	for (k=0; k < AUDIO_BLOCK_SAMPLES; k++) {
+		uint32_t m, f;
+		if (mode == DELAYLINE_INTERP_NONE) {
+			m = (d + 0x8000) >> 16;
+			i = head + k - m;
+			if (i < 0) i += len;
+			else if (i >= len) i -= len;
+			dst[k] = buf[i];
+		} else if (mode == DELAYLINE_INTERP_LINEAR) {
+			m = d >> 16;
+			f = (d & 0xFFFF) >> 1;
+			i = head + k - m;
+			if (i < 0) i += len;
+			else if (i >= len) i -= len;
+			j = i ? i - 1 : len - 1;
+			int32_t a = buf[i];
+			dst[k] = a + (((buf[j] - a) * (int32_t)f) >> 15);
+		} else {
+			// y = eta * (x[m] - y[n-1]) + x[m+1], eta = (1 - f) / (1 + f)
+			// for a fraction f between 0.5 and 1.5, away from the
+			// eta = -1 pole
+			m = d >> 16;
+			f = d & 0xFFFF;
+			if (f < 0x8000) {
+				if (m > 0) {
+					m--;
+					f += 0x10000;
+				} else {
+					f = 0x8000;
+				}
+			}
+			if (n || k == 0) {
+				eta = ((int32_t)(0x10000 - f) << 15) / (int32_t)(0x10000 + f);
+			}
+			i = head + k - m;
+			if (i < 0) i += len;
+			else if (i >= len) i -= len;
+			j = i ? i - 1 : len - 1;
+			y = (((buf[i] - y) * eta) >> 15) + buf[j];
+			if (y > 32767) y = 32767;
+			else if (y < -32768) y = -32768;
+			dst[k] = y;
+		}
+		if (n) {
+			d += s;
+			if (--n == 0) d = target[channel];
+		}
+	}
+	position[channel] = d;
+	ramp[channel] = n;
+	ystate[channel] = y;
+}
+
+void AudioEffectDelayLine::update(void)
+{
+	audio_block_t *block, *output;
+	uint32_t channel, n;
+
+	// input into the ring, silence when there is none
+	block = receiveReadOnly();
+	if (length == 0) {
+		// no room for a block
+		if (block) release(block);
+		return;
+	}
+	n = length - head;
+	if (n > AUDIO_BLOCK_SAMPLES) n = AUDIO_BLOCK_SAMPLES;
+	if (block) {
+		memcpy(buffer + head, block->data, n * sizeof(int16_t));
+		if (n < AUDIO_BLOCK_SAMPLES) {
+			memcpy(buffer, block->data + n, (AUDIO_BLOCK_SAMPLES - n) * sizeof(int16_t));
+		}
+		release(block);
+	} else {
+		memset(buffer + head, 0, n * sizeof(int16_t));
+		if (n < AUDIO_BLOCK_SAMPLES) {
+			memset(buffer, 0, (AUDIO_BLOCK_SAMPLES - n) * sizeof(int16_t));
+		}
+	}
+
+	for (channel = 0; channel < 8; channel++) {
+		if (!(activemask & (1<<channel))) continue;
+		output = allocate();
+		if (!output) continue;
+		tap(channel, output->data);
+		transmit(output, channel);
+		release(output);
+	}
+	head += AUDIO_BLOCK_SAMPLES;
+	if (head >= length) head -= length;
+}
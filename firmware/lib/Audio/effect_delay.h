@@ -45,7 +45,7 @@ public:
 	void delay(uint8_t channel, float milliseconds) {
 		if (channel >= 8) return;
 		if (milliseconds < 0.0) milliseconds = 0.0;
-		uint32_t n = (milliseconds*(AUDIO_SAMPLE_RATE_EXACT/1000.0))+0.5;
+		uint32_t n = (milliseconds*(AudioSampleRate()/1000.0))+0.5;
 		uint32_t nmax = AUDIO_BLOCK_SAMPLES * (DELAY_QUEUE_SIZE-1);
 		if (n > nmax) n = nmax;
 		uint32_t blks = (n + (AUDIO_BLOCK_SAMPLES-1)) / AUDIO_BLOCK_SAMPLES + 1;
@@ -96,4 +96,71 @@ private:
 	audio_block_t *inputQueueArray[1];
 };
 
+// Samples of memory AudioEffectDelayLine needs for a longest delay of
+// "delay" samples: the delay, the block being written and the
+// interpolation neighbours. Delays are limited to 65535 samples.
+#define AUDIO_DELAYLINE_SAMPLES(delay)	((delay) + AUDIO_BLOCK_SAMPLES + 2)
+
+#define DELAYLINE_INTERP_NONE		0
+#define DELAYLINE_INTERP_LINEAR		1
+#define DELAYLINE_INTERP_ALLPASS	2
+
+// The same 8 taps as AudioEffectDelay, on one circular sample buffer in
+// memory given by the caller instead of a queue of audio blocks, so the
+// audio pool is not touched beyond the output blocks. Delays have 16
+// fraction bits. A new delay glides from the old one over glide()
+// samples, the tap moves smoothly through the buffer and there is no
+// click. Linear interpolation follows fast modulation best, the first
+// order allpass keeps the level flat up to Nyquist for static or slowly
+// moving delays. Memory shorter than AUDIO_DELAYLINE_SAMPLES(0) is not
+// used, the object then transmits nothing and maxDelay() is 0.
+class AudioEffectDelayLine : public AudioStream
+{
+public:
+	AudioEffectDelayLine(int16_t *memory, uint32_t samples) : AudioStream(1, inputQueueArray),
+	  buffer(memory), length(samples >= AUDIO_DELAYLINE_SAMPLES(0) ? samples : 0), head(0), activemask(0),
+	  mode(DELAYLINE_INTERP_LINEAR), glide_length(AUDIO_BLOCK_SAMPLES) {
+		memset(buffer, 0, length * sizeof(int16_t));
+	}
+	void delay(uint8_t channel, float milliseconds) {
+		if (milliseconds < 0.0) milliseconds = 0.0;
+		delaySamples(channel, milliseconds * (AudioSampleRate() / 1000.0));
+	}
+	void delaySamples(uint8_t channel, float samples);
+	void disable(uint8_t channel) {
+		if (channel >= 8) return;
+		activemask &= ~(1<<channel);
+	}
+	// DELAYLINE_INTERP_NONE, _LINEAR (default) or _ALLPASS
+	void interpolation(uint8_t type) {
+		__disable_irq();
+		mode = type;
+		memset(ystate, 0, sizeof(ystate));
+		__enable_irq();
+	}
+	// time a delay change takes in samples, 0 = jump. Default is one block.
+	void glide(uint32_t samples) { glide_length = samples; }
+	// longest delay the memory allows, in samples
+	uint32_t maxDelay(void) {
+		if (length == 0) return 0;
+		uint32_t n = length - AUDIO_BLOCK_SAMPLES - 2;
+		return n < 65535 ? n : 65535;
+	}
+	virtual void update(void);
+private:
+	void tap(uint32_t channel, int16_t *dst);
+	int16_t *buffer;
+	uint32_t length;
+	uint32_t head;			// where the next input block goes
+	uint8_t activemask;
+	uint8_t mode;
+	uint32_t glide_length;
+	uint32_t position[8];		// current delay, 16.16 samples
+	uint32_t target[8];
+	int32_t step[8];		// per sample during a glide
+	uint32_t ramp[8];		// samples left in the glide
+	int32_t ystate[8];		// allpass output history
+	audio_block_t *inputQueueArray[1];
+};
+
 #endif
@@ -44,14 +44,14 @@ public:
 	}
 	AudioEffectDelayExternal(AudioEffectDelayMemoryType_t type, float milliseconds=1e6)
 	  : AudioStream(1, inputQueueArray) {
-		uint32_t n = (milliseconds*(AUDIO_SAMPLE_RATE_EXACT/1000.0f))+0.5f;
+		uint32_t n = (milliseconds*(AudioSampleRate()/1000.0f))+0.5f;
 		initialize(type, n);
 	}
 
 	void delay(uint8_t channel, float milliseconds) {
 		if (channel >= 8 || memory_type >= AUDIO_MEMORY_UNDEFINED) return;
 		if (milliseconds < 0.0) milliseconds = 0.0;
-		uint32_t n = (milliseconds*(AUDIO_SAMPLE_RATE_EXACT/1000.0f))+0.5f;
+		uint32_t n = (milliseconds*(AudioSampleRate()/1000.0f))+0.5f;
 		n += AUDIO_BLOCK_SAMPLES;
 		if (n > memory_length - AUDIO_BLOCK_SAMPLES)
 			n = memory_length - AUDIO_BLOCK_SAMPLES;
@@ -30,7 +30,7 @@
 #include "AudioStream.h"
 #include "utility/dspinst.h"
 
-#define SAMPLES_PER_MSEC (AUDIO_SAMPLE_RATE_EXACT/1000.0)
+#define SAMPLES_PER_MSEC (AudioSampleRate()/1000.0)
 
 class AudioEffectEnvelope : public AudioStream
 {
@@ -47,15 +47,19 @@ public:
 	void noteOn();
 	void noteOff();
 	void delay(float milliseconds) {
+		delay_ms = milliseconds;
 		delay_count = milliseconds2count(milliseconds);
 	}
 	void attack(float milliseconds) {
+		attack_ms = milliseconds;
 		attack_count = milliseconds2count(milliseconds);
 	}
 	void hold(float milliseconds) {
+		hold_ms = milliseconds;
 		hold_count = milliseconds2count(milliseconds);
 	}
 	void decay(float milliseconds) {
+		decay_ms = milliseconds;
 		decay_count = milliseconds2count(milliseconds);
 	}
 	void sustain(float level) {
@@ -64,15 +68,24 @@ public:
 		sustain_mult = level * 65536.0;
 	}
 	void release(float milliseconds) {
+		release_ms = milliseconds;
 		release_count = milliseconds2count(milliseconds);
 	}
 	using AudioStream::release;
 	virtual void update(void);
+	virtual void sampleRateChanged(void) {
+		delay(delay_ms);
+		attack(attack_ms);
+		hold(hold_ms);
+		decay(decay_ms);
+		release(release_ms);
+	}
 private:
 	uint16_t milliseconds2count(float milliseconds) {
 		if (milliseconds < 0.0) milliseconds = 0.0;
 		uint32_t c = ((uint32_t)(milliseconds*SAMPLES_PER_MSEC)+7)>>3;
-		if (c > 1103) return 1103; // allow up to 200 ms
+		uint32_t cmax = AudioSampleRate() / 40.0 + 0.5; // allow up to 200 ms
+		if (c > cmax) return cmax;
 		return c;
 	}
 	audio_block_t *inputQueueArray[1];
@@ -88,6 +101,12 @@ private:
 	uint16_t decay_count;
 	int32_t  sustain_mult;
 	uint16_t release_count;
+	// settings in ms, for rate changes
+	float delay_ms;
+	float attack_ms;
+	float hold_ms;
+	float decay_ms;
+	float release_ms;
 
 };
 
@@ -93,5 +93,91 @@ void AudioEffectFade::fadeBegin(uint32_t newrate, uint8_t dir)
 	__enable_irq();
 }
 
+// The fader gains for one block, 0 to 32767, advances pos
+static uint32_t fade_gains(int16_t *gain, uint32_t pos, uint32_t inc, uint8_t dir)
+{
+	uint32_t i, index, scale;
+	int32_t val1, val2;
+
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		index = pos >> 24;
+		val1 = fader_table[index];
+		val2 = fader_table[index+1];
+		scale = (pos >> 8) & 0xFFFF;
+		val2 *= scale;
+		val1 *= 0x10000 - scale;
+		gain[i] = (val1 + val2) >> 16;
+		if (dir > 0) {
+			if (inc < 0xFFFFFFFF - pos) pos += inc;
+			else pos = 0xFFFFFFFF;
+		} else {
+			if (inc < pos) pos -= inc;
+			else pos = 0;
+		}
+	}
+	return pos;
+}
+
+static void fade_apply(int16_t *dst, const int16_t *src, const int16_t *gain)
+{
+	for (uint32_t i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		dst[i] = (src[i] * gain[i]) >> 15;
+	}
+}
+
+void AudioEffectFadeStereo::update(void)
+{
+	audio_block_t *left, *right, *outl=NULL, *outr=NULL;
+	int16_t gain[AUDIO_BLOCK_SAMPLES];
+	uint32_t pos;
 
+	pos = position;
+	left = receiveReadOnly(0);
+	right = receiveReadOnly(1);
+	if (pos == 0) {
+		// output is silent
+		if (left) release(left);
+		if (right) release(right);
+		return;
+	} else if (pos == 0xFFFFFFFF) {
+		// output is 100%
+		if (left) {
+			transmit(left, 0);
+			release(left);
+		}
+		if (right) {
+			transmit(right, 1);
+			release(right);
+		}
+		return;
+	}
+	if (!left && !right) return;
+	position = fade_gains(gain, pos, rate, direction);
+	if (left) {
+		outl = allocate();
+		if (outl) fade_apply(outl->data, left->data, gain);
+	}
+	if (right == left) {
+		outr = outl;
+	} else if (right) {
+		outr = allocate();
+		if (outr) fade_apply(outr->data, right->data, gain);
+	}
+	if (outl) transmit(outl, 0);
+	if (outr) transmit(outr, 1);
+	if (outl) release(outl);
+	if (outr && outr != outl) release(outr);
+	if (left) release(left);
+	if (right) release(right);
+}
 
+void AudioEffectFadeStereo::fadeBegin(uint32_t newrate, uint8_t dir)
+{
+	__disable_irq();
+	uint32_t pos = position;
+	if (pos == 0) position = 1;
+	else if (pos == 0xFFFFFFFF) position = 0xFFFFFFFE;
+	rate = newrate;
+	direction = dir;
+	__enable_irq();
+}
@@ -36,22 +36,60 @@ public:
 	AudioEffectFade(void)
 	  : AudioStream(1, inputQueueArray), position(0xFFFFFFFF) {}
 	void fadeIn(uint32_t milliseconds) {
-		uint32_t samples = (uint32_t)(milliseconds * 441u + 5u) / 10u;
+		uint32_t samples = (uint32_t)(milliseconds * (AudioSampleRate() / 1000.0f) + 0.5f);
 		//Serial.printf("fadeIn, %u samples\n", samples);
 		fadeBegin(0xFFFFFFFFu / samples, 1);
 	}
 	void fadeOut(uint32_t milliseconds) {
-		uint32_t samples = (uint32_t)(milliseconds * 441u + 5u) / 10u;
+		uint32_t samples = (uint32_t)(milliseconds * (AudioSampleRate() / 1000.0f) + 0.5f);
 		//Serial.printf("fadeOut, %u samples\n", samples);
 		fadeBegin(0xFFFFFFFFu / samples, 0);
 	}
+	// true until the last fadeIn() or fadeOut() has reached its end,
+	// the fade only moves while blocks arrive
+	bool isFading(void) {
+		uint32_t pos = position;
+		return pos != 0 && pos != 0xFFFFFFFF;
+	}
 	virtual void update(void);
 private:
 	void fadeBegin(uint32_t newrate, uint8_t dir);
-	uint32_t position; // 0 = off, 0xFFFFFFFF = on
+	volatile uint32_t position; // 0 = off, 0xFFFFFFFF = on
 	uint32_t rate;
 	uint8_t direction; // 0 = fading out, 1 = fading in
 	audio_block_t *inputQueueArray[1];
 };
 
+
+// Both channels of a stereo path with one fader: the gain curve is
+// computed once per sample for the pair. The same block on both inputs
+// (a mono source) is faded once and sent to both outputs.
+class AudioEffectFadeStereo : public AudioStream
+{
+public:
+	AudioEffectFadeStereo(void)
+	  : AudioStream(2, inputQueueArray), position(0xFFFFFFFF) {}
+	void fadeIn(uint32_t milliseconds) {
+		uint32_t samples = (uint32_t)(milliseconds * (AudioSampleRate() / 1000.0f) + 0.5f);
+		fadeBegin(0xFFFFFFFFu / samples, 1);
+	}
+	void fadeOut(uint32_t milliseconds) {
+		uint32_t samples = (uint32_t)(milliseconds * (AudioSampleRate() / 1000.0f) + 0.5f);
+		fadeBegin(0xFFFFFFFFu / samples, 0);
+	}
+	// true until the last fadeIn() or fadeOut() has reached its end,
+	// the fade only moves while blocks arrive
+	bool isFading(void) {
+		uint32_t pos = position;
+		return pos != 0 && pos != 0xFFFFFFFF;
+	}
+	virtual void update(void);
+private:
+	void fadeBegin(uint32_t newrate, uint8_t dir);
+	volatile uint32_t position; // 0 = off, 0xFFFFFFFF = on
+	uint32_t rate;
+	uint8_t direction; // 0 = fading out, 1 = fading in
+	audio_block_t *inputQueueArray[2];
+};
+
 #endif
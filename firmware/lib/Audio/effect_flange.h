@@ -25,6 +25,7 @@
 
 #include "Arduino.h"
 #include "AudioStream.h"
+#include "effect_moddelay.h"
 
 /******************************************************************/
 //                A u d i o E f f e c t F l a n g e
@@ -33,27 +34,28 @@
 
 #define FLANGE_DELAY_PASSTHRU 0
 
+// One AudioModDelay tap at delay_offset +/- d_depth samples, read at
+// fractional positions, the LFO is a sine at delay_rate Hz.
 class AudioEffectFlange : 
 public AudioStream
 {
 public:
   AudioEffectFlange(void): 
-  AudioStream(1,inputQueueArray) { 
+  AudioStream(1,inputQueueArray), delay_length(0),
+  delay_offset_idx(FLANGE_DELAY_PASSTHRU) { 
   }
 
   boolean begin(short *delayline,int d_length,int delay_offset,int d_depth,float delay_rate);
   boolean voices(int delay_offset,int d_depth,float delay_rate);
   virtual void update(void);
+protected:
+  virtual void sampleRateChanged(void) { line.sampleRateChanged(); }
   
 private:
   audio_block_t *inputQueueArray[1];
-  short *l_delayline;
+  AudioModDelay line;
   int delay_length;
-  short l_circ_idx;
-  int delay_depth;
   int delay_offset_idx;
-  int   delay_rate_incr;
-  unsigned int l_delay_rate_index;
 };
 
 #endif
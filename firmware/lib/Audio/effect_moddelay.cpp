@@ -0,0 +1,161 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "effect_moddelay.h"
+#include "utility/dspinst.h"
+
+extern "C" {
+extern const int16_t AudioWaveformSine[257];
+}
+
+bool AudioModDelay::begin(int16_t *memory, uint32_t length)
+{
+	uint32_t size = 1;
+
+	if (memory == NULL || length < 2 * AUDIO_MODDELAY_SUBBLOCK) return false;
+	while (size * 2 <= length) size *= 2;
+	__disable_irq();
+	ring = memory;
+	mask = size - 1;
+	head = 0;
+	memset(ring, 0, size * sizeof(int16_t));
+	__enable_irq();
+	return true;
+}
+
+void AudioModDelay::taps(uint32_t n)
+{
+	if (n > AUDIO_MODDELAY_TAPS) n = AUDIO_MODDELAY_TAPS;
+	num_taps = n;
+}
+
+void AudioModDelay::tap(uint32_t n, float delay, float mod_depth, float lfo_phase)
+{
+	// room for the interpolation sample
+	float max = (float)(mask - 1);
+
+	if (n >= AUDIO_MODDELAY_TAPS) return;
+	if (mod_depth < 0.0f) mod_depth = -mod_depth;
+	if (delay < 0.0f) delay = 0.0f;
+	if (delay > max) delay = max;
+	// keep delay +/- depth on the ring
+	if (mod_depth > delay) mod_depth = delay;
+	if (mod_depth > max - delay) mod_depth = max - delay;
+	lfo_phase -= (int)lfo_phase;
+	if (lfo_phase < 0.0f) lfo_phase += 1.0f;
+	__disable_irq();
+	center[n] = delay * 65536.0f;
+	depth[n] = mod_depth * 65536.0f;
+	offset[n] = lfo_phase * 4294967296.0f;
+	current[n] = lfo(n, phase);
+	__enable_irq();
+}
+
+void AudioModDelay::rate(float hz)
+{
+	lfo_rate = hz;
+	phase_inc = hz * (4294967296.0f / AudioSampleRate());
+}
+
+// delay of a tap at an LFO phase, 16.16
+int32_t AudioModDelay::lfo(uint32_t tap, uint32_t ph)
+{
+	uint32_t index, scale;
+	int32_t val1, val2;
+
+	if (depth[tap] == 0) return center[tap];
+	ph += offset[tap];
+	index = ph >> 24;
+	val1 = AudioWaveformSine[index];
+	val2 = AudioWaveformSine[index+1];
+	scale = (ph >> 8) & 0xFFFF;
+	val2 *= scale;
+	val1 *= 0x10000 - scale;
+	return center[tap] + (signed_multiply_32x16b(depth[tap], (val1 + val2) >> 16) << 1);
+}
+
+void AudioModDelay::write(const int16_t *in, uint32_t n)
+{
+	if (!ring) return;
+	for (uint32_t i=0; i < n; i++) {
+		ring[head++ & mask] = in[i];
+	}
+}
+
+// one sub-block of a tap ramping from d to target, added to sum
+void AudioModDelay::read(int32_t *sum, uint32_t h, int32_t d, int32_t target)
+{
+	int32_t step = (target - d) / AUDIO_MODDELAY_SUBBLOCK, a, b;
+	uint32_t j, pos;
+
+	if (step == 0 && (d & 0xFFFF) == 0) {
+		// fixed whole sample delay
+		pos = h - (d >> 16);
+		for (j=0; j < AUDIO_MODDELAY_SUBBLOCK; j++) {
+			sum[j] += ring[(pos + j) & mask];
+		}
+	} else {
+		for (j=0; j < AUDIO_MODDELAY_SUBBLOCK; j++) {
+			pos = h + j - (d >> 16);
+			a = ring[pos & mask];
+			b = ring[(pos - 1) & mask];
+			sum[j] += a + (((b - a) * ((d & 0xFFFF) >> 1)) >> 15);
+			d += step;
+		}
+	}
+}
+
+void AudioModDelay::process(const int16_t *in, int16_t *out, uint32_t n)
+{
+	int32_t sum[AUDIO_MODDELAY_SUBBLOCK], target[AUDIO_MODDELAY_TAPS];
+	bool early[AUDIO_MODDELAY_TAPS];
+	uint32_t i, j, t, taps = num_taps, h;
+
+	if (!ring) return;
+	for (i=0; i < n; i += AUDIO_MODDELAY_SUBBLOCK) {
+		uint32_t next = phase + phase_inc * AUDIO_MODDELAY_SUBBLOCK;
+		h = head;
+		for (j=0; j < AUDIO_MODDELAY_SUBBLOCK; j++) sum[j] = in[i + j];
+		// a tap at least a sub-block back reads before the new samples
+		// go in, so it can reach back the whole ring, a shorter one
+		// reads after them
+		for (t=0; t < taps; t++) {
+			target[t] = lfo(t, next);
+			early[t] = current[t] >= (AUDIO_MODDELAY_SUBBLOCK << 16) &&
+			  target[t] >= (AUDIO_MODDELAY_SUBBLOCK << 16);
+			if (early[t]) read(sum, h, current[t], target[t]);
+		}
+		for (j=0; j < AUDIO_MODDELAY_SUBBLOCK; j++) {
+			ring[(h + j) & mask] = in[i + j];
+		}
+		for (t=0; t < taps; t++) {
+			if (!early[t]) read(sum, h, current[t], target[t]);
+			current[t] = target[t];
+		}
+		for (j=0; j < AUDIO_MODDELAY_SUBBLOCK; j++) {
+			out[i + j] = sum[j] / (int32_t)(taps + 1);
+		}
+		head = h + AUDIO_MODDELAY_SUBBLOCK;
+		phase = next;
+	}
+}
@@ -0,0 +1,80 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef effect_moddelay_h_
+#define effect_moddelay_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+#define AUDIO_MODDELAY_TAPS	8	// delayed taps, the dry sample comes on top
+#define AUDIO_MODDELAY_SUBBLOCK	16	// samples per LFO step
+
+// Modulated delay line, the core of AudioEffectChorus and AudioEffectFlange.
+// The samples go round a power of two ring, indexed with a mask. Each tap
+// has a delay, a modulation depth and an LFO phase, all the taps share one
+// sine LFO. The LFO is computed once every AUDIO_MODDELAY_SUBBLOCK samples
+// and the delay ramps linearly in between, the taps are read at fractional
+// positions with linear interpolation, so a moving tap does not zipper.
+// The output is the average of the dry sample and the taps.
+class AudioModDelay
+{
+public:
+	AudioModDelay(void) : ring(NULL), mask(0), head(0), num_taps(0),
+	  phase(0), phase_inc(0), lfo_rate(0) { }
+	// uses the largest power of two samples that fits in length, cleared.
+	// False below 2 * AUDIO_MODDELAY_SUBBLOCK samples.
+	bool begin(int16_t *memory, uint32_t length);
+	uint32_t size(void) { return ring ? mask + 1 : 0; }
+	// number of delayed taps, 0 to AUDIO_MODDELAY_TAPS
+	void taps(uint32_t n);
+	// tap n: delay and modulation depth in samples (delay +/- depth),
+	// lfo_phase 0 to 1. Limited to the ring size - 2.
+	void tap(uint32_t n, float delay, float depth, float lfo_phase = 0.0f);
+	// LFO rate in Hz
+	void rate(float hz);
+	void resetPhase(void) { phase = 0; }
+	// the owner calls this from its own sampleRateChanged()
+	void sampleRateChanged(void) { rate(lfo_rate); }
+	// in and out may be the same buffer, n a multiple of
+	// AUDIO_MODDELAY_SUBBLOCK
+	void process(const int16_t *in, int16_t *out, uint32_t n);
+	// only store the samples, for a bypass that keeps the line filled
+	void write(const int16_t *in, uint32_t n);
+private:
+	int32_t lfo(uint32_t tap, uint32_t ph);
+	void read(int32_t *sum, uint32_t h, int32_t d, int32_t target);
+	int16_t *ring;
+	uint32_t mask;
+	uint32_t head;			// where the next sample goes
+	volatile uint32_t num_taps;
+	uint32_t phase;			// LFO, a full turn is 2^32
+	uint32_t phase_inc;		// per sample
+	float lfo_rate;
+	int32_t center[AUDIO_MODDELAY_TAPS];	// 16.16 samples
+	int32_t depth[AUDIO_MODDELAY_TAPS];	// 16.16 samples
+	uint32_t offset[AUDIO_MODDELAY_TAPS];	// LFO phase
+	int32_t current[AUDIO_MODDELAY_TAPS];	// 16.16 delay at the sub-block start
+};
+
+#endif
@@ -0,0 +1,220 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "effect_reverb_fdn.h"
+#include "utility/dspinst.h"
+
+// line lengths at 44.1kHz, primes so the echoes do not line up
+static const uint16_t lengths4[4] = {
+	1087, 1283, 1511, 1777
+};
+static const uint16_t lengths8[8] = {
+	683, 797, 929, 1051, 1181, 1327, 1453, 1597
+};
+static const uint16_t lengths16[16] = {
+	421, 487, 547, 613, 677, 743, 809, 881,
+	947, 1021, 1093, 1163, 1237, 1301, 1373, 1451
+};
+
+#define MOD_DEPTH	8.0f	// samples at 44.1kHz
+#define INTERNAL_SHIFT	8	// 16 bit samples are 24 bit inside
+
+bool AudioEffectReverbFDN::begin(int16_t *memory, uint32_t samples, uint32_t lines, bool modulation)
+{
+	bool ok;
+
+	end();
+	arena = memory;
+	arena_samples = samples;
+	if (lines >= 16) {
+		lines = 16;
+		log2lines = 4;
+	} else if (lines >= 8) {
+		lines = 8;
+		log2lines = 3;
+	} else {
+		lines = 4;
+		log2lines = 2;
+	}
+	modulated = modulation;
+	__disable_irq();
+	lines_set = lines;
+	ok = configure();
+	__enable_irq();
+	return ok;
+}
+
+// lay the lines out in the arena for the current sample rate
+bool AudioEffectReverbFDN::configure(void)
+{
+	const uint16_t *base;
+	uint32_t i, n, sum, extra;
+	int16_t *p;
+	float scale;
+
+	n = lines_set;
+	nlines = 0;
+	if (!n || !arena) return false;
+	base = (n == 16) ? lengths16 : (n == 8) ? lengths8 : lengths4;
+	scale = AudioSampleRate() / 44100.0f;
+	extra = modulated ? (uint32_t)(MOD_DEPTH * scale) + 2 : 0;
+	for (sum=0, i=0; i < n; i++) sum += base[i];
+	if (arena_samples < sum / 4 + n * extra) return false;
+	if (sum * scale + n * extra > arena_samples) {
+		// too little memory for this rate, a smaller room
+		scale = (float)(arena_samples - n * extra) / sum;
+	}
+	depth = modulated ? (extra - 2) << 16 : 0;
+	p = arena;
+	for (i=0; i < n; i++) {
+		line[i].delay = base[i] * scale;
+		line[i].length = line[i].delay + extra;
+		line[i].buffer = p;
+		line[i].index = 0;
+		line[i].lp = 0;
+		line[i].phase = i * (0xFFFFFFFFu / n);
+		line[i].increment = (0.5f + 0.7f * i / n) * (4294967296.0f / AudioSampleRate());
+		p += line[i].length;
+	}
+	memset(arena, 0, (p - arena) * sizeof(int16_t));
+	// the even lines go left, the odd ones right
+	out_gain = 2147483647.0f * sqrtf(2.0f / n);
+	nlines = n;
+	gains();
+	return true;
+}
+
+void AudioEffectReverbFDN::gains(void)
+{
+	float fs = AudioSampleRate();
+	// a modulated tap reads half the depth further back on average
+	float mean = depth / 131072.0f;
+	for (uint32_t i=0; i < nlines; i++) {
+		float g = powf(10.0f, -3.0f * (line[i].delay + mean) / (fs * reverb_time));
+		line[i].gain = g * 2147483647.0f;
+	}
+	damp_coef = damp * 2147483647.0f;
+}
+
+void AudioEffectReverbFDN::reverbTime(float seconds)
+{
+	if (seconds <= 0.0f) return;
+	__disable_irq();
+	reverb_time = seconds;
+	gains();
+	__enable_irq();
+}
+
+void AudioEffectReverbFDN::damping(float n)
+{
+	if (n < 0.0f) n = 0.0f;
+	else if (n > 0.95f) n = 0.95f;
+	__disable_irq();
+	damp = n;
+	gains();
+	__enable_irq();
+}
+
+#if defined(KINETISK) || defined(DSPINST_HOST)
+
+void AudioEffectReverbFDN::update(void)
+{
+	audio_block_t *block, *left, *right;
+	int32_t s[AUDIO_REVERB_FDN_MAX_LINES];
+	uint32_t i, k, n;
+
+	block = receiveReadOnly();
+	n = nlines;
+	if (!n) {
+		if (block) release(block);
+		return;
+	}
+	left = allocate();
+	right = allocate();
+	if (!left || !right) {
+		if (left) release(left);
+		if (right) release(right);
+		if (block) release(block);
+		return;
+	}
+	for (k=0; k < AUDIO_BLOCK_SAMPLES; k++) {
+		// input at half level, + into lines 0 and 1, - into 2 and 3...
+		int32_t x = block ? block->data[k] << (INTERNAL_SHIFT - 1) : 0;
+		int32_t sum = 0, l = 0, r = 0;
+		for (i=0; i < n; i++) {
+			struct fdn_line *p = &line[i];
+			int32_t y;
+			if (modulated) {
+				uint32_t tri = p->phase;
+				if (tri & 0x80000000) tri = ~tri;
+				p->phase += p->increment;
+				uint32_t d = (p->delay << 16) + (((uint64_t)tri * depth) >> 31);
+				int32_t a = p->index - (d >> 16);
+				if (a < 0) a += p->length;
+				int32_t b = a ? a - 1 : p->length - 1;
+				int32_t f = (d & 0xFFFF) >> 1;
+				int32_t y0 = p->buffer[a];
+				y = (y0 << INTERNAL_SHIFT) + (((p->buffer[b] - y0) * f) >> (15 - INTERNAL_SHIFT));
+			} else {
+				// ring size = delay, the oldest sample is the one
+				// about to be overwritten
+				y = p->buffer[p->index] << INTERNAL_SHIFT;
+			}
+			if (i & 1) r += y;
+			else l += y;
+			p->lp = y + (multiply_32x32_rshift32_rounded(p->lp - y, damp_coef) << 1);
+			y = multiply_32x32_rshift32_rounded(p->lp, p->gain) << 1;
+			s[i] = y;
+			sum += y;
+		}
+		// Householder feedback: s - 2/N * sum(s)
+		sum >>= log2lines - 1;
+		for (i=0; i < n; i++) {
+			struct fdn_line *p = &line[i];
+			int32_t v = s[i] - sum + ((i & 2) ? -x : x);
+			p->buffer[p->index] = saturate16((v + (1 << (INTERNAL_SHIFT - 1))) >> INTERNAL_SHIFT);
+			if (++p->index >= p->length) p->index = 0;
+		}
+		l = multiply_32x32_rshift32_rounded(l, out_gain) << 1;
+		r = multiply_32x32_rshift32_rounded(r, out_gain) << 1;
+		left->data[k] = saturate16((l + (1 << (INTERNAL_SHIFT - 1))) >> INTERNAL_SHIFT);
+		right->data[k] = saturate16((r + (1 << (INTERNAL_SHIFT - 1))) >> INTERNAL_SHIFT);
+	}
+	if (block) release(block);
+	transmit(left, 0);
+	release(left);
+	transmit(right, 1);
+	release(right);
+}
+
+#elif defined(KINETISL)
+
+void AudioEffectReverbFDN::update(void)
+{
+	audio_block_t *block;
+
+	block = receiveReadOnly();
+	if (block) release(block);
+}
+
+#endif
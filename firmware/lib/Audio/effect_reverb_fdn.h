@@ -0,0 +1,100 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef effect_reverb_fdn_h_
+#define effect_reverb_fdn_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+#define AUDIO_REVERB_FDN_MAX_LINES	16
+
+// Samples of memory for 4, 8 or 16 lines at 44.1kHz, modulation included.
+// At higher rates the lines are shortened to fit, twice the memory keeps
+// the same room at 88.2kHz.
+#define AUDIO_REVERB_FDN_SAMPLES(lines)	\
+	((lines) <= 4 ? 5750 : (lines) <= 8 ? 9200 : 15050)
+
+// Feedback delay network reverb: 4, 8 or 16 delay lines of prime lengths
+// fed back through a Householder matrix, each with its decay gain and a
+// one pole damping lowpass. The lines are 16 bit samples in memory given
+// by the caller, all the math is 32 bit. More lines give a denser tail
+// for more cycles, the modulation moves the read taps a few samples with
+// slow triangle LFOs to break up the metallic ringing of a static network.
+// Mono in, stereo out (0 = left, 1 = right).
+class AudioEffectReverbFDN : public AudioStream
+{
+public:
+	AudioEffectReverbFDN(void) : AudioStream(1, inputQueueArray), arena(NULL), nlines(0), lines_set(0),
+	  reverb_time(2.0f), damp(0.3f) { }
+	// lines 4, 8 or 16, memory holds "samples" 16 bit samples. False when
+	// that is less than the lines at a quarter of their length and the
+	// modulation room, the reverb is then off (also after a sample rate
+	// change that no longer fits, until one that does).
+	bool begin(int16_t *memory, uint32_t samples, uint32_t lines=8, bool modulation=false);
+	void end(void) {
+		__disable_irq();
+		nlines = 0;
+		lines_set = 0;
+		__enable_irq();
+	}
+	// time for the tail to fall 60 dB at low frequencies. damping()
+	// shortens the highs, and so does the interpolation of the moving
+	// taps when modulation is on: a broadband T60 then reads shorter,
+	// about 0.85 to 0.9 of the setting without damping. reverbTime() is
+	// approximate for a modulated reverb.
+	void reverbTime(float seconds);
+	// high frequency damping, 0 (bright) to 1.0 (dark)
+	void damping(float n);
+	virtual void update(void);
+protected:
+	virtual void sampleRateChanged(void) { configure(); }
+private:
+	struct fdn_line {
+		int16_t *buffer;
+		uint32_t length;	// ring size
+		uint32_t delay;		// samples
+		uint32_t index;		// write position
+		int32_t gain;		// q31 decay per pass
+		int32_t lp;		// damping state
+		uint32_t phase;		// modulation LFO
+		uint32_t increment;
+	};
+	bool configure(void);
+	void gains(void);
+	int16_t *arena;
+	uint32_t arena_samples;
+	uint32_t nlines;		// 0 when off or the memory is too small
+	uint32_t lines_set;
+	uint32_t log2lines;
+	bool modulated;
+	uint32_t depth;			// modulation in 16.16 samples
+	int32_t damp_coef;		// q31
+	int32_t out_gain;		// q31
+	float reverb_time;
+	float damp;
+	struct fdn_line line[AUDIO_REVERB_FDN_MAX_LINES];
+	audio_block_t *inputQueueArray[1];
+};
+
+#endif
@@ -27,80 +27,284 @@
 #include "filter_biquad.h"
 #include "utility/dspinst.h"
 
-#if defined(KINETISK)
+void AudioFilterBiquadBank::init(int32_t *memory, uint32_t stages)
+{
+	uint32_t i;
+
+	num_stages = stages;
+	coef = memory;
+	target = coef + 5 * stages;
+	step = target + 5 * stages;
+	xstate = (uint32_t *)(step + 5 * stages);
+	ystate1 = (int32_t *)(xstate + stages);
+	ystate2 = ystate1 + stages;
+	carry = ystate2 + stages;
+	ramp = (uint32_t *)(carry + stages);
+	precise = ramp + stages;
+	for (i=0; i < AUDIO_BIQUAD_WORDS(stages); i++) memory[i] = 0;
+	// by default, the filter will not pass anything
+	active = stages ? 1 : 0;
+	ramp_length = AUDIO_BLOCK_SAMPLES / 2;
+	bypassed = false;
+}
 
-void AudioFilterBiquad::update(void)
+void AudioFilterBiquadBank::setInterpolation(uint32_t samples)
 {
-	audio_block_t *block;
-	int32_t b0, b1, b2, a1, a2, sum;
-	uint32_t in2, out2, bprev, aprev, flag;
-	uint32_t *data, *end;
-	int32_t *state;
-	block = receiveWritable();
-	if (!block) return;
-	end = (uint32_t *)(block->data) + AUDIO_BLOCK_SAMPLES/2;
-	state = (int32_t *)definition;
-	do {
-		b0 = *state++;
-		b1 = *state++;
-		b2 = *state++;
-		a1 = *state++;
-		a2 = *state++;
-		bprev = *state++;
-		aprev = *state++;
-		sum = *state & 0x3FFF;
-		data = end - AUDIO_BLOCK_SAMPLES/2;
-		do {
-			in2 = *data;
-			sum = signed_multiply_accumulate_32x16b(sum, b0, in2);
-			sum = signed_multiply_accumulate_32x16t(sum, b1, bprev);
-			sum = signed_multiply_accumulate_32x16b(sum, b2, bprev);
-			sum = signed_multiply_accumulate_32x16t(sum, a1, aprev);
-			sum = signed_multiply_accumulate_32x16b(sum, a2, aprev);
-			out2 = signed_saturate_rshift(sum, 16, 14);
-			sum &= 0x3FFF;
-			sum = signed_multiply_accumulate_32x16t(sum, b0, in2);
-			sum = signed_multiply_accumulate_32x16b(sum, b1, in2);
-			sum = signed_multiply_accumulate_32x16t(sum, b2, bprev);
-			sum = signed_multiply_accumulate_32x16b(sum, a1, out2);
-			sum = signed_multiply_accumulate_32x16t(sum, a2, aprev);
-			bprev = in2;
-			aprev = pack_16b_16b(
-				signed_saturate_rshift(sum, 16, 14), out2);
-			sum &= 0x3FFF;
-			bprev = in2;
-			*data++ = aprev;
-		} while (data < end);
-		flag = *state & 0x80000000;
-		*state++ = sum | flag;
-		*(state-2) = aprev;
-		*(state-3) = bprev;
-	} while (flag);
-	transmit(block);
-	release(block);
+	ramp_length = (samples + 1) / 2;
 }
 
-void AudioFilterBiquad::setCoefficients(uint32_t stage, const int *coefficients)
+void AudioFilterBiquadBank::setCoefficients(uint32_t stage, const int *coefficients)
 {
-	if (stage >= 4) return;
-	int32_t *dest = definition + (stage << 3);
+	uint32_t i, k, n = num_stages;
+	int32_t c;
+
+	if (stage >= n) return;
 	__disable_irq();
-	if (stage > 0) *(dest - 1) |= 0x80000000;
-	*dest++ = *coefficients++;
-	*dest++ = *coefficients++;
-	*dest++ = *coefficients++;
-	*dest++ = *coefficients++ * -1;
-	*dest++ = *coefficients++ * -1;
-	//*dest++ = 0;
-	//*dest++ = 0;  // clearing filter state causes loud pop
-	dest += 2;
-	*dest   &= 0x80000000;
+	// stages added behind the ones in use start as a pass through, so
+	// they ramp in like any other change
+	for (i=active; i <= stage; i++) {
+		coef[i] = 1 << 30;
+		for (k=1; k < 5; k++) coef[k * n + i] = 0;
+		xstate[i] = 0;
+		ystate1[i] = ystate2[i] = carry[i] = 0;
+		ramp[i] = 0;
+	}
+	if (stage >= active) active = stage + 1;
+	for (k=0; k < 5; k++) {
+		c = (k < 3) ? coefficients[k] : -coefficients[k];
+		target[k * n + stage] = c;
+		if (ramp_length) {
+			step[k * n + stage] = ((int64_t)c - coef[k * n + stage]) / (int32_t)ramp_length;
+		} else {
+			coef[k * n + stage] = c;
+		}
+	}
+	ramp[stage] = ramp_length;
 	__enable_irq();
 }
 
+// The state is kept across the switch, only its format changes.
+void AudioFilterBiquadBank::setPrecision(uint32_t stage, bool high)
+{
+	int32_t y1, y2;
+
+	if (stage >= num_stages) return;
+	__disable_irq();
+	if (high && !precise[stage]) {
+		y1 = (int16_t)(ystate1[stage] >> 16);
+		y2 = (int16_t)(ystate1[stage] & 0xFFFF);
+		ystate1[stage] = y1 << 12;
+		ystate2[stage] = y2 << 12;
+	} else if (!high && precise[stage]) {
+		y1 = signed_saturate_rshift(ystate1[stage], 16, 12);
+		y2 = signed_saturate_rshift(ystate2[stage], 16, 12);
+		ystate1[stage] = (y1 << 16) | (y2 & 0xFFFF);
+	}
+	carry[stage] = 0;
+	precise[stage] = high;
+	__enable_irq();
+}
+
+#if defined(KINETISK) || defined(DSPINST_HOST)
+
+typedef struct {
+	int32_t b0, b1, b2, a1, a2;
+} biquad_coef_t;
+
+// Direct form 1, two samples per pass. The output state is 16 bit, the
+// rounding error is carried to the next sample. While ramping the
+// coefficients take one step per pass.
+static inline void biquad16(uint32_t *data, uint32_t *end, biquad_coef_t *c,
+  const biquad_coef_t *d, uint32_t *xs, int32_t *ys, int32_t *carry, const bool ramping)
+  __attribute__((always_inline));
+static inline void biquad16(uint32_t *data, uint32_t *end, biquad_coef_t *c,
+  const biquad_coef_t *d, uint32_t *xs, int32_t *ys, int32_t *carry, const bool ramping)
+{
+	int32_t b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+	uint32_t in2, out2, bprev = *xs, aprev = *ys;
+	int32_t sum = *carry;
+
+	do {
+		in2 = *data;
+		sum = signed_multiply_accumulate_32x16b(sum, b0, in2);
+		sum = signed_multiply_accumulate_32x16t(sum, b1, bprev);
+		sum = signed_multiply_accumulate_32x16b(sum, b2, bprev);
+		sum = signed_multiply_accumulate_32x16t(sum, a1, aprev);
+		sum = signed_multiply_accumulate_32x16b(sum, a2, aprev);
+		out2 = signed_saturate_rshift(sum, 16, 14);
+		sum &= 0x3FFF;
+		sum = signed_multiply_accumulate_32x16t(sum, b0, in2);
+		sum = signed_multiply_accumulate_32x16b(sum, b1, in2);
+		sum = signed_multiply_accumulate_32x16t(sum, b2, bprev);
+		sum = signed_multiply_accumulate_32x16b(sum, a1, out2);
+		sum = signed_multiply_accumulate_32x16t(sum, a2, aprev);
+		bprev = in2;
+		aprev = pack_16b_16b(
+			signed_saturate_rshift(sum, 16, 14), out2);
+		sum &= 0x3FFF;
+		*data++ = aprev;
+		if (ramping) {
+			b0 += d->b0;
+			b1 += d->b1;
+			b2 += d->b2;
+			a1 += d->a1;
+			a2 += d->a2;
+		}
+	} while (data < end);
+	*xs = bprev;
+	*ys = aprev;
+	*carry = sum;
+	if (ramping) {
+		c->b0 = b0;
+		c->b1 = b1;
+		c->b2 = b2;
+		c->a1 = a1;
+		c->a2 = a2;
+	}
+}
+
+// Direct form 1, output state in 16.12 fixed point, 64 bit accumulator
+// with the rounding error carried to the next sample. That keeps the
+// noise of low frequency poles below the output LSB.
+static inline void biquad32(int16_t *data, int16_t *end, biquad_coef_t *c,
+  const biquad_coef_t *d, uint32_t *xs, int32_t *ys1, int32_t *ys2,
+  int32_t *carry, const bool ramping) __attribute__((always_inline));
+static inline void biquad32(int16_t *data, int16_t *end, biquad_coef_t *c,
+  const biquad_coef_t *d, uint32_t *xs, int32_t *ys1, int32_t *ys2,
+  int32_t *carry, const bool ramping)
+{
+	int32_t b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+	int32_t x0, x1, x2, y0, y1, y2;
+	uint32_t frac = *carry;
+	int64_t acc;
+
+	x1 = (int16_t)(*xs >> 16) << 12;
+	x2 = (int16_t)(*xs & 0xFFFF) << 12;
+	y1 = *ys1;
+	y2 = *ys2;
+	do {
+		x0 = *data << 12;
+		acc = (int64_t)b0 * x0 + frac;
+		acc += (int64_t)b1 * x1;
+		acc += (int64_t)b2 * x2;
+		acc += (int64_t)a1 * y1;
+		acc += (int64_t)a2 * y2;
+		frac = (uint32_t)acc & 0x3FFFFFFF;
+		y2 = signed_saturate_rshift((int32_t)(acc >> 30), 28, 0);
+		*data++ = signed_saturate_rshift(y2 + 2048, 16, 12);
+		x2 = *data << 12;
+		acc = (int64_t)b0 * x2 + frac;
+		acc += (int64_t)b1 * x0;
+		acc += (int64_t)b2 * x1;
+		acc += (int64_t)a1 * y2;
+		acc += (int64_t)a2 * y1;
+		frac = (uint32_t)acc & 0x3FFFFFFF;
+		y0 = signed_saturate_rshift((int32_t)(acc >> 30), 28, 0);
+		*data++ = signed_saturate_rshift(y0 + 2048, 16, 12);
+		x1 = x2;
+		x2 = x0;
+		y1 = y0;
+		if (ramping) {
+			b0 += d->b0;
+			b1 += d->b1;
+			b2 += d->b2;
+			a1 += d->a1;
+			a2 += d->a2;
+		}
+	} while (data < end);
+	*xs = pack_16b_16b(x1 >> 12, x2 >> 12);
+	*ys1 = y1;
+	*ys2 = y2;
+	*carry = frac;
+	if (ramping) {
+		c->b0 = b0;
+		c->b1 = b1;
+		c->b2 = b2;
+		c->a1 = a1;
+		c->a2 = a2;
+	}
+}
+
+// One stage over n samples (n even), ramping for the first "pairs" pairs.
+void AudioFilterBiquadBank::filter(uint32_t i, int16_t *data, uint32_t n)
+{
+	const uint32_t ns = num_stages;
+	biquad_coef_t c, d;
+	uint32_t pairs = ramp[i];
+	uint32_t k;
+
+	c.b0 = coef[i];
+	c.b1 = coef[ns + i];
+	c.b2 = coef[2 * ns + i];
+	c.a1 = coef[3 * ns + i];
+	c.a2 = coef[4 * ns + i];
+	if (pairs) {
+		if (pairs > n / 2) pairs = n / 2;
+		d.b0 = step[i];
+		d.b1 = step[ns + i];
+		d.b2 = step[2 * ns + i];
+		d.a1 = step[3 * ns + i];
+		d.a2 = step[4 * ns + i];
+		if (precise[i]) {
+			biquad32(data, data + pairs * 2, &c, &d, xstate + i,
+			  ystate1 + i, ystate2 + i, carry + i, true);
+		} else {
+			biquad16((uint32_t *)data, (uint32_t *)data + pairs, &c, &d,
+			  xstate + i, ystate1 + i, carry + i, true);
+		}
+		data += pairs * 2;
+		n -= pairs * 2;
+		ramp[i] -= pairs;
+		if (ramp[i]) {
+			coef[i] = c.b0;
+			coef[ns + i] = c.b1;
+			coef[2 * ns + i] = c.b2;
+			coef[3 * ns + i] = c.a1;
+			coef[4 * ns + i] = c.a2;
+		} else {
+			// the steps are rounded, land exactly on the target
+			for (k=0; k < 5; k++) coef[k * ns + i] = target[k * ns + i];
+			c.b0 = coef[i];
+			c.b1 = coef[ns + i];
+			c.b2 = coef[2 * ns + i];
+			c.a1 = coef[3 * ns + i];
+			c.a2 = coef[4 * ns + i];
+		}
+		if (!n) return;
+	}
+	if (precise[i]) {
+		biquad32(data, data + n, &c, &d, xstate + i,
+		  ystate1 + i, ystate2 + i, carry + i, false);
+	} else {
+		biquad16((uint32_t *)data, (uint32_t *)data + n / 2, &c, &d,
+		  xstate + i, ystate1 + i, carry + i, false);
+	}
+}
+
+void AudioFilterBiquadBank::update(void)
+{
+	audio_block_t *block;
+	uint32_t i;
+
+	if (bypassed) {
+		block = receiveReadOnly();
+		if (!block) return;
+		transmit(block);
+		release(block);
+		return;
+	}
+	block = receiveWritable();
+	if (!block) return;
+	for (i=0; i < active; i++) {
+		filter(i, block->data, AUDIO_BLOCK_SAMPLES);
+	}
+	transmit(block);
+	release(block);
+}
+
 #elif defined(KINETISL)
 
-void AudioFilterBiquad::update(void)
+void AudioFilterBiquadBank::update(void)
 {
         audio_block_t *block;
 
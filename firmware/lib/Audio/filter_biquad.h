@@ -30,14 +30,34 @@
 #include "Arduino.h"
 #include "AudioStream.h"
 
-class AudioFilterBiquad : public AudioStream
+// Coefficient bank layout, one array per field (structure of arrays):
+// b0 b1 b2 -a1 -a2, their targets and ramp steps, the packed input history,
+// two output history words, the rounding carry, the ramp count and the
+// precision flag. Words of memory needed for a number of stages:
+#define AUDIO_BIQUAD_WORDS(stages)	((stages) * 21)
+
+// Cascade of any number of biquads, in memory given by the caller.
+// Coefficient changes ramp linearly from the old to the new set over
+// setInterpolation() samples, a step every 2 samples. That keeps (a1, a2)
+// inside the stability triangle and the state intact, so there is no
+// click and no pop.
+class AudioFilterBiquadBank : public AudioStream
 {
 public:
-	AudioFilterBiquad(void) : AudioStream(1, inputQueueArray) {
-		// by default, the filter will not pass anything
-		for (int i=0; i<32; i++) definition[i] = 0;
+	AudioFilterBiquadBank(int32_t *memory, uint32_t stages) : AudioStream(1, inputQueueArray) {
+		init(memory, stages);
 	}
 	virtual void update(void);
+	// pass the audio through untouched, the coefficients are kept
+	void bypass(bool on) { bypassed = on; }
+	uint32_t stages(void) { return num_stages; }
+	// ramp length for coefficient changes in samples, 0 = switch at
+	// once. Default is one block.
+	void setInterpolation(uint32_t samples);
+	// 32 bit output state (16.12 fixed point) for low frequency and high
+	// Q stages, where the 16 bit state adds audible noise. About twice
+	// the cycles of the 16 bit mode.
+	void setPrecision(uint32_t stage, bool high);
 
 	// Set the biquad coefficients directly
 	void setCoefficients(uint32_t stage, const int *coefficients);
@@ -55,7 +75,7 @@ public:
 	// http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
 	void setLowpass(uint32_t stage, float frequency, float q = 0.7071) {
 		int coef[5];
-		double w0 = frequency * (2 * 3.141592654 / AUDIO_SAMPLE_RATE_EXACT);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
 		double sinW0 = sin(w0);
 		double alpha = sinW0 / ((double)q * 2.0);
 		double cosW0 = cos(w0);
@@ -69,7 +89,7 @@ public:
 	}
 	void setHighpass(uint32_t stage, float frequency, float q = 0.7071) {
 		int coef[5];
-		double w0 = frequency * (2 * 3.141592654 / AUDIO_SAMPLE_RATE_EXACT);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
 		double sinW0 = sin(w0);
 		double alpha = sinW0 / ((double)q * 2.0);
 		double cosW0 = cos(w0);
@@ -83,7 +103,7 @@ public:
 	}
 	void setBandpass(uint32_t stage, float frequency, float q = 1.0) {
 		int coef[5];
-		double w0 = frequency * (2 * 3.141592654 / AUDIO_SAMPLE_RATE_EXACT);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
 		double sinW0 = sin(w0);
 		double alpha = sinW0 / ((double)q * 2.0);
 		double cosW0 = cos(w0);
@@ -97,7 +117,7 @@ public:
 	}
 	void setNotch(uint32_t stage, float frequency, float q = 1.0) {
 		int coef[5];
-		double w0 = frequency * (2 * 3.141592654 / AUDIO_SAMPLE_RATE_EXACT);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
 		double sinW0 = sin(w0);
 		double alpha = sinW0 / ((double)q * 2.0);
 		double cosW0 = cos(w0);
@@ -109,10 +129,25 @@ public:
 		/* a2 */ coef[4] = (1.0 - alpha) * scale;
 		setCoefficients(stage, coef);
 	}
+	void setPeaking(uint32_t stage, float frequency, float gain, float q = 1.0f) {
+		int coef[5];
+		double a = pow(10.0, gain/40.0);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
+		double sinW0 = sin(w0);
+		double alpha = sinW0 / ((double)q * 2.0);
+		double cosW0 = cos(w0);
+		double scale = 1073741824.0 / (1.0 + alpha / a);
+		/* b0 */ coef[0] = (1.0 + alpha * a) * scale;
+		/* b1 */ coef[1] = (-2.0 * cosW0) * scale;
+		/* b2 */ coef[2] = (1.0 - alpha * a) * scale;
+		/* a1 */ coef[3] = (-2.0 * cosW0) * scale;
+		/* a2 */ coef[4] = (1.0 - alpha / a) * scale;
+		setCoefficients(stage, coef);
+	}
 	void setLowShelf(uint32_t stage, float frequency, float gain, float slope = 1.0f) {
 		int coef[5];
 		double a = pow(10.0, gain/40.0);
-		double w0 = frequency * (2 * 3.141592654 / AUDIO_SAMPLE_RATE_EXACT);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
 		double sinW0 = sin(w0);
 		//double alpha = (sinW0 * sqrt((a+1/a)*(1/slope-1)+2) ) / 2.0;
 		double cosW0 = cos(w0);
@@ -131,7 +166,7 @@ public:
 	void setHighShelf(uint32_t stage, float frequency, float gain, float slope = 1.0f) {
 		int coef[5];
 		double a = pow(10.0, gain/40.0);
-		double w0 = frequency * (2 * 3.141592654 / AUDIO_SAMPLE_RATE_EXACT);
+		double w0 = frequency * (2 * 3.141592654 / AudioSampleRate());
 		double sinW0 = sin(w0);
 		//double alpha = (sinW0 * sqrt((a+1/a)*(1/slope-1)+2) ) / 2.0;
 		double cosW0 = cos(w0);
@@ -149,8 +184,32 @@ public:
 	}
 
 private:
-	int32_t definition[32];  // up to 4 cascaded biquads
+	void init(int32_t *memory, uint32_t stages);
+	void filter(uint32_t stage, int16_t *data, uint32_t n);
+	uint32_t num_stages;
+	uint32_t active;		// stages in use, the ones set so far
+	uint32_t ramp_length;		// in sample pairs
+	int32_t *coef;			// [5][stages] Q30, a1 and a2 negated
+	int32_t *target;		// [5][stages]
+	int32_t *step;			// [5][stages]
+	uint32_t *xstate;		// x[n-1] top, x[n-2] bottom
+	int32_t *ystate1;		// 16 bit mode: y[n-1] top, y[n-2] bottom
+	int32_t *ystate2;		// high precision: ystate1 y[n-1], ystate2 y[n-2]
+	int32_t *carry;			// rounding error
+	uint32_t *ramp;			// sample pairs left in the current ramp
+	uint32_t *precise;		// high precision flag
+	volatile bool bypassed;
 	audio_block_t *inputQueueArray[1];
 };
 
+// The original 4 stage filter, same use as before.
+class AudioFilterBiquad : public AudioFilterBiquadBank
+{
+public:
+	// by default, the filter will not pass anything
+	AudioFilterBiquad(void) : AudioFilterBiquadBank(bank, 4) { }
+private:
+	int32_t bank[AUDIO_BIQUAD_WORDS(4)];
+};
+
 #endif
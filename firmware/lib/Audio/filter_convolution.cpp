@@ -0,0 +1,284 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "filter_convolution.h"
+#include "utility/dspinst.h"
+
+// Fixed point plan. Input samples and IR taps go into the FFT << 12, the
+// split step halves, so a bin is the true DFT * 16 and never overflows.
+// The IR spectra are stored q15 with a common exponent, the 32x16 multiply
+// drops 16 bits and the accumulated spectrum is the output spectrum
+// * 2^(7 - shift). Shifted by the exponent the inverse FFT gets the output
+// with 7 fraction bits, well below the rounding of its 7 halving stages.
+#define BINS		AUDIO_BLOCK_SAMPLES
+#define INPUT_SHIFT	12
+#define OUTPUT_FRAC	7
+
+// quarter wave q31 sine for the split and merge twiddles
+static int32_t quarter_sine[BINS/2 + 1];
+static bool quarter_sine_ready = false;
+
+// exp(-j*pi*k/BINS) = c - j*s, k from 0 to BINS-1
+static void twiddle(unsigned int k, int32_t *c, int32_t *s)
+{
+	if (k <= BINS/2) {
+		*s = quarter_sine[k];
+		*c = quarter_sine[BINS/2 - k];
+	} else {
+		*s = quarter_sine[BINS - k];
+		*c = -quarter_sine[k - BINS/2];
+	}
+}
+
+static inline int32_t multiply_q31(int32_t a, int32_t b)
+{
+	return ((int64_t)a * b) >> 31;
+}
+
+// Real spectrum of 2*BINS samples from the BINS point complex FFT z of
+// the even (re) and odd (im) samples:
+//   X[k] = (E + W*O) / 2,  E = (Z[k] + conj(Z[M-k])) / 2,
+//   O = -j * (Z[k] - conj(Z[M-k])) / 2,  W = exp(-j*pi*k/BINS)
+// x[0] holds the DC bin, x[1] the Nyquist bin, both real.
+static void split(const int32_t *z, int32_t *x)
+{
+	x[0] = (z[0] >> 1) + (z[1] >> 1);
+	x[1] = (z[0] >> 1) - (z[1] >> 1);
+	for (unsigned int k=1; k < BINS; k++) {
+		unsigned int m = BINS - k;
+		int32_t er = (z[2*k] >> 1) + (z[2*m] >> 1);
+		int32_t ei = (z[2*k+1] >> 1) - (z[2*m+1] >> 1);
+		int32_t or_ = (z[2*k+1] >> 1) + (z[2*m+1] >> 1);
+		int32_t oi = (z[2*m] >> 1) - (z[2*k] >> 1);
+		int32_t c, s;
+		twiddle(k, &c, &s);
+		x[2*k] = (er + multiply_q31(or_, c) + multiply_q31(oi, s)) >> 1;
+		x[2*k+1] = (ei + multiply_q31(oi, c) - multiply_q31(or_, s)) >> 1;
+	}
+}
+
+void AudioFilterConvolution::end(void)
+{
+	__disable_irq();
+	parts = 0;
+	__enable_irq();
+}
+
+bool AudioFilterConvolution::begin(const int16_t *ir, uint32_t taps, int32_t *memory)
+{
+	uint32_t n, p, i;
+	int32_t peak, s;
+
+	end();
+	if (!ir || !taps || !memory) return false;
+	if (!quarter_sine_ready) {
+		for (i=0; i <= BINS/2; i++) {
+			double v = sin(i * (3.14159265358979 / BINS)) * 2147483648.0;
+			quarter_sine[i] = (v > 2147483647.0) ? 2147483647 : (int32_t)v;
+		}
+		quarter_sine_ready = true;
+	}
+	n = (taps + BINS - 1) / BINS;
+	spectrum = (uint32_t *)memory;
+	fdl = memory + n * BINS;
+	acc = fdl + n * 2 * BINS;
+	buffer = acc + 2 * BINS;
+	prev = (int16_t *)(buffer + 2 * BINS);
+
+	// full q31 spectra in the delay line first, for the common exponent
+	peak = 0;
+	for (p=0; p < n; p++) {
+		int32_t *x = fdl + p * 2 * BINS;
+		for (i=0; i < BINS; i++) {
+			uint32_t t = p * BINS + i;
+			buffer[i] = (t < taps) ? ir[t] << INPUT_SHIFT : 0;
+		}
+		memset(buffer + BINS, 0, BINS * sizeof(int32_t));
+		arm_cfft_radix2_q31(&fft_inst, buffer);
+		split(buffer, x);
+		for (i=0; i < 2 * BINS; i++) {
+			int32_t a = abs(x[i]);
+			if (a > peak) peak = a;
+		}
+	}
+	s = 0;
+	while (peak > 32767) {
+		peak >>= 1;
+		s++;
+	}
+	while (peak && peak <= 16383) {
+		peak <<= 1;
+		s--;
+	}
+	for (p=0; p < n; p++) {
+		const int32_t *x = fdl + p * 2 * BINS;
+		uint32_t *h = spectrum + p * BINS;
+		for (i=0; i < BINS; i++) {
+			int32_t re, im;
+			if (s > 0) {
+				re = (x[2*i] + (1 << (s - 1))) >> s;
+				im = (x[2*i+1] + (1 << (s - 1))) >> s;
+			} else {
+				re = x[2*i] << -s;
+				im = x[2*i+1] << -s;
+			}
+			h[i] = pack_16b_16b(saturate16(im), saturate16(re));
+		}
+	}
+	shift = s;
+	memset(fdl, 0, n * 2 * BINS * sizeof(int32_t));
+	memset(prev, 0, BINS * sizeof(int16_t));
+	head = 0;
+	idle = n + 1;
+	__disable_irq();
+	parts = n;
+	__enable_irq();
+	return true;
+}
+
+#if defined(KINETISK) || defined(DSPINST_HOST)
+
+// The inverse of split() without the halving: complex spectrum of the
+// even + j * odd output samples, for the BINS point inverse FFT.
+static void merge(const int32_t *x, int32_t *z)
+{
+	z[0] = (x[0] >> 1) + (x[1] >> 1);
+	z[1] = (x[0] >> 1) - (x[1] >> 1);
+	for (unsigned int k=1; k < BINS; k++) {
+		unsigned int m = BINS - k;
+		int32_t er = (x[2*k] >> 1) + (x[2*m] >> 1);
+		int32_t ei = (x[2*k+1] >> 1) - (x[2*m+1] >> 1);
+		int32_t dr = (x[2*k] >> 1) - (x[2*m] >> 1);
+		int32_t di = (x[2*k+1] >> 1) + (x[2*m+1] >> 1);
+		int32_t c, s;
+		twiddle(k, &c, &s);
+		// O = D * conj(W), Z = E + j*O
+		int32_t or_ = multiply_q31(dr, c) - multiply_q31(di, s);
+		int32_t oi = multiply_q31(di, c) + multiply_q31(dr, s);
+		z[2*k] = er - oi;
+		z[2*k+1] = ei + or_;
+	}
+}
+
+void AudioFilterConvolution::update(void)
+{
+	audio_block_t *block, *out;
+	uint32_t p, k;
+
+	block = receiveReadOnly();
+	if (!parts) {
+		if (block) release(block);
+		return;
+	}
+	if (block) {
+		idle = 0;
+	} else if (idle > parts) {
+		// silence in, the last partition has passed too
+		return;
+	} else {
+		idle++;
+	}
+
+	// overlap-save frame: previous block, then this one
+	for (k=0; k < BINS; k++) {
+		buffer[k] = prev[k] << INPUT_SHIFT;
+	}
+	if (block) {
+		for (k=0; k < BINS; k++) {
+			buffer[BINS + k] = block->data[k] << INPUT_SHIFT;
+		}
+		memcpy(prev, block->data, BINS * sizeof(int16_t));
+		release(block);
+	} else {
+		memset(buffer + BINS, 0, BINS * sizeof(int32_t));
+		memset(prev, 0, BINS * sizeof(int16_t));
+	}
+	if (++head >= parts) head = 0;
+	arm_cfft_radix2_q31(&fft_inst, buffer);
+	split(buffer, fdl + head * 2 * BINS);
+
+	// multiply and add, partition p meets the input from p blocks ago
+	memset(acc, 0, 2 * BINS * sizeof(int32_t));
+	for (p=0; p < parts; p++) {
+		uint32_t slot = (head >= p) ? head - p : head + parts - p;
+		const int32_t *x = fdl + slot * 2 * BINS;
+		const uint32_t *h = spectrum + p * BINS;
+		int32_t *y = acc;
+		uint32_t hk = *h++;
+		// DC and Nyquist are real
+		y[0] = signed_multiply_accumulate_32x16b(y[0], x[0], hk);
+		y[1] = signed_multiply_accumulate_32x16t(y[1], x[1], hk);
+		x += 2;
+		y += 2;
+		for (k=1; k < BINS; k++) {
+			int32_t xr = *x++;
+			int32_t xi = *x++;
+			hk = *h++;
+			int32_t yr = signed_multiply_accumulate_32x16b(y[0], xr, hk);
+			int32_t yi = signed_multiply_accumulate_32x16t(y[1], xr, hk);
+			y[0] = yr - signed_multiply_32x16t(xi, hk);
+			y[1] = signed_multiply_accumulate_32x16b(yi, xi, hk);
+			y += 2;
+		}
+	}
+
+	// exponent back in, saturated, the result only clips if the output does
+	int32_t s = shift + OUTPUT_FRAC - 7;
+	if (s > 0) {
+		int32_t lim = 0x3FFFFFFF >> s;
+		for (k=0; k < 2 * BINS; k++) {
+			int32_t v = acc[k];
+			if (v > lim) v = lim;
+			else if (v < -lim) v = -lim;
+			acc[k] = v << s;
+		}
+	} else if (s < 0) {
+		for (k=0; k < 2 * BINS; k++) {
+			acc[k] >>= -s;
+		}
+	}
+	merge(acc, buffer);
+	arm_cfft_radix2_q31(&ifft_inst, buffer);
+
+	// the second half of the frame is valid, the first half wrapped around
+	out = allocate();
+	if (!out) return;
+	for (k=0; k < BINS; k++) {
+		int32_t v = buffer[BINS + k];
+		out->data[k] = saturate16((v + (1 << (OUTPUT_FRAC - 1))) >> OUTPUT_FRAC);
+	}
+	transmit(out);
+	release(out);
+}
+
+#elif defined(KINETISL)
+
+void AudioFilterConvolution::update(void)
+{
+	audio_block_t *block;
+
+	block = receiveReadOnly();
+	if (block) release(block);
+}
+
+#endif
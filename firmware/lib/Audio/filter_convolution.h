@@ -0,0 +1,74 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef filter_convolution_h_
+#define filter_convolution_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "arm_math.h"
+
+// Memory layout, one partition per block of taps: the impulse response
+// spectra (packed q15 complex, one word per bin), the input spectra delay
+// line (q31 complex), then the accumulator, the FFT buffer and the
+// previous input block. Words of memory needed for a number of taps:
+#define AUDIO_CONVOLUTION_WORDS(taps)	\
+	((((taps) + AUDIO_BLOCK_SAMPLES - 1) / AUDIO_BLOCK_SAMPLES * 3 + 4) * \
+	AUDIO_BLOCK_SAMPLES + AUDIO_BLOCK_SAMPLES / 2)
+
+// Uniformly partitioned overlap-save convolution for impulse responses
+// too long for AudioFilterFIR (cabinets, rooms). The IR is cut into
+// partitions of one block, each input block is transformed once with a
+// 2 block real FFT and multiplied with every partition spectrum, so the
+// cost per partition is a complex multiply per bin instead of a block of
+// taps per tap. Output latency is one block. Memory is 1.5kB per 128
+// taps, a Teensy 3.2 has room for about 2000.
+class AudioFilterConvolution : public AudioStream
+{
+public:
+	AudioFilterConvolution(void) : AudioStream(1, inputQueueArray), parts(0) {
+		// real 2 block FFT as a 1 block complex FFT
+		arm_cfft_radix2_init_q31(&fft_inst, AUDIO_BLOCK_SAMPLES, 0, 1);
+		arm_cfft_radix2_init_q31(&ifft_inst, AUDIO_BLOCK_SAMPLES, 1, 1);
+	}
+	// ir in q15 like the AudioFilterFIR coefficients, memory holds
+	// AUDIO_CONVOLUTION_WORDS(taps). The IR spectra are computed here,
+	// the ir array is not used after that. Returns false for bad arguments.
+	bool begin(const int16_t *ir, uint32_t taps, int32_t *memory);
+	void end(void);
+	virtual void update(void);
+private:
+	uint32_t parts;			// partitions, 0 = off
+	uint32_t head;			// delay line slot of the newest input
+	uint32_t idle;			// blocks without input, the tail runs out
+	int32_t shift;			// block exponent of the IR spectra
+	uint32_t *spectrum;		// [parts][bins] IR, im top, re bottom
+	int32_t *fdl;			// [parts][2*bins] input spectra
+	int32_t *acc;			// [2*bins] output spectrum
+	int32_t *buffer;		// [2*bins] FFT in place
+	int16_t *prev;			// [bins] last input block
+	arm_cfft_radix2_instance_q31 fft_inst;
+	arm_cfft_radix2_instance_q31 ifft_inst;
+	audio_block_t *inputQueueArray[1];
+};
+
+#endif
@@ -0,0 +1,305 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "filter_eqfit.h"
+
+#define EQFIT_MAX_POINTS	64
+#define EQFIT_GUARDS		3	// points above fmax that hold the last target
+#define EQFIT_MAX_CUT		12.0f	// dB
+#define EQFIT_Q_MIN		0.3f
+#define EQFIT_Q_MAX		8.0f
+#define EQFIT_ROUNDS		16
+#define EQFIT_TOLERANCE		0.1f	// dB, good enough to stop adding stages
+
+// http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt, same as the
+// AudioFilterBiquad helpers
+void AudioEqualizerFit::coefficients(const eqfit_stage_t *stage, float rate, double *coef)
+{
+	double a = pow(10.0, stage->gain / 40.0);
+	double w0 = stage->frequency * (2 * 3.141592654 / rate);
+	double sinW0 = sin(w0);
+	double cosW0 = cos(w0);
+	double alpha, sinsq, a0;
+
+	if (stage->type == EQFIT_PEAK) {
+		alpha = sinW0 / (stage->q * 2.0);
+		a0 = 1.0 + alpha / a;
+		coef[0] = (1.0 + alpha * a) / a0;
+		coef[1] = (-2.0 * cosW0) / a0;
+		coef[2] = (1.0 - alpha * a) / a0;
+		coef[3] = coef[1];
+		coef[4] = (1.0 - alpha / a) / a0;
+		return;
+	}
+	sinsq = sinW0 * sqrt((a * a + 1.0) * (1.0 / stage->q - 1.0) + 2.0 * a);
+	if (stage->type == EQFIT_LOWSHELF) {
+		a0 = (a + 1.0) + (a - 1.0) * cosW0 + sinsq;
+		coef[0] = a * ((a + 1.0) - (a - 1.0) * cosW0 + sinsq) / a0;
+		coef[1] = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosW0) / a0;
+		coef[2] = a * ((a + 1.0) - (a - 1.0) * cosW0 - sinsq) / a0;
+		coef[3] = -2.0 * ((a - 1.0) + (a + 1.0) * cosW0) / a0;
+		coef[4] = ((a + 1.0) + (a - 1.0) * cosW0 - sinsq) / a0;
+	} else {
+		a0 = (a + 1.0) - (a - 1.0) * cosW0 + sinsq;
+		coef[0] = a * ((a + 1.0) + (a - 1.0) * cosW0 + sinsq) / a0;
+		coef[1] = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosW0) / a0;
+		coef[2] = a * ((a + 1.0) + (a - 1.0) * cosW0 - sinsq) / a0;
+		coef[3] = 2.0 * ((a - 1.0) - (a + 1.0) * cosW0) / a0;
+		coef[4] = ((a + 1.0) - (a - 1.0) * cosW0 - sinsq) / a0;
+	}
+}
+
+float AudioEqualizerFit::response(const eqfit_stage_t *stages, uint32_t count,
+  float freq, float rate)
+{
+	double coef[5];
+	float w = freq * (float)(2.0 * M_PI) / rate;
+	float c1 = cosf(w), s1 = sinf(w), c2 = cosf(2 * w), s2 = sinf(2 * w);
+	float nr, ni, dr, di, mag = 1.0f;
+	uint32_t i;
+
+	for (i=0; i < count; i++) {
+		coefficients(stages + i, rate, coef);
+		// H(e^jw) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+		nr = coef[0] + coef[1] * c1 + coef[2] * c2;
+		ni = -coef[1] * s1 - coef[2] * s2;
+		dr = 1.0f + coef[3] * c1 + coef[4] * c2;
+		di = -coef[3] * s1 - coef[4] * s2;
+		mag *= sqrtf((nr * nr + ni * ni) / (dr * dr + di * di));
+	}
+	return 20.0f * log10f(mag);
+}
+
+void AudioEqualizerFit::stageResponse(const eqfit_stage_t *stage,
+  const float *freq, uint32_t points, float rate, float *out)
+{
+	uint32_t i;
+
+	for (i=0; i < points; i++) {
+		out[i] = response(stage, 1, freq[i], rate);
+	}
+}
+
+// Squared error of the cascade with one stage swapped, sum - own + next
+// in dB at each point. The guard points only count when the response goes
+// above them.
+float AudioEqualizerFit::error(const float *sum, const float *own,
+  const float *next, const float *target, uint32_t points, uint32_t guard)
+{
+	float e, total = 0.0f;
+	uint32_t i;
+
+	for (i=0; i < points; i++) {
+		e = target[i] - (sum[i] - own[i] + next[i]);
+		if (i >= guard && e > 0.0f) continue;
+		total += e * e;
+	}
+	return total;
+}
+
+// Greedy: a new stage goes where the remaining error is largest, a shelf
+// at the ends of the band, a peak in between. Then all stages are refined
+// by coordinate descent on gain, log frequency and log Q. Guard points
+// between fmax and 0.45 * rate keep the shelves from piling up above the
+// band, the response there may fall but not rise above the last target.
+// The cascade response at the points is kept in sum[], so a trial only
+// evaluates the stage being tuned. The cuts are sorted in front of the
+// boosts, so no partial cascade goes above the full one and the 16 bit
+// stage outputs do not clip.
+uint32_t AudioEqualizerFit::fit(const float *freq, const float *gain, uint32_t points,
+  float refFreq, float fmin, float fmax, float maxBoost, float rate,
+  eqfit_stage_t *stages, uint32_t maxStages)
+{
+	float fpt[EQFIT_MAX_POINTS + EQFIT_GUARDS];
+	float target[EQFIT_MAX_POINTS + EQFIT_GUARDS];
+	float sum[EQFIT_MAX_POINTS + EQFIT_GUARDS];
+	float own[EQFIT_MAX_POINTS + EQFIT_GUARDS];
+	float next[EQFIT_MAX_POINTS + EQFIT_GUARDS];
+	float ref, e, worst, best, trial, step[3];
+	float fhi = rate * 0.45f;
+	uint32_t i, n, p, r, k, lo, hi, at, total;
+	eqfit_stage_t *s, tmp;
+
+	if (points > EQFIT_MAX_POINTS) points = EQFIT_MAX_POINTS;
+	if (points < 2 || maxStages == 0) return 0;
+	if (fmax > fhi) fmax = fhi;
+	at = 0;
+	for (i=1; i < points; i++) {
+		if (fabsf(freq[i] - refFreq) < fabsf(freq[at] - refFreq)) at = i;
+	}
+	ref = gain[at];
+	lo = points;
+	hi = 0;
+	for (i=0; i < points; i++) {
+		fpt[i] = freq[i];
+		target[i] = 0.0f;
+		sum[i] = 0.0f;
+		if (freq[i] < fmin || freq[i] > fmax) continue;
+		target[i] = ref - gain[i];
+		if (target[i] > maxBoost) target[i] = maxBoost;
+		else if (target[i] < -EQFIT_MAX_CUT) target[i] = -EQFIT_MAX_CUT;
+		if (i < lo) lo = i;
+		hi = i;
+	}
+	if (lo > hi) return 0;
+	total = points;
+	for (i=1; i <= EQFIT_GUARDS; i++) {
+		trial = freq[hi] * powf(fhi / freq[hi], (float)i / EQFIT_GUARDS);
+		if (trial <= freq[points - 1]) continue;
+		fpt[total] = trial;
+		sum[total] = 0.0f;
+		target[total++] = target[hi];
+	}
+
+	for (n=0; n < maxStages; ) {
+		worst = 0.0f;
+		for (i=lo; i <= hi; i++) {
+			e = target[i] - sum[i];
+			if (fabsf(e) > fabsf(worst)) {
+				worst = e;
+				at = i;
+			}
+		}
+		if (fabsf(worst) < EQFIT_TOLERANCE) break;
+		s = stages + n++;
+		// a shelf alone is too soft for a steep roll-off at the top of
+		// the band, every other stage placed there is a peak
+		s->type = (at == hi && hi > lo && (n & 1)) ? EQFIT_HIGHSHELF :
+			(at == lo && hi > lo) ? EQFIT_LOWSHELF : EQFIT_PEAK;
+		s->frequency = freq[at];
+		s->gain = worst;
+		s->q = (s->type == EQFIT_PEAK) ? 1.41f : 1.0f;
+		stageResponse(s, fpt, total, rate, own);
+		for (i=0; i < total; i++) sum[i] += own[i];
+
+		best = error(sum, own, own, target, total, points);
+		for (p=0; p < n; p++) {
+			stageResponse(stages + p, fpt, total, rate, own);
+			step[0] = 1.0f;		// dB
+			step[1] = 0.25f;	// octaves
+			step[2] = 0.5f;		// octaves of Q
+			for (r=0; r < EQFIT_ROUNDS; r++) {
+				for (k=0; k < 3; k++) {
+					s = stages + p;
+					for (int dir=-1; dir <= 1; dir += 2) {
+						eqfit_stage_t keep = *s;
+						if (k == 0) {
+							trial = s->gain + dir * step[0];
+							if (trial > maxBoost || trial < -EQFIT_MAX_CUT) continue;
+							s->gain = trial;
+						} else if (k == 1) {
+							trial = s->frequency * exp2f(dir * step[1]);
+							if (trial < fmin * 0.5f || trial > fhi) continue;
+							s->frequency = trial;
+						} else {
+							trial = s->q * exp2f(dir * step[2]);
+							if (s->type != EQFIT_PEAK && trial > 1.0f) continue;
+							if (trial < EQFIT_Q_MIN || trial > EQFIT_Q_MAX) continue;
+							s->q = trial;
+						}
+						stageResponse(s, fpt, total, rate, next);
+						e = error(sum, own, next, target, total, points);
+						if (e < best) {
+							best = e;
+							for (i=0; i < total; i++) {
+								sum[i] += next[i] - own[i];
+								own[i] = next[i];
+							}
+							break;
+						}
+						*s = keep;
+					}
+					step[k] *= 0.7f;
+				}
+			}
+		}
+	}
+	for (i=1; i < n; i++) {
+		tmp = stages[i];
+		for (k=i; k > 0 && stages[k - 1].gain > tmp.gain; k--) {
+			stages[k] = stages[k - 1];
+		}
+		stages[k] = tmp;
+	}
+	return n;
+}
+
+// largest feed forward coefficient, they have to stay below 2 in Q30
+static double bmax(const double *coef)
+{
+	double m = fabs(coef[0]);
+
+	if (fabs(coef[1]) > m) m = fabs(coef[1]);
+	if (fabs(coef[2]) > m) m = fabs(coef[2]);
+	return m;
+}
+
+// Coefficients of bank stage i, a pass through from n on, scaled down in
+// 6 dB steps until they fit. Returns the gain taken out.
+void AudioEqualizerFit::stageCoefficients(const eqfit_stage_t *stages,
+  uint32_t i, uint32_t n, float rate, double *coef, double *taken)
+{
+	int j;
+
+	*taken = 1.0;
+	if (i < n) {
+		coefficients(stages + i, rate, coef);
+	} else {
+		coef[0] = 1.0;
+		coef[1] = coef[2] = coef[3] = coef[4] = 0.0;
+	}
+	while (bmax(coef) >= 1.999) {
+		for (j=0; j < 3; j++) coef[j] *= 0.5;
+		*taken *= 2.0;
+	}
+}
+
+// The filter coefficients are Q30, a boosting shelf far from its corner can
+// need |b| >= 2. Such a stage is scaled down in 6 dB steps and the gain is
+// put back from the first stage on, which also carries the level: the
+// first stage takes what fits, the rest goes to the next ones. Stages below
+// rate / 100 run with the 32 bit state, the 16 bit one is too noisy there.
+float AudioEqualizerFit::apply(AudioFilterBiquadBank *filter,
+  const eqfit_stage_t *stages, uint32_t n, float rate, float level)
+{
+	double coef[5], taken, g;
+	double scale = pow(10.0, level / 20.0);
+	uint32_t i, count = filter->stages();
+	int j;
+
+	if (count == 0) return level;
+	if (n > count) n = count;
+	for (i=0; i < count; i++) {
+		stageCoefficients(stages, i, n, rate, coef, &taken);
+		scale *= taken;
+	}
+	for (i=0; i < count; i++) {
+		stageCoefficients(stages, i, n, rate, coef, &taken);
+		filter->setPrecision(i, i < n && stages[i].frequency < rate * 0.01f);
+		g = 1.999 / bmax(coef);
+		if (scale < g) g = scale;
+		for (j=0; j < 3; j++) coef[j] *= g;
+		scale /= g;
+		filter->setCoefficients(i, coef);
+	}
+	return 20.0 * log10(scale);
+}
@@ -0,0 +1,74 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef filter_eqfit_h_
+#define filter_eqfit_h_
+
+#include "Arduino.h"
+#include "filter_biquad.h"
+
+#define EQFIT_PEAK		0
+#define EQFIT_LOWSHELF		1
+#define EQFIT_HIGHSHELF		2
+
+typedef struct
+{
+	uint8_t type;		// EQFIT_ value
+	float frequency;	// Hz
+	float gain;		// dB
+	float q;		// shelves use it as the slope
+} eqfit_stage_t;
+
+// Fits a cascade of peaking/shelving biquads to the inverse of a measured
+// frequency response, e.g. from the loopback analyzer, and loads it into
+// an AudioFilterBiquadBank.
+class AudioEqualizerFit
+{
+public:
+	// gain[] in dB at freq[], ascending. The target is flat at the level
+	// measured nearest refFreq, corrected between fmin and fmax only,
+	// boosts are limited to maxBoost dB. Returns the number of stages.
+	static uint32_t fit(const float *freq, const float *gain, uint32_t points,
+	  float refFreq, float fmin, float fmax, float maxBoost, float rate,
+	  eqfit_stage_t *stages, uint32_t maxStages);
+	// response of the cascade in dB
+	static float response(const eqfit_stage_t *stages, uint32_t count,
+	  float freq, float rate);
+	// b0, b1, b2, a1, a2, normalized to a0
+	static void coefficients(const eqfit_stage_t *stage, float rate, double *coef);
+	// Load the cascade into the filter, unused stages pass through,
+	// level in dB is added from the first stage on (headroom for the
+	// boosts). Returns the dB of level and of scaled down stages that did
+	// not fit into the coefficients, 0 when the whole response is loaded.
+	static float apply(AudioFilterBiquadBank *filter, const eqfit_stage_t *stages,
+	  uint32_t n, float rate, float level=0.0f);
+private:
+	static void stageCoefficients(const eqfit_stage_t *stages, uint32_t i,
+	  uint32_t n, float rate, double *coef, double *taken);
+	static void stageResponse(const eqfit_stage_t *stage, const float *freq,
+	  uint32_t points, float rate, float *out);
+	static float error(const float *sum, const float *own, const float *next,
+	  const float *target, uint32_t points, uint32_t guard);
+};
+
+#endif
@@ -42,13 +42,14 @@ public:
 		state_bandpass = 0;
 	}
 	void frequency(float freq) {
+		freq_set = freq;
 		if (freq < 20.0) freq = 20.0;
-		else if (freq > AUDIO_SAMPLE_RATE_EXACT/2.5) freq = AUDIO_SAMPLE_RATE_EXACT/2.5;
-		setting_fcenter = (freq * (3.141592654/(AUDIO_SAMPLE_RATE_EXACT*2.0)))
+		else if (freq > AudioSampleRate()/2.5) freq = AudioSampleRate()/2.5;
+		setting_fcenter = (freq * (3.141592654/(AudioSampleRate()*2.0)))
 			* 2147483647.0;
 		// TODO: should we use an approximation when freq is not a const,
 		// so the sinf() function isn't linked?
-		setting_fmult = sinf(freq * (3.141592654/(AUDIO_SAMPLE_RATE_EXACT*2.0)))
+		setting_fmult = sinf(freq * (3.141592654/(AudioSampleRate()*2.0)))
 			* 2147483647.0;
 	}
 	void resonance(float q) {
@@ -66,11 +67,13 @@ public:
 		setting_octavemult = n * 4096.0;
 	}
 	virtual void update(void);
+	virtual void sampleRateChanged(void) { frequency(freq_set); }
 private:
 	void update_fixed(const int16_t *in,
 		int16_t *lp, int16_t *bp, int16_t *hp);
 	void update_variable(const int16_t *in, const int16_t *ctl,
 		int16_t *lp, int16_t *bp, int16_t *hp);
+	float freq_set;
 	int32_t setting_fcenter;
 	int32_t setting_fmult;
 	int32_t setting_octavemult;
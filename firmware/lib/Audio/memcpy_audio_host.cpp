@@ -0,0 +1,60 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// memcpy_audio.S is Cortex-M4 only, these are the same routines for a
+// host build of the library.
+
+#if !defined(__MK20DX128__) && !defined(__MK20DX256__) && !defined(__MK64FX512__) && !defined(__MK66FX1M0__) && !defined(__MKL26Z64__)
+
+#include "AudioStream.h"
+#include "memcpy_audio.h"
+#include "utility/dspblock.h"
+
+void memcpy_tointerleaveLR(int16_t *dst, const int16_t *srcL, const int16_t *srcR)
+{
+	block_interleave(dst, srcL, srcR, AUDIO_BLOCK_SAMPLES);
+}
+
+void memcpy_tointerleaveL(int16_t *dst, const int16_t *srcL)
+{
+	block_interleave(dst, srcL, NULL, AUDIO_BLOCK_SAMPLES);
+}
+
+void memcpy_tointerleaveR(int16_t *dst, const int16_t *srcR)
+{
+	block_interleave(dst, NULL, srcR, AUDIO_BLOCK_SAMPLES);
+}
+
+// frame order 1 3 2 4, like the I2S quad DMA expects
+void memcpy_tointerleaveQuad(int16_t *dst, const int16_t *src1, const int16_t *src2,
+	const int16_t *src3, const int16_t *src4)
+{
+	for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		*dst++ = src1[i];
+		*dst++ = src3[i];
+		*dst++ = src2[i];
+		*dst++ = src4[i];
+	}
+}
+
+#endif
@@ -26,53 +26,22 @@
 
 #include "mixer.h"
 #include "utility/dspinst.h"
+#include "utility/dspblock.h"
 
-#if defined(KINETISK)
+#if !defined(KINETISL)	// Teensy 3.x and host builds
 #define MULTI_UNITYGAIN 65536
 
 static void applyGain(int16_t *data, int32_t mult)
 {
-	uint32_t *p = (uint32_t *)data;
-	const uint32_t *end = (uint32_t *)(data + AUDIO_BLOCK_SAMPLES);
-
-	do {
-		uint32_t tmp32 = *p; // read 2 samples from *data
-		int32_t val1 = signed_multiply_32x16b(mult, tmp32);
-		int32_t val2 = signed_multiply_32x16t(mult, tmp32);
-		val1 = signed_saturate_rshift(val1, 16, 0);
-		val2 = signed_saturate_rshift(val2, 16, 0);
-		*p++ = pack_16b_16b(val2, val1);
-	} while (p < end);
+	block_gain(data, mult, AUDIO_BLOCK_SAMPLES);
 }
 
 static void applyGainThenAdd(int16_t *data, const int16_t *in, int32_t mult)
 {
-	uint32_t *dst = (uint32_t *)data;
-	const uint32_t *src = (uint32_t *)in;
-	const uint32_t *end = (uint32_t *)(data + AUDIO_BLOCK_SAMPLES);
-
-	if (mult == MULTI_UNITYGAIN) {
-		do {
-			uint32_t tmp32 = *dst;
-			*dst++ = signed_add_16_and_16(tmp32, *src++);
-			tmp32 = *dst;
-			*dst++ = signed_add_16_and_16(tmp32, *src++);
-		} while (dst < end);
-	} else {
-		do {
-			uint32_t tmp32 = *src++; // read 2 samples from *data
-			int32_t val1 = signed_multiply_32x16b(mult, tmp32);
-			int32_t val2 = signed_multiply_32x16t(mult, tmp32);
-			val1 = signed_saturate_rshift(val1, 16, 0);
-			val2 = signed_saturate_rshift(val2, 16, 0);
-			tmp32 = pack_16b_16b(val2, val1);
-			uint32_t tmp32b = *dst;
-			*dst++ = signed_add_16_and_16(tmp32, tmp32b);
-		} while (dst < end);
-	}
+	block_gain_add(data, in, mult, AUDIO_BLOCK_SAMPLES);
 }
 
-#elif defined(KINETISL)
+#else
 #define MULTI_UNITYGAIN 256
 
 static void applyGain(int16_t *data, int32_t mult)
@@ -131,3 +100,188 @@ void AudioMixer4::update(void)
 }
 
 
+static int32_t gain_to_mult(float gain)
+{
+	if (gain > 32767.0f) gain = 32767.0f;
+	else if (gain < -32767.0f) gain = -32767.0f;
+	return gain * 65536.0f;
+}
+
+AudioMixerSparse::AudioMixerSparse(unsigned char ninput, audio_block_t **iqueue,
+  int32_t *mult, uint8_t *list) : AudioStream(ninput, iqueue)
+{
+	multiplier = mult;
+	active_list = list;
+	for (int i=0; i < ninput; i++) {
+		multiplier[i] = 65536;
+		active_list[i] = i;
+	}
+	num_active = ninput;
+}
+
+void AudioMixerSparse::gain(unsigned int channel, float gain)
+{
+	unsigned int i, n;
+	int32_t mult = gain_to_mult(gain);
+
+	if (channel >= num_inputs) return;
+	__disable_irq();
+	multiplier[channel] = mult;
+	for (i=0, n=0; i < num_inputs; i++) {
+		if (multiplier[i] != 0) active_list[n++] = i;
+	}
+	num_active = n;
+	__enable_irq();
+}
+
+void AudioMixerSparse::update(void)
+{
+	audio_block_t *in, *out=NULL;
+	unsigned int i, n, channel;
+	int32_t mult;
+
+	n = num_active;
+	// muted inputs, drop them without looking
+	for (i=0, channel=0; channel < num_inputs; channel++) {
+		if (i < n && active_list[i] == channel) {
+			i++;
+			continue;
+		}
+		in = receiveReadOnly(channel);
+		if (in) release(in);
+	}
+	for (i=0; i < n; i++) {
+		channel = active_list[i];
+		in = receiveReadOnly(channel);
+		if (!in) continue;
+		mult = multiplier[channel];
+		if (out) {
+			block_gain_add(out->data, in->data, mult, AUDIO_BLOCK_SAMPLES);
+			release(in);
+		} else if (in->ref_count == 1) {
+			// nobody else holds it, sum into it
+			if (mult != 65536) block_gain(in->data, mult, AUDIO_BLOCK_SAMPLES);
+			out = in;
+		} else if (mult == 65536 && i == n - 1) {
+			out = in;	// the only one, pass it on
+		} else {
+			out = allocate();
+			if (out) block_gain_copy(out->data, in->data, mult, AUDIO_BLOCK_SAMPLES);
+			release(in);
+		}
+	}
+	if (out) {
+		transmit(out);
+		release(out);
+	}
+}
+
+AudioMixerStereoSparse::AudioMixerStereoSparse(unsigned char ninput,
+  audio_block_t **iqueue, int32_t *mult, uint8_t *list, audio_block_t **scratch)
+  : AudioStream(ninput, iqueue)
+{
+	multiplier = mult;
+	active_list = list;
+	blocks = scratch;
+	for (int i=0; i < ninput; i++) {
+		multiplier[i] = 65536;
+		multiplier[ninput + i] = 65536;
+		active_list[i] = i;
+		blocks[i] = NULL;
+	}
+	num_active = ninput;
+	is_linked = true;
+}
+
+void AudioMixerStereoSparse::gain(unsigned int channel, float left, float right)
+{
+	unsigned int i, n;
+	int32_t *mult_r = multiplier + num_inputs;
+	int32_t mult_left = gain_to_mult(left);
+	int32_t mult_right = gain_to_mult(right);
+	bool same = true;
+
+	if (channel >= num_inputs) return;
+	__disable_irq();
+	multiplier[channel] = mult_left;
+	mult_r[channel] = mult_right;
+	for (i=0, n=0; i < num_inputs; i++) {
+		if (multiplier[i] != 0 || mult_r[i] != 0) active_list[n++] = i;
+		if (multiplier[i] != mult_r[i]) same = false;
+	}
+	num_active = n;
+	is_linked = same;
+	__enable_irq();
+}
+
+// One side: the sum of the active inputs. It goes into the first input
+// block when nobody else holds it and the other side (other = NULL when
+// both are the same) does not read it, else into a new block. The input
+// block itself is passed on when it is the only one and at unity gain.
+// *borrowed is set when the result is one of the input blocks.
+audio_block_t * AudioMixerStereoSparse::mix(const int32_t *mult, const int32_t *other,
+  unsigned int n, bool *borrowed)
+{
+	audio_block_t *out=NULL;
+	unsigned int i, count=0, first=0;
+	int32_t m;
+
+	*borrowed = false;
+	for (i=0; i < n; i++) {
+		if (blocks[i] && mult[active_list[i]] != 0) {
+			if (count++ == 0) first = i;
+		}
+	}
+	if (count == 0) return NULL;
+	m = mult[active_list[first]];
+	if (blocks[first]->ref_count == 1 && (!other || other[active_list[first]] == 0)) {
+		out = blocks[first];
+		*borrowed = true;
+		if (m != 65536) block_gain(out->data, m, AUDIO_BLOCK_SAMPLES);
+	} else if (count == 1 && m == 65536) {
+		*borrowed = true;
+		return blocks[first];
+	} else {
+		out = allocate();
+		if (!out) return NULL;
+		block_gain_copy(out->data, blocks[first]->data, m, AUDIO_BLOCK_SAMPLES);
+	}
+	for (i=first+1; i < n; i++) {
+		m = mult[active_list[i]];
+		if (!blocks[i] || m == 0) continue;
+		block_gain_add(out->data, blocks[i]->data, m, AUDIO_BLOCK_SAMPLES);
+	}
+	return out;
+}
+
+void AudioMixerStereoSparse::update(void)
+{
+	audio_block_t *in, *left, *right;
+	unsigned int i, n, channel;
+	bool borrowed_l, borrowed_r;
+
+	n = num_active;
+	for (i=0, channel=0; channel < num_inputs; channel++) {
+		if (i < n && active_list[i] == channel) {
+			blocks[i++] = receiveReadOnly(channel);
+			continue;
+		}
+		in = receiveReadOnly(channel);
+		if (in) release(in);
+	}
+	if (is_linked) {
+		left = mix(multiplier, NULL, n, &borrowed_l);
+		right = left;
+		borrowed_r = borrowed_l;
+	} else {
+		left = mix(multiplier, multiplier + num_inputs, n, &borrowed_l);
+		right = mix(multiplier + num_inputs, multiplier, n, &borrowed_r);
+	}
+	if (left) transmit(left, 0);
+	if (right) transmit(right, 1);
+	if (left && !borrowed_l) release(left);
+	if (right && right != left && !borrowed_r) release(right);
+	for (i=0; i < n; i++) {
+		if (blocks[i]) release(blocks[i]);
+	}
+}
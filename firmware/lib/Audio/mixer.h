@@ -32,7 +32,7 @@
 
 class AudioMixer4 : public AudioStream
 {
-#if defined(KINETISK)
+#if !defined(KINETISL)	// Teensy 3.x and host builds
 public:
         AudioMixer4(void) : AudioStream(4, inputQueueArray) {
 		for (int i=0; i<4; i++) multiplier[i] = 65536;
@@ -48,7 +48,7 @@ private:
 	int32_t multiplier[4];
 	audio_block_t *inputQueueArray[4];
 
-#elif defined(KINETISL)
+#else
 public:
         AudioMixer4(void) : AudioStream(4, inputQueueArray) {
 		for (int i=0; i<4; i++) multiplier[i] = 256;
@@ -66,4 +66,81 @@ private:
 #endif
 };
 
+// Mixer with any number of inputs. The inputs with a nonzero gain are
+// kept in a short list, only those are read and summed, into the first
+// input block when nobody else holds it, else into one new block, never
+// a receiveWritable() copy. Muted inputs are released unread. A single
+// input at unity gain is passed on as it is.
+// Use AudioMixer<N>, this is the part shared by all the widths.
+class AudioMixerSparse : public AudioStream
+{
+public:
+	virtual void update(void);
+	void gain(unsigned int channel, float gain);
+	unsigned int inputs(void) { return num_inputs; }
+	// number of inputs with a nonzero gain
+	unsigned int active(void) { return num_active; }
+protected:
+	AudioMixerSparse(unsigned char ninput, audio_block_t **iqueue,
+	  int32_t *mult, uint8_t *list);
+private:
+	int32_t *multiplier;		// [inputs] 16.16
+	uint8_t *active_list;		// [inputs] nonzero gain channels, ascending
+	volatile uint8_t num_active;
+};
+
+template <unsigned char N>
+class AudioMixer : public AudioMixerSparse
+{
+public:
+	AudioMixer(void) : AudioMixerSparse(N, inputQueueArray, mult, list) { }
+private:
+	int32_t mult[N];
+	uint8_t list[N];
+	audio_block_t *inputQueueArray[N];
+};
+
+
+// Stereo version, N inputs and 2 outputs with a left and a right gain per
+// input. A mono source takes one input and one patch cord for both sides,
+// a stereo source two inputs, one per side. The inputs are read once for
+// both sides, and while every input has the same gain on both sides the
+// sum is computed once and the same block goes to both outputs.
+// Use AudioMixerStereo<N>.
+class AudioMixerStereoSparse : public AudioStream
+{
+public:
+	virtual void update(void);
+	void gain(unsigned int channel, float left, float right);
+	void gain(unsigned int channel, float level) { gain(channel, level, level); }
+	unsigned int inputs(void) { return num_inputs; }
+	// number of inputs with a nonzero gain on either side
+	unsigned int active(void) { return num_active; }
+	// true when both outputs get the same sum
+	bool linked(void) { return is_linked; }
+protected:
+	AudioMixerStereoSparse(unsigned char ninput, audio_block_t **iqueue,
+	  int32_t *mult, uint8_t *list, audio_block_t **scratch);
+private:
+	audio_block_t * mix(const int32_t *mult, const int32_t *other,
+	  unsigned int n, bool *borrowed);
+	int32_t *multiplier;		// [2][inputs] left then right, 16.16
+	uint8_t *active_list;		// [inputs] nonzero gain channels, ascending
+	audio_block_t **blocks;		// [inputs] the active inputs in update()
+	volatile uint8_t num_active;
+	volatile bool is_linked;
+};
+
+template <unsigned char N>
+class AudioMixerStereo : public AudioMixerStereoSparse
+{
+public:
+	AudioMixerStereo(void) : AudioMixerStereoSparse(N, inputQueueArray, mult, list, blocks) { }
+private:
+	int32_t mult[2 * N];
+	uint8_t list[N];
+	audio_block_t *blocks[N];
+	audio_block_t *inputQueueArray[N];
+};
+
 #endif
@@ -25,13 +25,17 @@
  */
 
 #include "output_dac.h"
+#include "output_i2s.h"
 #include "utility/pdb.h"
+#include "utility/output_delay.h"
 
 #if defined(__MK20DX256__) || defined(__MK64FX512__) || defined(__MK66FX1M0__)
 
 DMAMEM static uint16_t dac_buffer[AUDIO_BLOCK_SAMPLES*2];
 audio_block_t * AudioOutputAnalog::block_left_1st = NULL;
 audio_block_t * AudioOutputAnalog::block_left_2nd = NULL;
+audio_block_t * AudioOutputAnalog::block_prev = NULL;
+uint16_t AudioOutputAnalog::delay_samples = 0;
 bool AudioOutputAnalog::update_responsibility = false;
 DMAChannel AudioOutputAnalog::dma(false);
 
@@ -111,14 +115,77 @@ void AudioOutputAnalog::update(void)
 	}
 }
 
+bool AudioOutputAnalog::loopBegin(const uint16_t *data, uint32_t samples)
+{
+	if (samples == 0 || samples > 32767) return false;
+	dma.disable();
+	dma.TCD->SADDR = data;
+	dma.TCD->SLAST = -(int32_t)(samples * 2);
+	dma.TCD->CITER_ELINKNO = samples;
+	dma.TCD->BITER_ELINKNO = samples;
+	dma.TCD->CSR = 0;
+	dma.enable();
+	return true;
+}
+
+void AudioOutputAnalog::loopEnd(void)
+{
+	dma.disable();
+	for (int i=0; i < AUDIO_BLOCK_SAMPLES*2; i++) dac_buffer[i] = 2047;
+	dma.TCD->SADDR = dac_buffer;
+	dma.TCD->SLAST = -sizeof(dac_buffer);
+	dma.TCD->CITER_ELINKNO = sizeof(dac_buffer) / 2;
+	dma.TCD->BITER_ELINKNO = sizeof(dac_buffer) / 2;
+	dma.TCD->CSR = DMA_TCD_CSR_INTHALF | DMA_TCD_CSR_INTMAJOR;
+	dma.enable();
+}
+
+// The update starts when the I2S DMA is at frame 0 and the I2S plays the
+// new block from the next frame 0 on. Each DAC interrupt takes the next
+// queued block and the DMA plays it from the following half of the DAC
+// buffer. Putting the DAC interrupts at I2S frame AUDIO_BLOCK_SAMPLES/2
+// gives the update half a block to finish, the DAC plays half a block
+// after the I2S.
+void AudioOutputAnalog::sync(void)
+{
+	audio_block_t *b1, *b2;
+	uint32_t pos;
+
+	__disable_irq();
+	pos = (AudioOutputI2S::position() + AUDIO_BLOCK_SAMPLES/2) % AUDIO_BLOCK_SAMPLES;
+	dma.disable();
+	dma.TCD->SADDR = dac_buffer + pos;
+	dma.TCD->CITER_ELINKNO = AUDIO_BLOCK_SAMPLES*2 - pos;
+	dma.enable();
+	b1 = block_left_1st;
+	b2 = block_left_2nd;
+	block_left_1st = NULL;
+	block_left_2nd = NULL;
+	__enable_irq();
+	if (b1) release(b1);
+	if (b2) release(b2);
+}
+
+void AudioOutputAnalog::delaySamples(uint32_t samples)
+{
+	audio_block_t *prev;
+
+	if (samples > AUDIO_BLOCK_SAMPLES) samples = AUDIO_BLOCK_SAMPLES;
+	__disable_irq();
+	delay_samples = samples;
+	prev = block_prev;
+	block_prev = NULL;
+	__enable_irq();
+	if (prev) release(prev);
+}
+
 // TODO: the DAC has much higher bandwidth than the datasheet says
 // can we output a 2X oversampled output, for easier filtering?
 
 void AudioOutputAnalog::isr(void)
 {
-	const int16_t *src, *end;
-	int16_t *dest;
-	audio_block_t *block;
+	uint16_t *dest;
+	audio_block_t *done;
 	uint32_t saddr;
 
 	saddr = (uint32_t)(dma.TCD->SADDR);
@@ -126,29 +193,17 @@ void AudioOutputAnalog::isr(void)
 	if (saddr < (uint32_t)dac_buffer + sizeof(dac_buffer) / 2) {
 		// DMA is transmitting the first half of the buffer
 		// so we must fill the second half
-		dest = (int16_t *)&dac_buffer[AUDIO_BLOCK_SAMPLES];
-		end = (int16_t *)&dac_buffer[AUDIO_BLOCK_SAMPLES*2];
+		dest = &dac_buffer[AUDIO_BLOCK_SAMPLES];
 	} else {
 		// DMA is transmitting the second half of the buffer
 		// so we must fill the first half
-		dest = (int16_t *)dac_buffer;
-		end = (int16_t *)&dac_buffer[AUDIO_BLOCK_SAMPLES];
-	}
-	block = AudioOutputAnalog::block_left_1st;
-	if (block) {
-		src = block->data;
-		do {
-			// TODO: this should probably dither
-			*dest++ = ((*src++) + 32767) >> 4;
-		} while (dest < end);
-		AudioStream::release(block);
-		AudioOutputAnalog::block_left_1st = AudioOutputAnalog::block_left_2nd;
-		AudioOutputAnalog::block_left_2nd = NULL;
-	} else {
-		do {
-			*dest++ = 2047;
-		} while (dest < end);
+		dest = dac_buffer;
 	}
+	// a delay starts with the tail of the previous block
+	done = output_dac_block(dest, &AudioOutputAnalog::block_left_1st,
+	  &AudioOutputAnalog::block_left_2nd, &AudioOutputAnalog::block_prev,
+	  AudioOutputAnalog::delay_samples);
+	if (done) AudioStream::release(done);
 	if (AudioOutputAnalog::update_responsibility) AudioStream::update_all();
 }
 
@@ -254,6 +309,23 @@ void AudioOutputAnalog::update(void)
 	}
 }
 
+bool AudioOutputAnalog::loopBegin(const uint16_t *data, uint32_t samples)
+{
+	return false;
+}
+
+void AudioOutputAnalog::loopEnd(void)
+{
+}
+
+void AudioOutputAnalog::sync(void)
+{
+}
+
+void AudioOutputAnalog::delaySamples(uint32_t samples)
+{
+}
+
 
 
 
@@ -270,6 +342,23 @@ void AudioOutputAnalog::update(void)
 	if (block) release(block);
 }
 
+bool AudioOutputAnalog::loopBegin(const uint16_t *data, uint32_t samples)
+{
+	return false;
+}
+
+void AudioOutputAnalog::loopEnd(void)
+{
+}
+
+void AudioOutputAnalog::sync(void)
+{
+}
+
+void AudioOutputAnalog::delaySamples(uint32_t samples)
+{
+}
+
 #endif // defined(__MK20DX256__)
 
 
@@ -38,9 +38,22 @@ public:
 	virtual void update(void);
 	void begin(void);
 	void analogReference(int ref);
+	// Loop mode: the DMA plays "samples" 12 bit DAC values from data over
+	// and over, with no interrupts, until loopEnd(). samples <= 32767.
+	static bool loopBegin(const uint16_t *data, uint32_t samples);
+	static void loopEnd(void);
+	// Lock the DAC DMA to the I2S output: after sync() the DAC plays
+	// every block AUDIO_BLOCK_SAMPLES/2 samples after the I2S output does,
+	// as long as both run at the same rate and the library update takes
+	// less than half a block. Call it after a rate change.
+	static void sync(void);
+	// Delay by 0 to AUDIO_BLOCK_SAMPLES samples, see sync()
+	static void delaySamples(uint32_t samples);
 private:
 	static audio_block_t *block_left_1st;
 	static audio_block_t *block_left_2nd;
+	static audio_block_t *block_prev;
+	static uint16_t delay_samples;
 	static bool update_responsibility;
 	audio_block_t *inputQueueArray[1];
 #if defined(KINETISK)
@@ -26,6 +26,7 @@
 
 #include "output_i2s.h"
 #include "memcpy_audio.h"
+#include "utility/output_delay.h"
 
 audio_block_t * AudioOutputI2S::block_left_1st = NULL;
 audio_block_t * AudioOutputI2S::block_right_1st = NULL;
@@ -33,7 +34,11 @@ audio_block_t * AudioOutputI2S::block_left_2nd = NULL;
 audio_block_t * AudioOutputI2S::block_right_2nd = NULL;
 uint16_t  AudioOutputI2S::block_left_offset = 0;
 uint16_t  AudioOutputI2S::block_right_offset = 0;
+audio_block_t * AudioOutputI2S::block_left_prev = NULL;
+audio_block_t * AudioOutputI2S::block_right_prev = NULL;
+uint16_t AudioOutputI2S::delay_samples = 0;
 bool AudioOutputI2S::update_responsibility = false;
+uint32_t AudioOutputI2S::isr_cycles_max = 0;
 DMAMEM static uint32_t i2s_tx_buffer[AUDIO_BLOCK_SAMPLES];
 DMAChannel AudioOutputI2S::dma(false);
 
@@ -71,13 +76,82 @@ void AudioOutputI2S::begin(void)
 }
 
 
+bool AudioOutputI2S::loopBegin(const int16_t *data, uint32_t frames)
+{
+#if defined(KINETISK)
+	if (frames == 0 || frames > 16383) return false;
+	dma.disable();
+	dma.TCD->SADDR = data;
+	dma.TCD->SLAST = -(int32_t)(frames * 4);
+	dma.TCD->CITER_ELINKNO = frames * 2;
+	dma.TCD->BITER_ELINKNO = frames * 2;
+	dma.TCD->CSR = 0;
+	dma.enable();
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AudioOutputI2S::loopEnd(void)
+{
+#if defined(KINETISK)
+	dma.disable();
+	memset(i2s_tx_buffer, 0, sizeof(i2s_tx_buffer));
+	dma.TCD->SADDR = i2s_tx_buffer;
+	dma.TCD->SLAST = -sizeof(i2s_tx_buffer);
+	dma.TCD->CITER_ELINKNO = sizeof(i2s_tx_buffer) / 2;
+	dma.TCD->BITER_ELINKNO = sizeof(i2s_tx_buffer) / 2;
+	dma.TCD->CSR = DMA_TCD_CSR_INTHALF | DMA_TCD_CSR_INTMAJOR;
+	dma.enable();
+#endif
+}
+
+
+void AudioOutputI2S::delaySamples(uint32_t samples)
+{
+	audio_block_t *prevL, *prevR;
+
+	if (samples > AUDIO_BLOCK_SAMPLES) samples = AUDIO_BLOCK_SAMPLES;
+	__disable_irq();
+	delay_samples = samples;
+	prevL = block_left_prev;
+	prevR = block_right_prev;
+	block_left_prev = NULL;
+	block_right_prev = NULL;
+	__enable_irq();
+	if (prevL) release(prevL);
+	if (prevR) release(prevR);
+}
+
+uint32_t AudioOutputI2S::position(void)
+{
+#if defined(KINETISK)
+	return ((uint32_t)(dma.TCD->SADDR) - (uint32_t)i2s_tx_buffer) / 4;
+#else
+	return ((uint32_t)(dma.CFG->SAR) - (uint32_t)i2s_tx_buffer) / 4;
+#endif
+}
+
+uint32_t AudioOutputI2S::isrCycles(void)
+{
+	uint32_t n;
+
+	__disable_irq();
+	n = isr_cycles_max;
+	isr_cycles_max = 0;
+	__enable_irq();
+	return n;
+}
+
 void AudioOutputI2S::isr(void)
 {
 #if defined(KINETISK)
 	int16_t *dest;
 	audio_block_t *blockL, *blockR;
-	uint32_t saddr, offsetL, offsetR;
+	uint32_t saddr, offsetL, offsetR, cycles, delay;
 
+	cycles = ARM_DWT_CYCCNT;
 	saddr = (uint32_t)(dma.TCD->SADDR);
 	dma.clearInterrupt();
 	if (saddr < (uint32_t)i2s_tx_buffer + sizeof(i2s_tx_buffer) / 2) {
@@ -91,6 +165,23 @@ void AudioOutputI2S::isr(void)
 		dest = (int16_t *)i2s_tx_buffer;
 	}
 
+	delay = AudioOutputI2S::delay_samples;
+	if (delay) {
+		// the window reaches back into the previous blocks, which are
+		// held until the delay has played them
+		blockL = output_delayed_half(dest, &AudioOutputI2S::block_left_1st,
+		  &AudioOutputI2S::block_left_2nd, &AudioOutputI2S::block_left_prev,
+		  &AudioOutputI2S::block_left_offset, delay);
+		blockR = output_delayed_half(dest + 1, &AudioOutputI2S::block_right_1st,
+		  &AudioOutputI2S::block_right_2nd, &AudioOutputI2S::block_right_prev,
+		  &AudioOutputI2S::block_right_offset, delay);
+		if (blockL) AudioStream::release(blockL);
+		if (blockR) AudioStream::release(blockR);
+		cycles = ARM_DWT_CYCCNT - cycles;
+		if (cycles > AudioOutputI2S::isr_cycles_max) AudioOutputI2S::isr_cycles_max = cycles;
+		return;
+	}
+
 	blockL = AudioOutputI2S::block_left_1st;
 	blockR = AudioOutputI2S::block_right_1st;
 	offsetL = AudioOutputI2S::block_left_offset;
@@ -108,6 +199,8 @@ void AudioOutputI2S::isr(void)
 		offsetR += AUDIO_BLOCK_SAMPLES / 2;
 	} else {
 		memset(dest,0,AUDIO_BLOCK_SAMPLES * 2);
+		cycles = ARM_DWT_CYCCNT - cycles;
+		if (cycles > AudioOutputI2S::isr_cycles_max) AudioOutputI2S::isr_cycles_max = cycles;
 		return;
 	}
 
@@ -127,6 +220,8 @@ void AudioOutputI2S::isr(void)
 		AudioOutputI2S::block_right_1st = AudioOutputI2S::block_right_2nd;
 		AudioOutputI2S::block_right_2nd = NULL;
 	}
+	cycles = ARM_DWT_CYCCNT - cycles;
+	if (cycles > AudioOutputI2S::isr_cycles_max) AudioOutputI2S::isr_cycles_max = cycles;
 #else
 	const int16_t *src, *end;
 	int16_t *dest;
@@ -417,3 +512,124 @@ void AudioOutputI2Sslave::config_i2s(void)
 }
 
 
+
+/******************************************************************/
+
+output_direct_t AudioOutputI2Sdirect::direct = OUTPUT_DIRECT_INIT;
+
+#if defined(KINETISK)
+// two block pair TCDs and the silence TCD, scatter/gather needs 32 byte
+// alignment
+static DMABaseClass::TCD_t direct_tcd[3] __attribute__ ((aligned(32)));
+#define DIRECT_SILENCE	2
+static int16_t direct_zero = 0;
+
+// One frame per minor loop: left, then right at +diff, then the minor
+// loop offset (2 - 2 * diff for a block pair) moves the source on to the
+// next left sample.
+static void direct_tcd_fill(volatile DMABaseClass::TCD_t *t, const int16_t *left,
+  int32_t diff, int32_t mloff, uint32_t frames)
+{
+	t->SADDR = left;
+	t->SOFF = diff;
+	t->ATTR = DMA_TCD_ATTR_SSIZE(1) | DMA_TCD_ATTR_DSIZE(1);
+	t->NBYTES_MLNO = DMA_TCD_NBYTES_SMLOE
+	  | DMA_TCD_NBYTES_MLOFFYES_MLOFF(mloff)
+	  | DMA_TCD_NBYTES_MLOFFYES_NBYTES(4);
+	t->SLAST = 0;
+	t->DADDR = &I2S0_TDR0;
+	t->DOFF = 0;
+	t->CITER_ELINKNO = frames;
+	t->DLASTSGA = (int32_t)&direct_tcd[DIRECT_SILENCE];
+	t->BITER_ELINKNO = frames;
+	t->CSR = DMA_TCD_CSR_INTMAJOR | DMA_TCD_CSR_ESG;
+}
+#endif
+
+void AudioOutputI2Sdirect::begin(void)
+{
+#if defined(KINETISK)
+	dma.begin(true); // Allocate the DMA channel first
+
+	config_i2s();
+	CORE_PIN22_CONFIG = PORT_PCR_MUX(6); // pin 22, PTC1, I2S0_TXD0
+
+	// the silence TCD reads one zero word and chains to itself
+	direct_tcd_fill(&direct_tcd[DIRECT_SILENCE], &direct_zero, 0, 0, AUDIO_BLOCK_SAMPLES);
+	direct_tcd_fill(dma.TCD, &direct_zero, 0, 0, AUDIO_BLOCK_SAMPLES);
+	dma.triggerAtHardwareEvent(DMAMUX_SOURCE_I2S0_TX);
+	update_responsibility = update_setup();
+	dma.enable();
+
+	I2S0_TCSR = I2S_TCSR_SR;
+	I2S0_TCSR = I2S_TCSR_TE | I2S_TCSR_BCE | I2S_TCSR_FRDE;
+	dma.attachInterrupt(isr);
+#else
+	AudioOutputI2S::begin();
+#endif
+}
+
+void AudioOutputI2Sdirect::update(void)
+{
+#if defined(KINETISK)
+	audio_block_t *blockL, *blockR, *zero;
+	const int16_t *left, *right;
+	int32_t diff;
+	int s;
+
+	blockL = receiveReadOnly(0); // input 0 = left channel
+	blockR = receiveReadOnly(1); // input 1 = right channel
+	if (!blockL && !blockR) return;
+	if (!blockL || !blockR) {
+		// a missing channel reads a zeroed block from the pool, held and
+		// released with the pair, SOFF only reaches +-32k so a static
+		// buffer could be out of reach
+		zero = allocate();
+		if (!zero) {
+			if (blockL) release(blockL);
+			if (blockR) release(blockR);
+			return;
+		}
+		memset(zero->data, 0, sizeof(zero->data));
+		if (!blockL) blockL = zero;
+		else blockR = zero;
+	}
+	left = blockL->data;
+	right = blockR->data;
+	diff = (const char *)right - (const char *)left;
+	__disable_irq();
+	s = output_direct_take(&direct, blockL, blockR, diff);
+	if (s < 0) {
+		// a pair is already waiting or out of SOFF reach, drop this one
+		__enable_irq();
+		release(blockL);
+		release(blockR);
+		return;
+	}
+	direct_tcd_fill(&direct_tcd[s], left, diff, 2 - 2 * diff, AUDIO_BLOCK_SAMPLES);
+	// chain it behind whatever plays now, if that is the silence TCD it
+	// still finishes its block first
+	dma.TCD->DLASTSGA = (int32_t)&direct_tcd[s];
+	__enable_irq();
+#else
+	AudioOutputI2S::update();
+#endif
+}
+
+void AudioOutputI2Sdirect::isr(void)
+{
+#if defined(KINETISK)
+	audio_block_t *blockL, *blockR;
+	uint32_t cycles;
+
+	cycles = ARM_DWT_CYCCNT;
+	dma.clearInterrupt();
+	// the DMA has loaded the chained TCD, the queued pair or the silence
+	output_direct_done(&direct, dma.TCD->SADDR == &direct_zero, &blockL, &blockR);
+	if (update_responsibility) AudioStream::update_all();
+	if (blockL) AudioStream::release(blockL);
+	if (blockR) AudioStream::release(blockR);
+	cycles = ARM_DWT_CYCCNT - cycles;
+	if (cycles > isr_cycles_max) isr_cycles_max = cycles;
+#endif
+}
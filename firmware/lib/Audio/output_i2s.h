@@ -30,6 +30,7 @@
 #include "Arduino.h"
 #include "AudioStream.h"
 #include "DMAChannel.h"
+#include "utility/output_direct.h"
 
 class AudioOutputI2S : public AudioStream
 {
@@ -37,6 +38,20 @@ public:
 	AudioOutputI2S(void) : AudioStream(2, inputQueueArray) { begin(); }
 	virtual void update(void);
 	void begin(void);
+	// Loop mode: the DMA plays "frames" interleaved L/R samples from data
+	// over and over, with no interrupts and no library updates, until
+	// loopEnd(). data must stay valid meanwhile, frames <= 16383.
+	static bool loopBegin(const int16_t *data, uint32_t frames);
+	static void loopEnd(void);
+	// Delay both channels by 0 to AUDIO_BLOCK_SAMPLES samples, to line
+	// the codec up with other outputs, see AudioOutputAnalog::sync().
+	// Teensy 3.x only, the LC ignores it.
+	static void delaySamples(uint32_t samples);
+	// Frame the DMA is sending, 0 to AUDIO_BLOCK_SAMPLES-1, the library
+	// update is started at 0
+	static uint32_t position(void);
+	// Longest DMA interrupt in CPU cycles since the last call
+	static uint32_t isrCycles(void);
 	friend class AudioInputI2S;
 protected:
 	AudioOutputI2S(int dummy): AudioStream(2, inputQueueArray) {} // to be used only inside AudioOutputI2Sslave !!
@@ -46,11 +61,15 @@ protected:
 	static bool update_responsibility;
 	static DMAChannel dma;
 	static void isr(void);
+	static uint32_t isr_cycles_max;
 private:
 	static audio_block_t *block_left_2nd;
 	static audio_block_t *block_right_2nd;
 	static uint16_t block_left_offset;
 	static uint16_t block_right_offset;
+	static audio_block_t *block_left_prev;
+	static audio_block_t *block_right_prev;
+	static uint16_t delay_samples;
 	audio_block_t *inputQueueArray[2];
 };
 
@@ -66,4 +85,21 @@ protected:
 	static void config_i2s(void);
 };
 
+
+// Zero copy version: the DMA reads the samples straight from the audio
+// blocks, a minor loop offset interleaves left and right. Every block pair
+// gets a TCD, scatter/gather chains them and the interrupt only releases
+// the pair it finished. An underrun chains a silence TCD until the next
+// pair arrives. Teensy 3.x, loop mode and delaySamples() do not apply.
+class AudioOutputI2Sdirect : public AudioOutputI2S
+{
+public:
+	AudioOutputI2Sdirect(void) : AudioOutputI2S(0) { begin(); }
+	virtual void update(void);
+	void begin(void);
+private:
+	static void isr(void);
+	static output_direct_t direct;  // block pairs in the TCD slots
+};
+
 #endif
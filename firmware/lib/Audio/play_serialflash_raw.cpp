@@ -97,7 +97,7 @@ void AudioPlaySerialflashRaw::update(void)
 	release(block);
 }
 
-#define B2M (uint32_t)((double)4294967296000.0 / AUDIO_SAMPLE_RATE_EXACT / 2.0) // 97352592
+#define B2M (uint32_t)((double)4294967296000.0 / AudioSampleRate() / 2.0) // 97352592
 
 uint32_t AudioPlaySerialflashRaw::positionMillis(void)
 {
@@ -107,7 +107,7 @@ public:
 		}
 		if (n > 1.0) n = 1.0;
 		else if (n < -1.0) n = -1.0;
-		int32_t c = (int32_t)(milliseconds*(AUDIO_SAMPLE_RATE_EXACT/1000.0));
+		int32_t c = (int32_t)(milliseconds*(AudioSampleRate()/1000.0));
 		if (c == 0) {
 			amplitude(n);
 			return;
@@ -44,7 +44,7 @@ public:
 			return;
 		}
 		magnitude = velocity * 65535.0f;
-		int len = (AUDIO_SAMPLE_RATE_EXACT / frequency) + 0.5f;
+		int len = (AudioSampleRate() / frequency) + 0.5f;
 		if (len > 536) len = 536;
 		bufferLen = len;
 		bufferIndex = 0;
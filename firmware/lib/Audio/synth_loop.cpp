@@ -0,0 +1,140 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "synth_loop.h"
+
+// fit() and render() also build on the host, play() and stop() need the
+// output DMA
+#if defined(KINETISK) || defined(KINETISL)
+#include "output_i2s.h"
+#include "output_dac.h"
+
+DMAMEM static int16_t loop_i2s[AUDIO_LOOP_MAX_FRAMES * 2];
+DMAMEM static uint16_t loop_dac[AUDIO_LOOP_MAX_FRAMES];
+#endif
+
+float AudioWaveformLoop::fit(float freq, float rate, uint32_t maxFrames,
+  uint32_t *frames, uint32_t *periods)
+{
+	double ratio, err, best = 1.0;
+	uint32_t n, k, bn = 0, bk = 0;
+
+	if (rate <= 0.0f) return 0.0f;
+	ratio = (double)freq / rate;
+	// at least one period has to fit
+	if (ratio * maxFrames < 1.0 || ratio >= 0.5) return 0.0f;
+	// for each length the nearest period count, keep the best ratio
+	for (n=2; n <= maxFrames; n++) {
+		k = ratio * n + 0.5;
+		if (k == 0 || 2 * k >= n) continue;
+		err = fabs((double)k / n - ratio);
+		if (err < best) {
+			best = err;
+			bn = n;
+			bk = k;
+			if (err == 0.0) break;
+		}
+	}
+	if (bn == 0) return 0.0f;
+	*frames = bn;
+	*periods = bk;
+	return (double)rate * bk / bn;
+}
+
+// The phase is kept as an exact fraction, (periods * i) mod frames, so the
+// last sample leads into the first one with no seam.
+void AudioWaveformLoop::render(int16_t *data, uint32_t frames, uint32_t periods,
+  short type, float amp, float width, uint32_t stride)
+{
+	uint32_t i, ph = 0;
+	float x, y;
+
+	if (amp < 0.0f) amp = 0.0f;
+	else if (amp > 1.0f) amp = 1.0f;
+	amp *= 32767.0f;
+	for (i=0; i < frames; i++) {
+		x = (float)ph / frames;
+		switch (type) {
+		case WAVEFORM_SQUARE:
+			y = (x < 0.5f) ? 1.0f : -1.0f;
+			break;
+		case WAVEFORM_PULSE:
+			y = (x < width) ? -1.0f : 1.0f;
+			break;
+		case WAVEFORM_TRIANGLE:
+			if (x < 0.25f) y = 4.0f * x;
+			else if (x < 0.75f) y = 2.0f - 4.0f * x;
+			else y = 4.0f * x - 4.0f;
+			break;
+		case WAVEFORM_SAWTOOTH:
+			y = (x < 0.5f) ? 2.0f * x : 2.0f * x - 2.0f;
+			break;
+		case WAVEFORM_SAWTOOTH_REVERSE:
+			y = (x < 0.5f) ? -2.0f * x : 2.0f - 2.0f * x;
+			break;
+		default:
+			y = sinf(x * (float)(2.0 * M_PI));
+			break;
+		}
+		*data = (int16_t)lrintf(y * amp);
+		data += stride;
+		ph += periods;
+		if (ph >= frames) ph -= frames;
+	}
+}
+
+#if defined(KINETISK) || defined(KINETISL)
+
+float AudioWaveformLoop::play(float freq, short type, float amp, float width,
+  float dacRate)
+{
+	uint32_t n, k, i;
+
+	stop();
+	i2s_freq = fit(freq, AudioSampleRate(), AUDIO_LOOP_MAX_FRAMES, &n, &k);
+	if (i2s_freq == 0.0f) return 0.0f;
+	render(loop_i2s, n, k, type, amp, width, 2);
+	render(loop_i2s + 1, n, k, type, amp, width, 2);
+	AudioOutputI2S::loopBegin(loop_i2s, n);
+	if (dacRate > 0.0f) {
+		dac_freq = fit(freq, dacRate, AUDIO_LOOP_MAX_FRAMES, &n, &k);
+		if (dac_freq > 0.0f) {
+			// same scaling as AudioOutputAnalog::isr()
+			render((int16_t *)loop_dac, n, k, type, amp, width);
+			for (i=0; i < n; i++) {
+				loop_dac[i] = ((int16_t)loop_dac[i] + 32767) >> 4;
+			}
+			AudioOutputAnalog::loopBegin(loop_dac, n);
+		}
+	}
+	return i2s_freq;
+}
+
+void AudioWaveformLoop::stop(void)
+{
+	if (i2s_freq != 0.0f) AudioOutputI2S::loopEnd();
+	if (dac_freq != 0.0f) AudioOutputAnalog::loopEnd();
+	i2s_freq = 0.0f;
+	dac_freq = 0.0f;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef synth_loop_h_
+#define synth_loop_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "synth_waveform.h"
+
+#define AUDIO_LOOP_MAX_FRAMES	2048
+
+// Pre-rendered waveform loop for rates the update graph can't keep up
+// with. A whole number of periods is rendered once and the I2S and DAC
+// DMA loop over it on their own (AudioOutputI2S::loopBegin(),
+// AudioOutputAnalog::loopBegin()), there is no per block CPU load.
+// The audio library is not updated while a loop plays.
+class AudioWaveformLoop
+{
+public:
+	AudioWaveformLoop(void) : i2s_freq(0), dac_freq(0) { }
+	// render freq and start both loops, the I2S at AudioSampleRate(), the
+	// DAC at dacRate (0 leaves the DAC alone), type is a WAVEFORM_ value,
+	// returns the frequency the I2S loop plays, 0 if it does not fit
+	float play(float freq, short type, float amp=1.0, float width=0.5,
+	  float dacRate=0);
+	void stop(void);
+	float frequency(void) { return i2s_freq; }
+	float frequencyDAC(void) { return dac_freq; }
+	// Loop length: the frames <= maxFrames holding a whole number of
+	// periods whose frequency is closest to freq, shortest on a tie.
+	// Returns that frequency, 0 below rate / maxFrames or from rate / 2 up.
+	static float fit(float freq, float rate, uint32_t maxFrames,
+	  uint32_t *frames, uint32_t *periods);
+	// "periods" whole periods in "frames" samples, stride 2 writes every
+	// other sample (interleaved stereo)
+	static void render(int16_t *data, uint32_t frames, uint32_t periods,
+	  short type, float amp, float width, uint32_t stride=1);
+private:
+	float i2s_freq;
+	float dac_freq;
+};
+
+#endif
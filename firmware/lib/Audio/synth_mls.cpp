@@ -0,0 +1,153 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "synth_mls.h"
+
+// Galois feedback masks of primitive polynomials, index = order
+const uint32_t AudioSynthMLS::taps[AUDIO_MLS_MAX_ORDER+1] = {
+	0, 0, 0x3, 0x6, 0xC, 0x14, 0x30, 0x60, 0xB8, 0x110, 0x240, 0x500,
+	0xE08, 0x1C80, 0x3802, 0x6000, 0xD008, 0x12000, 0x20400, 0x72000,
+	0x90000, 0x140000, 0x300000, 0x420000, 0xE10000
+};
+
+void AudioSynthMLS::update(void)
+{
+	audio_block_t *block;
+	uint32_t i, s, fb, bit;
+	int16_t mag;
+
+	mag = magnitude;
+	if (mag == 0) return;
+	block = allocate();
+	if (!block) return;
+	s = state;
+	fb = feedback;
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		bit = s & 1;
+		s >>= 1;
+		if (bit) s ^= fb;
+		block->data[i] = bit ? -mag : mag;
+	}
+	state = s;
+	transmit(block);
+	release(block);
+}
+
+void AudioSynthMLS::order(uint8_t n)
+{
+	if (n < AUDIO_MLS_MIN_ORDER) n = AUDIO_MLS_MIN_ORDER;
+	else if (n > AUDIO_MLS_MAX_ORDER) n = AUDIO_MLS_MAX_ORDER;
+	__disable_irq();
+	bits = n;
+	feedback = taps[n];
+	state = 1;
+	__enable_irq();
+}
+
+#define MLS_BIT(b, n)	((b[(n) >> 5] >> ((n) & 31)) & 1)
+
+// Fast Hadamard transform based cross correlation, see Borish & Angell,
+// "An efficient algorithm for measuring the impulse response using
+// pseudorandom noise", JAES 1983. Every nonzero order-bit window appears
+// exactly once per period, the window values give the input permutation
+// and the N single bit windows give the output permutation.
+bool AudioSynthMLS::impulseResponse(float *data, float *work, uint8_t order)
+{
+	uint32_t *seq;
+	uint32_t len, size, s, fb, bit, tag, n, i, j, h;
+	uint32_t column[AUDIO_MLS_MAX_ORDER];
+	float sum, a, b;
+
+	if (order < AUDIO_MLS_MIN_ORDER || order > AUDIO_MLS_MAX_ORDER) return false;
+	size = 1UL << order;
+	len = size - 1;
+	seq = (uint32_t *)malloc(((len + 31) >> 5) * sizeof(uint32_t));
+	if (!seq) return false;
+	memset(seq, 0, ((len + 31) >> 5) * sizeof(uint32_t));
+
+	// the same sequence as update() after order() or reset()
+	s = 1;
+	fb = taps[order];
+	for (n=0; n < len; n++) {
+		bit = s & 1;
+		s >>= 1;
+		if (bit) {
+			s ^= fb;
+			seq[n >> 5] |= 1UL << (n & 31);
+		}
+	}
+
+	// input permutation, the tag of sample n is bits n, n-1 .. n-order+1
+	// with bit n as the MSB
+	tag = 0;
+	for (n=len - order + 1; n < len; n++) {
+		tag = (tag >> 1) | (MLS_BIT(seq, n) << (order - 1));
+	}
+	sum = 0.0f;
+	for (n=0; n < len; n++) {
+		tag = (tag >> 1) | (MLS_BIT(seq, n) << (order - 1));
+		work[tag] = data[n];
+		sum += data[n];
+	}
+	work[0] = -sum;
+
+	// in place fast Hadamard transform
+	for (h=1; h < size; h <<= 1) {
+		for (i=0; i < size; i += h << 1) {
+			for (j=i; j < i + h; j++) {
+				a = work[j];
+				b = work[j + h];
+				work[j] = a + b;
+				work[j + h] = a - b;
+			}
+		}
+	}
+
+	// output permutation, column[i] is the sample whose input tag is
+	// bit i alone, the tag of lag k is then built from bits column[i] - k
+	tag = 0;
+	for (n=0; n + 1 < order; n++) {
+		tag |= MLS_BIT(seq, n) << n;
+	}
+	for (n=0; n < len; n++) {
+		j = n + order - 1;
+		if (j >= len) j -= len;
+		tag |= MLS_BIT(seq, j) << (order - 1);
+		if (tag && (tag & (tag - 1)) == 0) {
+			for (i=0; (tag >> i) != 1; i++) ;
+			column[i] = j;
+		}
+		tag >>= 1;
+	}
+	for (n=0; n < len; n++) {
+		tag = 0;
+		for (j=0; j < order; j++) {
+			i = column[j] + len - n;
+			if (i >= len) i -= len;
+			tag |= MLS_BIT(seq, i) << j;
+		}
+		data[n] = work[tag] * (1.0f / size);
+	}
+	free(seq);
+	return true;
+}
@@ -0,0 +1,67 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef synth_mls_h_
+#define synth_mls_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+#define AUDIO_MLS_MIN_ORDER	2
+#define AUDIO_MLS_MAX_ORDER	24
+
+// Maximum length sequence, +/-amplitude with a period of 2^order - 1
+// samples. The excitation is deterministic, so the response to one period
+// can be turned back into the impulse response of the measured path with
+// impulseResponse().
+class AudioSynthMLS : public AudioStream
+{
+public:
+	AudioSynthMLS(void) : AudioStream(0, NULL), magnitude(0) { order(16); }
+	void amplitude(float n) {	// 0 to 1.0
+		if (n < 0.0) n = 0.0;
+		else if (n > 1.0) n = 1.0;
+		magnitude = n * 32767.0;
+	}
+	// sets the period and restarts the sequence
+	void order(uint8_t n);
+	// restarts the sequence at the beginning of the period
+	void reset(void) { state = 1; }
+	uint32_t length(void) { return (1UL << bits) - 1; }
+	// Offline: "data" holds one period of the captured response, starting
+	// at the beginning of the sequence, and is replaced by the impulse
+	// response for a +/-1 excitation (divide by the amplitude used).
+	// "work" is scratch space of 2^order floats. A period captured from
+	// a later offset gives the response circularly shifted by that offset.
+	// Returns false on a bad order or when out of memory.
+	static bool impulseResponse(float *data, float *work, uint8_t order);
+	virtual void update(void);
+private:
+	static const uint32_t taps[AUDIO_MLS_MAX_ORDER+1];
+	uint32_t state;		// Galois LFSR, never 0
+	uint32_t feedback;	// tap mask for the current order
+	int16_t magnitude;
+	uint8_t bits;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "synth_multitone.h"
+#include "utility/dspinst.h"
+
+// data_waveforms.c
+extern "C" {
+extern const int16_t AudioWaveformSine[257];
+}
+
+// adds one block of every tone to acc, advances the phases in ph
+void AudioSynthMultitone::render(int32_t *acc, uint32_t *ph, const int32_t *mag)
+{
+	uint32_t t, i, p, inc, index, scale;
+	int32_t m, val1, val2;
+
+	for (t=0; t < ntones; t++) {
+		p = ph[t];
+		inc = phase_increment[t];
+		m = mag[t];
+		if (m == 0) {
+			ph[t] = p + inc * AUDIO_BLOCK_SAMPLES;
+			continue;
+		}
+		for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			index = p >> 24;
+			val1 = AudioWaveformSine[index];
+			val2 = AudioWaveformSine[index+1];
+			scale = (p >> 8) & 0xFFFF;
+			val2 *= scale;
+			val1 *= 0x10000 - scale;
+#if defined(KINETISK) || defined(DSPINST_HOST)
+			acc[i] += multiply_32x32_rshift32(val1 + val2, m);
+#elif defined(KINETISL)
+			acc[i] += (((val1 + val2) >> 16) * m) >> 16;
+#endif
+			p += inc;
+		}
+		ph[t] = p;
+	}
+}
+
+void AudioSynthMultitone::update(void)
+{
+	audio_block_t *block;
+	int32_t acc[AUDIO_BLOCK_SAMPLES];
+	uint32_t i;
+
+	if (!enabled) return;
+	block = allocate();
+	if (!block) {
+		for (i=0; i < ntones; i++) {
+			phase_accumulator[i] += phase_increment[i] * AUDIO_BLOCK_SAMPLES;
+		}
+		return;
+	}
+	memset(acc, 0, sizeof(acc));
+	render(acc, phase_accumulator, magnitude);
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		block->data[i] = saturate16(acc[i]);
+	}
+	transmit(block);
+	release(block);
+}
+
+void AudioSynthMultitone::tone(unsigned int n, float freq, float lvl, float phase)
+{
+	if (n >= AUDIO_MULTITONE_MAX) return;
+	if (freq < 0.0) freq = 0.0;
+	else if (freq > AudioSampleRate()/2) freq = AudioSampleRate()/2;
+	if (lvl < 0.0) lvl = 0.0;
+	phase = fmodf(phase, 360.0);
+	if (phase < 0.0) phase += 360.0;
+	__disable_irq();
+	phase_increment[n] = freq * (4294967296.0 / AudioSampleRate());
+	tone_freq[n] = freq;
+	phase_start[n] = phase * (4294967296.0 / 360.0);
+	level[n] = lvl;
+	if (n >= ntones) {
+		while (ntones < n) magnitude[ntones++] = 0;
+		magnitude[n] = 0;
+		ntones = n + 1;
+	}
+	__enable_irq();
+}
+
+void AudioSynthMultitone::logSpaced(float fmin, float fmax, unsigned int n, uint8_t periodBits)
+{
+	uint32_t k, bin, last = 0;
+	float freq, phase;
+
+	if (n > AUDIO_MULTITONE_MAX) n = AUDIO_MULTITONE_MAX;
+	if (n == 0 || fmin <= 0.0 || fmax < fmin) return;
+	if (periodBits > 24) periodBits = 24;
+	else if (periodBits && periodBits < 8) periodBits = 8;
+	enabled = false;
+	ntones = 0;
+	period_bits = periodBits;
+	for (k=0; k < n; k++) {
+		freq = (n > 1) ? fmin * powf(fmax / fmin, (float)k / (n - 1)) : fmin;
+		// Schroeder: phi(k) = -pi * k * (k - 1) / n, k = 1..n
+		phase = -180.0 * (float)(k + 1) * k / n;
+		tone(k, freq, 1.0, phase);
+		if (periodBits) {
+			bin = freq * (float)(1UL << periodBits) / AudioSampleRate() + 0.5;
+			if (bin <= last) bin = last + 1;
+			if (bin >= (1UL << (periodBits - 1))) bin = (1UL << (periodBits - 1)) - 1;
+			last = bin;
+			phase_increment[k] = bin << (32 - periodBits);
+		}
+	}
+}
+
+// Free running tones keep their frequencies. A periodic set is defined
+// in samples and keeps its bins, the tones move with the rate.
+void AudioSynthMultitone::sampleRateChanged(void)
+{
+	if (period_bits) return;
+	for (uint32_t i=0; i < ntones; i++) {
+		phase_increment[i] = tone_freq[i] * (4294967296.0 / AudioSampleRate());
+	}
+}
+
+void AudioSynthMultitone::amplitude(float n, unsigned int blocks)
+{
+	int32_t acc[AUDIO_BLOCK_SAMPLES];
+	int32_t mag[AUDIO_MULTITONE_MAX];
+	uint32_t ph[AUDIO_MULTITONE_MAX];
+	uint32_t i, b, peak = 0;
+	float scale, power = 0.0;
+
+	if (n < 0.0) n = 0.0;
+	else if (n > 1.0) n = 1.0;
+	if (n == 0.0 || ntones == 0) {
+		enabled = false;
+		return;
+	}
+	// render the sum at full scale per unit level and find its peak
+	for (i=0; i < ntones; i++) {
+		mag[i] = level[i] * 65536.0;
+		ph[i] = phase_start[i];
+		power += level[i] * level[i] * 0.5;
+	}
+	if (blocks == 0) blocks = 1;
+	for (b=0; b < blocks; b++) {
+		memset(acc, 0, sizeof(acc));
+		render(acc, ph, mag);
+		for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			uint32_t a = acc[i] < 0 ? -acc[i] : acc[i];
+			if (a > peak) peak = a;
+		}
+	}
+	if (peak == 0) {
+		enabled = false;
+		return;
+	}
+	crest = (peak / 32767.0) / sqrtf(power);
+	scale = n * 32767.0 / peak;
+	for (i=0; i < ntones; i++) mag[i] = level[i] * scale * 65536.0;
+	__disable_irq();
+	memcpy(magnitude, mag, ntones * sizeof(int32_t));
+	memcpy(phase_accumulator, phase_start, ntones * sizeof(uint32_t));
+	enabled = true;
+	__enable_irq();
+}
+
+void AudioSynthMultitone::begin(void)
+{
+	__disable_irq();
+	memcpy(phase_accumulator, phase_start, ntones * sizeof(uint32_t));
+	__enable_irq();
+}
@@ -0,0 +1,75 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef synth_multitone_h_
+#define synth_multitone_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+#define AUDIO_MULTITONE_MAX	32
+
+// Sum of up to AUDIO_MULTITONE_MAX sine oscillators, each one the same
+// phase accumulator and AudioWaveformSine interpolation as
+// AudioSynthWaveformSine. The phase, increment and magnitude arrays are
+// walked tone by tone, each tone adding a whole block into one accumulator.
+class AudioSynthMultitone : public AudioStream
+{
+public:
+	AudioSynthMultitone(void) : AudioStream(0, NULL),
+	  crest(0), ntones(0), period_bits(0), enabled(false) { }
+	// set one tone, level is relative to the other tones, phase in
+	// degrees is where the tone starts after begin()
+	void tone(unsigned int n, float freq, float level=1.0, float phase=0.0);
+	// n equal level tones log spaced from fmin to fmax with Schroeder
+	// phases for a low crest factor. With periodBits != 0 the tones are
+	// moved to multiples of fs/2^periodBits, the sum then repeats every
+	// 2^periodBits samples and an FFT of that size sees no leakage.
+	void logSpaced(float fmin, float fmax, unsigned int n, uint8_t periodBits=0);
+	// peak level of the sum, 0 to 1.0, measured over the first "blocks"
+	// blocks from the start phases, call it after the tones are set,
+	// the tones (re)start at their start phase
+	void amplitude(float n, unsigned int blocks=64);
+	// restart all tones at their start phase
+	void begin(void);
+	void stop(void) { enabled = false; }
+	// peak to RMS ratio found by the last amplitude()
+	float crestFactor(void) { return crest; }
+	virtual void update(void);
+protected:
+	virtual void sampleRateChanged(void);
+private:
+	void render(int32_t *acc, uint32_t *ph, const int32_t *mag);
+	uint32_t phase_accumulator[AUDIO_MULTITONE_MAX];
+	uint32_t phase_increment[AUDIO_MULTITONE_MAX];
+	uint32_t phase_start[AUDIO_MULTITONE_MAX];
+	int32_t  magnitude[AUDIO_MULTITONE_MAX];	// 65536 = full scale
+	float    level[AUDIO_MULTITONE_MAX];
+	float    tone_freq[AUDIO_MULTITONE_MAX];
+	float    crest;
+	uint8_t  ntones;
+	uint8_t  period_bits;
+	volatile bool enabled;
+};
+
+#endif
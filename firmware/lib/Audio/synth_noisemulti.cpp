@@ -0,0 +1,357 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "synth_noisemulti.h"
+#include "synth_pinknoise.h"
+#include "utility/dspblock.h"
+
+uint16_t AudioSynthNoiseMulti::instance_count = 0;
+
+// output of a stream that has no block, keeps the pair loops simple
+static uint32_t scratch[AUDIO_BLOCK_SAMPLES/2];
+
+static uint32_t powmod_16807(uint32_t e)
+{
+	uint64_t r = 1, b = 16807;
+	while (e) {
+		if (e & 1) r = (r * b) % 0x7FFFFFFF;
+		b = (b * b) % 0x7FFFFFFF;
+		e >>= 1;
+	}
+	return r;
+}
+
+AudioSynthNoiseMulti::AudioSynthNoiseMulti(void) : AudioStream(0, NULL)
+{
+	uint32_t i, n;
+
+	for (i=0; i < AUDIO_NOISE_STREAMS; i++) {
+		n = instance_count * AUDIO_NOISE_STREAMS + i;
+		level[i] = 0;
+		// white: 2^24 steps apart on the Park-Miller sequence
+		seed[i] = powmod_16807((n << 24) + 1);
+		// pink: scattered over the 32 bit LFSR states
+		plfsr[i] = 0x5EED41F5 ^ (0x9E3779B9 * (n + 1));
+		if (plfsr[i] == 0) plfsr[i] = 1;
+		pinc[i] = 0x0CCC;
+		pdec[i] = 0x0CCC;
+		paccu[i] = 0;
+	}
+	instance_count++;
+	pncnt = 0;
+	pink = false;
+}
+
+void AudioSynthNoiseMulti::update(void)
+{
+	audio_block_t *block[AUDIO_NOISE_STREAMS];
+	uint32_t i, n = 0;
+
+	for (i=0; i < AUDIO_NOISE_STREAMS; i++) {
+		block[i] = level[i] ? allocate() : NULL;
+		if (block[i]) n++;
+	}
+	if (n == 0) return;
+	if (pink) update_pink(block);
+	else update_white(block);
+	for (i=0; i < AUDIO_NOISE_STREAMS; i++) {
+		if (!block[i]) continue;
+		transmit(block[i], i);
+		release(block[i]);
+	}
+}
+
+// Park-Miller-Carta step, as in AudioSynthNoiseWhite
+static inline uint32_t park_miller(uint32_t lo) __attribute__((always_inline));
+static inline uint32_t park_miller(uint32_t lo)
+{
+	uint32_t hi;
+#if defined(KINETISK) || defined(DSPINST_HOST)
+	hi = multiply_16bx16t(16807, lo); // 16807 * (lo >> 16)
+#elif defined(KINETISL)
+	hi = 16807 * (lo >> 16);
+#endif
+	lo = 16807 * (lo & 0xFFFF);
+	lo += (hi & 0x7FFF) << 16;
+	lo += hi >> 15;
+	lo = (lo & 0x7FFFFFFF) + (lo >> 31);
+	return lo;
+}
+
+#if (defined(DSPBLOCK_AVX2) || defined(DSPBLOCK_SSE4)) && AUDIO_NOISE_STREAMS == 4
+// Host build: the 4 streams are the 4 lanes of one SSE register, every
+// step is a Park-Miller step of all of them. 8 samples of each stream
+// are transposed into 8 sample rows, one row per output block. The same
+// results as the pair loop below, the streams of a pair without blocks
+// keep their seeds. AVX2 has no 8 independent states to work on, it
+// runs this path as well.
+static inline __m128i park_miller_x4(__m128i lo)
+{
+	const __m128i k = _mm_set1_epi32(16807);
+	__m128i hi = _mm_mullo_epi32(k, _mm_srli_epi32(lo, 16));
+	lo = _mm_mullo_epi32(k, _mm_and_si128(lo, _mm_set1_epi32(0xFFFF)));
+	lo = _mm_add_epi32(lo, _mm_slli_epi32(_mm_and_si128(hi, _mm_set1_epi32(0x7FFF)), 16));
+	lo = _mm_add_epi32(lo, _mm_srli_epi32(hi, 15));
+	return _mm_add_epi32(_mm_and_si128(lo, _mm_set1_epi32(0x7FFFFFFF)), _mm_srli_epi32(lo, 31));
+}
+
+// signed_multiply_32x16b() of 4 lanes, the 16.16 gain and a 16 bit
+// value fit the 32 bit product
+static inline __m128i noise_gain_x4(__m128i gain, __m128i lo)
+{
+	__m128i x = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	return _mm_srai_epi32(_mm_mullo_epi32(gain, x), 16);
+}
+
+// v[n] holds sample i+n of streams 0-3, as 32 bit values in 16 bit
+// range: transpose to 8 samples of each stream and store them
+static inline void store_x4(int16_t **p, uint32_t i, const __m128i *v)
+{
+	__m128i a, b, c, d, e, f;
+
+	a = _mm_packs_epi32(v[0], v[1]);
+	b = _mm_packs_epi32(v[2], v[3]);
+	c = _mm_packs_epi32(v[4], v[5]);
+	d = _mm_packs_epi32(v[6], v[7]);
+	e = _mm_unpacklo_epi16(a, b);
+	f = _mm_unpackhi_epi16(a, b);
+	a = _mm_unpacklo_epi16(e, f);	// samples 0-3 of streams 0, 1
+	b = _mm_unpackhi_epi16(e, f);	// samples 0-3 of streams 2, 3
+	e = _mm_unpacklo_epi16(c, d);
+	f = _mm_unpackhi_epi16(c, d);
+	c = _mm_unpacklo_epi16(e, f);	// samples 4-7 of streams 0, 1
+	d = _mm_unpackhi_epi16(e, f);	// samples 4-7 of streams 2, 3
+	_mm_storeu_si128((__m128i *)(p[0] + i), _mm_unpacklo_epi64(a, c));
+	_mm_storeu_si128((__m128i *)(p[1] + i), _mm_unpackhi_epi64(a, c));
+	_mm_storeu_si128((__m128i *)(p[2] + i), _mm_unpacklo_epi64(b, d));
+	_mm_storeu_si128((__m128i *)(p[3] + i), _mm_unpackhi_epi64(b, d));
+}
+
+void AudioSynthNoiseMulti::update_white(audio_block_t **block)
+{
+	int16_t *p[4];
+	__m128i lo, gain, v[8];
+	uint32_t i, s;
+
+	for (s=0; s < 4; s++) {
+		p[s] = block[s] ? block[s]->data : (int16_t *)scratch;
+	}
+	lo = _mm_loadu_si128((const __m128i *)seed);
+	gain = _mm_loadu_si128((const __m128i *)level);
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i += 8) {
+		for (s=0; s < 8; s++) {
+			lo = park_miller_x4(lo);
+			v[s] = noise_gain_x4(gain, lo);
+		}
+		store_x4(p, i, v);
+	}
+	if (block[0] || block[1]) {
+		seed[0] = _mm_extract_epi32(lo, 0);
+		seed[1] = _mm_extract_epi32(lo, 1);
+	}
+	if (block[2] || block[3]) {
+		seed[2] = _mm_extract_epi32(lo, 2);
+		seed[3] = _mm_extract_epi32(lo, 3);
+	}
+}
+
+// PINT from synth_pinknoise.cpp for 4 streams, the table lookups are
+// gathers with AVX2
+static inline __m128i pink_lookup_x4(const int32_t *table, __m128i index)
+{
+#if defined(DSPBLOCK_AVX2)
+	return _mm_i32gather_epi32((const int *)table, index, 4);
+#else
+	return _mm_setr_epi32(table[_mm_extract_epi32(index, 0)],
+		table[_mm_extract_epi32(index, 1)],
+		table[_mm_extract_epi32(index, 2)],
+		table[_mm_extract_epi32(index, 3)]);
+#endif
+}
+
+#define PSTEP_X4(bitmask, out) do { \
+	__m128i m = _mm_set1_epi32(bitmask); \
+	__m128i bit = _mm_srai_epi32(lfsr, 31); \
+	dec = _mm_andnot_si128(m, dec); \
+	lfsr = _mm_slli_epi32(lfsr, 1); \
+	dec = _mm_or_si128(dec, _mm_and_si128(inc, m)); \
+	inc = _mm_xor_si128(inc, _mm_and_si128(bit, m)); \
+	accu = _mm_add_epi32(accu, _mm_sub_epi32(inc, dec)); \
+	lfsr = _mm_xor_si128(lfsr, _mm_and_si128(bit, taps)); \
+	out = _mm_add_epi32(accu, _mm_add_epi32( \
+	  pink_lookup_x4(AudioSynthNoisePink::pfira, _mm_and_si128(lfsr, low6)), \
+	  pink_lookup_x4(AudioSynthNoisePink::pfirb, \
+	    _mm_and_si128(_mm_srli_epi32(lfsr, 6), low6)))); \
+	out = noise_gain_x4(gain, out); \
+} while (0)
+
+void AudioSynthNoiseMulti::update_pink(audio_block_t **block)
+{
+	int16_t *p[4];
+	__m128i lfsr, inc, dec, accu, gain, v[16];
+	const __m128i taps = _mm_set1_epi32(0x46000001);
+	const __m128i low6 = _mm_set1_epi32(0x3F);
+	int32_t state[4][4];
+	uint32_t i, s;
+	uint8_t cnt;
+
+	for (s=0; s < 4; s++) {
+		p[s] = block[s] ? block[s]->data : (int16_t *)scratch;
+	}
+	lfsr = _mm_loadu_si128((const __m128i *)plfsr);
+	inc = _mm_loadu_si128((const __m128i *)pinc);
+	dec = _mm_loadu_si128((const __m128i *)pdec);
+	accu = _mm_loadu_si128((const __m128i *)paccu);
+	gain = _mm_loadu_si128((const __m128i *)level);
+	cnt = pncnt;
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i += 16) {
+		// the same bit order as the PPAIR() sequence below
+		PSTEP_X4(AudioSynthNoisePink::pnmask[cnt++], v[0]);
+		PSTEP_X4(0x0800, v[1]);
+		PSTEP_X4(0x0400, v[2]);
+		PSTEP_X4(0x0800, v[3]);
+		PSTEP_X4(0x0200, v[4]);
+		PSTEP_X4(0x0800, v[5]);
+		PSTEP_X4(0x0400, v[6]);
+		PSTEP_X4(0x0800, v[7]);
+		PSTEP_X4(0x0100, v[8]);
+		PSTEP_X4(0x0800, v[9]);
+		PSTEP_X4(0x0400, v[10]);
+		PSTEP_X4(0x0800, v[11]);
+		PSTEP_X4(0x0200, v[12]);
+		PSTEP_X4(0x0800, v[13]);
+		PSTEP_X4(0x0400, v[14]);
+		PSTEP_X4(0x0800, v[15]);
+		store_x4(p, i, v);
+		store_x4(p, i + 8, v + 8);
+	}
+	_mm_storeu_si128((__m128i *)state[0], lfsr);
+	_mm_storeu_si128((__m128i *)state[1], inc);
+	_mm_storeu_si128((__m128i *)state[2], dec);
+	_mm_storeu_si128((__m128i *)state[3], accu);
+	// a pair without blocks keeps its state, as in the pair loop
+	for (s=0; s < 4; s++) {
+		if (!block[s & ~1] && !block[s | 1]) continue;
+		plfsr[s] = state[0][s];
+		pinc[s] = state[1][s];
+		pdec[s] = state[2][s];
+		paccu[s] = state[3][s];
+	}
+	pncnt += AUDIO_BLOCK_SAMPLES / 16;
+}
+
+#else
+void AudioSynthNoiseMulti::update_white(audio_block_t **block)
+{
+	uint32_t *pa, *pb, *end;
+	uint32_t la, lb, s;
+	int32_t ga, gb, n1, n2, m1, m2;
+
+	for (s=0; s < AUDIO_NOISE_STREAMS; s += 2) {
+		if (!block[s] && !block[s+1]) continue;
+		pa = block[s] ? (uint32_t *)block[s]->data : scratch;
+		pb = block[s+1] ? (uint32_t *)block[s+1]->data : scratch;
+		end = pa + AUDIO_BLOCK_SAMPLES/2;
+		ga = level[s];
+		gb = level[s+1];
+		la = seed[s];
+		lb = seed[s+1];
+		do {
+			la = park_miller(la);
+			n1 = signed_multiply_32x16b(ga, la);
+			lb = park_miller(lb);
+			m1 = signed_multiply_32x16b(gb, lb);
+			la = park_miller(la);
+			n2 = signed_multiply_32x16b(ga, la);
+			lb = park_miller(lb);
+			m2 = signed_multiply_32x16b(gb, lb);
+			*pa++ = pack_16b_16b(n2, n1);
+			*pb++ = pack_16b_16b(m2, m1);
+		} while (pa < end);
+		seed[s] = la;
+		seed[s+1] = lb;
+	}
+}
+
+// PINT from synth_pinknoise.cpp with the state passed in
+#define PSTEP(bitmask, lfsr, inc, dec, accu, out) \
+	bit = lfsr >> 31; \
+	dec &= ~bitmask; \
+	lfsr <<= 1; \
+	dec |= inc & bitmask; \
+	inc ^= bit & bitmask; \
+	accu += inc - dec; \
+	lfsr ^= bit & taps; \
+	out = accu + \
+	  AudioSynthNoisePink::pfira[lfsr & 0x3F] + \
+	  AudioSynthNoisePink::pfirb[lfsr >> 6 & 0x3F]
+
+// two samples of both streams, the odd sample always uses bit 0x0800
+#define PPAIR(mask) \
+	PSTEP(mask, la, ia, da, aa, n1); \
+	PSTEP(mask, lb, ib, db, ab, m1); \
+	PSTEP(0x0800, la, ia, da, aa, n2); \
+	PSTEP(0x0800, lb, ib, db, ab, m2); \
+	n1 = signed_multiply_32x16b(ga, n1); \
+	n2 = signed_multiply_32x16b(ga, n2); \
+	m1 = signed_multiply_32x16b(gb, m1); \
+	m2 = signed_multiply_32x16b(gb, m2); \
+	*pa++ = pack_16b_16b(n2, n1); \
+	*pb++ = pack_16b_16b(m2, m1)
+
+void AudioSynthNoiseMulti::update_pink(audio_block_t **block)
+{
+	uint32_t *pa, *pb, *end;
+	uint32_t s;
+	uint8_t cnt;
+	int32_t ga, gb, n1, n2, m1, m2, bit;
+	int32_t la, ia, da, aa, lb, ib, db, ab;
+	const int32_t taps = 0x46000001;
+
+	for (s=0; s < AUDIO_NOISE_STREAMS; s += 2) {
+		if (!block[s] && !block[s+1]) continue;
+		pa = block[s] ? (uint32_t *)block[s]->data : scratch;
+		pb = block[s+1] ? (uint32_t *)block[s+1]->data : scratch;
+		end = pa + AUDIO_BLOCK_SAMPLES/2;
+		ga = level[s];
+		gb = level[s+1];
+		la = plfsr[s];   ia = pinc[s];   da = pdec[s];   aa = paccu[s];
+		lb = plfsr[s+1]; ib = pinc[s+1]; db = pdec[s+1]; ab = paccu[s+1];
+		cnt = pncnt;
+		do {
+			int32_t mask = AudioSynthNoisePink::pnmask[cnt++];
+			PPAIR(mask);
+			PPAIR(0x0400);
+			PPAIR(0x0200);
+			PPAIR(0x0400);
+			PPAIR(0x0100);
+			PPAIR(0x0400);
+			PPAIR(0x0200);
+			PPAIR(0x0400);
+		} while (pa < end);
+		plfsr[s] = la;   pinc[s] = ia;   pdec[s] = da;   paccu[s] = aa;
+		plfsr[s+1] = lb; pinc[s+1] = ib; pdec[s+1] = db; paccu[s+1] = ab;
+	}
+	pncnt += AUDIO_BLOCK_SAMPLES / 16;
+}
+#endif
@@ -0,0 +1,73 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef synth_noisemulti_h_
+#define synth_noisemulti_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "utility/dspinst.h"
+
+#define AUDIO_NOISE_STREAMS	4
+
+#define NOISE_WHITE	0
+#define NOISE_PINK	1
+
+// Several independent noise streams from one object, output n is stream n.
+// White streams use the AudioSynthNoiseWhite Park-Miller generator and
+// pink streams the AudioSynthNoisePink Stenzel generator, so the
+// statistics are the same. Every stream starts at a different, far apart
+// point of the generator sequence. Streams are computed in pairs, the two
+// independent states interleave in one loop and hide each other's latency.
+// A host build with SSE4.1 or AVX2 runs the 4 streams in the 4 lanes of
+// one register instead, with the same results.
+class AudioSynthNoiseMulti : public AudioStream
+{
+public:
+	AudioSynthNoiseMulti(void);
+	void amplitude(unsigned int channel, float n) {	// 0 to 1.0
+		if (channel >= AUDIO_NOISE_STREAMS) return;
+		if (n < 0.0) n = 0.0;
+		else if (n > 1.0) n = 1.0;
+		level[channel] = (int32_t)(n * 65536.0);
+	}
+	void amplitude(float n) {
+		for (unsigned int i=0; i < AUDIO_NOISE_STREAMS; i++) amplitude(i, n);
+	}
+	void type(uint8_t t) { pink = (t == NOISE_PINK); }
+	virtual void update(void);
+private:
+	void update_white(audio_block_t **block);
+	void update_pink(audio_block_t **block);
+	int32_t  level[AUDIO_NOISE_STREAMS];	// 0=off, 65536=max
+	uint32_t seed[AUDIO_NOISE_STREAMS];	// white, never 0
+	int32_t  plfsr[AUDIO_NOISE_STREAMS];	// pink, as AudioSynthNoisePink
+	int32_t  pinc[AUDIO_NOISE_STREAMS];
+	int32_t  pdec[AUDIO_NOISE_STREAMS];
+	int32_t  paccu[AUDIO_NOISE_STREAMS];
+	uint8_t  pncnt;				// shared by all pink streams
+	bool     pink;
+	static uint16_t instance_count;
+};
+
+#endif
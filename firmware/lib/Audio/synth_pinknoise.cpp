@@ -140,9 +140,36 @@ void AudioSynthNoisePink::update(void)
 	pdec = dec;
 	paccu = accu;
 	plfsr = lfsr;
+	if (pblocks && --pcount == 0) {
+		plfsr = pstart.lfsr;
+		pinc = pstart.inc;
+		pdec = pstart.dec;
+		paccu = pstart.accu;
+		pncnt = pstart.ncnt;
+		pcount = pblocks;
+	}
 	transmit(block);
 	release(block);
 }
 
+void AudioSynthNoisePink::period(uint8_t bits)
+{
+	__disable_irq();
+	if (bits == 0) {
+		pblocks = 0;
+	} else {
+		if (bits < AUDIO_NOISE_MIN_PERIOD) bits = AUDIO_NOISE_MIN_PERIOD;
+		else if (bits > 22) bits = 22;
+		pblocks = 1 << (bits - AUDIO_NOISE_MIN_PERIOD);
+		pcount = pblocks;
+		pstart.lfsr = plfsr;
+		pstart.inc = pinc;
+		pstart.dec = pdec;
+		pstart.accu = paccu;
+		pstart.ncnt = pncnt;
+	}
+	__enable_irq();
+}
+
 
 
@@ -29,6 +29,7 @@
 #include "Arduino.h"
 #include "AudioStream.h"
 #include "utility/dspinst.h"
+#include "synth_whitenoise.h"	// AUDIO_NOISE_MIN_PERIOD
 
 class AudioSynthNoisePink : public AudioStream
 {
@@ -39,14 +40,19 @@ public:
 		pncnt  = 0;
 		pinc   = 0x0CCC;
 		pdec   = 0x0CCC;
+		pblocks = 0;
 	}	
 	void amplitude(float n) {
 		if (n < 0.0) n = 0.0;
 		else if (n > 1.0) n = 1.0;
 		level = (int32_t)(n * 65536.0);
 	}
+	// repeat the noise every 2^bits samples from the current state,
+	// 0 = aperiodic, otherwise AUDIO_NOISE_MIN_PERIOD to 22
+	void period(uint8_t bits);
 	virtual void update(void);
 private:
+	friend class AudioSynthNoiseMulti;	// shares the tables
 	static const uint8_t pnmask[256];
 	static const int32_t pfira[64];
 	static const int32_t pfirb[64];
@@ -57,6 +63,12 @@ private:
 	int32_t paccu;		// accumulator
 	uint8_t pncnt;		// overflowing counter as index to pnmask[]
 	int32_t level;		// 0=off, 65536=max
+	struct {		// generator state at the start of the period
+		int32_t lfsr, inc, dec, accu;
+		uint8_t ncnt;
+	} pstart;
+	uint32_t pblocks;	// period in blocks, 0 = aperiodic
+	uint32_t pcount;	// blocks left in the period
 };
 
 #endif
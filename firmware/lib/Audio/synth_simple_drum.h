@@ -47,12 +47,13 @@ public:
 
   void frequency(float freq)
   {
+    freq_set = freq;
     if(freq < 0.0)
       freq = 0;
-    else if(freq > (AUDIO_SAMPLE_RATE_EXACT/2))
-      freq = AUDIO_SAMPLE_RATE_EXACT/2;
+    else if(freq > (AudioSampleRate()/2))
+      freq = AudioSampleRate()/2;
 
-    wav_increment = (freq * (0x7fffffffLL/AUDIO_SAMPLE_RATE_EXACT)) + 0.5;
+    wav_increment = (freq * (0x7fffffffLL/AudioSampleRate())) + 0.5;
   }
 
   void length(int32_t milliseconds)
@@ -62,7 +63,8 @@ public:
     if(milliseconds > 5000)
       milliseconds = 5000;
 
-    int32_t len_samples = milliseconds*(AUDIO_SAMPLE_RATE_EXACT/1000.0);
+    length_ms = milliseconds;
+    int32_t len_samples = milliseconds*(AudioSampleRate()/1000.0);
 
     env_decrement = (0x7fff0000/len_samples);
   };
@@ -72,6 +74,7 @@ public:
 
   using AudioStream::release;
   virtual void update(void);
+  virtual void sampleRateChanged(void) { frequency(freq_set); length(length_ms); }
 
 private:
   audio_block_t *inputQueueArray[1];
@@ -89,6 +92,10 @@ private:
   
   uint32_t wav_increment;
   int32_t  wav_pitch_mod;
+
+  // settings, for rate changes
+  float    freq_set;
+  int32_t  length_ms;
 };
 
 #endif
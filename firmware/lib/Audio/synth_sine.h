@@ -38,11 +38,12 @@
 class AudioSynthWaveformSine : public AudioStream
 {
 public:
-	AudioSynthWaveformSine() : AudioStream(0, NULL), magnitude(16384) {}
+	AudioSynthWaveformSine() : AudioStream(0, NULL), freq_set(0), magnitude(16384) {}
 	void frequency(float freq) {
 		if (freq < 0.0) freq = 0.0;
-		else if (freq > AUDIO_SAMPLE_RATE_EXACT/2) freq = AUDIO_SAMPLE_RATE_EXACT/2;
-		phase_increment = freq * (4294967296.0 / AUDIO_SAMPLE_RATE_EXACT);
+		else if (freq > AudioSampleRate()/2) freq = AudioSampleRate()/2;
+		phase_increment = freq * (4294967296.0 / AudioSampleRate());
+		freq_set = freq;
 	}
 	void phase(float angle) {
 		if (angle < 0.0) angle = 0.0;
@@ -58,7 +59,10 @@ public:
 		magnitude = n * 65536.0;
 	}
 	virtual void update(void);
+protected:
+	virtual void sampleRateChanged(void) { frequency(freq_set); }
 private:
+	float freq_set;
 	uint32_t phase_accumulator;
 	uint32_t phase_increment;
 	int32_t magnitude;
@@ -68,11 +72,12 @@ private:
 class AudioSynthWaveformSineHires : public AudioStream
 {
 public:
-	AudioSynthWaveformSineHires() : AudioStream(0, NULL), magnitude(16384) {}
+	AudioSynthWaveformSineHires() : AudioStream(0, NULL), freq_set(0), magnitude(16384) {}
 	void frequency(float freq) {
 		if (freq < 0.0) freq = 0.0;
-		else if (freq > AUDIO_SAMPLE_RATE_EXACT/2) freq = AUDIO_SAMPLE_RATE_EXACT/2;
-		phase_increment = freq * (4294967296.0 / AUDIO_SAMPLE_RATE_EXACT);
+		else if (freq > AudioSampleRate()/2) freq = AudioSampleRate()/2;
+		phase_increment = freq * (4294967296.0 / AudioSampleRate());
+		freq_set = freq;
 	}
 	void phase(float angle) {
 		if (angle < 0.0) angle = 0.0;
@@ -88,7 +93,10 @@ public:
 		magnitude = n * 65536.0;
 	}
 	virtual void update(void);
+protected:
+	virtual void sampleRateChanged(void) { frequency(freq_set); }
 private:
+	float freq_set;
 	uint32_t phase_accumulator;
 	uint32_t phase_increment;
 	int32_t magnitude;
@@ -98,14 +106,15 @@ private:
 class AudioSynthWaveformSineModulated : public AudioStream
 {
 public:
-	AudioSynthWaveformSineModulated() : AudioStream(1, inputQueueArray), magnitude(16384) {}
+	AudioSynthWaveformSineModulated() : AudioStream(1, inputQueueArray), freq_set(0), magnitude(16384) {}
 	// maximum unmodulated carrier frequency is 11025 Hz
 	// input = +1.0 doubles carrier
 	// input = -1.0 DC output
 	void frequency(float freq) {
 		if (freq < 0.0) freq = 0.0;
-		else if (freq > AUDIO_SAMPLE_RATE_EXACT/4) freq = AUDIO_SAMPLE_RATE_EXACT/4;
-		phase_increment = freq * (4294967296.0 / AUDIO_SAMPLE_RATE_EXACT);
+		else if (freq > AudioSampleRate()/4) freq = AudioSampleRate()/4;
+		phase_increment = freq * (4294967296.0 / AudioSampleRate());
+		freq_set = freq;
 	}
 	void phase(float angle) {
 		if (angle < 0.0) angle = 0.0;
@@ -121,7 +130,10 @@ public:
 		magnitude = n * 65536.0;
 	}
 	virtual void update(void);
+protected:
+	virtual void sampleRateChanged(void) { frequency(freq_set); }
 private:
+	float freq_set;
 	uint32_t phase_accumulator;
 	uint32_t phase_increment;
 	audio_block_t *inputQueueArray[1];
@@ -0,0 +1,191 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "synth_steppedsine.h"
+
+void AudioSynthSteppedSine::steps(const float *f, unsigned int n)
+{
+	if (n > AUDIO_STEPPED_MAX) n = AUDIO_STEPPED_MAX;
+	stop();
+	for (unsigned int i=0; i < n; i++) freq[i] = f[i];
+	nsteps = n;
+	prepare();
+}
+
+void AudioSynthSteppedSine::logSpaced(float fmin, float fmax, unsigned int n)
+{
+	float r;
+
+	if (n > AUDIO_STEPPED_MAX) n = AUDIO_STEPPED_MAX;
+	if (n == 0) return;
+	stop();
+	r = (n > 1) ? powf(fmax / fmin, 1.0f / (n - 1)) : 1.0f;
+	freq[0] = fmin;
+	for (unsigned int i=1; i < n; i++) freq[i] = freq[i-1] * r;
+	nsteps = n;
+	prepare();
+}
+
+void AudioSynthSteppedSine::timing(float settleMs, uint16_t windowCycles)
+{
+	uint32_t n;
+
+	stop();
+	settle_ms = settleMs;
+	n = settleMs * (AudioSampleRate() / 1000.0f) + 0.5f;
+	// a step change per block at most, update() relies on it
+	if (n < AUDIO_BLOCK_SAMPLES) n = AUDIO_BLOCK_SAMPLES;
+	settle_len = n;
+	cycles = windowCycles ? windowCycles : 1;
+	prepare();
+}
+
+void AudioSynthSteppedSine::sampleRateChanged(void)
+{
+	timing(settle_ms, cycles);
+	AudioSynthWaveform::sampleRateChanged();
+}
+
+// Window length and phase increment per step. The window is the nearest
+// whole number of samples to "cycles" periods, the increment is then set
+// so that the window holds exactly "cycles" periods.
+void AudioSynthSteppedSine::prepare(void)
+{
+	float f, c;
+	uint32_t len;
+
+	for (unsigned int i=0; i < nsteps; i++) {
+		f = freq[i];
+		if (f < 1.0f) f = 1.0f;
+		else if (f > AudioSampleRate() / 2) f = AudioSampleRate() / 2;
+		c = cycles;
+		if (c * AudioSampleRate() / f < AUDIO_BLOCK_SAMPLES) {
+			c = ceilf(AUDIO_BLOCK_SAMPLES * f / AudioSampleRate());
+		}
+		len = c * AudioSampleRate() / f + 0.5f;
+		window_len[i] = len;
+		step_incr[i] = (double)c * 2147483648.0 / len + 0.5;
+	}
+}
+
+float AudioSynthSteppedSine::stepFrequency(unsigned int n)
+{
+	if (n >= nsteps) return 0.0f;
+	return step_incr[n] * (AudioSampleRate() / 2147483648.0);
+}
+
+void AudioSynthSteppedSine::start(float level)
+{
+	if (nsteps == 0) return;
+	if (level < 0) level = 0;
+	else if (level > 1.0) level = 1.0;
+	__disable_irq();
+	tone_type = WAVEFORM_SINE;
+	tone_phase = 0;
+	tone_incr = step_incr[0];
+	tone_amp = (int32_t)(level * 32767.0) << 16;
+	glide_count = 0;
+	amp_count = 0;
+	cur = 0;
+	left = settle_len;
+	clock = 0;
+	new_output = false;
+	state = STEP_SETTLE;
+	__enable_irq();
+}
+
+void AudioSynthSteppedSine::stop(void)
+{
+	__disable_irq();
+	state = STEP_IDLE;
+	amplitude(0);
+	__enable_irq();
+}
+
+// Called from update() when the settle time or the window runs out,
+// offset is where in the current block the next one starts. Changes are
+// handed to AudioSynthWaveform::update() through its glide and ramp
+// counters with a zero step: the value is held for offset samples and
+// then replaced.
+void AudioSynthSteppedSine::next(uint32_t offset)
+{
+	if (state == STEP_SETTLE) {
+		state = STEP_MEASURE;
+		left = window_len[cur];
+		win_start = clock;
+		return;
+	}
+	done_step = cur;
+	done_start = win_start;
+	done_len = window_len[cur];
+	new_output = true;
+	if (++cur >= nsteps) {
+		state = STEP_IDLE;
+		amp_target = 0;
+		amp_step = 0;
+		amp_count = offset;
+		return;
+	}
+	state = STEP_SETTLE;
+	left = settle_len;
+	glide_target = step_incr[cur];
+	glide_step = 0;
+	glide_count = offset;
+}
+
+void AudioSynthSteppedSine::update(void)
+{
+	audio_block_t *gate;
+	int16_t *p, *end;
+	uint32_t pos, n;
+	int16_t g;
+
+	if (state == STEP_IDLE) {
+		AudioSynthWaveform::update();
+		return;
+	}
+	gate = allocate();
+	p = gate ? gate->data : NULL;
+	pos = 0;
+	do {
+		n = AUDIO_BLOCK_SAMPLES - pos;
+		if (n > left) n = left;
+		if (p) {
+			g = (state == STEP_MEASURE) ? 32767 : 0;
+			end = p + n;
+			while (p < end) *p++ = g;
+		}
+		pos += n;
+		left -= n;
+		clock += n;
+		if (left == 0) next(pos);
+	} while (pos < AUDIO_BLOCK_SAMPLES && state != STEP_IDLE);
+	if (p) {
+		end = gate->data + AUDIO_BLOCK_SAMPLES;
+		while (p < end) *p++ = 0;
+	}
+	AudioSynthWaveform::update();
+	if (gate) {
+		transmit(gate, 1);
+		release(gate);
+	}
+}
@@ -0,0 +1,100 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef synth_steppedsine_h_
+#define synth_steppedsine_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "synth_waveform.h"
+
+#define AUDIO_STEPPED_MAX	64
+
+// Stepped sine: a sine AudioSynthWaveform that walks a frequency table on
+// its own. Every step plays a settle time and then a measurement window of
+// a whole number of cycles, the step frequency is trimmed so the window
+// holds exactly that many. Step changes are scheduled to the sample inside
+// update(), no main loop involvement is needed.
+// Output 0 is the sine, output 1 is a gate, full scale during measurement
+// windows and zero elsewhere.
+class AudioSynthSteppedSine : public AudioSynthWaveform
+{
+public:
+	AudioSynthSteppedSine(void) : AudioSynthWaveform(),
+	  nsteps(0), settle_ms(0), settle_len(AUDIO_BLOCK_SAMPLES), cycles(10),
+	  state(STEP_IDLE), new_output(false) { }
+	// frequency table, up to AUDIO_STEPPED_MAX entries
+	void steps(const float *freq, unsigned int n);
+	// n log spaced steps from fmin to fmax
+	void logSpaced(float fmin, float fmax, unsigned int n);
+	// settle time per step and cycles per measurement window, both are
+	// raised to at least one block
+	void timing(float settleMs, uint16_t windowCycles);
+	// play the table from the first step, stops by itself after the last
+	void start(float level=1.0);
+	void stop(void);
+	bool running(void) { return state != STEP_IDLE; }
+	bool measuring(void) { return state == STEP_MEASURE; }
+	// step being played, -1 when stopped
+	int step(void) { return state != STEP_IDLE ? cur : -1; }
+	// frequency of step n after trimming to whole cycles
+	float stepFrequency(unsigned int n);
+	// samples since start()
+	uint32_t position(void) { return clock; }
+	// a measurement window has completed, the functions below describe it
+	bool available(void) {
+		if (new_output) {
+			new_output = false;
+			return true;
+		}
+		return false;
+	}
+	int lastStep(void) { return done_step; }
+	uint32_t windowStart(void) { return done_start; }	// in samples
+	uint32_t windowLength(void) { return done_len; }
+	virtual void update(void);
+protected:
+	// window lengths are in samples, a running sequence is stopped
+	virtual void sampleRateChanged(void);
+private:
+	enum { STEP_IDLE, STEP_SETTLE, STEP_MEASURE };
+	void prepare(void);
+	void next(uint32_t offset);
+	float    freq[AUDIO_STEPPED_MAX];
+	uint32_t step_incr[AUDIO_STEPPED_MAX];
+	uint32_t window_len[AUDIO_STEPPED_MAX];
+	uint16_t nsteps;
+	float    settle_ms;
+	uint32_t settle_len;
+	uint16_t cycles;
+	uint16_t cur;
+	uint32_t left;			// samples left in the settle or window
+	uint32_t clock;
+	uint32_t win_start;
+	int      done_step;
+	uint32_t done_start;
+	uint32_t done_len;
+	volatile uint8_t state;
+	volatile bool new_output;
+};
+
+#endif
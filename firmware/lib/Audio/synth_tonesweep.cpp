@@ -57,8 +57,8 @@ if(0) {
   if(t_amp > 1)return false;
   if(t_lo < 1)return false;
   if(t_hi < 1)return false;
-  if(t_hi >= (int) AUDIO_SAMPLE_RATE_EXACT / 2)return false;
-  if(t_lo >= (int) AUDIO_SAMPLE_RATE_EXACT / 2)return false;
+  if(t_hi >= (int) AudioSampleRate() / 2)return false;
+  if(t_lo >= (int) AudioSampleRate() / 2)return false;
   if(t_time <= 0)return false;
   if(t_dir != 1 && t_dir!=-1)  return false;
 
@@ -85,7 +85,8 @@ if(0) {
     else                  tone_freq = tone_lo*0x100000000LL;
   }
 
-  tone_tmp = tone_tmp / t_time / AUDIO_SAMPLE_RATE_EXACT;   //freq step pro one sample
+  tone_time = t_time;
+  tone_tmp = tone_tmp / t_time / AudioSampleRate();   //freq step pro one sample
   tone_incr = (tone_tmp * 0x100000000LL);                   //phaseacc adder
   sweep_pause = 0;
   sweep_busy = 1;
@@ -105,7 +106,7 @@ uint32_t AudioSynthToneSweep::getExpFreq(uint32_t linFreq)
     uint32_t pos, index, scale;
     uint32_t val1, val2, val;
 
-    if (linFreq > (int)AUDIO_SAMPLE_RATE_EXACT / 2) return 0;
+    if (linFreq > (int)AudioSampleRate() / 2) return 0;
     if (linFreq < tone_lo)  linFreq = tone_lo;
     if (linFreq > tone_hi)  linFreq = tone_hi;
 
@@ -142,7 +143,7 @@ void AudioSynthToneSweep::update(void)
     uint32_t tmp  = tone_freq >> 32;
     freq_exp = getExpFreq(tmp);
 
-    uint64_t tone_tmp = (0x400000000000LL * (int)(freq_exp&0x7fffffff)) / (int) (AUDIO_SAMPLE_RATE_EXACT*2); //for 88.2kHz I2S
+    uint64_t tone_tmp = (0x400000000000LL * (int)(freq_exp&0x7fffffff)) / (int) AudioSampleRate();
     // Generate the sweep
     for(i = 0;i < AUDIO_BLOCK_SAMPLES;i++)
     {
@@ -233,3 +234,12 @@ void AudioSynthToneSweep::flipDir(void)
 {
     tone_sign *= -1;
 }
+// ### keeps the sweep time after a sample rate change ###
+void AudioSynthToneSweep::sampleRateChanged(void)
+{
+    float tone_tmp;
+
+    if (!sweep_busy) return;
+    tone_tmp = (float)(tone_hi - tone_lo) / tone_time / AudioSampleRate();
+    tone_incr = (tone_tmp * 0x100000000LL);
+}
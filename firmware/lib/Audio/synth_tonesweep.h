@@ -47,6 +47,8 @@ public:
   void flipDir(void);
   int getSweepDir(void);
   void stop(void);
+protected:
+  virtual void sampleRateChanged(void);
 
 private:
   short tone_amp;
@@ -55,6 +57,7 @@ private:
   uint64_t tone_freq;
   uint64_t tone_phase;
   uint64_t tone_incr;
+  float tone_time;
 
   uint32_t freq_exp;
 
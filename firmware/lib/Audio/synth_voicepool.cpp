@@ -0,0 +1,319 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "synth_voicepool.h"
+#include "utility/dspinst.h"
+
+extern "C" {
+extern const int16_t AudioWaveformSine[257];
+}
+
+AudioSynthVoicePool::AudioSynthVoicePool(int32_t *memory, uint32_t voices)
+  : AudioStream(0, NULL)
+{
+	num_voices = voices;
+	list = (uint32_t *)memory;
+	for (uint32_t i=0; i < voices; i++) list[i] = i;
+	num_active = 0;
+}
+
+uint32_t AudioSynthVoicePool::claim(void)
+{
+	uint32_t i, voice, n = num_active;
+
+	if (n < num_voices) {
+		// first free one, it becomes the newest
+		num_active = n + 1;
+		return list[n];
+	}
+	// steal the oldest, move it to the end
+	voice = list[0];
+	for (i=1; i < n; i++) list[i-1] = list[i];
+	list[n-1] = voice;
+	return voice;
+}
+
+void AudioSynthVoicePool::retire(uint32_t n)
+{
+	uint32_t i, voice = list[n], last = num_active - 1;
+
+	for (i=n; i < last; i++) list[i] = list[i+1];
+	list[last] = voice;
+	num_active = last;
+}
+
+void AudioSynthVoicePool::noteOff(uint32_t voice)
+{
+	__disable_irq();
+	for (uint32_t n=0; n < num_active; n++) {
+		if (list[n] == voice) {
+			retire(n);
+			break;
+		}
+	}
+	__enable_irq();
+}
+
+void AudioSynthVoicePool::update(void)
+{
+	audio_block_t *block;
+	uint32_t n = 0;
+	bool add = false;
+
+	if (num_active == 0) return;
+	block = allocate();
+	if (!block) return;
+	while (n < num_active) {
+		if (render(list[n], block->data, add)) n++;
+		else retire(n);
+		add = true;
+	}
+	transmit(block);
+	release(block);
+}
+
+/******************************************************************/
+
+static uint32_t pseudorand(uint32_t lo)
+{
+	uint32_t hi;
+
+	hi = multiply_16bx16t(16807, lo); // 16807 * (lo >> 16)
+	lo = 16807 * (lo & 0xFFFF);
+	lo += (hi & 0x7FFF) << 16;
+	lo += hi >> 15;
+	lo = (lo & 0x7FFFFFFF) + (lo >> 31);
+	return lo;
+}
+
+uint32_t AudioSynthKarplusStrongPool::seed = 1;
+
+AudioSynthKarplusStrongPool::AudioSynthKarplusStrongPool(int32_t *memory, uint32_t voices)
+  : AudioSynthVoicePool(memory, voices)
+{
+	length = (uint32_t *)memory + voices;
+	index = length + voices;
+	magnitude = (int32_t *)index + voices;
+	strings = (int16_t *)(magnitude + voices);
+}
+
+uint32_t AudioSynthKarplusStrongPool::noteOn(float frequency, float velocity)
+{
+	uint32_t voice;
+	int32_t mag;
+	int len;
+
+	if (velocity > 1.0f) velocity = 1.0f;
+	else if (velocity <= 0.0f) return num_voices;
+	mag = velocity * 65535.0f;
+	if (mag < 1) mag = 1;
+	len = (AudioSampleRate() / frequency) + 0.5f;
+	if (len > AUDIO_KARPLUS_LENGTH) len = AUDIO_KARPLUS_LENGTH;
+	if (len < 2) len = 2;
+	__disable_irq();
+	voice = claim();
+	length[voice] = len;
+	index[voice] = 0;
+	magnitude[voice] = mag;	// the string is filled on the next update
+	__enable_irq();
+	return voice;
+}
+
+bool AudioSynthKarplusStrongPool::render(uint32_t voice, int16_t *data, bool add)
+{
+	int16_t *buffer = strings + voice * AUDIO_KARPLUS_LENGTH;
+	uint32_t i, len = length[voice], idx = index[voice];
+	int16_t in, out, prior;
+	int32_t sum, peak = 0;
+
+	if (magnitude[voice]) {
+		uint32_t lo = seed;
+		for (i=0; i < len; i++) {
+			lo = pseudorand(lo);
+			buffer[i] = signed_multiply_32x16b(magnitude[voice], lo);
+		}
+		seed = lo;
+		magnitude[voice] = 0;
+	}
+	prior = buffer[idx > 0 ? idx - 1 : len - 1];
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		in = buffer[idx];
+		// rounded toward zero, flooring would leave the string on a
+		// negative DC level forever
+		sum = (in + prior) * 32686;
+		out = (sum + ((sum >> 31) & 0xFFFF)) >> 16;
+		buffer[idx] = out;
+		prior = in;
+		if (++idx >= len) idx = 0;
+		data[i] = add ? saturate16(data[i] + out) : out;
+		peak |= out;
+	}
+	index[voice] = idx;
+	return peak != 0;
+}
+
+/******************************************************************/
+
+AudioSynthSimpleDrumPool::AudioSynthSimpleDrumPool(int32_t *memory, uint32_t voices)
+  : AudioSynthVoicePool(memory, voices)
+{
+	frequency = (float *)memory + voices;
+	envelope = (int32_t *)frequency + voices;
+	phasor = (uint32_t *)envelope + voices;
+	phasor2 = phasor + voices;
+	increment = phasor2 + voices;
+	amplitude = (int32_t *)increment + voices;
+	for (uint32_t i=0; i < voices; i++) frequency[i] = 0.0f;
+	length(600);
+	pitchMod(0x200);
+	wav_amplitude1 = 0x7fff;
+	wav_amplitude2 = 0;
+}
+
+// phase increment at the current rate, as AudioSynthSimpleDrum::frequency()
+static uint32_t drum_increment(float freq)
+{
+	if (freq < 0.0f) freq = 0.0f;
+	else if (freq > AudioSampleRate() / 2) freq = AudioSampleRate() / 2;
+	return (freq * (0x7fffffffLL / AudioSampleRate())) + 0.5f;
+}
+
+uint32_t AudioSynthSimpleDrumPool::noteOn(float freq, float velocity)
+{
+	uint32_t voice, inc = drum_increment(freq);
+
+	if (velocity > 1.0f) velocity = 1.0f;
+	else if (velocity <= 0.0f) return num_voices;
+	__disable_irq();
+	voice = claim();
+	envelope[voice] = 0x7fff0000;
+	phasor[voice] = 0;
+	phasor2[voice] = 0;
+	frequency[voice] = freq;
+	increment[voice] = inc;
+	amplitude[voice] = velocity * 65536.0f;
+	__enable_irq();
+	return voice;
+}
+
+void AudioSynthSimpleDrumPool::length(int32_t milliseconds)
+{
+	if (milliseconds < 0) return;
+	if (milliseconds > 5000) milliseconds = 5000;
+	length_ms = milliseconds;
+	int32_t len_samples = milliseconds * (AudioSampleRate() / 1000.0);
+	env_decrement = 0x7fff0000 / len_samples;
+}
+
+// the hits keep their pitch and length at the new rate
+void AudioSynthSimpleDrumPool::sampleRateChanged(void)
+{
+	for (uint32_t i=0; i < num_voices; i++) {
+		increment[i] = drum_increment(frequency[i]);
+	}
+	length(length_ms);
+}
+
+void AudioSynthSimpleDrumPool::secondMix(float level)
+{
+	if (level < 0) level = 0;
+	else if (level > 1.0) level = 1.0;
+	__disable_irq();
+	wav_amplitude2 = level * 0x3fff;
+	wav_amplitude1 = 0x7fff - wav_amplitude2;
+	__enable_irq();
+}
+
+// same mapping as AudioSynthSimpleDrum::pitchMod(), to 2.14
+void AudioSynthSimpleDrumPool::pitchMod(float depth)
+{
+	int32_t intdepth, calc;
+
+	if (depth < 0) depth = 0;
+	else if (depth > 1.0) depth = 1.0;
+	intdepth = depth * 0x7fff;
+	if (intdepth < 0x4000) {
+		calc = ((0x4000 - intdepth) * 0x3000) >> 14;
+		calc = -calc;
+	} else {
+		calc = ((intdepth - 0x4000) * 0xc000) >> 14;
+	}
+	wav_pitch_mod = calc;
+}
+
+// The AudioSynthSimpleDrum update() loop for one voice, times the velocity
+bool AudioSynthSimpleDrumPool::render(uint32_t voice, int16_t *data, bool add)
+{
+	int32_t env = envelope[voice], env_sqr, amp = amplitude[voice];
+	uint32_t ph = phasor[voice], ph2 = phasor2[voice], inc = increment[voice];
+	int32_t sin_l, sin_r, interp, interp2, mod, mod2, delta, index, scale, val;
+	bool do_second = (wav_amplitude2 > 50);
+	uint32_t i;
+
+	for (i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+		if (env < 0x0000ffff) {
+			// envelope has expired, the rest is silent
+			if (!add) {
+				for (; i < AUDIO_BLOCK_SAMPLES; i++) data[i] = 0;
+			}
+			break;
+		}
+		env -= env_decrement;
+		env_sqr = multiply_16tx16t(env, env);
+
+		mod = signed_multiply_32x16b(env_sqr, wav_pitch_mod >> 1) >> 13;
+		mod2 = signed_multiply_32x16b(inc << 3, mod >> 1);
+		ph = (ph + inc + mod2) & 0x7fffffff;
+
+		index = ph >> 23;
+		sin_l = AudioWaveformSine[index];
+		sin_r = AudioWaveformSine[index+1];
+		delta = sin_r - sin_l;
+		scale = (ph >> 7) & 0xFFFF;
+		delta = (delta * scale) >> 16;
+		interp = sin_l + delta;
+
+		if (do_second) {
+			ph2 += inc + (inc >> 1) + mod2 + (mod2 >> 1);
+			ph2 &= 0x7fffffff;
+			index = ph2 >> 23;
+			sin_l = AudioWaveformSine[index];
+			sin_r = AudioWaveformSine[index+1];
+			delta = sin_r - sin_l;
+			scale = (ph2 >> 7) & 0xFFFF;
+			delta = (delta * scale) >> 16;
+			interp2 = sin_l + delta;
+			interp2 = (interp2 * wav_amplitude2) >> 15;
+			interp = (interp * wav_amplitude1) >> 15;
+			interp = interp + interp2;
+		}
+
+		val = signed_multiply_32x16b(env_sqr, interp) >> 15;
+		if (amp != 65536) val = (val * amp) >> 16;
+		data[i] = add ? saturate16(data[i] + val) : (int16_t)val;
+	}
+	envelope[voice] = env;
+	phasor[voice] = ph;
+	phasor2[voice] = ph2;
+	return env >= 0x0000ffff;
+}
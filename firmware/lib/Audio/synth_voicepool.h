@@ -0,0 +1,110 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef synth_voicepool_h_
+#define synth_voicepool_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+
+// Longest Karplus-Strong string, same as AudioSynthKarplusStrong
+#define AUDIO_KARPLUS_LENGTH	536
+
+// Words of memory for a number of voices: the voice list, the voice
+// state (one array per field) and, for the plucks, the strings.
+#define AUDIO_KARPLUS_POOL_WORDS(voices)	((voices) * (5 + AUDIO_KARPLUS_LENGTH / 2))
+#define AUDIO_DRUM_POOL_WORDS(voices)		((voices) * 7)
+
+// Many voices of one synth in a single object and a single output block.
+// Only the sounding voices are rendered, they end by themselves when they
+// decay. When all are busy a new note takes the oldest one.
+class AudioSynthVoicePool : public AudioStream
+{
+public:
+	virtual void update(void);
+	uint32_t voices(void) { return num_voices; }
+	// voices sounding now
+	uint32_t active(void) { return num_active; }
+	void noteOff(uint32_t voice);
+	void allOff(void) { num_active = 0; }
+protected:
+	AudioSynthVoicePool(int32_t *memory, uint32_t voices);
+	// a free voice, or the oldest one. Audio interrupts off.
+	uint32_t claim(void);
+	// render one block of a voice, into data or added to it, returns
+	// false when the voice has ended
+	virtual bool render(uint32_t voice, int16_t *data, bool add) = 0;
+	uint32_t num_voices;
+private:
+	void retire(uint32_t n);
+	uint32_t *list;		// [voices] the sounding ones oldest first, then the free ones
+	volatile uint32_t num_active;
+};
+
+// Plucked strings, AudioSynthKarplusStrong as a voice pool. The loop
+// filter rounds toward zero, so a string decays to silence and the voice
+// ends there.
+class AudioSynthKarplusStrongPool : public AudioSynthVoicePool
+{
+public:
+	AudioSynthKarplusStrongPool(int32_t *memory, uint32_t voices);
+	// returns the voice, for noteOff()
+	uint32_t noteOn(float frequency, float velocity);
+private:
+	virtual bool render(uint32_t voice, int16_t *data, bool add);
+	uint32_t *length;	// [voices] string length
+	uint32_t *index;	// [voices] string position
+	int32_t *magnitude;	// [voices] pluck level, 0 once the string is filled
+	int16_t *strings;	// [voices][AUDIO_KARPLUS_LENGTH]
+	static uint32_t seed;
+};
+
+// Drum hits, AudioSynthSimpleDrum as a voice pool. Length, second tone
+// and pitch modulation are common to all the voices, the frequency and
+// velocity are set per hit.
+class AudioSynthSimpleDrumPool : public AudioSynthVoicePool
+{
+public:
+	AudioSynthSimpleDrumPool(int32_t *memory, uint32_t voices);
+	uint32_t noteOn(float frequency, float velocity = 1.0f);
+	void length(int32_t milliseconds);
+	void secondMix(float level);
+	void pitchMod(float depth);
+protected:
+	virtual void sampleRateChanged(void);
+private:
+	virtual bool render(uint32_t voice, int16_t *data, bool add);
+	float *frequency;	// [voices] as given to noteOn()
+	int32_t *envelope;	// [voices] linear envelope
+	uint32_t *phasor;	// [voices]
+	uint32_t *phasor2;	// [voices] the fifth
+	uint32_t *increment;	// [voices]
+	int32_t *amplitude;	// [voices] velocity, 65536 = 1.0
+	int32_t env_decrement;
+	int32_t length_ms;
+	int16_t wav_amplitude1;
+	int16_t wav_amplitude2;
+	int32_t wav_pitch_mod;
+};
+
+#endif
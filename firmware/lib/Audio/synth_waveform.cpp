@@ -42,120 +42,176 @@ void AudioSynthWaveform::update(void)
   short *bp, *end;
   int32_t val1, val2, val3;
   uint32_t index, scale;
+  uint32_t ph, inc, n, remaining;
+  int32_t amp, dinc, damp;
 
   // temporaries for TRIANGLE
   uint32_t mag;
   short tmp_amp;
 
-  if(tone_amp == 0) return;
+  if(tone_amp == 0 && amp_count == 0) return;
   block = allocate();
   if (block) {
+    if (tone_type == WAVEFORM_ARBITRARY && !arbdata) {
+      release(block);
+      return;
+    }
     bp = block->data;
-    switch(tone_type) {
-    case WAVEFORM_SINE:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-
-        // Calculate interpolated sin
-        index = tone_phase >> 23;
-        val1 = AudioWaveformSine[index];
-        val2 = AudioWaveformSine[index+1];
-        scale = (tone_phase >> 7) & 0xFFFF;
-        val2 *= scale;
-        val1 *= 0xFFFF - scale;
-        val3 = (val1 + val2) >> 16;
-        *bp++ = (short)((val3 * tone_amp) >> 15);
-
-        // phase and incr are both unsigned 32-bit fractions
-        tone_phase += tone_incr;
-        // If tone_phase has overflowed, truncate the top bit
-        if(tone_phase & 0x80000000)tone_phase &= 0x7fffffff;
-      }
-      break;
-
-    case WAVEFORM_ARBITRARY:
-      if (!arbdata) {
-		release(block);
-		return;
+    ph = tone_phase;
+    inc = tone_incr;
+    amp = tone_amp;
+    remaining = AUDIO_BLOCK_SAMPLES;
+    do {
+      // a glide or ramp ending inside the block splits it there, so
+      // both land on the exact sample. The steps are added on every
+      // sample (zero when idle) and the cost does not change.
+      n = remaining;
+      dinc = 0;
+      damp = 0;
+      if (glide_count) {
+        if (n > glide_count) n = glide_count;
+        dinc = glide_step;
       }
-      // len = 256
-      for (int i = 0; i < AUDIO_BLOCK_SAMPLES;i++) {
-		index = tone_phase >> 23;
-		val1 = *(arbdata + index);
-		val2 = *(arbdata + ((index + 1) & 255));
-		scale = (tone_phase >> 7) & 0xFFFF;
-		val2 *= scale;
-		val1 *= 0xFFFF - scale;
-		val3 = (val1 + val2) >> 16;
-		*bp++ = (short)((val3 * tone_amp) >> 15);
-		tone_phase += tone_incr;
-		tone_phase &= 0x7fffffff;
+      if (amp_count) {
+        if (n > amp_count) n = amp_count;
+        damp = amp_step;
       }
-      break;
-
-    case WAVEFORM_SQUARE:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        if(tone_phase & 0x40000000)*bp++ = -tone_amp;
-        else *bp++ = tone_amp;
-        // phase and incr are both unsigned 32-bit fractions
-        tone_phase += tone_incr;
-      }
-      break;
+      switch(tone_type) {
+      case WAVEFORM_SINE:
+        for(uint32_t i = 0;i < n;i++) {
 
-    case WAVEFORM_SAWTOOTH:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        *bp++ = ((short)(tone_phase>>15)*tone_amp) >> 15;
-        // phase and incr are both unsigned 32-bit fractions
-        tone_phase += tone_incr;
-      }
-      break;
+          // Calculate interpolated sin
+          index = ph >> 23;
+          val1 = AudioWaveformSine[index];
+          val2 = AudioWaveformSine[index+1];
+          scale = (ph >> 7) & 0xFFFF;
+          val2 *= scale;
+          val1 *= 0xFFFF - scale;
+          val3 = (val1 + val2) >> 16;
+          *bp++ = (short)((val3 * (amp >> 16)) >> 15);
 
-    case WAVEFORM_SAWTOOTH_REVERSE:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        *bp++ = ((short)(tone_phase>>15)*tone_amp) >> 15;
-         // phase and incr are both unsigned 32-bit fractions
-         tone_phase -= tone_incr;
-      }
-      break;
+          // phase and incr are both unsigned 32-bit fractions
+          ph += inc;
+          // If tone_phase has overflowed, truncate the top bit
+          if(ph & 0x80000000)ph &= 0x7fffffff;
+          inc += dinc;
+          amp += damp;
+        }
+        break;
 
-    case WAVEFORM_TRIANGLE:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        if(tone_phase & 0x80000000) {
-          // negative half-cycle
-          tmp_amp = -tone_amp;
+      case WAVEFORM_ARBITRARY:
+        // len = 256
+        for (uint32_t i = 0; i < n;i++) {
+          index = ph >> 23;
+          val1 = *(arbdata + index);
+          val2 = *(arbdata + ((index + 1) & 255));
+          scale = (ph >> 7) & 0xFFFF;
+          val2 *= scale;
+          val1 *= 0xFFFF - scale;
+          val3 = (val1 + val2) >> 16;
+          *bp++ = (short)((val3 * (amp >> 16)) >> 15);
+          ph += inc;
+          ph &= 0x7fffffff;
+          inc += dinc;
+          amp += damp;
         }
-        else {
-          // positive half-cycle
-          tmp_amp = tone_amp;
+        break;
+
+      case WAVEFORM_SQUARE:
+        for(uint32_t i = 0;i < n;i++) {
+          if(ph & 0x40000000)*bp++ = -(amp >> 16);
+          else *bp++ = amp >> 16;
+          // phase and incr are both unsigned 32-bit fractions
+          ph += inc;
+          inc += dinc;
+          amp += damp;
         }
-        mag = tone_phase << 2;
-        // Determine which quadrant
-        if(tone_phase & 0x40000000) {
-          // negate the magnitude
-          mag = ~mag + 1;
+        break;
+
+      case WAVEFORM_SAWTOOTH:
+        for(uint32_t i = 0;i < n;i++) {
+          *bp++ = ((short)(ph>>15)*(amp >> 16)) >> 15;
+          // phase and incr are both unsigned 32-bit fractions
+          ph += inc;
+          inc += dinc;
+          amp += damp;
         }
-        *bp++ = ((short)(mag>>17)*tmp_amp) >> 15;
-        tone_phase += 2*tone_incr;
-      }
-      break;
+        break;
 
-    case WAVEFORM_PULSE:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        if(tone_phase < tone_width)*bp++ = -tone_amp;
-        else *bp++ = tone_amp;
-        tone_phase += tone_incr<<1;
-      }
-      break;
+      case WAVEFORM_SAWTOOTH_REVERSE:
+        for(uint32_t i = 0;i < n;i++) {
+          *bp++ = ((short)(ph>>15)*(amp >> 16)) >> 15;
+          // phase and incr are both unsigned 32-bit fractions
+          ph -= inc;
+          inc += dinc;
+          amp += damp;
+        }
+        break;
+
+      case WAVEFORM_TRIANGLE:
+        for(uint32_t i = 0;i < n;i++) {
+          if(ph & 0x80000000) {
+            // negative half-cycle
+            tmp_amp = -(amp >> 16);
+          }
+          else {
+            // positive half-cycle
+            tmp_amp = amp >> 16;
+          }
+          mag = ph << 2;
+          // Determine which quadrant
+          if(ph & 0x40000000) {
+            // negate the magnitude
+            mag = ~mag + 1;
+          }
+          *bp++ = ((short)(mag>>17)*tmp_amp) >> 15;
+          ph += 2*inc;
+          inc += dinc;
+          amp += damp;
+        }
+        break;
+
+      case WAVEFORM_PULSE:
+        for(uint32_t i = 0;i < n;i++) {
+          if(ph < tone_width)*bp++ = -(amp >> 16);
+          else *bp++ = amp >> 16;
+          ph += inc<<1;
+          inc += dinc;
+          amp += damp;
+        }
+        break;
 
-    case WAVEFORM_SAMPLE_HOLD:
-      for(int i = 0;i < AUDIO_BLOCK_SAMPLES;i++) {
-        if(tone_phase < tone_incr) {
-          sample = random(-tone_amp, tone_amp);
+      case WAVEFORM_SAMPLE_HOLD:
+        for(uint32_t i = 0;i < n;i++) {
+          if(ph < inc) {
+            sample = random(-(amp >> 16), amp >> 16);
+          }
+          *bp++ = sample;
+          ph += inc;
+          inc += dinc;
+          amp += damp;
         }
-        *bp++ = sample;
-        tone_phase += tone_incr;
+        break;
+
+      default:
+        bp += n;
+        break;
       }
-      break;
-    }
+      // land exactly on the targets, the steps are rounded
+      if (glide_count) {
+        glide_count -= n;
+        if (glide_count == 0) inc = glide_target;
+      }
+      if (amp_count) {
+        amp_count -= n;
+        if (amp_count == 0) amp = amp_target;
+      }
+      remaining -= n;
+    } while (remaining);
+    tone_phase = ph;
+    tone_incr = inc;
+    tone_amp = amp;
+
     if (tone_offset) {
 	bp = block->data;
 	end = bp + AUDIO_BLOCK_SAMPLES;
@@ -168,3 +224,48 @@ void AudioSynthWaveform::update(void)
     release(block);
   }
 }
+
+// Number of samples in a glide or ramp, at least one.
+static uint32_t ramp_samples(float milliseconds)
+{
+  float n = milliseconds * (AudioSampleRate() / 1000.0f) + 0.5f;
+  if (n < 1.0f) return 1;
+  if (n > 2147483647.0f) return 2147483647;
+  return n;
+}
+
+void AudioSynthWaveform::frequency(float t_freq, float milliseconds)
+{
+  uint32_t target, count;
+
+  if (t_freq < 0.0) t_freq = 0.0;
+  else if (t_freq > AudioSampleRate() / 2) t_freq = AudioSampleRate() / 2;
+  target = (t_freq * (0x80000000LL/AudioSampleRate())) + 0.5;
+  count = ramp_samples(milliseconds);
+  __disable_irq();
+  tone_freq = t_freq;
+  glide_target = target;
+  glide_step = ((int64_t)target - (int64_t)tone_incr) / (int32_t)count;
+  glide_count = count;
+  __enable_irq();
+}
+
+void AudioSynthWaveform::amplitude(float n, float milliseconds)
+{
+  int32_t target;
+  uint32_t count;
+
+  if (n < 0) n = 0;
+  else if (n > 1.0) n = 1.0;
+  target = (int32_t)(n * 32767.0) << 16;
+  count = ramp_samples(milliseconds);
+  __disable_irq();
+  if (tone_amp == 0 && amp_count == 0 && target) {
+    // starting from silence, as in amplitude(n)
+    tone_phase = 0;
+  }
+  amp_target = target;
+  amp_step = ((int64_t)target - (int64_t)tone_amp) / (int32_t)count;
+  amp_count = count;
+  __enable_irq();
+}
@@ -62,15 +62,19 @@ public:
   AudioSynthWaveform(void) :
   AudioStream(0,NULL), tone_amp(0), tone_freq(0),
   tone_phase(0), tone_width(0.25), tone_incr(0), tone_type(0),
-  tone_offset(0), arbdata(NULL)
+  tone_offset(0), arbdata(NULL), glide_count(0), amp_count(0)
   {
   }
 
   void frequency(float t_freq) {
     if (t_freq < 0.0) t_freq = 0.0;
-    else if (t_freq > AUDIO_SAMPLE_RATE_EXACT / 2) t_freq = AUDIO_SAMPLE_RATE_EXACT / 2;
-    tone_incr = (t_freq * (0x80000000LL/AUDIO_SAMPLE_RATE_EXACT)) + 0.5;
+    else if (t_freq > AudioSampleRate() / 2) t_freq = AudioSampleRate() / 2;
+    glide_count = 0;
+    tone_freq = t_freq;
+    tone_incr = (t_freq * (0x80000000LL/AudioSampleRate())) + 0.5;
   }
+  // phase continuous glide to t_freq, linear over milliseconds
+  void frequency(float t_freq, float milliseconds);
   void phase(float angle) {
     if (angle < 0.0) angle = 0.0;
     else if (angle > 360.0) {
@@ -88,8 +92,11 @@ public:
       tone_phase = 0;
     }
     // set new magnitude
-    tone_amp = n * 32767.0;
+    amp_count = 0;
+    tone_amp = (int32_t)(n * 32767.0) << 16;
   }
+  // ramp to n, linear over milliseconds
+  void amplitude(float n, float milliseconds);
   void offset(float n) {
     if (n < -1.0) n = -1.0;
     else if (n > 1.0) n = 1.0;
@@ -116,9 +123,11 @@ public:
   }
   virtual void update(void);
 
-private:
-  short    tone_amp;
-  short    tone_freq;
+protected:
+  // a glide in progress jumps to its target
+  virtual void sampleRateChanged(void) { frequency(tone_freq); }
+  int32_t  tone_amp;       // 16.16, upper half is the magnitude
+  float    tone_freq;      // set or glide target, for rate changes
   uint32_t tone_phase;
   uint32_t tone_width;
   // sample for SAMPLE_HOLD
@@ -128,6 +137,13 @@ private:
   short    tone_type;
   int16_t  tone_offset;
   const int16_t *arbdata;
+  // glide and ramp, applied per sample in update()
+  uint32_t glide_target;
+  int32_t  glide_step;
+  uint32_t glide_count;    // samples left
+  int32_t  amp_target;
+  int32_t  amp_step;
+  uint32_t amp_count;
 };
 
 
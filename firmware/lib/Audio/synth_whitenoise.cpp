@@ -44,7 +44,7 @@ void AudioSynthNoiseWhite::update(void)
 	end = p + AUDIO_BLOCK_SAMPLES/2;
 	lo = seed;
 	do {
-#if defined(KINETISK)
+#if defined(KINETISK) || defined(DSPINST_HOST)
 		hi = multiply_16bx16t(16807, lo); // 16807 * (lo >> 16)
 		lo = 16807 * (lo & 0xFFFF);
 		lo += (hi & 0x7FFF) << 16;
@@ -91,10 +91,29 @@ void AudioSynthNoiseWhite::update(void)
 #endif
 	} while (p < end);
 	seed = lo;
+	if (pblocks && --pcount == 0) {
+		seed = pseed;
+		pcount = pblocks;
+	}
 	transmit(block);
 	release(block);
 }
 
+void AudioSynthNoiseWhite::period(uint8_t bits)
+{
+	__disable_irq();
+	if (bits == 0) {
+		pblocks = 0;
+	} else {
+		if (bits < AUDIO_NOISE_MIN_PERIOD) bits = AUDIO_NOISE_MIN_PERIOD;
+		else if (bits > 22) bits = 22;
+		pblocks = 1 << (bits - AUDIO_NOISE_MIN_PERIOD);
+		pcount = pblocks;
+		pseed = seed;
+	}
+	__enable_irq();
+}
+
 uint16_t AudioSynthNoiseWhite::instance_count = 0;
 
 
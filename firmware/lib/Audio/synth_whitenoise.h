@@ -30,22 +30,36 @@
 #include "AudioStream.h"
 #include "utility/dspinst.h"
 
+// shortest period, a whole number of blocks
+#if AUDIO_BLOCK_SAMPLES == 128
+#define AUDIO_NOISE_MIN_PERIOD	7
+#elif AUDIO_BLOCK_SAMPLES == 64
+#define AUDIO_NOISE_MIN_PERIOD	6
+#endif
+
 class AudioSynthNoiseWhite : public AudioStream
 {
 public:
 	AudioSynthNoiseWhite() : AudioStream(0, NULL) {
 		level = 0;
 		seed = 1 + instance_count++;
+		pblocks = 0;
 	}
 	void amplitude(float n) {
 		if (n < 0.0) n = 0.0;
 		else if (n > 1.0) n = 1.0;
 		level = (int32_t)(n * 65536.0);
 	}
+	// repeat the noise every 2^bits samples from the current state,
+	// 0 = aperiodic, otherwise AUDIO_NOISE_MIN_PERIOD to 22
+	void period(uint8_t bits);
 	virtual void update(void);
 private:
 	int32_t  level; // 0=off, 65536=max
 	uint32_t seed;  // must start at 1
+	uint32_t pseed; // seed at the start of the period
+	uint32_t pblocks; // period in blocks, 0 = aperiodic
+	uint32_t pcount;  // blocks left in the period
 	static uint16_t instance_count;
 };
 
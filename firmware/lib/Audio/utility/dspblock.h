@@ -0,0 +1,297 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef dspblock_h_
+#define dspblock_h_
+
+#include <stdint.h>
+#include "dspinst.h"
+
+// Whole buffer kernels on top of the dspinst.h instructions. On a Teensy
+// 3.x they are the usual two samples per word loops, on a host build
+// they run 8 (SSE4.1) or 16 (AVX2) samples at a time with the same
+// results as the single instructions, bit for bit, and a scalar tail.
+
+#if defined(DSPINST_HOST) && defined(__AVX2__)
+#include <immintrin.h>
+#define DSPBLOCK_AVX2
+
+// (x * m) >> 16 for 8 lanes: bits 47..16 of the 64 bit products, like smulwb
+static inline __m256i dspblock_mulw(__m256i x, __m256i m)
+{
+	__m256i even = _mm256_srli_epi64(_mm256_mul_epi32(x, m), 16);
+	__m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), m);
+	odd = _mm256_slli_epi64(_mm256_srli_epi64(odd, 16), 32);
+	return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+// 16 samples times a 16.16 gain, saturated like ssat
+static inline __m256i dspblock_gain(__m256i x, __m256i m)
+{
+	__m256i lo = dspblock_mulw(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(x)), m);
+	__m256i hi = dspblock_mulw(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1)), m);
+	return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+#elif defined(DSPINST_HOST) && defined(__SSE4_1__)
+#include <smmintrin.h>
+#define DSPBLOCK_SSE4
+
+static inline __m128i dspblock_mulw(__m128i x, __m128i m)
+{
+	__m128i even = _mm_srli_epi64(_mm_mul_epi32(x, m), 16);
+	__m128i odd = _mm_mul_epi32(_mm_srli_epi64(x, 32), m);
+	odd = _mm_slli_epi64(_mm_srli_epi64(odd, 16), 32);
+	return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+static inline __m128i dspblock_gain(__m128i x, __m128i m)
+{
+	__m128i lo = dspblock_mulw(_mm_cvtepi16_epi32(x), m);
+	__m128i hi = dspblock_mulw(_mm_cvtepi16_epi32(_mm_srli_si128(x, 8)), m);
+	return _mm_packs_epi32(lo, hi);
+}
+#endif
+
+// data = limit((data * mult) >> 16), mult is 16.16, 65536 = unity.
+// On a Teensy 3.x n is even and data word aligned.
+static inline void block_gain(int16_t *data, int32_t mult, uint32_t n)
+{
+#if defined(KINETISK)
+	uint32_t *p = (uint32_t *)data;
+	const uint32_t *end = (uint32_t *)(data + n);
+
+	do {
+		uint32_t tmp32 = *p; // read 2 samples from *data
+		int32_t val1 = signed_multiply_32x16b(mult, tmp32);
+		int32_t val2 = signed_multiply_32x16t(mult, tmp32);
+		val1 = signed_saturate_rshift(val1, 16, 0);
+		val2 = signed_saturate_rshift(val2, 16, 0);
+		*p++ = pack_16b_16b(val2, val1);
+	} while (p < end);
+#else
+	uint32_t i = 0;
+#if defined(DSPBLOCK_AVX2)
+	const __m256i m = _mm256_set1_epi32(mult);
+	for (; i + 16 <= n; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(data + i));
+		_mm256_storeu_si256((__m256i *)(data + i), dspblock_gain(x, m));
+	}
+#elif defined(DSPBLOCK_SSE4)
+	const __m128i m = _mm_set1_epi32(mult);
+	for (; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+		_mm_storeu_si128((__m128i *)(data + i), dspblock_gain(x, m));
+	}
+#endif
+	for (; i < n; i++) {
+		int32_t val = signed_multiply_32x16b(mult, (uint16_t)data[i]);
+		data[i] = signed_saturate_rshift(val, 16, 0);
+	}
+#endif
+}
+
+// dst = limit((src * mult) >> 16), block_gain() into another buffer
+static inline void block_gain_copy(int16_t *data, const int16_t *in, int32_t mult, uint32_t n)
+{
+#if defined(KINETISK)
+	uint32_t *dst = (uint32_t *)data;
+	const uint32_t *src = (uint32_t *)in;
+	const uint32_t *end = (uint32_t *)(data + n);
+
+	if (mult == 65536) {
+		do {
+			*dst++ = *src++;
+			*dst++ = *src++;
+		} while (dst < end);
+	} else {
+		do {
+			uint32_t tmp32 = *src++;
+			int32_t val1 = signed_multiply_32x16b(mult, tmp32);
+			int32_t val2 = signed_multiply_32x16t(mult, tmp32);
+			val1 = signed_saturate_rshift(val1, 16, 0);
+			val2 = signed_saturate_rshift(val2, 16, 0);
+			*dst++ = pack_16b_16b(val2, val1);
+		} while (dst < end);
+	}
+#else
+	uint32_t i = 0;
+#if defined(DSPBLOCK_AVX2)
+	const __m256i m = _mm256_set1_epi32(mult);
+	for (; i + 16 <= n; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+		if (mult != 65536) x = dspblock_gain(x, m);
+		_mm256_storeu_si256((__m256i *)(data + i), x);
+	}
+#elif defined(DSPBLOCK_SSE4)
+	const __m128i m = _mm_set1_epi32(mult);
+	for (; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+		if (mult != 65536) x = dspblock_gain(x, m);
+		_mm_storeu_si128((__m128i *)(data + i), x);
+	}
+#endif
+	for (; i < n; i++) {
+		int32_t val = signed_multiply_32x16b(mult, (uint16_t)in[i]);
+		data[i] = signed_saturate_rshift(val, 16, 0);
+	}
+#endif
+}
+
+// dst = limit(dst + limit((src * mult) >> 16)), same gain as block_gain()
+static inline void block_gain_add(int16_t *data, const int16_t *in, int32_t mult, uint32_t n)
+{
+#if defined(KINETISK)
+	uint32_t *dst = (uint32_t *)data;
+	const uint32_t *src = (uint32_t *)in;
+	const uint32_t *end = (uint32_t *)(data + n);
+
+	if (mult == 65536) {
+		do {
+			uint32_t tmp32 = *dst;
+			*dst++ = signed_add_16_and_16(tmp32, *src++);
+			tmp32 = *dst;
+			*dst++ = signed_add_16_and_16(tmp32, *src++);
+		} while (dst < end);
+	} else {
+		do {
+			uint32_t tmp32 = *src++; // read 2 samples from *data
+			int32_t val1 = signed_multiply_32x16b(mult, tmp32);
+			int32_t val2 = signed_multiply_32x16t(mult, tmp32);
+			val1 = signed_saturate_rshift(val1, 16, 0);
+			val2 = signed_saturate_rshift(val2, 16, 0);
+			tmp32 = pack_16b_16b(val2, val1);
+			uint32_t tmp32b = *dst;
+			*dst++ = signed_add_16_and_16(tmp32, tmp32b);
+		} while (dst < end);
+	}
+#else
+	uint32_t i = 0;
+#if defined(DSPBLOCK_AVX2)
+	const __m256i m = _mm256_set1_epi32(mult);
+	for (; i + 16 <= n; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(data + i));
+		if (mult != 65536) x = dspblock_gain(x, m);
+		_mm256_storeu_si256((__m256i *)(data + i), _mm256_adds_epi16(y, x));
+	}
+#elif defined(DSPBLOCK_SSE4)
+	const __m128i m = _mm_set1_epi32(mult);
+	for (; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+		__m128i y = _mm_loadu_si128((const __m128i *)(data + i));
+		if (mult != 65536) x = dspblock_gain(x, m);
+		_mm_storeu_si128((__m128i *)(data + i), _mm_adds_epi16(y, x));
+	}
+#endif
+	for (; i < n; i++) {
+		int32_t val = in[i];
+		if (mult != 65536) {
+			val = signed_multiply_32x16b(mult, (uint16_t)in[i]);
+			val = signed_saturate_rshift(val, 16, 0);
+		}
+		data[i] = signed_saturate_rshift(data[i] + val, 16, 0);
+	}
+#endif
+}
+
+// dst = limit(src >> rshift), 32 bit to 16 bit samples
+static inline void block_saturate(int16_t *dst, const int32_t *src, int rshift, uint32_t n)
+{
+	uint32_t i = 0;
+#if defined(DSPBLOCK_AVX2)
+	const __m128i s = _mm_cvtsi32_si128(rshift);
+	for (; i + 16 <= n; i += 16) {
+		__m256i lo = _mm256_sra_epi32(_mm256_loadu_si256((const __m256i *)(src + i)), s);
+		__m256i hi = _mm256_sra_epi32(_mm256_loadu_si256((const __m256i *)(src + i + 8)), s);
+		__m256i r = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+		_mm256_storeu_si256((__m256i *)(dst + i), r);
+	}
+#elif defined(DSPBLOCK_SSE4)
+	const __m128i s = _mm_cvtsi32_si128(rshift);
+	for (; i + 8 <= n; i += 8) {
+		__m128i lo = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)(src + i)), s);
+		__m128i hi = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)(src + i + 4)), s);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; i < n; i++) {
+		dst[i] = signed_saturate_rshift(src[i] >> rshift, 16, 0);
+	}
+}
+
+// dst = a[0] b[0] a[1] b[1] ..., a NULL a or b gives zeros
+static inline void block_interleave(int16_t *dst, const int16_t *a, const int16_t *b, uint32_t n)
+{
+	uint32_t i = 0;
+#if defined(DSPBLOCK_AVX2)
+	for (; i + 16 <= n; i += 16) {
+		__m256i x = a ? _mm256_loadu_si256((const __m256i *)(a + i)) : _mm256_setzero_si256();
+		__m256i y = b ? _mm256_loadu_si256((const __m256i *)(b + i)) : _mm256_setzero_si256();
+		__m256i lo = _mm256_unpacklo_epi16(x, y);
+		__m256i hi = _mm256_unpackhi_epi16(x, y);
+		_mm256_storeu_si256((__m256i *)(dst + 2*i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst + 2*i + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+#elif defined(DSPBLOCK_SSE4)
+	for (; i + 8 <= n; i += 8) {
+		__m128i x = a ? _mm_loadu_si128((const __m128i *)(a + i)) : _mm_setzero_si128();
+		__m128i y = b ? _mm_loadu_si128((const __m128i *)(b + i)) : _mm_setzero_si128();
+		_mm_storeu_si128((__m128i *)(dst + 2*i), _mm_unpacklo_epi16(x, y));
+		_mm_storeu_si128((__m128i *)(dst + 2*i + 8), _mm_unpackhi_epi16(x, y));
+	}
+#endif
+	for (; i < n; i++) {
+		dst[2*i] = a ? a[i] : 0;
+		dst[2*i+1] = b ? b[i] : 0;
+	}
+}
+
+// dst = (src * window) >> 15, the analyzer window, src may be dst
+static inline void block_window(int16_t *dst, const int16_t *src, const int16_t *window, uint32_t n)
+{
+	uint32_t i = 0;
+#if defined(DSPBLOCK_AVX2)
+	for (; i + 16 <= n; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i w = _mm256_loadu_si256((const __m256i *)(window + i));
+		__m256i r = _mm256_or_si256(_mm256_slli_epi16(_mm256_mulhi_epi16(x, w), 1),
+			_mm256_srli_epi16(_mm256_mullo_epi16(x, w), 15));
+		_mm256_storeu_si256((__m256i *)(dst + i), r);
+	}
+#elif defined(DSPBLOCK_SSE4)
+	for (; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i w = _mm_loadu_si128((const __m128i *)(window + i));
+		__m128i r = _mm_or_si128(_mm_slli_epi16(_mm_mulhi_epi16(x, w), 1),
+			_mm_srli_epi16(_mm_mullo_epi16(x, w), 15));
+		_mm_storeu_si128((__m128i *)(dst + i), r);
+	}
+#endif
+	for (; i < n; i++) {
+		int32_t val = src[i] * window[i];
+		dst[i] = val >> 15;
+	}
+}
+
+#endif
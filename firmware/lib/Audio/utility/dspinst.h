@@ -29,6 +29,13 @@
 
 #include <stdint.h>
 
+// Neither a Teensy 3.x nor a Teensy LC: a host build. The instructions
+// are done in plain C with the same results, bit for bit, except that
+// nothing sets the Q flag.
+#if !defined(KINETISK) && !defined(KINETISL)
+#define DSPINST_HOST
+#endif
+
 // computes limit((val >> rshift), 2**bits)
 static inline int32_t signed_saturate_rshift(int32_t val, int bits, int rshift) __attribute__((always_inline, unused));
 static inline int32_t signed_saturate_rshift(int32_t val, int bits, int rshift)
@@ -47,6 +54,13 @@ static inline int32_t signed_saturate_rshift(int32_t val, int bits, int rshift)
 		if (out < -max) out = -max;
 	}
 	return out;
+#else
+	int32_t out, max;
+	out = val >> rshift;
+	max = 1 << (bits - 1);
+	if (out > max - 1) out = max - 1;
+	else if (out < -max) out = -max;
+	return out;
 #endif
 }
 
@@ -62,6 +76,10 @@ static inline int16_t saturate16(int32_t val)
 	return out;
 #elif defined(KINETISL)
 	return 0; // TODO....
+#else
+	if (val > 32767) return 32767;
+	if (val < -32768) return -32768;
+	return val;
 #endif
 }
 
@@ -75,6 +93,8 @@ static inline int32_t signed_multiply_32x16b(int32_t a, uint32_t b)
 	return out;
 #elif defined(KINETISL)
 	return ((int64_t)a * (int16_t)(b & 0xFFFF)) >> 16;
+#else
+	return ((int64_t)a * (int16_t)(b & 0xFFFF)) >> 16;
 #endif
 }
 
@@ -88,6 +108,8 @@ static inline int32_t signed_multiply_32x16t(int32_t a, uint32_t b)
 	return out;
 #elif defined(KINETISL)
 	return ((int64_t)a * (int16_t)(b >> 16)) >> 16;
+#else
+	return ((int64_t)a * (int16_t)(b >> 16)) >> 16;
 #endif
 }
 
@@ -101,6 +123,8 @@ static inline int32_t multiply_32x32_rshift32(int32_t a, int32_t b)
 	return out;
 #elif defined(KINETISL)
 	return 0; // TODO....
+#else
+	return ((int64_t)a * b) >> 32;
 #endif
 }
 
@@ -114,6 +138,8 @@ static inline int32_t multiply_32x32_rshift32_rounded(int32_t a, int32_t b)
 	return out;
 #elif defined(KINETISL)
 	return 0; // TODO....
+#else
+	return ((int64_t)a * b + 0x80000000LL) >> 32;
 #endif
 }
 
@@ -127,6 +153,8 @@ static inline int32_t multiply_accumulate_32x32_rshift32_rounded(int32_t sum, in
 	return out;
 #elif defined(KINETISL)
 	return 0; // TODO....
+#else
+	return (((uint64_t)(uint32_t)sum << 32) + (uint64_t)((int64_t)a * b) + 0x80000000ULL) >> 32;
 #endif
 }
 
@@ -140,6 +168,8 @@ static inline int32_t multiply_subtract_32x32_rshift32_rounded(int32_t sum, int3
 	return out;
 #elif defined(KINETISL)
 	return 0; // TODO....
+#else
+	return (((uint64_t)(uint32_t)sum << 32) - (uint64_t)((int64_t)a * b) + 0x80000000ULL) >> 32;
 #endif
 }
 
@@ -154,6 +184,8 @@ static inline uint32_t pack_16t_16t(int32_t a, int32_t b)
 	return out;
 #elif defined(KINETISL)
 	return (a & 0xFFFF0000) | ((uint32_t)b >> 16);
+#else
+	return (a & 0xFFFF0000) | ((uint32_t)b >> 16);
 #endif
 }
 
@@ -167,6 +199,8 @@ static inline uint32_t pack_16t_16b(int32_t a, int32_t b)
 	return out;
 #elif defined(KINETISL)
 	return (a & 0xFFFF0000) | (b & 0x0000FFFF);
+#else
+	return (a & 0xFFFF0000) | (b & 0x0000FFFF);
 #endif
 }
 
@@ -180,6 +214,8 @@ static inline uint32_t pack_16b_16b(int32_t a, int32_t b)
 	return out;
 #elif defined(KINETISL)
 	return (a << 16) | (b & 0x0000FFFF);
+#else
+	return ((uint32_t)a << 16) | (b & 0x0000FFFF);
 #endif
 }
 
@@ -198,157 +234,242 @@ static inline uint32_t pack_16x16(int32_t a, int32_t b)
 static inline uint32_t signed_add_16_and_16(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline uint32_t signed_add_16_and_16(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	int32_t lo = (int16_t)a + (int16_t)b;
+	int32_t hi = (int16_t)(a >> 16) + (int16_t)(b >> 16);
+	lo = lo > 32767 ? 32767 : lo < -32768 ? -32768 : lo;
+	hi = hi > 32767 ? 32767 : hi < -32768 ? -32768 : hi;
+	return ((uint32_t)hi << 16) | (lo & 0xFFFF);
+#else
 	int32_t out;
 	asm volatile("qadd16 %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes (((a[31:16] - b[31:16]) << 16) | (a[15:0 - b[15:0]))  (saturates)
 static inline int32_t signed_subtract_16_and_16(int32_t a, int32_t b) __attribute__((always_inline, unused));
 static inline int32_t signed_subtract_16_and_16(int32_t a, int32_t b)
 {
+#if defined(DSPINST_HOST)
+	int32_t lo = (int16_t)a - (int16_t)b;
+	int32_t hi = (int16_t)((uint32_t)a >> 16) - (int16_t)((uint32_t)b >> 16);
+	lo = lo > 32767 ? 32767 : lo < -32768 ? -32768 : lo;
+	hi = hi > 32767 ? 32767 : hi < -32768 ? -32768 : hi;
+	return ((uint32_t)hi << 16) | (lo & 0xFFFF);
+#else
 	int32_t out;
 	asm volatile("qsub16 %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes out = (((a[31:16]+b[31:16])/2) <<16) | ((a[15:0]+b[15:0])/2)
 static inline int32_t signed_halving_add_16_and_16(int32_t a, int32_t b) __attribute__((always_inline, unused));
 static inline int32_t signed_halving_add_16_and_16(int32_t a, int32_t b)
 {
+#if defined(DSPINST_HOST)
+	int32_t lo = ((int16_t)a + (int16_t)b) >> 1;
+	int32_t hi = ((int16_t)((uint32_t)a >> 16) + (int16_t)((uint32_t)b >> 16)) >> 1;
+	return ((uint32_t)hi << 16) | (lo & 0xFFFF);
+#else
 	int32_t out;
 	asm volatile("shadd16 %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes out = (((a[31:16]-b[31:16])/2) <<16) | ((a[15:0]-b[15:0])/2)
 static inline int32_t signed_halving_subtract_16_and_16(int32_t a, int32_t b) __attribute__((always_inline, unused));
 static inline int32_t signed_halving_subtract_16_and_16(int32_t a, int32_t b)
 {
+#if defined(DSPINST_HOST)
+	int32_t lo = ((int16_t)a - (int16_t)b) >> 1;
+	int32_t hi = ((int16_t)((uint32_t)a >> 16) - (int16_t)((uint32_t)b >> 16)) >> 1;
+	return ((uint32_t)hi << 16) | (lo & 0xFFFF);
+#else
 	int32_t out;
 	asm volatile("shsub16 %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes (sum + ((a[31:0] * b[15:0]) >> 16))
 static inline int32_t signed_multiply_accumulate_32x16b(int32_t sum, int32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t signed_multiply_accumulate_32x16b(int32_t sum, int32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (uint32_t)sum + (uint32_t)(((int64_t)a * (int16_t)(b & 0xFFFF)) >> 16);
+#else
 	int32_t out;
 	asm volatile("smlawb %0, %2, %3, %1" : "=r" (out) : "r" (sum), "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes (sum + ((a[31:0] * b[31:16]) >> 16))
 static inline int32_t signed_multiply_accumulate_32x16t(int32_t sum, int32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t signed_multiply_accumulate_32x16t(int32_t sum, int32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (uint32_t)sum + (uint32_t)(((int64_t)a * (int16_t)(b >> 16)) >> 16);
+#else
 	int32_t out;
 	asm volatile("smlawt %0, %2, %3, %1" : "=r" (out) : "r" (sum), "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes logical and, forces compiler to allocate register and use single cycle instruction
 static inline uint32_t logical_and(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline uint32_t logical_and(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return a & b;
+#else
 	asm volatile("and %0, %1" : "+r" (a) : "r" (b));
 	return a;
+#endif
 }
 
 // computes ((a[15:0] * b[15:0]) + (a[31:16] * b[31:16]))
 static inline int32_t multiply_16tx16t_add_16bx16b(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t multiply_16tx16t_add_16bx16b(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (uint32_t)((int16_t)a * (int16_t)b) + (uint32_t)((int16_t)(a >> 16) * (int16_t)(b >> 16));
+#else
 	int32_t out;
 	asm volatile("smuad %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes ((a[15:0] * b[31:16]) + (a[31:16] * b[15:0]))
 static inline int32_t multiply_16tx16b_add_16bx16t(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t multiply_16tx16b_add_16bx16t(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (uint32_t)((int16_t)a * (int16_t)(b >> 16)) + (uint32_t)((int16_t)(a >> 16) * (int16_t)b);
+#else
 	int32_t out;
 	asm volatile("smuadx %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // // computes sum += ((a[15:0] * b[15:0]) + (a[31:16] * b[31:16]))
 static inline int64_t multiply_accumulate_16tx16t_add_16bx16b(int64_t sum, uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return sum + (int16_t)a * (int16_t)b + (int16_t)(a >> 16) * (int16_t)(b >> 16);
+#else
 	asm volatile("smlald %Q0, %R0, %1, %2" : "+r" (sum) : "r" (a), "r" (b));
 	return sum;
+#endif
 }
 
 // // computes sum += ((a[15:0] * b[31:16]) + (a[31:16] * b[15:0]))
 static inline int64_t multiply_accumulate_16tx16b_add_16bx16t(int64_t sum, uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return sum + (int16_t)a * (int16_t)(b >> 16) + (int16_t)(a >> 16) * (int16_t)b;
+#else
 	asm volatile("smlaldx %Q0, %R0, %1, %2" : "+r" (sum) : "r" (a), "r" (b));
 	return sum;
+#endif
 }
 
 // computes ((a[15:0] * b[15:0])
 static inline int32_t multiply_16bx16b(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t multiply_16bx16b(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (int16_t)a * (int16_t)b;
+#else
 	int32_t out;
 	asm volatile("smulbb %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes ((a[15:0] * b[31:16])
 static inline int32_t multiply_16bx16t(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t multiply_16bx16t(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (int16_t)a * (int16_t)(b >> 16);
+#else
 	int32_t out;
 	asm volatile("smulbt %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes ((a[31:16] * b[15:0])
 static inline int32_t multiply_16tx16b(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t multiply_16tx16b(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (int16_t)(a >> 16) * (int16_t)b;
+#else
 	int32_t out;
 	asm volatile("smultb %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes ((a[31:16] * b[31:16])
 static inline int32_t multiply_16tx16t(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t multiply_16tx16t(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	return (int16_t)(a >> 16) * (int16_t)(b >> 16);
+#else
 	int32_t out;
 	asm volatile("smultt %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 // computes (a - b), result saturated to 32 bit integer range
 static inline int32_t substract_32_saturate(uint32_t a, uint32_t b) __attribute__((always_inline, unused));
 static inline int32_t substract_32_saturate(uint32_t a, uint32_t b)
 {
+#if defined(DSPINST_HOST)
+	int64_t out = (int64_t)(int32_t)a - (int32_t)b;
+	if (out > 2147483647LL) return 2147483647;
+	if (out < -2147483648LL) return -2147483647 - 1;
+	return out;
+#else
 	int32_t out;
 	asm volatile("qsub %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
 	return out;
+#endif
 }
 
 //get Q from PSR
 static inline uint32_t get_q_psr(void) __attribute__((always_inline, unused));
 static inline uint32_t get_q_psr(void)
 {
+#if defined(DSPINST_HOST)
+	return 0;
+#else
   uint32_t out;
   asm ("mrs %0, APSR" : "=r" (out));
   return (out & 0x8000000)>>27;
+#endif
 }
 
 //clear Q BIT in PSR
 static inline void clr_q_psr(void) __attribute__((always_inline, unused));
 static inline void clr_q_psr(void)
 {
+#if !defined(DSPINST_HOST)
   uint32_t t;
   asm ("mov %[t],#0\n"
        "msr APSR_nzcvq,%0\n" : [t] "=&r" (t)::"cc"); 
+#endif
 }
 
 #endif
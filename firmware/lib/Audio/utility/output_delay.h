@@ -0,0 +1,121 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef output_delay_h_
+#define output_delay_h_
+
+#include "AudioStream.h"
+
+// Delayed playout for the I2S and DAC interrupts, AudioOutputI2S and
+// AudioOutputAnalog delaySamples(). The state of a channel is passed in,
+// so the host tests run this code as it is: the queue (first, second),
+// the read offset and "prev", the block before first, held until the
+// delay has played its tail. A missing block plays as silence, the tail
+// of the previous one still plays first. Blocks the functions are done
+// with are returned, the caller releases them outside its own state
+// changes.
+
+// Half a block of one channel, delayed: index counts from the start of
+// the previous block, a missing block plays as silence.
+static inline void interleave_delayed(int16_t *dest, const audio_block_t *prev,
+  const audio_block_t *cur, uint32_t index)
+{
+	const int16_t *src;
+	uint32_t n, i = 0;
+
+	if (index < AUDIO_BLOCK_SAMPLES) {
+		n = AUDIO_BLOCK_SAMPLES - index;
+		if (n > AUDIO_BLOCK_SAMPLES/2) n = AUDIO_BLOCK_SAMPLES/2;
+		src = prev ? prev->data + index : NULL;
+		for (; i < n; i++, dest += 2) *dest = src ? *src++ : 0;
+		index = 0;
+	} else {
+		index -= AUDIO_BLOCK_SAMPLES;
+	}
+	src = cur ? cur->data + index : NULL;
+	for (; i < AUDIO_BLOCK_SAMPLES/2; i++, dest += 2) *dest = src ? *src++ : 0;
+}
+
+// One I2S interrupt, one channel: half a block into every other sample
+// of dest, delay 1 to AUDIO_BLOCK_SAMPLES. An idle channel, no block and
+// no tail, keeps its offset so the next block starts at 0.
+static inline audio_block_t * output_delayed_half(int16_t *dest,
+  audio_block_t **first, audio_block_t **second, audio_block_t **prev,
+  uint16_t *offset, uint32_t delay)
+{
+	audio_block_t *cur = *first, *done;
+	uint32_t off = *offset;
+
+	if (!cur && !*prev) {
+		interleave_delayed(dest, NULL, NULL, 0);
+		return NULL;
+	}
+	interleave_delayed(dest, *prev, cur, off + AUDIO_BLOCK_SAMPLES - delay);
+	off += AUDIO_BLOCK_SAMPLES/2;
+	if (off < AUDIO_BLOCK_SAMPLES) {
+		*offset = off;
+		return NULL;
+	}
+	*offset = 0;
+	done = *prev;
+	*prev = cur;
+	*first = *second;
+	*second = NULL;
+	return done;
+}
+
+// One DAC interrupt: a whole block of 12 bit DAC values, delay 0 to
+// AUDIO_BLOCK_SAMPLES.
+static inline audio_block_t * output_dac_block(uint16_t *dest,
+  audio_block_t **first, audio_block_t **second, audio_block_t **prev,
+  uint32_t delay)
+{
+	const int16_t *src;
+	audio_block_t *cur = *first, *done = *prev;
+	uint16_t *end = dest + AUDIO_BLOCK_SAMPLES;
+	uint32_t n = delay;
+
+	if (done) {
+		src = done->data + AUDIO_BLOCK_SAMPLES - n;
+		for (; n; n--) *dest++ = ((*src++) + 32767) >> 4;
+	}
+	if (cur) {
+		for (; n; n--) *dest++ = 2047;
+		src = cur->data;
+		while (dest < end) {
+			// TODO: this should probably dither
+			*dest++ = ((*src++) + 32767) >> 4;
+		}
+		*first = *second;
+		*second = NULL;
+		if (!delay) {
+			*prev = NULL;
+			return cur;
+		}
+	}
+	while (dest < end) *dest++ = 2047;
+	*prev = cur;
+	return done;
+}
+
+#endif
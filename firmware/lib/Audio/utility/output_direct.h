@@ -0,0 +1,83 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef output_direct_h_
+#define output_direct_h_
+
+#include "AudioStream.h"
+
+// Block pair bookkeeping of AudioOutputI2Sdirect. The DMA plays slot
+// "playing" and has slot "queued" chained behind it; the TCDs are the
+// caller's, these functions only decide which slot a pair goes to and
+// which pair is finished, so the host tests run them as they are. Both
+// are called with the interrupt off or from the interrupt.
+
+struct output_direct_t {
+	audio_block_t *slot_left[2];
+	audio_block_t *slot_right[2];
+	int8_t playing;		// slot the DMA reads, -1 = silence
+	int8_t queued;		// slot chained to play next, -1 = none
+};
+
+#define OUTPUT_DIRECT_INIT { {NULL, NULL}, {NULL, NULL}, -1, -1 }
+
+// update(): the slot the pair goes to, -1 when a pair is already waiting
+// or right is out of SOFF reach of left (diff = right - left in bytes),
+// the caller then releases the pair.
+static inline int output_direct_take(output_direct_t *d, audio_block_t *left,
+  audio_block_t *right, int32_t diff)
+{
+	int s;
+
+	if (d->queued >= 0 || diff > 32767 || diff < -32768) return -1;
+	s = (d->playing == 0) ? 1 : 0;
+	d->slot_left[s] = left;
+	d->slot_right[s] = right;
+	d->queued = s;
+	return s;
+}
+
+// isr(): the DMA has loaded the chained TCD, the queued pair or the
+// silence one. The pair it finished is returned in left and right, NULL
+// after silence, for the caller to release.
+static inline void output_direct_done(output_direct_t *d, bool silence,
+  audio_block_t **left, audio_block_t **right)
+{
+	int done = d->playing;
+
+	if (silence) {
+		d->playing = -1;
+	} else {
+		d->playing = d->queued;
+		d->queued = -1;
+	}
+	*left = *right = NULL;
+	if (done >= 0) {
+		*left = d->slot_left[done];
+		*right = d->slot_right[done];
+		d->slot_left[done] = NULL;
+		d->slot_right[done] = NULL;
+	}
+}
+
+#endif
@@ -0,0 +1,72 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2017, Piotr Zapart, www.hexeguitar.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef rfft_split_h_
+#define rfft_split_h_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" const int16_t rfft_sine_quarter_table[];
+#else
+extern const int16_t rfft_sine_quarter_table[];
+#endif
+
+// Real input FFT: N real samples are treated as N/2 complex values
+// (even samples = real part, odd samples = imaginary part) and run
+// through a N/2 point complex FFT.  The split step below recovers bin k
+// of the N point real spectrum from the half size result z:
+//
+//   X[k] = (A - j*W*B) / 4,  A = Z[k] + conj(Z[M-k]),  B = Z[k] - conj(Z[M-k])
+//
+// M = N/2, W = exp(-j*2*pi*k/N), step = 1024/N.  The extra 1/2 in the
+// scaling makes the result match a full N point q15 CFFT (output / N),
+// so the existing read() scaling stays valid.  Returns |X[k]|^2.
+static inline uint32_t rfft_split_magsq(const int16_t *z, unsigned int k,
+	unsigned int m, unsigned int step) __attribute__((always_inline, unused));
+static inline uint32_t rfft_split_magsq(const int16_t *z, unsigned int k,
+	unsigned int m, unsigned int step)
+{
+	unsigned int mk = (m - k) & (m - 1);	// M-k, Z[M] wraps to Z[0]
+	int32_t zr = z[2*k];
+	int32_t zi = z[2*k+1];
+	int32_t cr = z[2*mk];
+	int32_t ci = -z[2*mk+1];
+	int32_t ar = zr + cr;
+	int32_t ai = zi + ci;
+	int32_t br = zr - cr;
+	int32_t bi = zi - ci;
+	unsigned int t = k * step;		// angle, 1024 steps per cycle
+	int32_t s, c;
+	if (t <= 256) {
+		s = rfft_sine_quarter_table[t];
+		c = rfft_sine_quarter_table[256 - t];
+	} else {
+		s = rfft_sine_quarter_table[512 - t];
+		c = -rfft_sine_quarter_table[t - 256];
+	}
+	int32_t xr = (ar + ((c * bi) >> 15) - ((s * br) >> 15)) >> 2;
+	int32_t xi = (ai - ((c * br) >> 15) - ((s * bi) >> 15)) >> 2;
+	return (uint32_t)(xr * xr) + (uint32_t)(xi * xi);
+}
+
+#endif
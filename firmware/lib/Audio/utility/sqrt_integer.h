@@ -35,6 +35,11 @@ extern const uint16_t sqrt_integer_guess_table[];
 inline uint32_t sqrt_uint32(uint32_t in) __attribute__((always_inline,unused));
 inline uint32_t sqrt_uint32(uint32_t in)
 {
+#if !defined(KINETISK) && !defined(KINETISL)
+	// 0 takes the last table entry, 0, and 0/0 gives 0 on a Cortex-M
+	// but traps on a PC (and __builtin_clz(0) is undefined there)
+	if (in == 0) return 0;
+#endif
 	uint32_t n = sqrt_integer_guess_table[__builtin_clz(in)];
 	n = ((in / n) + n) / 2;
 	n = ((in / n) + n) / 2;
@@ -45,6 +50,11 @@ inline uint32_t sqrt_uint32(uint32_t in)
 inline uint32_t sqrt_uint32_approx(uint32_t in) __attribute__((always_inline,unused));
 inline uint32_t sqrt_uint32_approx(uint32_t in)
 {
+#if !defined(KINETISK) && !defined(KINETISL)
+	// 0 takes the last table entry, 0, and 0/0 gives 0 on a Cortex-M
+	// but traps on a PC (and __builtin_clz(0) is undefined there)
+	if (in == 0) return 0;
+#endif
 	uint32_t n = sqrt_integer_guess_table[__builtin_clz(in)];
 	n = ((in / n) + n) / 2;
 	n = ((in / n) + n) / 2;
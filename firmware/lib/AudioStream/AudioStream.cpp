@@ -40,6 +40,7 @@ uint16_t AudioStream::cpu_cycles_total = 0;
 uint16_t AudioStream::cpu_cycles_total_max = 0;
 uint8_t AudioStream::memory_used = 0;
 uint8_t AudioStream::memory_used_max = 0;
+float AudioStream::sample_rate = AUDIO_SAMPLE_RATE_EXACT;
 
 
 
@@ -219,6 +220,20 @@ void AudioStream::update_stop(void)
 
 AudioStream * AudioStream::first_update = NULL;
 
+// New sample rate, every object gets sampleRateChanged() in update order.
+// Call it with the audio library held off, AudioNoInterrupts(), so no
+// update() runs with a half recomputed graph.
+void AudioStream::setSampleRate(float rate)
+{
+	AudioStream *p;
+
+	if (rate <= 0.0f || rate == sample_rate) return;
+	sample_rate = rate;
+	for (p = first_update; p; p = p->next_update) {
+		p->sampleRateChanged();
+	}
+}
+
 void software_isr(void) // AudioStream::update_all()
 {
 	AudioStream *p;
@@ -66,6 +66,12 @@
 
 #define AUDIO_SAMPLE_RATE AUDIO_SAMPLE_RATE_EXACT
 
+// AUDIO_SAMPLE_RATE_EXACT is only the rate at startup. When the sketch
+// reprograms the I2S clock it tells the library with
+// AudioStream::setSampleRate(), objects compute their increments and
+// coefficients from AudioSampleRate().
+#define AudioSampleRate() (AudioStream::sample_rate)
+
 #ifndef __ASSEMBLER__
 class AudioStream;
 class AudioConnection;
@@ -150,6 +156,8 @@ public:
 	static uint16_t cpu_cycles_total_max;
 	static uint8_t memory_used;
 	static uint8_t memory_used_max;
+	static float sample_rate;
+	static void setSampleRate(float rate);
 protected:
 	bool active;
 	unsigned char num_inputs;
@@ -163,6 +171,9 @@ protected:
 	static void update_all(void) { NVIC_SET_PENDING(IRQ_SOFTWARE); }
 	friend void software_isr(void);
 	friend class AudioConnection;
+	// called by setSampleRate() with the audio library held off, objects
+	// that cache rate dependent values recompute them here
+	virtual void sampleRateChanged(void) { }
 private:
 	AudioConnection *destination_list;
 	audio_block_t **inputQueue;
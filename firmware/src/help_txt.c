@@ -41,8 +41,9 @@
 
 const char * help_txt[]=
 {
-    "A: Waveform generator\n\n1:100Hz   2:Oct Up\n3: 1kHz   8:Oct Down\n7: 5kHz   6:Note Up\n9:10kHz   4:Note Down\n0:18kHz   5:A=440Hz\n*:Wave    #:Duty",
-    "B: Sine Sweep\n\n0-9: Start sweep\nNumber sets the speed\n*:Pause\n#:Flip direction",
+    "A: Waveform generator\n\n1:100Hz   2:Oct Up\n3: 1kHz   8:Oct Down\n7: 5kHz   6:Note Up\n9:10kHz   4:Note Down\n0:18kHz   5:A=440Hz\n*:Wave #:Duty A:Loop",
+    "B: Sine Sweep\n\n0-9: Start sweep\nNumber sets the speed\n*:Pause\n#:Flip direction\nB:1kHz ref on pin A14",
     "C: Wav file player\n\n44.1kHz stereo 16bit\nnaming: waveXX.wav\nXX=00-99\n0-9:Play file 00-09\n*:Enter new file No\n#:Stop/Mute",
-    "D: Noise generator\n\n1:White noise\n2:Pink noise\n#:Mute/OFF"
+    "D: Noise generator\n1:White noise\n2:Pink noise\n3:MLS, 2^16-1 period\n4/5:Periodic white/pink\n#:Mute/OFF\nD:Loopback analyzer",
+    "D: Loopback analyzer\nLine out -> line in\n1:THD+N at 1kHz\n2:Freq/phase response\n3:Latency 4:Fit EQ\n5:EQ on/off\n#:Stop/Mute\nD:Noise generator"
 };
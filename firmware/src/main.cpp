@@ -93,7 +93,8 @@ typedef enum
     SD_WAV_PLAY,
     SIG_GEN,
     NOISE_GEN,
-    SIN_SWEEP
+    SIN_SWEEP,
+    ANALYZER
 }engineState_t;
 
 engineState_t engineState = SIG_GEN;
@@ -108,18 +109,23 @@ typedef enum
     SIGNAL_GEN,
     WHITE_NOISE,
     PINK_NOISE,
-    SINUS_SWEEP
+    SINUS_SWEEP,
+    MLS_NOISE
 }outputChannel_t;
-// available output channels:
-#define WAV_PLAY_CH     0
-#define WAV_PLAY_CHSDA  0       //wav player A (SD mixer)
-#define WAV_PLAY_CHSDB  1       //wav player B (SD mixer)
+// available output channels, inputs of mixerLR:
+#define WAV_PLAY_CHAL   0       //wav player A, left
+#define WAV_PLAY_CHAR   1       //wav player A, right
+#define WAV_PLAY_CHBL   2       //wav player B, left
+#define WAV_PLAY_CHBR   3       //wav player B, right
+#define SIG_GEN_CH      4       //mono sources, one input for both sides
+#define WHITE_NOISE_CH  5
+#define SIN_SWEEP_CH    6
+#define PINK_NOISE_CH   7
+#define MLS_NOISE_CH    8
+#define OUT_MIX_INPUTS  9
 
-#define SIG_GEN_CH      1
-#define WHITE_NOISE_CH  2
-#define SIN_SWEEP_CH    3
-#define PINK_NOISE_CH   0       //output mixer: pink noise ch = wav player ch
-#define PINK_NOISE_CHSD 2       //SD out mixer: pin noise ch = 2
+#define DAC_SIG_GEN_CH  0       //DAC mixer: waveform generator
+#define DAC_REF_CH      1       //DAC mixer: reference square
 
 #define RELAY_CTRL      20      //relay switching the output
                                 //between the codec and 12bit DAC
@@ -133,7 +139,7 @@ typedef enum
 
 const char * engineStateTxt[] =
 {
-    "WAV PLAYER","SIG GEN","NOISE","SIN SWEEP"
+    "WAV PLAYER","SIG GEN","NOISE","SIN SWEEP","ANALYZER"
 };
 //##############################################################################
 // ### WAV player ###
@@ -177,6 +183,9 @@ char currentFile[] = "wave00.wav";
 #define SIGGEN_MAX_OCTAVE       8
 #define SIGGEN_AMPL_DEFAULT     1
 #define SIGGEN_F_LIMIT          8000
+#define SIGGEN_GLIDE_MS         5               //note change glide time, 0=jump
+#define SIGGEN_LOOP_I2S_FS      96000           //HF loop rates, SGTL5000 max is 96kHz,
+#define SIGGEN_LOOP_DAC_FS      192000          //the 12bit DAC goes up to 192kHz
 #define NOTE_C                  0
 #define NOTE_B                  11
 #define NOTE_A                  9
@@ -196,6 +205,7 @@ uint8_t sigGen_oct = 4;         //default octave is 4
 short sigGen_wave = 0;
 float sigGen_duty = 1.0;
 float sigGen_freq = noteFreqTable[sigGen_oct][sigGen_note];
+bool sigGenLoop = false;        //HF loop mode, 2nd press of A
 //##############################################################################
 // ### Sin Sweep Generator ###
 #define SINSWEEP_DIR_UP     1
@@ -204,6 +214,16 @@ float sigGen_freq = noteFreqTable[sigGen_oct][sigGen_note];
 const int sinSweepStartF = 16;
 const int sinSweepEndF = 22000;
 const float sinSweepLvl = 1.0;
+//##############################################################################
+// ### Dual output: sweep on the codec, reference square on the 12bit DAC ###
+// AudioOutputAnalog::sync() puts the DAC half a block behind the codec,
+// the codec is delayed to match. The SGTL5000 filter delay is not in here,
+// trim OUT_ALIGN_I2S/DAC against a scope if it matters.
+#define DAC_REF_FREQ        1000
+#define DAC_REF_AMPL        1.0
+#define OUT_ALIGN_I2S       (AUDIO_BLOCK_SAMPLES / 2)  //codec delay [samples]
+#define OUT_ALIGN_DAC       0                          //DAC delay [samples]
+bool dacRefOn = false;
 const float sinSweepTime_ms[10] =
 {
       0.1, 0.2, 0.5,   1,   2,
@@ -211,6 +231,121 @@ const float sinSweepTime_ms[10] =
 };
 int sinSweepDir = SINSWEEP_DIR_UP;
 //##############################################################################
+// ### Noise Generator ###
+#define NOISE_MLS_ORDER     16      //MLS period 2^16-1 samples, ~1.5s
+#define NOISE_PERIOD_BITS   16      //periodic white/pink noise, 2^16 samples
+//##############################################################################
+// ### Output monitor ###
+#define MONITOR_KEY         '#'     //hold to toggle, short press keeps the old function
+#define MONITOR_REFRESH_MS  50      //screen refresh period
+#define MONITOR_FFT_HOLDOFF 8       //blocks skipped between two FFTs
+#define MONITOR_FFT_IDLE    255     //FFT holdoff while the monitor is off
+#define MONITOR_FFT_AVG     2       //number of spectra averaged together
+#define MONITOR_DB_RANGE    72.0    //spectrum display range in dB
+#define MONITOR_SCOPE_Y     24      //scope trace center line
+#define MONITOR_SCOPE_H     12      //scope trace half height
+#define MONITOR_SPECT_H     25      //spectrum bars max height
+#define MONITOR_CLIP_LVL    0.999   //peak level treated as clipping
+
+bool monitorMode = false;
+bool monitorSkipRelease = false;
+elapsedMillis monitorTimer;
+int16_t monitorTrace[AUDIO_SCOPE_SAMPLES];
+bool monitorClipL = false;
+bool monitorClipR = false;
+//##############################################################################
+// ### Loopback analyzer ###
+// line out has to be connected to line in, left channel is measured
+#define ANALYZER_THDN_FREQ  1000.0  //THD+N test frequency
+#define ANALYZER_LEVEL      0.5     //test tone amplitude, leaves headroom for the ADC
+#define ANALYZER_CYCLES     20      //periods per measurement window
+#define ANALYZER_HARMONICS  10      //harmonics printed with THD+N, incl. fundamental
+#define ANALYZER_LAT_FREQ   100.0   //latency test square wave
+#define ANALYZER_LAT_LVL    0.05    //latency onset threshold
+#define ANALYZER_LAT_MUTE   20      //ms of silence before the latency test
+#define ANALYZER_FR_STEPS   31
+
+const float analyzerFreqs[ANALYZER_FR_STEPS] =      //1/3 octave steps
+{
+       20,    25,  31.5,    40,    50,    63,    80,   100,
+      125,   160,   200,   250,   315,   400,   500,   630,
+      800,  1000,  1250,  1600,  2000,  2500,  3150,  4000,
+     5000,  6300,  8000, 10000, 12500, 16000, 20000
+};
+typedef enum
+{
+    ANALYZER_IDLE,
+    ANALYZER_THDN,
+    ANALYZER_RESPONSE,
+    ANALYZER_LATENCY
+}analyzerTask_t;
+analyzerTask_t analyzerTask = ANALYZER_IDLE;
+uint8_t analyzerStep = 0;
+float analyzerFreq = 0;             //local oscillator frequency
+int32_t analyzerLatency = -1;       //last measured latency in samples, -1 = unknown
+//##############################################################################
+// ### Output calibration EQ ###
+/*  Biquad cascade between the mixers and the faders, fitted to the inverse
+ *  of the analyzer's last response run (2 then 4), so the line out is flat
+ *  without the relay/DAC detour. The loopback includes the ADC path, the
+ *  fit corrects the round trip. Fitted on the left channel, loaded into both.
+ *  Valid only at the rate it was fitted at, bypassed at any other.
+ */
+#define CAL_EQ_STAGES       8       //biquads per channel
+#define CAL_EQ_MAX_BOOST    6.0     //dB
+#define CAL_EQ_FMIN         100.0   //corrected band, the ADC high pass shows below
+#define CAL_EQ_FMAX         20000.0
+float calEqGain[ANALYZER_FR_STEPS]; //last response run without the EQ, dB
+bool calEqMeasured = false;
+eqfit_stage_t calEqStages[CAL_EQ_STAGES];
+uint32_t calEqCount = 0;
+float calEqLevel = 0;               //headroom for the boosts, dB
+uint32_t calEqFs = 0;               //I2S rate of the fit, 0 = not fitted
+bool calEqOn = false;
+int32_t calEqBankL[AUDIO_BIQUAD_WORDS(CAL_EQ_STAGES)];
+int32_t calEqBankR[AUDIO_BIQUAD_WORDS(CAL_EQ_STAGES)];
+//##############################################################################
+// ### Mode switching ###
+/*  Sample rate and output channel changes are staged with reconfigI2SFreq()
+ *  and reconfigChannel(), reconfigCommit() fades the outputs out, the
+ *  switch is then driven from loop() by reconfigUpdate(): the changes are
+ *  applied together on one block boundary once the outputs are silent,
+ *  then the outputs fade back in. Nothing waits in between.
+ */
+#define I2S_FS_GEN          (44117 * 2) //sig gen, sweep, analyzer, 96000 works too
+#define I2S_FS_WAV          44117       //wav player, noise
+#define RECONFIG_FADE_MS    4       //fade out/in time
+#define RECONFIG_DRAIN_MS   6       //faded out blocks still in the DMA buffers
+#define RECONFIG_WAIT_US    20000   //longest wait for a fade, it only moves
+                                    //while blocks reach the faders
+//#define RECONFIG_REPORT           //print the switch times, the I2S ISR and the
+                                    //audio update cost of the state left over Serial
+//#define I2S_DIRECT                //zero copy I2S output, for its ISR cycles in the
+                                    //report, no loop mode or dual output delay
+typedef struct
+{
+    uint32_t        i2sFreq;        //0 = no change
+    outputChannel_t channel;
+    bool            channelSet;
+    void            (*after)(void); //run once applied, before the fade in
+}reconfig_t;
+reconfig_t reconfig = {0, MUTE_ALL, false, NULL};
+typedef enum
+{
+    RECONFIG_IDLE,
+    RECONFIG_FADE_OUT,              //waiting for both faders to be silent
+    RECONFIG_DRAIN,                 //waiting for the DMA buffers to play out
+    RECONFIG_FADE_IN                //applied, waiting for the fade in
+}reconfigState_t;
+reconfigState_t reconfigState = RECONFIG_IDLE;
+uint32_t i2sFreqNow = 0;
+uint32_t reconfigSwitch_us = 0;     //last commit, fade out to fade in done
+uint32_t reconfigSilent_us = 0;     //last commit, faded out to fade in start
+uint32_t reconfigMute_us = 0;       //last commit, time the ISR was held off
+uint32_t reconfigStart_us = 0;      //micros() of the running commit
+uint32_t reconfigFaded_us = 0;      //micros() when the fade out ended
+outputChannel_t channelNow = MUTE_ALL;  //set by mixerApply()
+//##############################################################################
 // ### 4x4 keypad config ###
 const byte ROWS = 4; //four rows
 const byte COLS = 4; //three columns
@@ -232,8 +367,20 @@ void handleKeyPress(char key);                                  //main key press
 bool keypadHandleWavPlayer(char key);                           //wav player key press handler
 
 bool mixerSetChannel(outputChannel_t ch);
+bool mixerApply(outputChannel_t ch);
+void reconfigI2SFreq(uint32_t freq);
+void reconfigChannel(outputChannel_t ch);
+void reconfigCommit(void (*after)(void) = NULL);
+void reconfigApply(void);
+void reconfigUpdate(void);
+bool reconfigBusy(void);
 
-bool setSigGen(float freq, short waveform);                     //mode A - Waveform generator
+bool setSigGen(float freq, short waveform, float glide=SIGGEN_GLIDE_MS);   //mode A - Waveform generator
+void sigGenRestart(void);
+void sigGenLoopStart(void);
+void sigGenLoopRender(void);
+void sigGenLoopStop(void);
+void dacRefSet(bool on);
 bool playSinSweep(float time_ms, int dir);                      //mode B - Sine Sweep
 bool playFile(const char *filename, wavPlayerNo_t playerNo);    //mode C - WAV player
 void playNewFile(void);
@@ -256,43 +403,75 @@ void displayBargraph(int min, int max, int value);
 void displayUpdate(void);
 void displayHelpTxt(uint8_t mode);
 void displayStartScreen(engineState_t mode);
+void displayMonitor(void);
+void monitorSet(bool on);
+void displayAnalyzer(void);
+void analyzerStart(analyzerTask_t task);
+void analyzerStop(void);
+void analyzerMeasure(float freq);
+void analyzerUpdate(void);
+void calEqFit(void);
+void calEqSet(bool on);
 
 void ISR_checkWavePosition(void);
 //##############################################################################
 // GUItool: begin automatically generated code
 AudioSynthNoisePink      pink;           //xy=419,310
+AudioSynthMLS            mls;            //xy=419,350
 AudioPlaySdWav           playSdWavB;     //xy=431,193
 AudioPlaySdWav           playSdWavA;     //xy=432,120
-AudioMixer4              mixerSD_R;      //xy=645,205
-AudioMixer4              mixerSD_L;      //xy=647,133
 AudioSynthToneSweep      tonesweep;      //xy=651,353
 AudioSynthWaveform       wave;           //xy=656,263
 AudioSynthNoiseWhite     noise;          //xy=658,311
-AudioMixer4              mixerL;         //xy=962,230
-AudioMixer4              mixerDAC; //xy=963,158
-AudioMixer4              mixerR;         //xy=965,302
+AudioMixerStereo<OUT_MIX_INPUTS> mixerLR; //xy=962,230
+AudioMixer<2>            mixerDAC;       //xy=963,158
+AudioFilterBiquadBank    calEqL(calEqBankL, CAL_EQ_STAGES); //xy=1010,230
+AudioFilterBiquadBank    calEqR(calEqBankR, CAL_EQ_STAGES); //xy=1010,302
+AudioEffectFadeStereo    fadeLR;         //xy=1060,230
+AudioEffectFade          fadeDAC;        //xy=1060,158
+#ifdef I2S_DIRECT
+AudioOutputI2Sdirect     i2s;
+#else
 AudioOutputI2S           i2s;            //xy=1141,228
+#endif
 AudioOutputAnalog        dac12;           //xy=1142,178
-AudioConnection          patchCord1(pink, 0, mixerSD_L, 2);
-AudioConnection          patchCord2(pink, 0, mixerSD_R, 2);
-AudioConnection          patchCord3(playSdWavB, 0, mixerSD_L, 1);
-AudioConnection          patchCord4(playSdWavB, 1, mixerSD_R, 1);
-AudioConnection          patchCord5(playSdWavA, 0, mixerSD_L, 0);
-AudioConnection          patchCord6(playSdWavA, 1, mixerSD_R, 0);
-AudioConnection          patchCord7(mixerSD_R, 0, mixerR, 0);
-AudioConnection          patchCord8(mixerSD_L, 0, mixerL, 0);
-AudioConnection          patchCord9(tonesweep, 0, mixerL, 3);
-AudioConnection          patchCord10(tonesweep, 0, mixerR, 3);
-AudioConnection          patchCord11(wave, 0, mixerL, 1);
-AudioConnection          patchCord12(wave, 0, mixerR, 1);
-AudioConnection          patchCord13(wave, 0, mixerDAC, 0);
-AudioConnection          patchCord14(noise, 0, mixerL, 2);
-AudioConnection          patchCord15(noise, 0, mixerR, 2);
-AudioConnection          patchCord16(mixerL, 0, i2s, 0);
-AudioConnection          patchCord17(mixerDAC, dac12);
-AudioConnection          patchCord18(mixerR, 0, i2s, 1);
+AudioConnection          patchCord1(playSdWavA, 0, mixerLR, WAV_PLAY_CHAL);
+AudioConnection          patchCord2(playSdWavA, 1, mixerLR, WAV_PLAY_CHAR);
+AudioConnection          patchCord3(playSdWavB, 0, mixerLR, WAV_PLAY_CHBL);
+AudioConnection          patchCord4(playSdWavB, 1, mixerLR, WAV_PLAY_CHBR);
+AudioConnection          patchCord5(wave, 0, mixerLR, SIG_GEN_CH);
+AudioConnection          patchCord6(noise, 0, mixerLR, WHITE_NOISE_CH);
+AudioConnection          patchCord7(tonesweep, 0, mixerLR, SIN_SWEEP_CH);
+AudioConnection          patchCord8(pink, 0, mixerLR, PINK_NOISE_CH);
+AudioConnection          patchCord9(mls, 0, mixerLR, MLS_NOISE_CH);
+AudioConnection          patchCord10(wave, 0, mixerDAC, DAC_SIG_GEN_CH);
+AudioConnection          patchCord11(mixerLR, 0, calEqL, 0);
+AudioConnection          patchCord12(mixerDAC, fadeDAC);
+AudioConnection          patchCord13(mixerLR, 1, calEqR, 0);
+AudioAnalyzeFFT256       fftMon;         //xy=1141,366
+AudioAnalyzeScope        scopeMon;       //xy=1140,404
+AudioAnalyzePeak         peakL;          //xy=1134,442
+AudioAnalyzePeak         peakR;          //xy=1134,480
+AudioConnection          patchCord14(mixerLR, 0, fftMon, 0);
+AudioConnection          patchCord15(mixerLR, 0, scopeMon, 0);
+AudioConnection          patchCord16(mixerLR, 0, peakL, 0);
+AudioConnection          patchCord17(mixerLR, 1, peakR, 0);
+AudioInputI2S            i2sIn;          //xy=962,530
+AudioAnalyzeLoopback     loopback;       //xy=1141,518
+AudioConnection          patchCord18(mixerLR, 0, loopback, 0);
+AudioConnection          patchCord19(i2sIn, 0, loopback, 1);
+AudioAnalyzeToneBank     harmonicsMon;   //xy=1141,556
+AudioConnection          patchCord20(i2sIn, 0, harmonicsMon);
+AudioConnection          patchCord21(fadeLR, 0, i2s, 0);
+AudioConnection          patchCord22(fadeDAC, dac12);
+AudioConnection          patchCord23(fadeLR, 1, i2s, 1);
+AudioSynthWaveform       dacRef;         //xy=656,158
+AudioConnection          patchCord24(dacRef, 0, mixerDAC, DAC_REF_CH);
+AudioConnection          patchCord25(calEqL, 0, fadeLR, 0);
+AudioConnection          patchCord26(calEqR, 0, fadeLR, 1);
 AudioControlSGTL5000     sgtl5000_1;     //xy=1140,282
 // GUItool: end automatically generated code
+AudioWaveformLoop        hfLoop;         //HF loop, plays straight from the output DMA
 
 
 //##############################################################################
@@ -307,6 +486,9 @@ Adafruit_SSD1306 display(OLED_RESET);
 // I2S Fs update            by Frank B (https://forum.pjrc.com/threads/38753)
 // WAV player uses standard 44117...Hz Fs
 // Waveform generator (A) and Sine Sweep use 2x44117Hz setiing
+// The audio library follows the I2S rate (AudioSampleRate()), the DAC
+// runs at the same rate and is synced to the I2S after every change,
+// except in the HF loop where it runs on its own
 void setDACFreq(int freq)
 {
     const unsigned config = PDB_SC_TRGSEL(15) | PDB_SC_PDBEN | PDB_SC_CONT | PDB_SC_PDBIE | PDB_SC_DMAEN;
@@ -322,8 +504,10 @@ void SGT_setFs(uint32_t freq)
     //SGTL5000 sampling freq reconfiguration, CHIP_CLK_CTRL register @ 0x0004
     const int CHIP_CLK_CTRL_addr = 0x0004;      //register address
     uint16_t regValue = 0x000C;                 //default library value for 44.1kHz, 256*Fs 0b00 00 01 00
-    if (freq == 44117)          regValue = 0x0004;
-    else if (freq == 44117*2)   regValue = 0x000C;
+    //176.4/192kHz are beyond the SGTL5000, they need another codec
+    if (freq == 44117 || freq == 44100)     regValue = 0x0004;
+    else if (freq == 48000)                 regValue = 0x0008;
+    else if (freq == 44117*2 || freq == 88200 || freq == 96000)   regValue = 0x000C;
 
     Wire.beginTransmission(0x0A);       //stock SGTL5000 I2C  slave address
     Wire.write(CHIP_CLK_CTRL_addr >> 8);
@@ -333,7 +517,10 @@ void SGT_setFs(uint32_t freq)
     Wire.endTransmission();
 }
 
-void setI2SFreq(uint32_t freq)
+/*  I2S_setFs() only writes the MCLK divider, the caller holds the audio
+ *  library off. setI2SFreq() is the standalone version.
+ */
+bool I2S_setFs(uint32_t freq)
 {
     typedef struct
     {
@@ -361,18 +548,138 @@ void setI2SFreq(uint32_t freq)
     #elif (F_PLL==240000000)
     const tmclk clkArr[numfreqs] = {{16, 1875}, {29, 2466}, {32, 1875}, {89, 3784}, {64, 1875}, {147, 3125}, {4, 85}, {32, 625}, {205, 2179}, {8, 85}, {64, 625}, {89, 473}, {16, 85}, {128, 625} };
     #endif
-    AudioNoInterrupts();  // disable audio library momentarily
     for (int f = 0; f < numfreqs; f++)
     {
         if ( freq == samplefreqs[f] )
         {
             while (I2S0_MCR & I2S_MCR_DUF) ;
             I2S0_MDR = I2S_MDR_FRACT((clkArr[f].mult - 1)) | I2S_MDR_DIVIDE((clkArr[f].div - 1));
-            return;
-            SGT_setFs(freq);
+            i2sFreqNow = freq;
+            //MCLK = 256*Fs, the exact rate for the audio library
+            AudioStream::setSampleRate((float)F_PLL * clkArr[f].mult / clkArr[f].div / 256.0);
+            return true;
         }
     }
-    AudioInterrupts();  //
+    return false;
+}
+
+void setI2SFreq(uint32_t freq)
+{
+    bool ok;
+    AudioNoInterrupts();  // disable audio library momentarily
+    ok = I2S_setFs(freq);
+    AudioInterrupts();    // always re-enabled, the codec is set over I2C after
+    if (ok) SGT_setFs(freq);
+}
+//##############################################################################
+//### mode switching ###
+void reconfigI2SFreq(uint32_t freq)
+{
+    reconfig.i2sFreq = freq;
+}
+
+void reconfigChannel(outputChannel_t ch)
+{
+    reconfig.channel = ch;
+    reconfig.channelSet = true;
+}
+/*  Fade out, let the silent blocks reach the outputs, apply the staged
+ *  changes inside one AudioNoInterrupts() section so they all take effect
+ *  on the same block, then fade in. reconfigCommit() only starts the fade
+ *  out, each later step is taken by reconfigUpdate() from loop() once the
+ *  previous one is done. The codec clock register is written over I2C
+ *  after the apply, with the audio library running again. "after" runs
+ *  right after the apply, for work that needs the new rate or channel.
+ */
+void reconfigCommit(void (*after)(void))
+{
+#ifdef RECONFIG_REPORT
+    //the state running until now, steady, nothing fading yet
+    //cpu_cycles_total is kept in units of 16 cycles (CYCCNT >> 4)
+    Serial.print("state "); Serial.print(channelNow);
+    Serial.print("\tsoftware_isr [cycles]: "); Serial.println(AudioStream::cpu_cycles_total << 4);
+#endif
+    reconfig.after = after;
+    if (reconfigState == RECONFIG_FADE_OUT || reconfigState == RECONFIG_DRAIN) return;
+    reconfigStart_us = micros();
+    fadeLR.fadeOut(RECONFIG_FADE_MS);
+    fadeDAC.fadeOut(RECONFIG_FADE_MS);
+    reconfigState = RECONFIG_FADE_OUT;
+}
+
+void reconfigApply(void)
+{
+    uint32_t t0;
+    bool newFs = false;
+
+    t0 = micros();
+    AudioNoInterrupts();
+    if (reconfig.i2sFreq && reconfig.i2sFreq != i2sFreqNow)
+    {
+        newFs = I2S_setFs(reconfig.i2sFreq);
+    }
+    if (reconfig.channelSet) mixerApply(reconfig.channel);
+    AudioInterrupts();
+    reconfigMute_us = micros() - t0;
+    if (newFs)
+    {
+        SGT_setFs(reconfig.i2sFreq);
+        setDACFreq(reconfig.i2sFreq);
+        dac12.sync();
+        calEqSet(calEqOn);
+    }
+    reconfig.i2sFreq = 0;
+    reconfig.channelSet = false;
+    if (reconfig.after)
+    {
+        void (*after)(void) = reconfig.after;
+        reconfig.after = NULL;
+        after();
+    }
+}
+
+void reconfigUpdate(void)
+{
+    switch (reconfigState)
+    {
+        case RECONFIG_IDLE:
+                        return;
+        case RECONFIG_FADE_OUT:
+                        if ((fadeLR.isFading() || fadeDAC.isFading())
+                            && micros() - reconfigStart_us < RECONFIG_WAIT_US) return;
+                        reconfigFaded_us = micros();
+                        reconfigState = RECONFIG_DRAIN;
+                        return;
+        case RECONFIG_DRAIN:
+                        if (micros() - reconfigFaded_us < RECONFIG_DRAIN_MS * 1000) return;
+                        reconfigApply();
+                        fadeLR.fadeIn(RECONFIG_FADE_MS);
+                        fadeDAC.fadeIn(RECONFIG_FADE_MS);
+                        reconfigSilent_us = micros() - reconfigFaded_us;
+                        reconfigState = RECONFIG_FADE_IN;
+#ifdef RECONFIG_REPORT
+                        Serial.print("fade out [us]: "); Serial.print(reconfigFaded_us - reconfigStart_us);
+                        Serial.print("\tsilent [us]: "); Serial.print(reconfigSilent_us);
+                        Serial.print("\tISR held off [us]: "); Serial.print(reconfigMute_us);
+                        Serial.print("\tI2S ISR max [cycles]: "); Serial.println(AudioOutputI2S::isrCycles());
+#endif
+                        return;
+        case RECONFIG_FADE_IN:
+                        if ((fadeLR.isFading() || fadeDAC.isFading())
+                            && micros() - reconfigStart_us < RECONFIG_WAIT_US * 2) return;
+                        reconfigState = RECONFIG_IDLE;
+                        reconfigSwitch_us = micros() - reconfigStart_us;
+#ifdef RECONFIG_REPORT
+                        Serial.print("switch [us]: "); Serial.println(reconfigSwitch_us);
+#endif
+                        return;
+    }
+}
+
+//a mode switch is running, the key handlers wait for it
+bool reconfigBusy(void)
+{
+    return reconfigState != RECONFIG_IDLE;
 }
 //##############################################################################
 //### handle keypad ###
@@ -382,18 +689,35 @@ void keypadEvent(KeypadEvent key)
   {
     case IDLE:      break;
     case PRESSED:
+                   monitorSkipRelease = false;
                    if (helpMode == true)
                    {
                        helpMode = false;
                        displayMainArea();
                        displayStartScreen(engineState);
                        key = NO_KEY;        //use the press to exit help mode only
+                       monitorSkipRelease = true;
                    }
+                   if (key == MONITOR_KEY)  break;  //short press is handled on release
     	           handleKeyPress(key);
+                   if (monitorMode) monitorTimer = MONITOR_REFRESH_MS; //redraw over the key action
                    break;
     case RELEASED:
+                    if (key == MONITOR_KEY && monitorSkipRelease == false)
+                    {
+                        handleKeyPress(key);
+                        if (monitorMode) monitorTimer = MONITOR_REFRESH_MS;
+                    }
                     break;
     case HOLD:
+                    if (key == MONITOR_KEY)
+                    {
+                        monitorSkipRelease = true;
+                        monitorSet(!monitorMode);
+                        if (monitorMode)    displayClrMainArea();
+                        else                displayStartScreen(engineState);
+                        break;
+                    }
                     helpMode = true;
                     switch (key)
                     {
@@ -407,7 +731,8 @@ void keypadEvent(KeypadEvent key)
                                     displayHelpTxt(2);
                                     break;
                         case 'D':
-                                    displayHelpTxt(3);
+                                    if (engineState == ANALYZER)    displayHelpTxt(4);
+                                    else                            displayHelpTxt(3);
                                     break;
                     }
                     break;
@@ -421,28 +746,52 @@ void handleKeyPress(char key)
         case NO_KEY:
                 break;
         case 'A':
+                if (engineState == SIG_GEN && !sigGenLoop)  //2nd press: HF loop
+                {
+                    sigGenLoopStart();
+                    break;
+                }
+                sigGenLoopStop();
+                dacRefSet(false);
                 engineState = SIG_GEN;
+                monitorSet(false);
+                analyzerStop();
                 fileNameEditMode = SETNAME_OFF;     //exit fle name edit mode
                 sigGen_freq = noteFreqTable[sigGen_oct][sigGen_note];
-                setSigGen(sigGen_freq, sigGen_wave);
-                setI2SFreq(44117 * 2);
-                mixerSetChannel(MUTE_ALL);
+                reconfigI2SFreq(I2S_FS_GEN);
+                reconfigChannel(MUTE_ALL);
+                reconfigCommit(sigGenRestart);
                 Timer1.stop();
                 displayStartScreen(SIG_GEN);
                 break;
         case 'B':
+                if (engineState == SIN_SWEEP)       //2nd press: DAC reference
+                {
+                    dacRefSet(!dacRefOn);
+                    displayStartScreen(SIN_SWEEP);
+                    break;
+                }
+                sigGenLoopStop();
                 engineState = SIN_SWEEP;
+                monitorSet(false);
+                analyzerStop();
                 fileNameEditMode = SETNAME_OFF;     //exit fle name edit mode
-                mixerSetChannel(MUTE_ALL);
-                setI2SFreq(44117 * 2);
+                reconfigI2SFreq(I2S_FS_GEN);
+                reconfigChannel(MUTE_ALL);
+                reconfigCommit();
                 Timer1.stop();
                 displayStartScreen(SIN_SWEEP);
                 break;
         case 'C':
+                sigGenLoopStop();
+                dacRefSet(false);
                 engineState = SD_WAV_PLAY;
+                monitorSet(false);
+                analyzerStop();
                 fileNameEditMode = SETNAME_OFF;     //exit fle name edit mode
-                mixerSetChannel(MUTE_ALL);
-                setI2SFreq(44117);
+                reconfigI2SFreq(I2S_FS_WAV);
+                reconfigChannel(MUTE_ALL);
+                reconfigCommit();
                 displayMode();
                 displayClrMainArea();
                 if (SDinitComplete==false)
@@ -474,19 +823,36 @@ void handleKeyPress(char key)
                 }
                 break;
         case 'D':
-                engineState = NOISE_GEN;
+                sigGenLoopStop();
+                dacRefSet(false);
+                if (engineState == NOISE_GEN)       //2nd press: loopback analyzer
+                {
+                    engineState = ANALYZER;
+                    reconfigI2SFreq(I2S_FS_GEN);
+                }
+                else
+                {
+                    engineState = NOISE_GEN;
+                    reconfigI2SFreq(I2S_FS_WAV);
+                }
+                monitorSet(false);
+                analyzerStop();
                 fileNameEditMode = SETNAME_OFF;     //exit fle name edit mode
-                setI2SFreq(44117);
-                mixerSetChannel(MUTE_ALL);
+                reconfigChannel(MUTE_ALL);
+                reconfigCommit();
                 Timer1.stop();
-                displayStartScreen(NOISE_GEN);
+                displayStartScreen(engineState);
                 break;
         case '1':
                 switch(engineState)
                 {
                     case NOISE_GEN:
+                                noise.period(0);
                                 mixerSetChannel(WHITE_NOISE);
                                 break;
+                    case ANALYZER:
+                                analyzerStart(ANALYZER_THDN);
+                                break;
                     case SIN_SWEEP:
                                 mixerSetChannel(SINUS_SWEEP);
                                 playSinSweep(sinSweepTime_ms[0], sinSweepDir);
@@ -519,8 +885,12 @@ void handleKeyPress(char key)
                 switch(engineState)
                 {
                     case NOISE_GEN:
+                                pink.period(0);
                                 mixerSetChannel(PINK_NOISE);
                                 break;
+                    case ANALYZER:
+                                analyzerStart(ANALYZER_RESPONSE);
+                                break;
                     case SIN_SWEEP:
                                 mixerSetChannel(SINUS_SWEEP);
                                 playSinSweep(sinSweepTime_ms[1], sinSweepDir);
@@ -545,6 +915,11 @@ void handleKeyPress(char key)
                 switch(engineState)
                 {
                     case NOISE_GEN:
+                                mls.reset();
+                                mixerSetChannel(MLS_NOISE);
+                                break;
+                    case ANALYZER:
+                                analyzerStart(ANALYZER_LATENCY);
                                 break;
                     case SIN_SWEEP:
                                 mixerSetChannel(SINUS_SWEEP);
@@ -578,6 +953,12 @@ void handleKeyPress(char key)
                 switch(engineState)
                 {
                     case NOISE_GEN:
+                                noise.period(NOISE_PERIOD_BITS);
+                                mixerSetChannel(WHITE_NOISE);
+                                break;
+                    case ANALYZER:
+                                analyzerStop();
+                                calEqFit();
                                 break;
                     case SIN_SWEEP:
                                 mixerSetChannel(SINUS_SWEEP);
@@ -607,6 +988,14 @@ void handleKeyPress(char key)
         switch(engineState)
                 {
                     case NOISE_GEN:
+                                pink.period(NOISE_PERIOD_BITS);
+                                mixerSetChannel(PINK_NOISE);
+                                break;
+                    case ANALYZER:
+                                analyzerStop();
+                                calEqSet(!calEqOn);
+                                displayClrMainArea();
+                                displayAnalyzer();
                                 break;
                     case SIN_SWEEP:
                                 mixerSetChannel(SINUS_SWEEP);
@@ -790,6 +1179,10 @@ void handleKeyPress(char key)
                     case NOISE_GEN:
                                 mixerSetChannel(MUTE_ALL);
                                 break;
+                    case ANALYZER:
+                                analyzerStop();
+                                displayStartScreen(ANALYZER);
+                                break;
                     case SIN_SWEEP:
                                 if (tonesweep.isPlaying())      //in play mode
                                 {
@@ -814,6 +1207,7 @@ void handleKeyPress(char key)
                                 sigGen_duty += 0.1;
                                 if (sigGen_duty>1.0)    sigGen_duty = 0.1;
                                 wave.pulseWidth(sigGen_duty);
+                                if (sigGenLoop) setSigGen(sigGen_freq, sigGen_wave);    //re-render
                                 break;
                     default:
                                 break;
@@ -907,46 +1301,55 @@ bool keypadHandleWavPlayer(char key)
 /*
     Turns on one channel, mutes the rest
     ch = 0 -> mute all channels
+    mixerApply() does not touch the audio interrupts, callers group it
+    with other changes inside their own AudioNoInterrupts() section
 */
 bool mixerSetChannel(outputChannel_t ch)
+{
+    bool out;
+    AudioNoInterrupts();  // disable audio library momentarily
+    out = mixerApply(ch);
+    AudioInterrupts();    // enable, both tones will start together
+    return out;
+}
+
+bool mixerApply(outputChannel_t ch)
 {
     bool out = true;       //possible future uses
     byte i;
-    AudioNoInterrupts();  // disable audio library momentarily
     switch (ch)
     {
         case MUTE_ALL:  //all channels OFF
                         digitalWrite(RELAY_CTRL,LOW);
-                        for (i = 0;i<4;i++)
+                        for (i = 0;i<OUT_MIX_INPUTS;i++)
                         {
-                            mixerL.gain(i,0);
-                            mixerR.gain(i,0);
-                            mixerSD_L.gain(i,0);
-                            mixerSD_R.gain(i,0);
-                            mixerDAC.gain(i,0);
+                            mixerLR.gain(i,0);
+                        }
+                        if (!dacRefOn)                      //DAC has its own source
+                        {
+                            mixerDAC.gain(DAC_SIG_GEN_CH,0);
+                            mixerDAC.gain(DAC_REF_CH,0);
                         }
                         noise.amplitude(0); //switch off
                         pink.amplitude(0);  //all sources
+                        mls.amplitude(0);
                         playSdWavA.stop();
                         playSdWavB.stop();
                         tonesweep.stop();
                         out = true;
                         break;
         case WAV_PLAYER:
-                        mixerSetChannel(MUTE_ALL);
-                        mixerSD_R.gain(WAV_PLAY_CHSDA,1);   //----
-                        mixerSD_R.gain(WAV_PLAY_CHSDB,1);   //SD mixer
-                        mixerSD_L.gain(WAV_PLAY_CHSDA,1);   //
-                        mixerSD_L.gain(WAV_PLAY_CHSDB,1);   //----
-                        mixerR.gain(WAV_PLAY_CH,1);         //output
-                        mixerL.gain(WAV_PLAY_CH,1);         //mixer
+                        mixerApply(MUTE_ALL);
+                        mixerLR.gain(WAV_PLAY_CHAL,1,0);   //stereo:
+                        mixerLR.gain(WAV_PLAY_CHAR,0,1);   //left input to
+                        mixerLR.gain(WAV_PLAY_CHBL,1,0);   //the left side,
+                        mixerLR.gain(WAV_PLAY_CHBR,0,1);   //right to right
                         break;
         case SIGNAL_GEN:
-                        mixerSetChannel(MUTE_ALL);
-                        mixerR.gain(SIG_GEN_CH,1);
-                        mixerL.gain(SIG_GEN_CH,1);
+                        mixerApply(MUTE_ALL);
+                        mixerLR.gain(SIG_GEN_CH,1);
 
-                        mixerDAC.gain(0,1);    //use 12bit DAC
+                        if (!dacRefOn)  mixerDAC.gain(DAC_SIG_GEN_CH,1);    //use 12bit DAC
 
                         // if (sigGen_wave == 2 || sigGen_wave == 3)   //SQR or pulse
                         // {
@@ -956,29 +1359,30 @@ bool mixerSetChannel(outputChannel_t ch)
 
                         break;
         case WHITE_NOISE:
-                        mixerSetChannel(MUTE_ALL);
+                        mixerApply(MUTE_ALL);
                         noise.amplitude(1); //turn on noise gen
-                        mixerR.gain(WHITE_NOISE_CH,1);
-                        mixerL.gain(WHITE_NOISE_CH,1);
+                        mixerLR.gain(WHITE_NOISE_CH,1);
                         break;
         case PINK_NOISE:
-                        mixerSetChannel(MUTE_ALL);
+                        mixerApply(MUTE_ALL);
                         pink.amplitude(1);
-                        mixerSD_R.gain(PINK_NOISE_CHSD,1);   //SD
-                        mixerSD_L.gain(PINK_NOISE_CHSD,1);   //mixer
-                        mixerR.gain(PINK_NOISE_CH,1);        //output
-                        mixerL.gain(PINK_NOISE_CH,1);        //mixer
+                        mixerLR.gain(PINK_NOISE_CH,1);
                         break;
         case SINUS_SWEEP:
-                        mixerSetChannel(MUTE_ALL);
-                        mixerR.gain(SIN_SWEEP_CH,1);        //output
-                        mixerL.gain(SIN_SWEEP_CH,1);        //mixer
+                        mixerApply(MUTE_ALL);
+                        mixerLR.gain(SIN_SWEEP_CH,1);
+                        break;
+        case MLS_NOISE:
+                        mixerApply(MUTE_ALL);
+                        mls.amplitude(1);
+                        mixerLR.gain(MLS_NOISE_CH,1);
                         break;
         default:
-                        mixerSetChannel(MUTE_ALL);
+                        mixerApply(MUTE_ALL);
+                        ch = MUTE_ALL;
                         break;
     }
-    AudioInterrupts();    // enable, both tones will start together
+    channelNow = ch;
     return out;
 }
 //##############################################################################
@@ -1022,6 +1426,9 @@ void displayMainArea(void)
                     displayNote(sigGen_oct, sigGen_note);
                     displayWaveSymbol(sigGen_wave);
                     break;
+        case ANALYZER:
+                    displayAnalyzer();
+                    break;
         default:
                     break;
     }
@@ -1070,9 +1477,9 @@ void displayWaveSymbol(uint8_t wave)
 void displayNoiseGen(void)
 {
     display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
-    display.println("1: White Noise");
+    display.println("1:White 2:Pink 3:MLS");
     display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW1);
-    display.println("2: Pink Noise");
+    display.println("Periodic 4:Wht 5:Pnk");
     display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW2);
     display.print("#: Mute/OFF");
 }
@@ -1122,6 +1529,11 @@ void displaySinSweep(void)
     display.print("Fmin = "); display.print(sinSweepStartF); display.print("Hz");
     display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW1);
     display.print("Fmax = "); display.print(sinSweepEndF); display.print("Hz");
+    if (dacRefOn)
+    {
+        display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW2);
+        display.print("DAC = "); display.print(DAC_REF_FREQ); display.print("Hz SQR");
+    }
 }
 
 //##############################################################################
@@ -1195,6 +1607,9 @@ void displayStartScreen(engineState_t mode)
                     displayNote(sigGen_oct, sigGen_note);
                     displayWaveSymbol(sigGen_wave);
                     break;
+        case ANALYZER:
+                    displayAnalyzer();
+                    break;
         default:
                     break;
     }
@@ -1202,6 +1617,15 @@ void displayStartScreen(engineState_t mode)
 //##############################################################################
 void displayUpdate(void)
 {
+    if (helpMode == false && monitorMode == true && fileNameEditMode == SETNAME_OFF)
+    {
+        if (monitorTimer >= MONITOR_REFRESH_MS)
+        {
+            monitorTimer = 0;
+            displayMonitor();
+        }
+        return;
+    }
     if (helpMode == false)      //in help mode do not update
     {
         //displayCpuUsage();
@@ -1210,6 +1634,7 @@ void displayUpdate(void)
             case SIG_GEN:
                         break;
             case NOISE_GEN:
+            case ANALYZER:
                         break;
             case SD_WAV_PLAY:
                             char txtNumber[2];
@@ -1268,6 +1693,312 @@ void displayUpdate(void)
     }
 }
 //##############################################################################
+// ### output monitor ###
+/*  Scope trace and spectrum of the left output channel plus a clipping
+ *  indicator for both channels. The analyzers are fed from mixerLR,
+ *  the FFT runs only every MONITOR_FFT_HOLDOFF blocks and is split over two
+ *  audio updates, the scope is re-armed once per screen refresh.
+ */
+void monitorSet(bool on)
+{
+    monitorMode = on;
+    if (on)
+    {
+        fftMon.holdoff(MONITOR_FFT_HOLDOFF);
+        scopeMon.trigger();
+        monitorTimer = MONITOR_REFRESH_MS;      //draw on the next update
+    }
+    else
+    {
+        fftMon.holdoff(MONITOR_FFT_IDLE);
+    }
+}
+
+void displayMonitor(void)
+{
+    int i, y, yLast;
+    float level;
+
+    if (scopeMon.available())
+    {
+        for (i = 0; i < AUDIO_SCOPE_SAMPLES; i++)   monitorTrace[i] = scopeMon.read(i);
+        scopeMon.trigger();
+    }
+    if (peakL.available())  monitorClipL = peakL.read() >= MONITOR_CLIP_LVL;
+    if (peakR.available())  monitorClipR = peakR.read() >= MONITOR_CLIP_LVL;
+
+    displayClrMainArea();
+    // scope
+    yLast = MONITOR_SCOPE_Y - ((monitorTrace[0] * MONITOR_SCOPE_H) >> 15);
+    for (i = 1; i < AUDIO_SCOPE_SAMPLES && i < display.width(); i++)
+    {
+        y = MONITOR_SCOPE_Y - ((monitorTrace[i] * MONITOR_SCOPE_H) >> 15);
+        display.drawLine(i-1, yLast, i, y, WHITE);
+        yLast = y;
+    }
+    // spectrum, log scale
+    for (i = 0; i < 128 && i < display.width(); i++)
+    {
+        level = fftMon.read(i);
+        if (level < 1e-6) continue;
+        y = (20.0 * log10f(level) + MONITOR_DB_RANGE) * (MONITOR_SPECT_H / MONITOR_DB_RANGE);
+        if (y <= 0) continue;
+        if (y > MONITOR_SPECT_H) y = MONITOR_SPECT_H;
+        display.drawFastVLine(i, display.height() - y, y, WHITE);
+    }
+    if (monitorClipL || monitorClipR)
+    {
+        display.setCursor(display.width() - 24, 12);
+        display.setTextColor(BLACK, WHITE);     //reverse
+        display.print("CLIP");
+        display.setTextColor(WHITE, BLACK);     //restore
+    }
+}
+//##############################################################################
+// ### loopback analyzer ###
+/*  Plays a test tone on both outputs and measures the left line input against
+ *  the left output. THD+N and the response run one window per frequency, the
+ *  results are shown on the display and printed over Serial. The local
+ *  oscillator uses the same increment as the generator, so it runs at
+ *  exactly the generator frequency.
+ */
+void displayAnalyzer(void)
+{
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
+    display.print("1:THD+N 2:Response");
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW1);
+    display.print("3:Latency 4:Fit EQ");
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW2);
+    display.print(calEqOn ? "5:EQ ON  #:Stop" : "5:EQ OFF #:Stop");
+}
+
+void analyzerMeasure(float freq)
+{
+    setSigGen(freq, 0, 0);                      //sine, no glide
+    wave.amplitude(ANALYZER_LEVEL);
+    analyzerFreq = loopback.frequency(freq, ANALYZER_CYCLES);
+    mixerSetChannel(SIGNAL_GEN);
+}
+
+void analyzerStart(analyzerTask_t task)
+{
+    analyzerStop();
+    analyzerTask = task;
+    analyzerStep = 0;
+    displayClrMainArea();
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
+    switch (task)
+    {
+        case ANALYZER_THDN:
+                    display.print("THD+N...");
+                    harmonicsMon.harmonics(ANALYZER_THDN_FREQ, ANALYZER_HARMONICS);
+                    analyzerMeasure(ANALYZER_THDN_FREQ);
+                    break;
+        case ANALYZER_RESPONSE:
+                    display.print("Response...");
+                    Serial.println("f[Hz]\tlevel[dB]\tphase[deg]\tTHD+N[%]");
+                    analyzerMeasure(analyzerFreqs[0]);
+                    break;
+        case ANALYZER_LATENCY:
+                    display.print("Latency...");
+                    delay(ANALYZER_LAT_MUTE);           //let the output go silent
+                    loopback.latency(ANALYZER_LAT_LVL);
+                    setSigGen(ANALYZER_LAT_FREQ, 2, 0); //square, sharp onset
+                    wave.amplitude(ANALYZER_LEVEL);
+                    mixerSetChannel(SIGNAL_GEN);
+                    break;
+        default:
+                    break;
+    }
+}
+
+void analyzerStop(void)
+{
+    analyzerTask = ANALYZER_IDLE;
+    loopback.stop();
+    harmonicsMon.stop();
+    mixerSetChannel(MUTE_ALL);
+}
+
+void analyzerUpdate(void)
+{
+    float freq, gain, phase, thdn;
+
+    if (engineState != ANALYZER || analyzerTask == ANALYZER_IDLE) return;
+    if (!loopback.available()) return;
+
+    if (analyzerTask == ANALYZER_LATENCY)
+    {
+        analyzerLatency = loopback.latencySamples();
+        analyzerStop();
+        displayClrMainArea();
+        display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
+        if (analyzerLatency < 0)
+        {
+            display.print("No signal on line in");
+            Serial.println("Latency: no signal");
+            return;
+        }
+        display.print("Latency");
+        display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW1);
+        display.print(analyzerLatency);
+        display.print(" samples");
+        display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW2);
+        display.print(analyzerLatency * 1000.0 / AudioSampleRate());
+        display.print(" ms");
+        Serial.print("Latency: ");
+        Serial.print(analyzerLatency);
+        Serial.print(" samples, ");
+        Serial.print(analyzerLatency * 1000.0 / AudioSampleRate());
+        Serial.println(" ms");
+        return;
+    }
+
+    freq = analyzerFreq;
+    gain = loopback.gain();
+    thdn = loopback.thdn();
+    phase = loopback.phase();
+    if (analyzerLatency > 0)                    //remove the pure delay
+    {
+        phase += 360.0 * analyzerFreq * analyzerLatency / AudioSampleRate();
+        phase = fmodf(phase + 180.0, 360.0);
+        if (phase < 0) phase += 360.0;
+        phase -= 180.0;
+    }
+    gain = gain > 1e-6 ? 20.0 * log10f(gain) : -120.0;
+    if (analyzerTask == ANALYZER_RESPONSE)      //keep the response without the EQ
+    {
+        calEqGain[analyzerStep] = gain;
+        if (calEqOn && calEqFs == i2sFreqNow)
+        {
+            calEqGain[analyzerStep] -= calEqLevel +
+                AudioEqualizerFit::response(calEqStages, calEqCount, freq, AudioSampleRate());
+        }
+    }
+
+    displayClrMainArea();
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
+    display.print("F=");
+    display.print(freq, 1);
+    display.print("Hz");
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW1);
+    display.print("G=");
+    display.print(gain, 2);
+    display.print("dB P=");
+    display.print(phase, 1);
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW2);
+    display.print("THD+N=");
+    display.print(thdn * 100.0, 4);
+    display.print("%");
+
+    Serial.print(freq, 1);
+    Serial.print('\t');
+    Serial.print(gain, 2);
+    Serial.print('\t');
+    Serial.print(phase, 1);
+    Serial.print('\t');
+    Serial.println(thdn * 100.0, 4);
+
+    if (analyzerTask == ANALYZER_THDN)
+    {
+        if (harmonicsMon.available())           //H2.. relative to the fundamental
+        {
+            float harm[ANALYZER_HARMONICS];
+            uint8_t n = harmonicsMon.read(harm, ANALYZER_HARMONICS);
+            Serial.print("H2-H");
+            Serial.print(n);
+            Serial.print("[dB]");
+            for (uint8_t i = 1; i < n; i++)
+            {
+                Serial.print('\t');
+                if (harm[0] > 0 && harm[i] > 0) Serial.print(20.0 * log10f(harm[i] / harm[0]), 1);
+                else                            Serial.print("-");
+            }
+            Serial.println();
+        }
+        analyzerMeasure(ANALYZER_THDN_FREQ);    //keep measuring
+        return;
+    }
+    if (++analyzerStep < ANALYZER_FR_STEPS)
+    {
+        analyzerMeasure(analyzerFreqs[analyzerStep]);
+        return;
+    }
+    analyzerStop();
+    calEqMeasured = true;
+    Serial.println("Response done");
+}
+//##############################################################################
+/*  Fit the EQ to the last response run and switch it on. The level is
+ *  lowered by the largest boost, so a full scale signal does not clip.
+ */
+void calEqFit(void)
+{
+    float f, r, peak = 0;
+
+    displayClrMainArea();
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
+    if (!calEqMeasured)
+    {
+        display.print("Run 2:Response first");
+        return;
+    }
+    display.print("Fitting EQ...");
+    display.display();
+    calEqCount = AudioEqualizerFit::fit(analyzerFreqs, calEqGain, ANALYZER_FR_STEPS,
+                    ANALYZER_THDN_FREQ, CAL_EQ_FMIN, CAL_EQ_FMAX, CAL_EQ_MAX_BOOST,
+                    AudioSampleRate(), calEqStages, CAL_EQ_STAGES);
+    for (f = analyzerFreqs[0]; f < AudioSampleRate() * 0.45; f *= 1.05)
+    {
+        r = AudioEqualizerFit::response(calEqStages, calEqCount, f, AudioSampleRate());
+        if (r > peak) peak = r;
+    }
+    calEqLevel = -peak;
+    calEqFs = i2sFreqNow;
+    f = AudioEqualizerFit::apply(&calEqL, calEqStages, calEqCount, AudioSampleRate(), calEqLevel);
+    AudioEqualizerFit::apply(&calEqR, calEqStages, calEqCount, AudioSampleRate(), calEqLevel);
+    calEqLevel -= f;                    //the part the coefficients could not carry
+    calEqSet(true);
+
+    Serial.println("type\tf[Hz]\tgain[dB]\tQ");
+    for (uint32_t i = 0; i < calEqCount; i++)
+    {
+        Serial.print(calEqStages[i].type);
+        Serial.print('\t');
+        Serial.print(calEqStages[i].frequency, 1);
+        Serial.print('\t');
+        Serial.print(calEqStages[i].gain, 2);
+        Serial.print('\t');
+        Serial.println(calEqStages[i].q, 2);
+    }
+    Serial.print("EQ level [dB]: ");
+    Serial.println(calEqLevel, 2);
+
+    displayClrMainArea();
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW0);
+    display.print("EQ: ");
+    display.print(calEqCount);
+    display.print(" stages");
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW1);
+    display.print("Level ");
+    display.print(calEqLevel, 1);
+    display.print("dB");
+    display.setCursor(DISP_TXT_COL0,DISP_TXT_ROW2);
+    display.print("2:Check 5:EQ on/off");
+}
+//##############################################################################
+/*  The EQ runs only at the rate it was fitted at, otherwise it is bypassed
+ *  and costs nothing. Called again on every I2S rate change.
+ */
+void calEqSet(bool on)
+{
+    bool run = on && calEqFs && calEqFs == i2sFreqNow;
+
+    calEqOn = on;
+    calEqL.bypass(!run);
+    calEqR.bypass(!run);
+}
+//##############################################################################
 // ### start sin sweep ###
 bool playSinSweep(float time_ms, int dir)
 {
@@ -1404,16 +2135,102 @@ void ISR_checkWavePosition(void)
  *  SQR and PULSE use 12bit DAC instead of the codec, hence they are able
  *  to produce a pure square wave
  *  RampUp & Down are heavily aliased beyond 8kHz, hence the limitation
+ *  Changing only the frequency glides to the new one over glide ms
+ *  without resetting the phase, so note changes do not click.
  */
-bool setSigGen(float freq, short waveform)
+bool setSigGen(float freq, short waveform, float glide)
 {
+    static short running = -1;                  //waveform currently set
     bool out = false;
     if (waveform>MAX_WAVEFORMS-1) return out;
     if (freq > SIGGEN_F_LIMIT && waveform > 3) return out;       //4,5 = RampDown, RampUp
     out = true;
-    wave.begin(SIGGEN_AMPL_DEFAULT, freq/2 , waveIndex[waveform]);
+    if (sigGenLoop)
+    {
+        //the whole graph stands still while looping, wave is left as is
+        out = hfLoop.play(freq, waveIndex[waveform], SIGGEN_AMPL_DEFAULT,
+                          sigGen_duty, SIGGEN_LOOP_DAC_FS) > 0;
+        //SQR and PULSE edges go out through the 192kHz 12bit DAC loop,
+        //the relay puts it on the output, the rest stays on the codec
+        digitalWrite(RELAY_CTRL, (waveform == 2 || waveform == 3)
+                     && hfLoop.frequencyDAC() > 0 ? HIGH : LOW);
+        running = -1;
+        return out;
+    }
+    if (waveform == running && glide > 0)
+    {
+        wave.frequency(freq, glide);
+        wave.amplitude(SIGGEN_AMPL_DEFAULT, glide);
+    }
+    else wave.begin(SIGGEN_AMPL_DEFAULT, freq, waveIndex[waveform]);
+    running = waveform;
     return out;
 }
+
+//mode A entered, run once the generator rate is set
+void sigGenRestart(void)
+{
+    setSigGen(sigGen_freq, sigGen_wave);
+}
+//##############################################################################
+/*  HF loop: one whole number of periods is rendered into a buffer and the
+ *  I2S and DAC DMA play it in a loop, the audio library is not updated.
+ *  Note and wave changes re-render the loop, there is a short gap.
+ */
+void sigGenLoopStart(void)
+{
+    reconfigI2SFreq(SIGGEN_LOOP_I2S_FS);
+    reconfigChannel(MUTE_ALL);
+    reconfigCommit(sigGenLoopRender);
+}
+
+//the rest of sigGenLoopStart(), once the loop rate is set
+void sigGenLoopRender(void)
+{
+    setDACFreq(SIGGEN_LOOP_DAC_FS);
+    sigGenLoop = true;
+    if (setSigGen(sigGen_freq, sigGen_wave))
+    {
+        displayClrMainArea();
+        displayNote(sigGen_oct, sigGen_note);
+    }
+    else
+    {
+        displayClrMainArea();
+        displayFreqWarning();
+    }
+}
+//##############################################################################
+void sigGenLoopStop(void)
+{
+    if (!sigGenLoop) return;
+    hfLoop.stop();
+    digitalWrite(RELAY_CTRL, LOW);              //back to the codec
+    sigGenLoop = false;
+    setDACFreq(i2sFreqNow);
+    dac12.sync();
+}
+//##############################################################################
+/*  Dual output: the DAC gets its own source and keeps it through codec
+ *  channel changes, both outputs are delayed to line up. The relay stays
+ *  on the codec, the sweep keeps the jack and the reference is picked up
+ *  at the DAC pin (A14).
+ */
+void dacRefSet(bool on)
+{
+    if (on == dacRefOn) return;
+    dacRefOn = on;
+    digitalWrite(RELAY_CTRL, LOW);              //jack on the codec
+    if (on) dacRef.begin(DAC_REF_AMPL, DAC_REF_FREQ, WAVEFORM_SQUARE);
+    else    dacRef.amplitude(0);
+    AudioNoInterrupts();
+    mixerDAC.gain(DAC_SIG_GEN_CH, 0);
+    mixerDAC.gain(DAC_REF_CH, on ? 1 : 0);
+    AudioInterrupts();
+    i2s.delaySamples(on ? OUT_ALIGN_I2S : 0);
+    dac12.delaySamples(on ? OUT_ALIGN_DAC : 0);
+    dac12.sync();
+}
 //##############################################################################
 void setup()
 {
@@ -1429,16 +2246,19 @@ void setup()
     display.drawBitmap(0,0, welcomeScrn, 128,64, WHITE);
     display.display();
 
-    AudioMemory(15);
+    AudioMemory(20);
+    calEqSet(false);                            //not fitted yet, pass through
     keypad.addEventListener(keypadEvent); //add an event listener for this keypad
 
     // Enable the codec, mute the HP out, we're using the line out only
     sgtl5000_1.enable();
     sgtl5000_1.volume(0.5);
     sgtl5000_1.muteHeadphone();
+    sgtl5000_1.inputSelect(AUDIO_INPUT_LINEIN);     //loopback analyzer input
 
-    setDACFreq(44117 * 2);
-    setI2SFreq(44117 * 2);
+    setDACFreq(I2S_FS_GEN);
+    setI2SFreq(I2S_FS_GEN);
+    dac12.sync();
 
     Timer1.initialize(2000);
     Timer1.attachInterrupt(ISR_checkWavePosition);
@@ -1464,14 +2284,21 @@ void setup()
     setSigGen(noteFreqTable[sigGen_oct][sigGen_note], sigGen_wave);
     wave.pulseWidth(sigGen_duty);
     mixerSetChannel(MUTE_ALL);
+    mls.order(NOISE_MLS_ORDER);
+
+    fftMon.averageTogether(MONITOR_FFT_AVG);
+    monitorSet(false);
 
     display.display();
 }
 //##############################################################################
 void loop()
 {
-    key=keypad.getKey();      //update keypad input
+    //keys wait for a mode switch to finish, the handlers expect the new mode
+    if (!reconfigBusy()) key=keypad.getKey();      //update keypad input
     wavLooper();
+    reconfigUpdate();
+    analyzerUpdate();
     displayUpdate();
     display.display();
 }